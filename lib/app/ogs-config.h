@@ -75,6 +75,8 @@ typedef struct ogs_global_conf_s {
 
         int no_pfcp_rr_select;
         int no_time_zone_information;
+
+        int use_io_uring;
     } parameter;
 
     struct {
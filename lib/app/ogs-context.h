@@ -45,6 +45,8 @@ typedef struct ogs_app_context_s {
         const char *level;
         const char *domain;
         ogs_log_ts_e timestamp;
+        bool async;
+        unsigned int rate_limit;    /* Messages per second and domain */
     } logger;
 
     ogs_queue_t *queue;
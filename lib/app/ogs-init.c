@@ -121,6 +121,14 @@ int ogs_app_initialize(
     ogs_log_set_timestamp(ogs_app()->logger_default.timestamp,
                           ogs_app()->logger.timestamp);
 
+    if (ogs_app()->logger.rate_limit)
+        ogs_log_set_rate_limit(NULL, ogs_app()->logger.rate_limit);
+
+    if (ogs_app()->logger.async) {
+        rv = ogs_log_async_start();
+        if (rv != OGS_OK) return rv;
+    }
+
     /**************************************************************************
      * Stage 5 : Setup Database Module
      */
@@ -161,6 +169,11 @@ int ogs_app_initialize(
     ogs_assert(ogs_app()->queue);
     ogs_app()->timer_mgr = ogs_timer_mgr_create(ogs_app()->pool.timer);
     ogs_assert(ogs_app()->timer_mgr);
+    if (ogs_global_conf()->parameter.use_io_uring &&
+        ogs_pollset_use_io_uring() == false) {
+        ogs_warn("io_uring is not available, use the default pollset");
+        ogs_global_conf()->parameter.use_io_uring = false;
+    }
     ogs_app()->pollset = ogs_pollset_create(ogs_app()->pool.socket);
     ogs_assert(ogs_app()->pollset);
 
@@ -355,6 +368,12 @@ static int parse_config(void)
                 } else if (!strcmp(logger_key, "domain")) {
                     ogs_app()->logger.domain =
                         ogs_yaml_iter_value(&logger_iter);
+                } else if (!strcmp(logger_key, "async")) {
+                    ogs_app()->logger.async =
+                        ogs_yaml_iter_bool(&logger_iter);
+                } else if (!strcmp(logger_key, "rate_limit")) {
+                    const char *v = ogs_yaml_iter_value(&logger_iter);
+                    if (v) ogs_app()->logger.rate_limit = atoi(v);
                 }
             }
         } else if (!strcmp(root_key, "global")) {
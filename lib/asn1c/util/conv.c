@@ -215,37 +215,29 @@ int ogs_asn_ip_to_BIT_STRING(ogs_ip_t *ip, BIT_STRING_t *bit_string)
 
 int ogs_asn_copy_ie(const asn_TYPE_descriptor_t *td, void *src, void *dst)
 {
-    asn_enc_rval_t enc_ret = {0};
-    asn_dec_rval_t dec_ret = {0};
-    uint8_t *buffer = NULL;
+    char errbuf[128] = { 0, };
+    size_t errlen = sizeof(errbuf);
+    int rv;
 
     ogs_assert(td);
     ogs_assert(src);
     ogs_assert(dst);
 
-    buffer = ogs_calloc(1, OGS_MAX_SDU_LEN);
-    if (!buffer) {
-        ogs_error("ogs_calloc() failed");
+    /*
+     * The IE comes from a received packet, so keep rejecting
+     * what the APER encoder would have refused before copying it.
+     */
+    rv = asn_check_constraints(td, src, errbuf, &errlen);
+    if (rv != 0) {
+        ogs_error("asn_check_constraints() failed[%s]", errbuf);
         return OGS_ERROR;
     }
 
-    enc_ret = aper_encode_to_buffer(td, NULL, src, buffer, OGS_MAX_SDU_LEN);
-    if (enc_ret.encoded < 0) {
-        ogs_error("aper_encode_to_buffer() failed[%d]", (int)enc_ret.encoded);
-        ogs_free(buffer);
+    rv = asn_copy(td, &dst, src);
+    if (rv != 0) {
+        ogs_error("asn_copy() failed[%d]", rv);
         return OGS_ERROR;
     }
 
-    dec_ret = aper_decode(NULL, td, (void **)&dst,
-            buffer, ((enc_ret.encoded + 7) / 8), 0, 0);
-
-    if (dec_ret.code != RC_OK) {
-        ogs_error("aper_decode() failed[%d]", dec_ret.code);
-        ogs_free(buffer);
-        return OGS_ERROR;
-    }
-
-    ogs_free(buffer);
-
     return OGS_OK;
 }
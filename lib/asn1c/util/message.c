@@ -19,32 +19,39 @@
 
 #include "message.h"
 
+/*
+ * APER output is written to a per-thread scratch buffer first so that
+ * the returned pkbuf only takes the encoded size from the pool
+ * instead of a full OGS_MAX_SDU_LEN cluster.
+ */
+static OGS_THREAD_LOCAL uint8_t encode_buffer[OGS_MAX_SDU_LEN];
+
 ogs_pkbuf_t *ogs_asn_encode(const asn_TYPE_descriptor_t *td, void *sptr)
 {
     asn_enc_rval_t enc_ret = {0};
     ogs_pkbuf_t *pkbuf = NULL;
+    size_t size;
 
     ogs_assert(td);
     ogs_assert(sptr);
 
-    pkbuf = ogs_pkbuf_alloc(NULL, OGS_MAX_SDU_LEN);
-    if (!pkbuf) {
-        ogs_error("ogs_pkbuf_alloc() failed");
-        return NULL;
-    }
-    ogs_pkbuf_put(pkbuf, OGS_MAX_SDU_LEN);
-
     enc_ret = aper_encode_to_buffer(td, NULL,
-                    sptr, pkbuf->data, OGS_MAX_SDU_LEN);
+                    sptr, encode_buffer, sizeof(encode_buffer));
     ogs_asn_free(td, sptr);
 
     if (enc_ret.encoded < 0) {
         ogs_error("Failed to encode ASN-PDU [%d]", (int)enc_ret.encoded);
-        ogs_pkbuf_free(pkbuf);
         return NULL;
     }
 
-    ogs_pkbuf_trim(pkbuf, ((enc_ret.encoded + 7) >> 3));
+    size = (enc_ret.encoded + 7) >> 3;
+
+    pkbuf = ogs_pkbuf_alloc(NULL, ogs_max(size, 1));
+    if (!pkbuf) {
+        ogs_error("ogs_pkbuf_alloc() failed");
+        return NULL;
+    }
+    ogs_pkbuf_put_data(pkbuf, encode_buffer, size);
 
     return pkbuf;
 }
@@ -81,3 +88,178 @@ void ogs_asn_free(const asn_TYPE_descriptor_t *td, void *sptr)
 
     ASN_STRUCT_FREE_CONTENTS_ONLY(*td, sptr);
 }
+
+/*
+ * X.691 unconstrained length determinant, as used by open types and
+ * unconstrained OCTET STRINGs. Fragmented (>= 16K) values are left
+ * to the full decoder.
+ */
+static int route_get_length(uint8_t **pos, uint8_t *end, size_t *length)
+{
+    uint8_t *p = *pos;
+
+    if (p >= end)
+        return OGS_ERROR;
+
+    if ((p[0] & 0x80) == 0) {
+        *length = p[0];
+        p += 1;
+    } else if ((p[0] & 0xc0) == 0x80) {
+        if (end - p < 2)
+            return OGS_ERROR;
+        *length = ((p[0] & 0x3f) << 8) | p[1];
+        p += 2;
+    } else {
+        return OGS_ERROR;
+    }
+
+    if (*length > (size_t)(end - p))
+        return OGS_ERROR;
+
+    *pos = p;
+    return OGS_OK;
+}
+
+int ogs_asn_route_parse(ogs_asn_route_t *route, uint8_t *data, size_t size)
+{
+    uint8_t *p = NULL, *end = NULL;
+    size_t length;
+
+    ogs_assert(route);
+    ogs_assert(data);
+
+    memset(route, 0, sizeof(*route));
+
+    p = data;
+    end = data + size;
+
+    /*
+     * PDU ::= CHOICE { initiatingMessage, successfulOutcome,
+     *                  unsuccessfulOutcome, ... }
+     * followed by the message SEQUENCE :
+     *   procedureCode INTEGER (0..255)
+     *   criticality ENUMERATED { reject, ignore, notify }
+     *   value OPEN TYPE
+     */
+    if (end - p < 3)
+        return OGS_ERROR;
+
+    if (p[0] & 0x80)
+        return OGS_ERROR;   /* Extension alternative */
+
+    route->present = ((p[0] >> 5) & 0x03) + 1;
+    if (route->present > 3)
+        return OGS_ERROR;
+
+    route->procedure_code = p[1];
+
+    route->criticality = p[2] >> 6;
+    if (route->criticality > 2)
+        return OGS_ERROR;
+
+    p += 3;
+
+    if (route_get_length(&p, end, &length) != OGS_OK)
+        return OGS_ERROR;
+    end = p + length;
+
+    /*
+     * value ::= SEQUENCE { protocolIEs ProtocolIE-Container, ... }
+     * ProtocolIE-Container ::= SEQUENCE (SIZE (0..65535)) OF ...
+     */
+    if (end - p < 3)
+        return OGS_ERROR;
+
+    route->num_of_ie = (p[1] << 8) | p[2];
+    p += 3;
+
+    route->pos = p;
+    route->end = end;
+
+    return OGS_OK;
+}
+
+int ogs_asn_route_next_ie(ogs_asn_route_t *route, ogs_asn_route_ie_t *ie)
+{
+    uint8_t *p = NULL;
+    size_t length;
+
+    ogs_assert(route);
+    ogs_assert(ie);
+
+    /*
+     * ProtocolIE-Field ::= SEQUENCE {
+     *   id ProtocolIE-ID (0..65535)
+     *   criticality ENUMERATED { reject, ignore, notify }
+     *   value OPEN TYPE }
+     */
+    p = route->pos;
+    if (!p || route->end - p < 3)
+        return OGS_ERROR;
+
+    ie->id = (p[0] << 8) | p[1];
+    ie->criticality = p[2] >> 6;
+    p += 3;
+
+    if (route_get_length(&p, route->end, &length) != OGS_OK)
+        return OGS_ERROR;
+
+    ie->value = p;
+    ie->length = length;
+
+    route->pos = p + length;
+
+    return OGS_OK;
+}
+
+int ogs_asn_route_decode_uint(
+        ogs_asn_route_ie_t *ie, int range_bits, uint64_t *value)
+{
+    int max_octets, bits, length, i;
+    uint64_t v = 0;
+
+    ogs_assert(ie);
+    ogs_assert(value);
+    ogs_assert(range_bits > 16 && range_bits <= 64);
+
+    /*
+     * X.691 #12.2.6 : the number of octets comes first as a bit-field,
+     * then the octet-aligned value.
+     */
+    max_octets = (range_bits + 7) >> 3;
+    bits = 1;
+    while ((1 << bits) < max_octets)
+        bits++;
+
+    if (ie->length < 1)
+        return OGS_ERROR;
+
+    length = (ie->value[0] >> (8 - bits)) + 1;
+    if (length > max_octets || ie->length < 1 + length)
+        return OGS_ERROR;
+
+    for (i = 0; i < length; i++)
+        v = (v << 8) | ie->value[1 + i];
+
+    *value = v;
+
+    return OGS_OK;
+}
+
+int ogs_asn_route_decode_octet_string(
+        ogs_asn_route_ie_t *ie, uint8_t **buf, size_t *size)
+{
+    uint8_t *p = NULL;
+
+    ogs_assert(ie);
+    ogs_assert(buf);
+    ogs_assert(size);
+
+    p = ie->value;
+    if (route_get_length(&p, ie->value + ie->length, size) != OGS_OK)
+        return OGS_ERROR;
+
+    *buf = p;
+
+    return OGS_OK;
+}
@@ -34,6 +34,38 @@ int ogs_asn_decode(const asn_TYPE_descriptor_t *td,
         void *struct_ptr, size_t struct_size, ogs_pkbuf_t *pkbuf);
 void ogs_asn_free(const asn_TYPE_descriptor_t *td, void *sptr);
 
+/*
+ * Routing view of an APER encoded S1AP/NGAP PDU.
+ *
+ * Only the PDU header and the top-level ProtocolIE-Container are read
+ * from the bitstream, so the caller can pick out the IEs it needs
+ * without building the asn1c structure. IE values point into the
+ * buffer given to ogs_asn_route_parse().
+ */
+typedef struct ogs_asn_route_ie_s {
+    uint16_t id;
+    uint8_t criticality;
+    uint8_t *value;
+    size_t length;
+} ogs_asn_route_ie_t;
+
+typedef struct ogs_asn_route_s {
+    uint8_t present;            /* 1-based CHOICE index of the PDU */
+    uint8_t procedure_code;
+    uint8_t criticality;
+    int num_of_ie;
+
+    uint8_t *pos;               /* Next ProtocolIE-Field */
+    uint8_t *end;
+} ogs_asn_route_t;
+
+int ogs_asn_route_parse(ogs_asn_route_t *route, uint8_t *data, size_t size);
+int ogs_asn_route_next_ie(ogs_asn_route_t *route, ogs_asn_route_ie_t *ie);
+int ogs_asn_route_decode_uint(
+        ogs_asn_route_ie_t *ie, int range_bits, uint64_t *value);
+int ogs_asn_route_decode_octet_string(
+        ogs_asn_route_ie_t *ie, uint8_t **buf, size_t *size);
+
 #ifdef __cplusplus
 }
 #endif
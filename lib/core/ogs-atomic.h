@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2019-2024 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#if !defined(OGS_CORE_INSIDE) && !defined(OGS_CORE_COMPILATION)
+#error "This header cannot be included directly."
+#endif
+
+#ifndef OGS_ATOMIC_H
+#define OGS_ATOMIC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Thin wrappers over the GCC/Clang __atomic builtins.
+ *
+ * The project is built as gnu89, so <stdatomic.h> is not available.
+ * The operands are plain integer or pointer lvalues.
+ */
+#if !defined(__GNUC__)
+#error "GCC compatible __atomic builtins are required"
+#endif
+
+#define OGS_ATOMIC_RELAXED  __ATOMIC_RELAXED
+#define OGS_ATOMIC_ACQUIRE  __ATOMIC_ACQUIRE
+#define OGS_ATOMIC_RELEASE  __ATOMIC_RELEASE
+#define OGS_ATOMIC_ACQ_REL  __ATOMIC_ACQ_REL
+#define OGS_ATOMIC_SEQ_CST  __ATOMIC_SEQ_CST
+
+#define ogs_atomic_load(ptr, order) __atomic_load_n(ptr, order)
+#define ogs_atomic_store(ptr, val, order) __atomic_store_n(ptr, val, order)
+#define ogs_atomic_exchange(ptr, val, order) \
+    __atomic_exchange_n(ptr, val, order)
+#define ogs_atomic_fetch_add(ptr, val, order) \
+    __atomic_fetch_add(ptr, val, order)
+#define ogs_atomic_fetch_sub(ptr, val, order) \
+    __atomic_fetch_sub(ptr, val, order)
+
+/* Weak compare-and-swap : *expected is updated on failure */
+#define ogs_atomic_cas(ptr, expected, desired, success, failure) \
+    __atomic_compare_exchange_n(ptr, expected, desired, 1, success, failure)
+
+#define ogs_atomic_fence(order) __atomic_thread_fence(order)
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ogs_cpu_relax() __asm__ __volatile__("pause")
+#elif defined(__aarch64__)
+#define ogs_cpu_relax() __asm__ __volatile__("yield")
+#else
+#define ogs_cpu_relax() do { } while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OGS_ATOMIC_H */
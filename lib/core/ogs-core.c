@@ -34,6 +34,8 @@ static ogs_core_context_t self = {
     .pkbuf.config_pool = 8,
 
     .tlv.pool = 512,
+
+    .mem.arena = true,
 };
 
 void ogs_core_initialize(void)
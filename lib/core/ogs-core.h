@@ -28,6 +28,7 @@
 
 #include "core/ogs-compat.h"
 #include "core/ogs-macros.h"
+#include "core/ogs-atomic.h"
 #include "core/ogs-list.h"
 #include "core/ogs-pool.h"
 #include "core/ogs-abort.h"
@@ -60,6 +61,7 @@
 #include "core/ogs-env.h"
 #include "core/ogs-fsm.h"
 #include "core/ogs-hash.h"
+#include "core/ogs-lpm.h"
 #include "core/ogs-misc.h"
 #include "core/ogs-getopt.h"
 #include "core/ogs-file.h"
@@ -92,6 +94,10 @@ typedef struct {
         int pool;
     } tlv;
 
+    struct {
+        bool arena;     /* Per-thread arenas instead of talloc */
+    } mem;
+
 } ogs_core_context_t;
 
 void ogs_core_initialize(void);
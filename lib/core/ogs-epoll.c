@@ -43,6 +43,8 @@ const ogs_pollset_actions_t ogs_epoll_actions = {
     epoll_process,
 
     ogs_notify_pollset,
+
+    NULL,
 };
 
 struct epoll_map_s {
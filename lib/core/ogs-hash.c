@@ -34,36 +34,341 @@
 
 #include "ogs-core.h"
 
-typedef struct ogs_hash_entry_t ogs_hash_entry_t;
-struct ogs_hash_entry_t {
-    ogs_hash_entry_t    *next;
-    unsigned int        hash;
+/*
+ * Open addressing with groups of 8 control bytes, probed a word at a time.
+ *
+ * A control byte is EMPTY, DELETED, or the top 7 bits of the hash of the
+ * entry in that slot, so most probes are resolved without touching the
+ * entries. When the table grows, the previous one is kept aside and its
+ * entries are moved a few groups at a time on each insertion, so that no
+ * single call rehashes the whole table.
+ */
+
+#define GROUP_WIDTH         8
+#define INITIAL_CAPACITY    16  /* tunable == 2^n, n >= 3 */
+#define MIGRATE_GROUPS      2   /* Groups moved per insertion while growing */
+
+#define CTRL_EMPTY          0x80
+#define CTRL_DELETED        0xfe
+
+#define LSB                 0x0101010101010101ULL
+#define MSB                 0x8080808080808080ULL
+
+typedef struct ogs_hash_entry_t {
     const void          *key;
-    int                 klen;
     const void          *val;
-};
+    int                 klen;
+    unsigned int        hash;
+} ogs_hash_entry_t;
+
+typedef struct hash_table_s {
+    uint8_t             *ctrl;
+    ogs_hash_entry_t    *slot;
+    unsigned int        mask;   /* Capacity - 1 */
+    unsigned int        used;   /* Slots not EMPTY */
+    unsigned int        count;  /* Slots in use */
+} hash_table_t;
 
 struct ogs_hash_index_t {
     ogs_hash_t          *ht;
-    ogs_hash_entry_t    *this, *next;
+    ogs_hash_entry_t    *this;
+    hash_table_t        *table;
     unsigned int        index;
 };
 
 struct ogs_hash_t {
-    ogs_hash_entry_t    **array;
-    ogs_hash_index_t    iterator;  /* For ogs_hash_first(NULL, ...) */
-    unsigned int        count, max, seed;
+    hash_table_t        table;
+    hash_table_t        old;        /* Being moved into table, if ctrl */
+    unsigned int        migrate;    /* Next group of old to move */
+    ogs_hash_index_t    iterator;   /* For ogs_hash_first(NULL, ...) */
+    unsigned int        count;
+    uint64_t            seed;
     ogs_hashfunc_t      hash_func;
-    ogs_hash_entry_t    *free;  /* List of recycled entries */
 };
 
-#define INITIAL_MAX 15 /* tunable == 2^n - 1 */
+static ogs_inline uint64_t load64(const void *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static ogs_inline uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+/* Bit 7 of each byte of the group set where the condition holds */
+static ogs_inline uint64_t group_load(const uint8_t *ctrl)
+{
+    return le64toh(load64(ctrl));
+}
+
+static ogs_inline uint64_t group_match(uint64_t group, uint8_t h2)
+{
+    uint64_t x = group ^ (LSB * h2);
+    return (x - LSB) & ~x & MSB;    /* May have false positives */
+}
+
+static ogs_inline uint64_t group_match_empty(uint64_t group)
+{
+    return group & (~group << 6) & MSB;
+}
+
+static ogs_inline uint64_t group_match_free(uint64_t group)
+{
+    return group & ~(group << 7) & MSB;
+}
+
+static ogs_inline int group_first(uint64_t match)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(match) >> 3;
+#else
+    int i = 0;
+    while (!(match & 0x80)) {
+        match >>= 8;
+        i++;
+    }
+    return i;
+#endif
+}
+
+static ogs_inline unsigned int h1_of(unsigned int hash)
+{
+    return hash;
+}
+
+static ogs_inline uint8_t h2_of(unsigned int hash)
+{
+    return hash >> 25;
+}
+
+static ogs_inline int key_equal(const void *a, const void *b, int klen)
+{
+    switch (klen) {
+    case 4: {
+        uint32_t x, y;
+        memcpy(&x, a, 4);
+        memcpy(&y, b, 4);
+        return x == y;
+    }
+    case 8:
+        return load64(a) == load64(b);
+    case 16:
+        return load64(a) == load64(b) &&
+            load64((const uint8_t *)a + 8) == load64((const uint8_t *)b + 8);
+    default:
+        return memcmp(a, b, klen) == 0;
+    }
+}
+
+#define PRIME1 0x9e3779b185ebca87ULL
+#define PRIME2 0xc2b2ae3d27d4eb4fULL
+
+static ogs_inline uint64_t hash_round(uint64_t h, uint64_t k)
+{
+    k *= PRIME2;
+    k = rotl64(k, 31);
+    k *= PRIME1;
+    h ^= k;
+    return rotl64(h, 27) * PRIME1 + PRIME2;
+}
+
+static ogs_inline unsigned int hash_final(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return (unsigned int)(h ^ (h >> 32));
+}
+
+/* Seeded 64-bit multiply/rotate hash, one round per 8 bytes */
+static unsigned int hashfunc_default(
+        const char *char_key, int *klen, uint64_t seed)
+{
+    const uint8_t *p = (const uint8_t *)char_key;
+    uint64_t h, k;
+    int len;
+
+    if (*klen == OGS_HASH_KEY_STRING)
+        *klen = strlen(char_key);
+    len = *klen;
+
+    h = seed ^ ((uint64_t)len * PRIME1);
+
+    switch (len) {
+    case 4: {
+        uint32_t k32;
+        memcpy(&k32, p, 4);
+        h = hash_round(h, k32);
+        break;
+    }
+    case 8:
+        h = hash_round(h, load64(p));
+        break;
+    case 16:
+        h = hash_round(hash_round(h, load64(p)), load64(p + 8));
+        break;
+    default:
+        for (; len >= 8; len -= 8, p += 8)
+            h = hash_round(h, load64(p));
+        if (len) {
+            k = 0;
+            memcpy(&k, p, len);
+            h = hash_round(h, k);
+        }
+    }
+
+    return hash_final(h);
+}
+
+unsigned int ogs_hashfunc_default(const char *char_key, int *klen)
+{
+    return hashfunc_default(char_key, klen, 0);
+}
+
+static unsigned int hash_of(ogs_hash_t *ht, const void *key, int *klen)
+{
+    if (ht->hash_func)
+        /* Spread a custom hash over the control bits */
+        return hash_final(ht->hash_func(key, klen));
+
+    return hashfunc_default(key, klen, ht->seed);
+}
+
+static void table_alloc(hash_table_t *t, unsigned int capacity)
+{
+    t->ctrl = ogs_malloc(capacity);
+    ogs_assert(t->ctrl);
+    memset(t->ctrl, CTRL_EMPTY, capacity);
+    t->slot = ogs_malloc(sizeof(*t->slot) * capacity);
+    ogs_assert(t->slot);
+    t->mask = capacity - 1;
+    t->used = t->count = 0;
+}
+
+static void table_free(hash_table_t *t)
+{
+    ogs_free(t->ctrl);
+    ogs_free(t->slot);
+    memset(t, 0, sizeof(*t));
+}
+
+/* Triangular probing over the groups visits each of them once */
+#define for_each_group(t, hash, g, i) \
+    for (i = 0, g = h1_of(hash) & ((t)->mask / GROUP_WIDTH); \
+            i <= (t)->mask / GROUP_WIDTH; \
+            i++, g = (g + i) & ((t)->mask / GROUP_WIDTH))
 
-static ogs_hash_entry_t **alloc_array(ogs_hash_t *ht, unsigned int max)
+static ogs_hash_entry_t *table_find(hash_table_t *t,
+        unsigned int hash, const void *key, int klen)
 {
-    ogs_hash_entry_t **ptr = ogs_calloc(1, sizeof(*ht->array) * (max + 1));
-    ogs_assert(ptr);
-    return ptr;
+    unsigned int g, i;
+    uint8_t h2 = h2_of(hash);
+
+    if (!t->ctrl)
+        return NULL;
+
+    for_each_group(t, hash, g, i) {
+        const uint8_t *ctrl = t->ctrl + g * GROUP_WIDTH;
+        uint64_t group = group_load(ctrl);
+        uint64_t match;
+
+        for (match = group_match(group, h2); match; match &= match - 1) {
+            int n = group_first(match);
+            ogs_hash_entry_t *he = &t->slot[g * GROUP_WIDTH + n];
+
+            if (ctrl[n] == h2 && he->hash == hash && he->klen == klen &&
+                key_equal(he->key, key, klen))
+                return he;
+        }
+        if (group_match_empty(group))
+            break;
+    }
+
+    return NULL;
+}
+
+static ogs_hash_entry_t *table_insert(hash_table_t *t, unsigned int hash)
+{
+    unsigned int g, i;
+
+    for_each_group(t, hash, g, i) {
+        uint8_t *ctrl = t->ctrl + g * GROUP_WIDTH;
+        uint64_t match = group_match_free(group_load(ctrl));
+
+        if (match) {
+            int n = group_first(match);
+
+            if (ctrl[n] == CTRL_EMPTY)
+                t->used++;
+            t->count++;
+            ctrl[n] = h2_of(hash);
+
+            return &t->slot[g * GROUP_WIDTH + n];
+        }
+    }
+
+    ogs_assert_if_reached();
+    return NULL;
+}
+
+static void table_delete(hash_table_t *t, ogs_hash_entry_t *he)
+{
+    t->ctrl[he - t->slot] = CTRL_DELETED;
+    t->count--;
+}
+
+static unsigned int table_limit(hash_table_t *t)
+{
+    return (t->mask + 1) - (t->mask + 1) / 8;
+}
+
+static void migrate(ogs_hash_t *ht, unsigned int groups)
+{
+    hash_table_t *old = &ht->old;
+    unsigned int i;
+
+    for (; groups && old->ctrl; groups--) {
+        unsigned int base = ht->migrate * GROUP_WIDTH;
+
+        for (i = base; i < base + GROUP_WIDTH; i++) {
+            ogs_hash_entry_t *he;
+
+            if (old->ctrl[i] & 0x80)
+                continue;
+
+            he = table_insert(&ht->table, old->slot[i].hash);
+            *he = old->slot[i];
+            table_delete(old, &old->slot[i]);
+        }
+
+        if (++ht->migrate > old->mask / GROUP_WIDTH) {
+            ogs_assert(old->count == 0);
+            table_free(old);
+        }
+    }
+}
+
+static void grow(ogs_hash_t *ht)
+{
+    unsigned int capacity = ht->table.mask + 1;
+
+    /* Finish the previous growth first */
+    migrate(ht, ht->old.mask / GROUP_WIDTH + 1);
+
+    /* Mostly deleted slots : rebuild at the same size */
+    if (ht->table.count >= capacity / 2)
+        capacity *= 2;
+
+    ht->old = ht->table;
+    ht->migrate = 0;
+    table_alloc(&ht->table, capacity);
+
+    migrate(ht, MIGRATE_GROUPS);
 }
 
 ogs_hash_t *ogs_hash_make(void)
@@ -71,18 +376,15 @@ ogs_hash_t *ogs_hash_make(void)
     ogs_hash_t *ht;
     ogs_time_t now = ogs_get_monotonic_time();
 
-    ht = ogs_malloc(sizeof(ogs_hash_t));
+    ht = ogs_calloc(1, sizeof(ogs_hash_t));
     if (!ht) {
-        ogs_error("ogs_malloc() failed");
+        ogs_error("ogs_calloc() failed");
         return NULL;
     }
 
-    ht->free = NULL;
-    ht->count = 0;
-    ht->max = INITIAL_MAX;
-    ht->seed = (unsigned int)((now >> 32) ^ now ^ 
-                              (uintptr_t)ht ^ (uintptr_t)&now) - 1;
-    ht->array = alloc_array(ht, ht->max);
+    ht->seed = ((uint64_t)now << 32) ^ now ^
+                (uintptr_t)ht ^ ((uintptr_t)&now << 16);
+    table_alloc(&ht->table, INITIAL_CAPACITY);
     ht->hash_func = NULL;
 
     return ht;
@@ -101,22 +403,12 @@ ogs_hash_t *ogs_hash_make_custom(ogs_hashfunc_t hash_func)
 
 void ogs_hash_destroy(ogs_hash_t *ht)
 {
-    ogs_hash_entry_t *he = NULL, *next_he = NULL;
-
     ogs_assert(ht);
-    ogs_assert(ht->array);
-
-    ogs_hash_clear(ht);
-
-    he = ht->free;
-    while(he) {
-        next_he = he->next;
+    ogs_assert(ht->table.ctrl);
 
-        ogs_free(he);
-        he = next_he;
-    }
-
-    ogs_free(ht->array);
+    if (ht->old.ctrl)
+        table_free(&ht->old);
+    table_free(&ht->table);
     ogs_free(ht);
 }
 
@@ -124,15 +416,33 @@ ogs_hash_index_t *ogs_hash_next(ogs_hash_index_t *hi)
 {
     ogs_assert(hi);
 
-    hi->this = hi->next;
-    while (!hi->this) {
-        if (hi->index > hi->ht->max)
+    for (;;) {
+        hash_table_t *t = hi->table;
+
+        while (t->ctrl && hi->index <= t->mask) {
+            unsigned int i = hi->index;
+
+            /* Skip groups with no entry at once */
+            if (i % GROUP_WIDTH == 0 &&
+                (group_load(t->ctrl + i) & MSB) == MSB) {
+                hi->index += GROUP_WIDTH;
+                continue;
+            }
+
+            hi->index++;
+            if (!(t->ctrl[i] & 0x80)) {
+                hi->this = &t->slot[i];
+                return hi;
+            }
+        }
+
+        if (t == &hi->ht->table)
             return NULL;
 
-        hi->this = hi->ht->array[hi->index++];
+        /* Entries of the table being grown come first */
+        hi->table = &hi->ht->table;
+        hi->index = 0;
     }
-    hi->next = hi->this->next;
-    return hi;
 }
 
 ogs_hash_index_t *ogs_hash_first(ogs_hash_t *ht)
@@ -144,9 +454,9 @@ ogs_hash_index_t *ogs_hash_first(ogs_hash_t *ht)
     hi = &ht->iterator;
 
     hi->ht = ht;
+    hi->table = &ht->old;
     hi->index = 0;
     hi->this = NULL;
-    hi->next = NULL;
     return ogs_hash_next(hi);
 }
 
@@ -184,138 +494,54 @@ void *ogs_hash_this_val(ogs_hash_index_t *hi)
     return val;
 }
 
-static void expand_array(ogs_hash_t *ht)
+static ogs_hash_entry_t *find_entry(ogs_hash_t *ht,
+        unsigned int hash, const void *key, int klen, hash_table_t **t)
 {
-    ogs_hash_index_t *hi;
-    ogs_hash_entry_t **new_array;
-    unsigned int new_max;
-
-    new_max = ht->max * 2 + 1;
-    new_array = alloc_array(ht, new_max);
-    for (hi = ogs_hash_first(ht); hi; hi = ogs_hash_next(hi)) {
-        unsigned int i = hi->this->hash & new_max;
-        hi->this->next = new_array[i];
-        new_array[i] = hi->this;
-    }
-    ogs_free(ht->array);
-    ht->array = new_array;
-    ht->max = new_max;
-}
+    ogs_hash_entry_t *he;
 
-static unsigned int hashfunc_default(
-        const char *char_key, int *klen, unsigned int hash)
-{
-    const unsigned char *key = (const unsigned char *)char_key;
-    const unsigned char *p;
-    int i;
-    
-    /*
-     * This is the popular `times 33' hash algorithm which is used by
-     * perl and also appears in Berkeley DB. This is one of the best
-     * known hash functions for strings because it is both computed
-     * very fast and distributes very well.
-     *
-     * The originator may be Dan Bernstein but the code in Berkeley DB
-     * cites Chris Torek as the source. The best citation I have found
-     * is "Chris Torek, Hash function for text in C, Usenet message
-     * <27038@mimsy.umd.edu> in comp.lang.c , October, 1990." in Rich
-     * Salz's USENIX 1992 paper about INN which can be found at
-     * <http://citeseer.nj.nec.com/salz92internetnews.html>.
-     *
-     * The magic of number 33, i.e. why it works better than many other
-     * constants, prime or not, has never been adequately explained by
-     * anyone. So I try an explanation: if one experimentally tests all
-     * multipliers between 1 and 256 (as I did while writing a low-level
-     * data structure library some time ago) one detects that even
-     * numbers are not useable at all. The remaining 128 odd numbers
-     * (except for the number 1) work more or less all equally well.
-     * They all distribute in an acceptable way and this way fill a hash
-     * table with an average percent of approx. 86%.
-     *
-     * If one compares the chi^2 values of the variants (see
-     * Bob Jenkins ``Hashing Frequently Asked Questions'' at
-     * http://burtleburtle.net/bob/hash/hashfaq.html for a description
-     * of chi^2), the number 33 not even has the best value. But the
-     * number 33 and a few other equally good numbers like 17, 31, 63,
-     * 127 and 129 have nevertheless a great advantage to the remaining
-     * numbers in the large set of possible multipliers: their multiply
-     * operation can be replaced by a faster operation based on just one
-     * shift plus either a single addition or subtraction operation. And
-     * because a hash function has to both distribute good _and_ has to
-     * be very fast to compute, those few numbers should be preferred.
-     *
-     *                  -- Ralf S. Engelschall <rse@engelschall.com>
-     */
-
-    if (*klen == OGS_HASH_KEY_STRING) {
-        for (p = key; *p; p++) {
-            hash = hash * 33 + *p;
-        }
-        *klen = p - key;
-    }
-    else {
-        for (p = key, i = *klen; i; i--, p++) {
-            hash = hash * 33 + *p;
-        }
+    he = table_find(&ht->table, hash, key, klen);
+    if (he) {
+        *t = &ht->table;
+        return he;
     }
 
-    return hash;
-}
+    he = table_find(&ht->old, hash, key, klen);
+    if (he)
+        *t = &ht->old;
 
-unsigned int ogs_hashfunc_default(const char *char_key, int *klen)
-{
-    return hashfunc_default(char_key, klen, 0);
+    return he;
 }
 
-static ogs_hash_entry_t **find_entry(ogs_hash_t *ht,
-        const void *key, int klen, const void *val, const char *file_line)
+static void add_entry(ogs_hash_t *ht,
+        unsigned int hash, const void *key, int klen, const void *val)
 {
-    ogs_hash_entry_t **hep, *he;
-    unsigned int hash;
+    ogs_hash_entry_t *he;
 
-    if (ht->hash_func)
-        hash = ht->hash_func(key, &klen);
-    else
-        hash = hashfunc_default(key, &klen, ht->seed);
-
-    /* scan linked list */
-    for (hep = &ht->array[hash & ht->max], he = *hep;
-         he; hep = &he->next, he = *hep) {
-        if (he->hash == hash
-            && he->klen == klen
-            && memcmp(he->key, key, klen) == 0)
-            break;
-    }
-    if (he || !val)
-        return hep;
-
-    /* add a new entry for non-NULL values */
-    if ((he = ht->free) != NULL)
-        ht->free = he->next;
-    else {
-        he = ogs_malloc(sizeof(*he));
-        ogs_assert(he);
-    }
-    he->next = NULL;
-    he->hash = hash;
-    he->key  = key;
+    migrate(ht, MIGRATE_GROUPS);
+    if (ht->table.used >= table_limit(&ht->table))
+        grow(ht);
+
+    he = table_insert(&ht->table, hash);
+    he->key = key;
     he->klen = klen;
-    he->val  = val;
-    *hep = he;
+    he->val = val;
+    he->hash = hash;
     ht->count++;
-    return hep;
 }
 
 void *ogs_hash_get_debug(ogs_hash_t *ht,
         const void *key, int klen, const char *file_line)
 {
     ogs_hash_entry_t *he;
+    hash_table_t *t;
+    unsigned int hash;
 
     ogs_assert(ht);
     ogs_assert(key);
     ogs_assert(klen);
 
-    he = *find_entry(ht, key, klen, NULL, file_line);
+    hash = hash_of(ht, key, &klen);
+    he = find_entry(ht, hash, key, klen, &t);
     if (he)
         return (void *)he->val;
     else
@@ -325,29 +551,27 @@ void *ogs_hash_get_debug(ogs_hash_t *ht,
 void ogs_hash_set_debug(ogs_hash_t *ht,
         const void *key, int klen, const void *val, const char *file_line)
 {
-    ogs_hash_entry_t **hep;
+    ogs_hash_entry_t *he;
+    hash_table_t *t;
+    unsigned int hash;
 
     ogs_assert(ht);
     ogs_assert(key);
     ogs_assert(klen);
 
-    hep = find_entry(ht, key, klen, val, file_line);
-    if (*hep) {
+    hash = hash_of(ht, key, &klen);
+    he = find_entry(ht, hash, key, klen, &t);
+    if (he) {
         if (!val) {
             /* delete entry */
-            ogs_hash_entry_t *old = *hep;
-            *hep = (*hep)->next;
-            old->next = ht->free;
-            ht->free = old;
+            table_delete(t, he);
             --ht->count;
         } else {
             /* replace entry */
-            (*hep)->val = val;
-            /* check that the collision rate isn't too high */
-            if (ht->count > ht->max) {
-                expand_array(ht);
-            }
+            he->val = val;
         }
+    } else if (val) {
+        add_entry(ht, hash, key, klen, val);
     }
     /* else key not present and val==NULL */
 }
@@ -355,19 +579,21 @@ void ogs_hash_set_debug(ogs_hash_t *ht,
 void *ogs_hash_get_or_set_debug(ogs_hash_t *ht,
         const void *key, int klen, const void *val, const char *file_line)
 {
-    ogs_hash_entry_t **hep;
+    ogs_hash_entry_t *he;
+    hash_table_t *t;
+    unsigned int hash;
 
     ogs_assert(ht);
     ogs_assert(key);
     ogs_assert(klen);
 
-    hep = find_entry(ht, key, klen, val, file_line);
-    if (*hep) {
-        val = (*hep)->val;
-        /* check that the collision rate isn't too high */
-        if (ht->count > ht->max) {
-            expand_array(ht);
-        }
+    hash = hash_of(ht, key, &klen);
+    he = find_entry(ht, hash, key, klen, &t);
+    if (he)
+        return (void *)he->val;
+
+    if (val) {
+        add_entry(ht, hash, key, klen, val);
         return (void *)val;
     }
     /* else key not present and val==NULL */
@@ -382,12 +608,14 @@ unsigned int ogs_hash_count(ogs_hash_t *ht)
 
 void ogs_hash_clear(ogs_hash_t *ht)
 {
-    ogs_hash_index_t *hi;
-
     ogs_assert(ht);
 
-    for (hi = ogs_hash_first(ht); hi; hi = ogs_hash_next(hi))
-        ogs_hash_set(ht, hi->this->key, hi->this->klen, NULL);
+    if (ht->old.ctrl)
+        table_free(&ht->old);
+
+    memset(ht->table.ctrl, CTRL_EMPTY, ht->table.mask + 1);
+    ht->table.used = ht->table.count = 0;
+    ht->count = 0;
 }
 
 /* This is basically the following...
@@ -406,9 +634,9 @@ int ogs_hash_do(ogs_hash_do_callback_fn_t *comp,
     int rv, dorv  = 1;
 
     hix.ht    = (ogs_hash_t *)ht;
+    hix.table = &hix.ht->old;
     hix.index = 0;
     hix.this  = NULL;
-    hix.next  = NULL;
 
     if ((hi = ogs_hash_next(&hix))) {
         /* Scan the entire table */
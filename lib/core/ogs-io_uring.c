@@ -0,0 +1,880 @@
+/*
+ * Copyright (C) 2019-2024 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "core-config-private.h"
+
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <endian.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "ogs-core.h"
+#include "ogs-poll-private.h"
+
+#ifndef POLLRDHUP
+#define POLLRDHUP 0x2000
+#endif
+
+/* Not in the headers older than Linux 6.7 */
+#define URING_OP_READ_MULTISHOT     49
+
+#define URING_SQ_ENTRIES            256
+
+/* Buffers registered with the kernel for each receiving fd */
+#define URING_RECV_ENTRIES          64
+
+/*
+ * A multishot recvmsg(2) writes 'struct io_uring_recvmsg_out' and the
+ * source address in front of the payload. They go into the headroom.
+ */
+#define URING_RECV_NAMELEN          sizeof(struct sockaddr_in6)
+#define URING_RECV_META \
+    (sizeof(struct io_uring_recvmsg_out) + URING_RECV_NAMELEN)
+
+/*
+ * user_data of a submission :
+ * - poll   : generation << 32 | pool index << 2
+ * - recv   : uring_recv_t pointer | 1
+ * - ignore : 2, for the removal and the cancellation
+ */
+#define UD_POLL                     0
+#define UD_RECV                     1
+#define UD_IGNORE                   2
+#define UD_KIND(__uD)               ((__uD) & 3)
+
+static void uring_init(ogs_pollset_t *pollset);
+static void uring_cleanup(ogs_pollset_t *pollset);
+static int uring_add(ogs_poll_t *poll);
+static int uring_remove(ogs_poll_t *poll);
+static int uring_process(ogs_pollset_t *pollset, ogs_time_t timeout);
+static int uring_add_recv(ogs_poll_t *poll);
+
+const ogs_pollset_actions_t ogs_io_uring_actions = {
+    uring_init,
+    uring_cleanup,
+
+    uring_add,
+    uring_remove,
+    uring_process,
+
+    ogs_notify_pollset,
+
+    uring_add_recv,
+};
+
+typedef struct uring_recv_s {
+    ogs_lnode_t lnode;
+
+    ogs_poll_t *poll;               /* NULL once removed */
+    ogs_socket_t fd;
+    bool socket;
+    unsigned int headroom;
+
+    struct msghdr msg;              /* Read by the kernel while armed */
+
+    uint16_t bgid;
+    struct io_uring_buf_ring *ring;
+    uint16_t tail;
+    ogs_pkbuf_t *pkbuf[URING_RECV_ENTRIES];     /* By buffer ID */
+    int missing;                    /* Buffer IDs not in the ring */
+
+    bool armed;
+    bool received;
+    bool unsupported;
+
+    int num;
+    ogs_pkbuf_t *batch[OGS_POLL_RECV_BATCH];
+    ogs_sockaddr_t from[OGS_POLL_RECV_BATCH];
+} uring_recv_t;
+
+struct uring_context_s {
+    int fd;
+
+    struct {
+        unsigned int *head;
+        unsigned int *tail;
+        unsigned int *mask;
+        unsigned int entries;
+        unsigned int local_tail;
+        struct io_uring_sqe *sqes;
+    } sq;
+
+    struct {
+        unsigned int *head;
+        unsigned int *tail;
+        unsigned int *mask;
+        unsigned int entries;
+        struct io_uring_cqe *cqes;
+    } cq;
+
+    void *sq_ptr, *cq_ptr;
+    size_t sq_size, cq_size, sqes_size;
+
+    /* By pool index of the poll */
+    uint32_t *gen;
+    bool *armed;
+
+    ogs_list_t recv_list;
+    uint16_t next_bgid;
+    bool read_multishot;
+};
+
+static int uring_setup(unsigned int entries, struct io_uring_params *p)
+{
+    int fd;
+
+    /* COOP_TASKRUN is Linux 5.19 or later */
+    p->flags |= IORING_SETUP_COOP_TASKRUN;
+    fd = syscall(__NR_io_uring_setup, entries, p);
+    if (fd < 0 && errno == EINVAL) {
+        p->flags &= ~IORING_SETUP_COOP_TASKRUN;
+        fd = syscall(__NR_io_uring_setup, entries, p);
+    }
+
+    return fd;
+}
+
+bool ogs_io_uring_probe(void)
+{
+    struct io_uring_params p;
+    int fd;
+
+    memset(&p, 0, sizeof(p));
+    fd = uring_setup(4, &p);
+    if (fd < 0) {
+        ogs_log_message(OGS_LOG_WARN, ogs_errno, "io_uring_setup() failed");
+        return false;
+    }
+    close(fd);
+
+    /*
+     * EXT_ARG is Linux 5.11 : poll with a timeout.
+     * NODROP keeps the completions when the ring overflows.
+     */
+    if ((p.features & (IORING_FEAT_EXT_ARG|IORING_FEAT_NODROP)) !=
+            (IORING_FEAT_EXT_ARG|IORING_FEAT_NODROP)) {
+        ogs_warn("io_uring is too old [features:0x%x]", p.features);
+        return false;
+    }
+
+    return true;
+}
+
+static void uring_probe_ops(struct uring_context_s *context)
+{
+    struct io_uring_probe *probe = NULL;
+    size_t len = sizeof(*probe) + 256 * sizeof(struct io_uring_probe_op);
+
+    probe = ogs_calloc(1, len);
+    ogs_assert(probe);
+
+    if (syscall(__NR_io_uring_register, context->fd,
+                IORING_REGISTER_PROBE, probe, 256) == 0 &&
+        probe->last_op >= URING_OP_READ_MULTISHOT &&
+        (probe->ops[URING_OP_READ_MULTISHOT].flags & IO_URING_OP_SUPPORTED))
+        context->read_multishot = true;
+
+    ogs_free(probe);
+}
+
+static void uring_init(ogs_pollset_t *pollset)
+{
+    struct uring_context_s *context = NULL;
+    struct io_uring_params p;
+    unsigned int *array = NULL;
+    unsigned int i;
+
+    ogs_assert(pollset);
+
+    context = ogs_calloc(1, sizeof *context);
+    ogs_assert(context);
+    pollset->context = context;
+
+    context->gen = ogs_calloc(pollset->capacity + 1, sizeof(uint32_t));
+    ogs_assert(context->gen);
+    context->armed = ogs_calloc(pollset->capacity + 1, sizeof(bool));
+    ogs_assert(context->armed);
+
+    memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_CQSIZE;
+    p.cq_entries = ogs_max(pollset->capacity * 2, URING_SQ_ENTRIES * 2);
+
+    context->fd = uring_setup(URING_SQ_ENTRIES, &p);
+    if (context->fd < 0) {
+        ogs_log_message(OGS_LOG_FATAL, ogs_errno,
+                "io_uring_setup() failed [%d]", pollset->capacity);
+        ogs_assert_if_reached();
+        return;
+    }
+
+    context->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+    context->cq_size = p.cq_off.cqes +
+        p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+        context->sq_size = context->cq_size =
+            ogs_max(context->sq_size, context->cq_size);
+
+    context->sq_ptr = mmap(NULL, context->sq_size, PROT_READ|PROT_WRITE,
+            MAP_SHARED|MAP_POPULATE, context->fd, IORING_OFF_SQ_RING);
+    ogs_assert(context->sq_ptr != MAP_FAILED);
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        context->cq_ptr = context->sq_ptr;
+    } else {
+        context->cq_ptr = mmap(NULL, context->cq_size, PROT_READ|PROT_WRITE,
+                MAP_SHARED|MAP_POPULATE, context->fd, IORING_OFF_CQ_RING);
+        ogs_assert(context->cq_ptr != MAP_FAILED);
+    }
+
+    context->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    context->sq.sqes = mmap(NULL, context->sqes_size, PROT_READ|PROT_WRITE,
+            MAP_SHARED|MAP_POPULATE, context->fd, IORING_OFF_SQES);
+    ogs_assert(context->sq.sqes != MAP_FAILED);
+
+    context->sq.head = (unsigned int *)
+        ((char *)context->sq_ptr + p.sq_off.head);
+    context->sq.tail = (unsigned int *)
+        ((char *)context->sq_ptr + p.sq_off.tail);
+    context->sq.mask = (unsigned int *)
+        ((char *)context->sq_ptr + p.sq_off.ring_mask);
+    context->sq.entries = p.sq_entries;
+    context->sq.local_tail = *context->sq.tail;
+
+    /* The submission queue entries are used in ring order */
+    array = (unsigned int *)((char *)context->sq_ptr + p.sq_off.array);
+    for (i = 0; i < p.sq_entries; i++)
+        array[i] = i;
+
+    context->cq.head = (unsigned int *)
+        ((char *)context->cq_ptr + p.cq_off.head);
+    context->cq.tail = (unsigned int *)
+        ((char *)context->cq_ptr + p.cq_off.tail);
+    context->cq.mask = (unsigned int *)
+        ((char *)context->cq_ptr + p.cq_off.ring_mask);
+    context->cq.entries = p.cq_entries;
+    context->cq.cqes = (struct io_uring_cqe *)
+        ((char *)context->cq_ptr + p.cq_off.cqes);
+
+    ogs_list_init(&context->recv_list);
+    uring_probe_ops(context);
+
+    ogs_notify_init(pollset);
+}
+
+static int uring_enter(struct uring_context_s *context,
+        unsigned int min_complete, unsigned int flags,
+        struct io_uring_getevents_arg *arg)
+{
+    unsigned int submit;
+
+    ogs_atomic_store(context->sq.tail,
+            context->sq.local_tail, OGS_ATOMIC_RELEASE);
+    submit = context->sq.local_tail -
+        ogs_atomic_load(context->sq.head, OGS_ATOMIC_ACQUIRE);
+
+    if (arg)
+        flags |= IORING_ENTER_EXT_ARG;
+
+    return syscall(__NR_io_uring_enter, context->fd, submit, min_complete,
+            flags, arg, arg ? sizeof(*arg) : 0);
+}
+
+static struct io_uring_sqe *uring_get_sqe(struct uring_context_s *context)
+{
+    struct io_uring_sqe *sqe = NULL;
+
+    if (context->sq.local_tail -
+            ogs_atomic_load(context->sq.head, OGS_ATOMIC_ACQUIRE) >=
+            context->sq.entries) {
+        if (uring_enter(context, 0, 0, NULL) < 0)
+            ogs_log_message(OGS_LOG_ERROR, ogs_errno,
+                    "io_uring_enter() failed");
+        if (context->sq.local_tail -
+                ogs_atomic_load(context->sq.head, OGS_ATOMIC_ACQUIRE) >=
+                context->sq.entries) {
+            ogs_error("io_uring submission queue is full");
+            return NULL;
+        }
+    }
+
+    sqe = &context->sq.sqes[context->sq.local_tail & *context->sq.mask];
+    context->sq.local_tail++;
+
+    memset(sqe, 0, sizeof(*sqe));
+
+    return sqe;
+}
+
+static uint64_t poll_user_data(
+        struct uring_context_s *context, ogs_poll_t *poll)
+{
+    uint64_t index = ogs_pool_index(&poll->pollset->pool, poll);
+
+    return ((uint64_t)context->gen[index] << 32) | (index << 2) | UD_POLL;
+}
+
+/*
+ * One-shot poll, armed again after the handler : it reports the fd
+ * as long as it stays ready, like the level-triggered epoll.
+ */
+static int uring_arm_poll(struct uring_context_s *context, ogs_poll_t *poll)
+{
+    struct io_uring_sqe *sqe = NULL;
+    uint32_t mask = 0;
+
+    sqe = uring_get_sqe(context);
+    if (!sqe)
+        return OGS_ERROR;
+
+    if (poll->when & OGS_POLLIN)
+        mask |= POLLIN|POLLRDHUP;
+    if (poll->when & OGS_POLLOUT)
+        mask |= POLLOUT;
+#if __BYTE_ORDER == __BIG_ENDIAN
+    mask = (mask << 16) | (mask >> 16);
+#endif
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = poll->fd;
+    sqe->poll32_events = mask;
+    sqe->user_data = poll_user_data(context, poll);
+
+    context->armed[ogs_pool_index(&poll->pollset->pool, poll)] = true;
+
+    return OGS_OK;
+}
+
+static int uring_add(ogs_poll_t *poll)
+{
+    ogs_pollset_t *pollset = NULL;
+    struct uring_context_s *context = NULL;
+
+    ogs_assert(poll);
+    pollset = poll->pollset;
+    ogs_assert(pollset);
+    context = pollset->context;
+    ogs_assert(context);
+
+    context->gen[ogs_pool_index(&pollset->pool, poll)]++;
+
+    return uring_arm_poll(context, poll);
+}
+
+static void recv_destroy(struct uring_context_s *context, uring_recv_t *rc)
+{
+    struct io_uring_buf_reg reg;
+    int i;
+
+    memset(&reg, 0, sizeof(reg));
+    reg.bgid = rc->bgid;
+    if (syscall(__NR_io_uring_register, context->fd,
+                IORING_UNREGISTER_PBUF_RING, &reg, 1) < 0)
+        ogs_log_message(OGS_LOG_ERROR, ogs_errno,
+                "IORING_UNREGISTER_PBUF_RING failed");
+    munmap(rc->ring, URING_RECV_ENTRIES * sizeof(struct io_uring_buf));
+
+    for (i = 0; i < URING_RECV_ENTRIES; i++)
+        if (rc->pkbuf[i])
+            ogs_pkbuf_free(rc->pkbuf[i]);
+    for (i = 0; i < rc->num; i++)
+        ogs_pkbuf_free(rc->batch[i]);
+
+    ogs_list_remove(&context->recv_list, rc);
+    ogs_free(rc);
+}
+
+static int uring_remove(ogs_poll_t *poll)
+{
+    ogs_pollset_t *pollset = NULL;
+    struct uring_context_s *context = NULL;
+    struct io_uring_sqe *sqe = NULL;
+    uring_recv_t *rc = NULL;
+    int index;
+
+    ogs_assert(poll);
+    pollset = poll->pollset;
+    ogs_assert(pollset);
+    context = pollset->context;
+    ogs_assert(context);
+
+    rc = poll->recv.context;
+    if (rc) {
+        /* Released once the kernel is done with its buffers */
+        rc->poll = NULL;
+        poll->recv.context = NULL;
+
+        if (rc->armed) {
+            sqe = uring_get_sqe(context);
+            if (!sqe)
+                return OGS_ERROR;
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            sqe->addr = (uintptr_t)rc | UD_RECV;
+            sqe->user_data = UD_IGNORE;
+        }
+        return OGS_OK;
+    }
+
+    index = ogs_pool_index(&pollset->pool, poll);
+
+    if (context->armed[index]) {
+        sqe = uring_get_sqe(context);
+        if (!sqe)
+            return OGS_ERROR;
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->addr = poll_user_data(context, poll);
+        sqe->user_data = UD_IGNORE;
+        context->armed[index] = false;
+    }
+
+    /* A completion already queued for this poll is ignored */
+    context->gen[index]++;
+
+    return OGS_OK;
+}
+
+static void recv_push(uring_recv_t *rc, uint16_t bid)
+{
+    ogs_pkbuf_t *pkbuf = rc->pkbuf[bid];
+    struct io_uring_buf *buf = NULL;
+    unsigned char *addr = pkbuf->data;
+
+    if (rc->socket)
+        addr -= URING_RECV_META;
+
+    /* Only addr/len/bid : the ring tail overlays 'resv' of the first */
+    buf = &rc->ring->bufs[rc->tail & (URING_RECV_ENTRIES - 1)];
+    buf->addr = (uintptr_t)addr;
+    buf->len = pkbuf->end - addr;
+    buf->bid = bid;
+    rc->tail++;
+}
+
+static bool recv_fill(uring_recv_t *rc, uint16_t bid)
+{
+    ogs_poll_t *poll = rc->poll;
+    ogs_pkbuf_t *pkbuf = NULL;
+
+    pkbuf = ogs_pkbuf_alloc(poll->recv.pool, poll->recv.size);
+    if (!pkbuf)
+        return false;
+    ogs_pkbuf_reserve(pkbuf, rc->headroom);
+
+    rc->pkbuf[bid] = pkbuf;
+    recv_push(rc, bid);
+
+    return true;
+}
+
+static void recv_refill(uring_recv_t *rc)
+{
+    int i;
+
+    for (i = 0; rc->missing && i < URING_RECV_ENTRIES; i++) {
+        if (rc->pkbuf[i])
+            continue;
+        if (recv_fill(rc, i) == false)
+            break;
+        rc->missing--;
+    }
+
+    ogs_atomic_store(&rc->ring->tail, rc->tail, OGS_ATOMIC_RELEASE);
+}
+
+static int recv_arm(struct uring_context_s *context, uring_recv_t *rc)
+{
+    struct io_uring_sqe *sqe = NULL;
+
+    sqe = uring_get_sqe(context);
+    if (!sqe)
+        return OGS_ERROR;
+
+    if (rc->socket) {
+        sqe->opcode = IORING_OP_RECVMSG;
+        sqe->addr = (uintptr_t)&rc->msg;
+        sqe->len = 1;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+    } else {
+        sqe->opcode = URING_OP_READ_MULTISHOT;
+    }
+    sqe->fd = rc->fd;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = rc->bgid;
+    sqe->user_data = (uintptr_t)rc | UD_RECV;
+
+    rc->armed = true;
+
+    return OGS_OK;
+}
+
+static int uring_add_recv(ogs_poll_t *poll)
+{
+    ogs_pollset_t *pollset = NULL;
+    struct uring_context_s *context = NULL;
+    struct io_uring_buf_reg reg;
+    uring_recv_t *rc = NULL;
+    int i;
+
+    ogs_assert(poll);
+    pollset = poll->pollset;
+    ogs_assert(pollset);
+    context = pollset->context;
+    ogs_assert(context);
+
+    /* Without the multishot read, a TUN device is read when ready */
+    if (!poll->recv.socket && !context->read_multishot)
+        return uring_add(poll);
+
+    rc = ogs_calloc(1, sizeof(*rc));
+    if (!rc) {
+        ogs_error("ogs_calloc() failed");
+        return OGS_ERROR;
+    }
+
+    rc->poll = poll;
+    rc->fd = poll->fd;
+    rc->socket = poll->recv.socket;
+    rc->headroom = poll->recv.headroom;
+    if (rc->socket) {
+        rc->headroom = ogs_max(rc->headroom, URING_RECV_META);
+        rc->msg.msg_namelen = URING_RECV_NAMELEN;
+    }
+    ogs_assert(poll->recv.size > rc->headroom);
+
+    rc->ring = mmap(NULL, URING_RECV_ENTRIES * sizeof(struct io_uring_buf),
+            PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (rc->ring == MAP_FAILED) {
+        ogs_log_message(OGS_LOG_ERROR, ogs_errno, "mmap() failed");
+        ogs_free(rc);
+        return OGS_ERROR;
+    }
+
+    rc->bgid = context->next_bgid++;
+
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uintptr_t)rc->ring;
+    reg.ring_entries = URING_RECV_ENTRIES;
+    reg.bgid = rc->bgid;
+    if (syscall(__NR_io_uring_register, context->fd,
+                IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        /* Linux 5.19 or later : otherwise, read when ready */
+        ogs_log_message(OGS_LOG_WARN, ogs_errno,
+                "IORING_REGISTER_PBUF_RING failed");
+        munmap(rc->ring, URING_RECV_ENTRIES * sizeof(struct io_uring_buf));
+        ogs_free(rc);
+        return uring_add(poll);
+    }
+
+    ogs_list_add(&context->recv_list, rc);
+    poll->recv.context = rc;
+
+    rc->missing = URING_RECV_ENTRIES;
+    recv_refill(rc);
+    if (rc->missing == URING_RECV_ENTRIES) {
+        ogs_error("No receive buffer");
+        poll->recv.context = NULL;
+        recv_destroy(context, rc);
+        return OGS_ERROR;
+    }
+
+    for (i = 0; i < OGS_POLL_RECV_BATCH; i++)
+        rc->from[i].ogs_sa_family = AF_UNSPEC;
+
+    return recv_arm(context, rc);
+}
+
+static void recv_flush(uring_recv_t *rc)
+{
+    ogs_pkbuf_t *batch[OGS_POLL_RECV_BATCH];
+    ogs_sockaddr_t from[OGS_POLL_RECV_BATCH];
+    ogs_poll_t *poll = rc->poll;
+    int i, num = rc->num;
+
+    if (!num)
+        return;
+    rc->num = 0;
+
+    if (!poll) {
+        for (i = 0; i < num; i++)
+            ogs_pkbuf_free(rc->batch[i]);
+        return;
+    }
+
+    /* The handler may remove the poll */
+    memcpy(batch, rc->batch, num * sizeof(batch[0]));
+    if (rc->socket)
+        memcpy(from, rc->from, num * sizeof(from[0]));
+
+    poll->recv.handler(poll->fd, batch,
+            rc->socket ? from : NULL, num, poll->recv.data);
+}
+
+static void recv_complete(uring_recv_t *rc, int res, uint32_t flags)
+{
+    uint16_t bid = flags >> IORING_CQE_BUFFER_SHIFT;
+    ogs_pkbuf_t *pkbuf = NULL;
+
+    ogs_assert(bid < URING_RECV_ENTRIES);
+    pkbuf = rc->pkbuf[bid];
+    ogs_assert(pkbuf);
+    rc->pkbuf[bid] = NULL;
+
+    if (!rc->poll || recv_fill(rc, bid) == false)
+        rc->missing++;
+
+    if (!rc->poll) {
+        ogs_pkbuf_free(pkbuf);
+        return;
+    }
+
+    if (rc->socket) {
+        struct io_uring_recvmsg_out *out = (struct io_uring_recvmsg_out *)
+            (pkbuf->data - URING_RECV_META);
+
+        if (out->flags & MSG_TRUNC) {
+            ogs_error("Truncated [%d]", out->payloadlen);
+            ogs_pkbuf_free(pkbuf);
+            return;
+        }
+
+        memset(&rc->from[rc->num], 0, sizeof(rc->from[rc->num]));
+        memcpy(&rc->from[rc->num], out + 1,
+                ogs_min(out->namelen, URING_RECV_NAMELEN));
+        ogs_pkbuf_put(pkbuf, out->payloadlen);
+    } else {
+        ogs_pkbuf_put(pkbuf, res);
+    }
+
+    rc->received = true;
+    rc->batch[rc->num++] = pkbuf;
+    if (rc->num == OGS_POLL_RECV_BATCH)
+        recv_flush(rc);
+}
+
+static void dispatch_recv(ogs_pollset_t *pollset,
+        uring_recv_t *rc, int res, uint32_t flags)
+{
+    if (res >= 0 && (flags & IORING_CQE_F_BUFFER)) {
+        recv_complete(rc, res, flags);
+    } else if (res == -EINVAL && !rc->received) {
+        /* Multishot receive is Linux 6.0 or later */
+        rc->unsupported = true;
+    } else if (res < 0 && res != -ENOBUFS && res != -ECANCELED) {
+        ogs_log_message(OGS_LOG_ERROR, -res, "recv(%d) failed", rc->fd);
+    }
+
+    if (!(flags & IORING_CQE_F_MORE)) {
+        rc->armed = false;
+
+        /* Read when ready from now on */
+        if (rc->unsupported && rc->poll) {
+            ogs_poll_t *poll = rc->poll;
+
+            ogs_warn("Multishot receive is not supported");
+            recv_flush(rc);
+            if (rc->poll) {
+                rc->poll = NULL;
+                poll->recv.context = NULL;
+                ogs_expect(uring_add(poll) == OGS_OK);
+            }
+        }
+    }
+}
+
+static void dispatch_poll(ogs_pollset_t *pollset, uint64_t ud, int res)
+{
+    struct uring_context_s *context = pollset->context;
+    uint32_t index = (ud >> 2) & 0x3fffffff;
+    uint32_t gen = ud >> 32;
+    ogs_poll_t *poll = NULL;
+    short when = 0;
+
+    poll = ogs_pool_find(&pollset->pool, index);
+    if (!poll || context->gen[index] != gen)
+        return;
+
+    context->armed[index] = false;
+
+    if (res < 0) {
+        ogs_log_message(OGS_LOG_ERROR, -res, "poll(%d) failed", poll->fd);
+        return;
+    }
+
+    if (res & POLLERR) {
+        when = OGS_POLLIN|OGS_POLLOUT;
+    } else if ((res & POLLHUP) && !(res & POLLRDHUP)) {
+        when = OGS_POLLIN|OGS_POLLOUT;
+    } else {
+        if (res & POLLIN)
+            when |= OGS_POLLIN;
+        if (res & POLLOUT)
+            when |= OGS_POLLOUT;
+        if (res & POLLRDHUP) {
+            when |= OGS_POLLIN;
+            when &= ~OGS_POLLOUT;
+        }
+    }
+    when &= poll->when;
+
+    if (when)
+        poll->handler(when, poll->fd, poll->data);
+
+    /* Unless the handler removed it */
+    if (context->gen[index] == gen && !context->armed[index])
+        ogs_expect(uring_arm_poll(context, poll) == OGS_OK);
+}
+
+static int uring_reap(ogs_pollset_t *pollset)
+{
+    struct uring_context_s *context = pollset->context;
+    uring_recv_t *rc = NULL, *next_rc = NULL;
+    unsigned int head, tail;
+    int n = 0;
+
+    head = *context->cq.head;
+    tail = ogs_atomic_load(context->cq.tail, OGS_ATOMIC_ACQUIRE);
+
+    /* No more than a ring at a time : the handlers may add some */
+    while (head != tail && n < (int)context->cq.entries) {
+        struct io_uring_cqe *cqe =
+            &context->cq.cqes[head & *context->cq.mask];
+        uint64_t ud = cqe->user_data;
+        int res = cqe->res;
+        uint32_t flags = cqe->flags;
+
+        head++;
+        ogs_atomic_store(context->cq.head, head, OGS_ATOMIC_RELEASE);
+        n++;
+
+        if (UD_KIND(ud) == UD_POLL)
+            dispatch_poll(pollset, ud, res);
+        else if (UD_KIND(ud) == UD_RECV)
+            dispatch_recv(pollset, (uring_recv_t *)(uintptr_t)(ud & ~3ULL),
+                    res, flags);
+
+        if (head == tail)
+            tail = ogs_atomic_load(context->cq.tail, OGS_ATOMIC_ACQUIRE);
+    }
+
+    ogs_list_for_each_safe(&context->recv_list, next_rc, rc)
+        recv_flush(rc);
+
+    return n;
+}
+
+/* Releases the removed receivers and re-arms the ones out of buffers */
+static void uring_sweep(ogs_pollset_t *pollset)
+{
+    struct uring_context_s *context = pollset->context;
+    uring_recv_t *rc = NULL, *next_rc = NULL;
+
+    ogs_list_for_each_safe(&context->recv_list, next_rc, rc) {
+        if (rc->armed)
+            continue;
+
+        if (!rc->poll || rc->unsupported) {
+            recv_destroy(context, rc);
+            continue;
+        }
+
+        recv_refill(rc);
+        if (rc->missing < URING_RECV_ENTRIES)
+            ogs_expect(recv_arm(context, rc) == OGS_OK);
+    }
+
+    ogs_list_for_each(&context->recv_list, rc) {
+        if (rc->poll && rc->missing)
+            recv_refill(rc);
+    }
+}
+
+static int uring_process(ogs_pollset_t *pollset, ogs_time_t timeout)
+{
+    struct uring_context_s *context = NULL;
+    struct io_uring_getevents_arg arg;
+    struct __kernel_timespec ts;
+    int rv, n;
+
+    ogs_assert(pollset);
+    context = pollset->context;
+    ogs_assert(context);
+
+    memset(&arg, 0, sizeof(arg));
+    if (timeout != OGS_INFINITE_TIME) {
+        ts.tv_sec = ogs_time_sec(timeout);
+        ts.tv_nsec = ogs_time_usec(timeout) * 1000;
+        arg.ts = (uintptr_t)&ts;
+    }
+
+    rv = uring_enter(context, 1, IORING_ENTER_GETEVENTS, &arg);
+    if (rv < 0 && errno != ETIME) {
+        ogs_log_message(OGS_LOG_ERROR, ogs_errno, "io_uring_enter() failed");
+        return OGS_ERROR;
+    }
+
+    n = uring_reap(pollset);
+    uring_sweep(pollset);
+
+    /* Submit the re-armed polls before running the timers and events */
+    if (context->sq.local_tail !=
+            ogs_atomic_load(context->sq.head, OGS_ATOMIC_ACQUIRE) &&
+        uring_enter(context, 0, 0, NULL) < 0)
+        ogs_log_message(OGS_LOG_ERROR, ogs_errno, "io_uring_enter() failed");
+
+    return n ? OGS_OK : OGS_TIMEUP;
+}
+
+static void uring_cleanup(ogs_pollset_t *pollset)
+{
+    struct uring_context_s *context = NULL;
+    uring_recv_t *rc = NULL;
+    int i;
+
+    ogs_assert(pollset);
+    context = pollset->context;
+    ogs_assert(context);
+
+    ogs_notify_final(pollset);
+
+    /* The kernel may write into the buffers until cancelled */
+    for (i = 0; i < 100 && ogs_list_first(&context->recv_list); i++) {
+        ogs_list_for_each(&context->recv_list, rc) {
+            if (rc->poll) {
+                ogs_warn("Receiver [%d] is not removed", rc->fd);
+                ogs_pollset_remove(rc->poll);
+            }
+        }
+        uring_process(pollset, ogs_time_from_msec(10));
+    }
+    ogs_assert(ogs_list_first(&context->recv_list) == NULL);
+
+    munmap(context->sq.sqes, context->sqes_size);
+    if (context->cq_ptr != context->sq_ptr)
+        munmap(context->cq_ptr, context->cq_size);
+    munmap(context->sq_ptr, context->sq_size);
+    close(context->fd);
+
+    ogs_free(context->armed);
+    ogs_free(context->gen);
+    ogs_free(context);
+}
@@ -27,6 +27,14 @@
 #include <stdarg.h>
 #endif
 
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#if HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+
 #include "ogs-core.h"
 
 #define TA_NOR              "\033[0m"       /* all off */
@@ -82,8 +90,86 @@ typedef struct ogs_log_domain_s {
     int id;
     ogs_log_level_e level;
     const char *name;
+
+    /* At most 'rate' messages per second, 0 for no limit */
+    unsigned int rate;
+    long window;
+    unsigned int count;
+    unsigned long dropped;
 } ogs_log_domain_t;
 
+/*
+ * Asynchronous mode
+ *
+ * The calling thread only formats the message content and copies it,
+ * with the location and the timestamp, into a ring of its own. A writer
+ * thread drains all the rings, adds the timestamp, domain, level and
+ * location for each log target and writes them out in batches. It also
+ * reopens the files on ogs_log_cycle().
+ *
+ * Each ring has a single producer and a single consumer, so neither side
+ * takes a lock. A message is dropped when the ring of its thread is full.
+ * FATAL messages are always written synchronously, as an abort follows,
+ * once the rings are drained so that the messages before them come first.
+ *
+ * ogs_log_async_stop() waits for the threads still pushing a message
+ * before it frees the rings; they fall back to synchronous writes.
+ *
+ * Messages of different threads may be written slightly out of order.
+ */
+#define LOG_RING_SIZE       (256*1024)
+#define LOG_WRITER_INTERVAL ogs_time_from_msec(50)
+
+#define LOG_RECORD_PAD      0xff
+#define LOG_BATCH_IOV       256
+
+typedef struct log_record_s {
+    uint32_t size;          /* Whole record, a multiple of 8 */
+    uint8_t level;          /* LOG_RECORD_PAD up to the end of the ring */
+    uint8_t content_only;
+    int line;
+    ogs_err_t err;
+    struct timeval tv;
+    const char *domain;
+    const char *file;
+    const char *func;
+    char content[];
+} log_record_t;
+
+typedef struct log_ring_s {
+    struct log_ring_s *next;
+    char *buf;
+
+    char pad0[64];
+    size_t head;            /* Written by the writer thread */
+    char pad1[64];
+    size_t tail;            /* Written by the owner thread */
+} log_ring_t;
+
+static struct {
+    int running;
+    int producers;          /* Threads between async_enter/leave() */
+    unsigned int generation;
+
+    ogs_thread_t *thread;
+    ogs_thread_mutex_t drain;   /* The rings and 'batch' have one reader */
+    ogs_thread_mutex_t mutex;
+    ogs_thread_cond_t cond;
+    int sleeping;
+    int cycle;
+    int stop;
+
+    log_ring_t *ring_list;
+
+    unsigned long dropped;  /* Rate limited or ring full */
+    unsigned long reported;
+} async;
+
+static OGS_THREAD_LOCAL struct {
+    log_ring_t *ring;
+    unsigned int generation;
+} thread_ring;
+
 const char *level_strings[] = {
     NULL,
     "FATAL", "ERROR", "WARNING", "INFO", "DEBUG", "TRACE",
@@ -95,11 +181,14 @@ static OGS_LIST(log_list);
 static OGS_POOL(domain_pool, ogs_log_domain_t);
 static OGS_LIST(domain_list);
 
+/* Applied to the domains added later on as well */
+static unsigned int default_rate;
+
 static ogs_log_t *add_log(ogs_log_type_e type);
 static int file_cycle(ogs_log_t *log);
 
 static char *log_timestamp(char *buf, char *last,
-        int use_color);
+        const struct timeval *tv, int use_color);
 static char *log_domain(char *buf, char *last,
         const char *name, int use_color);
 static char *log_content(char *buf, char *last,
@@ -111,11 +200,23 @@ static char *log_linefeed(char *buf, char *last);
 static void file_writer(
         ogs_log_t *log, ogs_log_level_e level, const char *string);
 
+static int rate_limited(ogs_log_domain_t *domain, ogs_log_level_e level);
+static int async_enter(void);
+static void async_leave(void);
+static int async_push(ogs_log_level_e level, ogs_log_domain_t *domain,
+        ogs_err_t err, const char *file, int line, const char *func,
+        int content_only, const char *content, size_t len);
+static void async_flush(void);
+
 void ogs_log_init(void)
 {
     ogs_pool_init(&log_pool, ogs_core()->log.pool);
     ogs_pool_init(&domain_pool, ogs_core()->log.domain_pool);
 
+    ogs_thread_mutex_init(&async.drain);
+    ogs_thread_mutex_init(&async.mutex);
+    ogs_thread_cond_init(&async.cond);
+
     ogs_log_add_domain("core", ogs_core()->log.level);
     ogs_log_add_stderr();
 }
@@ -125,6 +226,8 @@ void ogs_log_final(void)
     ogs_log_t *log, *saved_log;
     ogs_log_domain_t *domain, *saved_domain;
 
+    ogs_log_async_stop();
+
     ogs_list_for_each_safe(&log_list, saved_log, log)
         ogs_log_remove(log);
     ogs_pool_final(&log_pool);
@@ -132,12 +235,25 @@ void ogs_log_final(void)
     ogs_list_for_each_safe(&domain_list, saved_domain, domain)
         ogs_log_remove_domain(domain);
     ogs_pool_final(&domain_pool);
+
+    ogs_thread_cond_destroy(&async.cond);
+    ogs_thread_mutex_destroy(&async.mutex);
+    ogs_thread_mutex_destroy(&async.drain);
 }
 
 void ogs_log_cycle(void)
 {
     ogs_log_t *log = NULL;
 
+    if (ogs_atomic_load(&async.running, OGS_ATOMIC_ACQUIRE)) {
+        /* The writer thread owns the files */
+        ogs_atomic_store(&async.cycle, 1, OGS_ATOMIC_RELEASE);
+        ogs_thread_mutex_lock(&async.mutex);
+        ogs_thread_cond_signal(&async.cond);
+        ogs_thread_mutex_unlock(&async.mutex);
+        return;
+    }
+
     ogs_list_for_each(&log_list, log) {
         switch(log->type) {
         case OGS_LOG_FILE_TYPE:
@@ -212,6 +328,10 @@ ogs_log_domain_t *ogs_log_add_domain(const char *name, ogs_log_level_e level)
     domain->name = name;
     domain->id = ogs_pool_index(&domain_pool, domain);
     domain->level = level;
+    domain->rate = default_rate;
+    domain->window = 0;
+    domain->count = 0;
+    domain->dropped = 0;
 
     ogs_list_add(&domain_list, domain);
 
@@ -398,6 +518,80 @@ int ogs_log_config_domain(const char *domain, const char *level)
     return OGS_OK;
 }
 
+void ogs_log_set_rate_limit(const char *_mask, unsigned int rate)
+{
+    ogs_log_domain_t *domain = NULL;
+
+    if (_mask) {
+        const char *delim = " \t\n,:";
+        char *mask = NULL;
+        char *saveptr;
+        char *name;
+
+        mask = ogs_strdup(_mask);
+        ogs_assert(mask);
+
+        for (name = ogs_strtok_r(mask, delim, &saveptr);
+            name != NULL;
+            name = ogs_strtok_r(NULL, delim, &saveptr)) {
+
+            domain = ogs_log_find_domain(name);
+            if (domain)
+                domain->rate = rate;
+        }
+
+        ogs_free(mask);
+    } else {
+        default_rate = rate;
+        ogs_list_for_each(&domain_list, domain)
+            domain->rate = rate;
+    }
+}
+
+unsigned long ogs_log_get_domain_dropped(int id)
+{
+    ogs_log_domain_t *domain = NULL;
+
+    ogs_assert(id > 0 && id <= ogs_core()->log.domain_pool);
+
+    domain = ogs_pool_find(&domain_pool, id);
+    ogs_assert(domain);
+
+    return ogs_atomic_load(&domain->dropped, OGS_ATOMIC_RELAXED);
+}
+
+static void log_dropped(ogs_log_domain_t *domain)
+{
+    ogs_atomic_fetch_add(&domain->dropped, 1, OGS_ATOMIC_RELAXED);
+    ogs_atomic_fetch_add(&async.dropped, 1, OGS_ATOMIC_RELAXED);
+}
+
+/*
+ * Fixed one second windows. Threads racing on a window change may let
+ * a few more messages through, which is fine for a limiter.
+ */
+static int rate_limited(ogs_log_domain_t *domain, ogs_log_level_e level)
+{
+    long now, window;
+
+    if (!domain->rate || level == OGS_LOG_FATAL)
+        return 0;
+
+    now = (long)ogs_time_sec(ogs_get_monotonic_time());
+    window = ogs_atomic_load(&domain->window, OGS_ATOMIC_RELAXED);
+    if (window != now &&
+        ogs_atomic_cas(&domain->window, &window, now,
+            OGS_ATOMIC_RELAXED, OGS_ATOMIC_RELAXED))
+        ogs_atomic_store(&domain->count, 0, OGS_ATOMIC_RELAXED);
+
+    if (ogs_atomic_fetch_add(&domain->count, 1, OGS_ATOMIC_RELAXED) <
+            domain->rate)
+        return 0;
+
+    log_dropped(domain);
+    return 1;
+}
+
 void ogs_log_vprintf(ogs_log_level_e level, int id,
     ogs_err_t err, const char *file, int line, const char *func,
     int content_only, const char *format, va_list ap)
@@ -410,7 +604,7 @@ void ogs_log_vprintf(ogs_log_level_e level, int id,
 
     int wrote_stderr = 0;
 
-    ogs_list_for_each(&log_list, log) {
+    if (ogs_list_first(&log_list)) {
         domain = ogs_pool_find(&domain_pool, id);
         if (!domain) {
             fprintf(stderr, "No LogDomain[id:%d] in %s:%d", id, file, line);
@@ -418,13 +612,27 @@ void ogs_log_vprintf(ogs_log_level_e level, int id,
         }
         if (domain->level < level)
             return;
+        if (rate_limited(domain, level))
+            return;
 
+        if (level == OGS_LOG_FATAL) {
+            async_flush();
+        } else if (async_enter()) {
+            p = log_content(logstr, logstr + OGS_HUGE_LEN, format, ap);
+            async_push(level, domain, err, file, line, func,
+                    content_only, logstr, p - logstr);
+            async_leave();
+            return;
+        }
+    }
+
+    ogs_list_for_each(&log_list, log) {
         p = logstr;
         last = logstr + OGS_HUGE_LEN;
 
         if (!content_only) {
             if (log->print.timestamp)
-                p = log_timestamp(p, last, log->print.color);
+                p = log_timestamp(p, last, NULL, log->print.color);
             if (log->print.domain)
                 p = log_domain(p, last, domain->name, log->print.color);
             if (log->print.level)
@@ -465,7 +673,7 @@ void ogs_log_vprintf(ogs_log_level_e level, int id,
         last = logstr + OGS_HUGE_LEN;
 
         if (!content_only) {
-            p = log_timestamp(p, last, use_color);
+            p = log_timestamp(p, last, NULL, use_color);
             p = log_level(p, last, level, use_color);
         }
         p = log_content(p, last, format, ap);
@@ -495,10 +703,16 @@ void ogs_log_printf(ogs_log_level_e level, int id,
 void ogs_log_hexdump_func(ogs_log_level_e level, int id,
         const unsigned char *data, size_t len)
 {
+    ogs_log_domain_t *domain = NULL;
     size_t n, m;
     char dumpstr[OGS_HUGE_LEN];
     char *p, *last;
 
+    /* Do not format a dump which is filtered out anyway */
+    domain = ogs_pool_find(&domain_pool, id);
+    if (domain && domain->level < level)
+        return;
+
     last = dumpstr + OGS_HUGE_LEN;
     p = dumpstr;
 
@@ -525,6 +739,402 @@ void ogs_log_hexdump_func(ogs_log_level_e level, int id,
     ogs_log_print(level, "%s", dumpstr);
 }
 
+/*
+ * A producer announces itself before it checks 'running', and
+ * ogs_log_async_stop() clears 'running' before it waits for the count
+ * to drop to zero : either the producer sees the stop, or the stop
+ * waits for the producer to leave its ring.
+ */
+static int async_enter(void)
+{
+    ogs_atomic_fetch_add(&async.producers, 1, OGS_ATOMIC_SEQ_CST);
+    if (ogs_atomic_load(&async.running, OGS_ATOMIC_SEQ_CST))
+        return 1;
+
+    async_leave();
+    return 0;
+}
+
+static void async_leave(void)
+{
+    ogs_atomic_fetch_sub(&async.producers, 1, OGS_ATOMIC_RELEASE);
+}
+
+static log_ring_t *async_ring(void)
+{
+    log_ring_t *ring = NULL;
+    unsigned int generation =
+        ogs_atomic_load(&async.generation, OGS_ATOMIC_ACQUIRE);
+
+    if (thread_ring.ring && thread_ring.generation == generation)
+        return thread_ring.ring;
+
+    ring = calloc(1, sizeof(*ring));
+    if (!ring)
+        return NULL;
+    ring->buf = malloc(LOG_RING_SIZE);
+    if (!ring->buf) {
+        free(ring);
+        return NULL;
+    }
+
+    ring->next = ogs_atomic_load(&async.ring_list, OGS_ATOMIC_RELAXED);
+    while (!ogs_atomic_cas(&async.ring_list, &ring->next, ring,
+                OGS_ATOMIC_RELEASE, OGS_ATOMIC_RELAXED));
+
+    thread_ring.ring = ring;
+    thread_ring.generation = generation;
+
+    return ring;
+}
+
+static int async_push(ogs_log_level_e level, ogs_log_domain_t *domain,
+        ogs_err_t err, const char *file, int line, const char *func,
+        int content_only, const char *content, size_t len)
+{
+    log_ring_t *ring = NULL;
+    log_record_t *r = NULL;
+    size_t head, tail, used, off, contig, need;
+
+    ring = async_ring();
+    if (!ring) {
+        log_dropped(domain);
+        return OGS_ERROR;
+    }
+
+    need = (sizeof(*r) + len + 1 + 7) & ~(size_t)7;
+
+    tail = ring->tail;
+    head = ogs_atomic_load(&ring->head, OGS_ATOMIC_ACQUIRE);
+    used = tail - head;
+    off = tail & (LOG_RING_SIZE - 1);
+    contig = LOG_RING_SIZE - off;
+
+    if (contig < need) {
+        /* Records are contiguous : skip the end of the ring */
+        if (LOG_RING_SIZE - used < contig + need) {
+            log_dropped(domain);
+            return OGS_RETRY;
+        }
+        r = (log_record_t *)(ring->buf + off);
+        r->size = contig;
+        r->level = LOG_RECORD_PAD;
+        tail += contig;
+        used += contig;
+        off = 0;
+    } else if (LOG_RING_SIZE - used < need) {
+        log_dropped(domain);
+        return OGS_RETRY;
+    }
+
+    r = (log_record_t *)(ring->buf + off);
+    r->size = need;
+    r->level = level;
+    r->content_only = content_only;
+    r->line = line;
+    r->err = err;
+    ogs_gettimeofday(&r->tv);
+    r->domain = domain->name;
+    r->file = file;
+    r->func = func;
+    memcpy(r->content, content, len);
+    r->content[len] = 0;
+
+    ogs_atomic_store(&ring->tail, tail + need, OGS_ATOMIC_RELEASE);
+
+    /* Wake the writer up early, without ever waiting for it */
+    if (used + need > LOG_RING_SIZE / 2 &&
+        ogs_atomic_load(&async.sleeping, OGS_ATOMIC_ACQUIRE) &&
+        ogs_thread_mutex_trylock(&async.mutex)) {
+        ogs_thread_cond_signal(&async.cond);
+        ogs_thread_mutex_unlock(&async.mutex);
+    }
+
+    return OGS_OK;
+}
+
+/*
+ * The writer thread gathers the decorations, formatted in 'scratch',
+ * and the contents, left in the rings, into one writev() per batch.
+ */
+#define LOG_DECOR_LEN 1024
+
+static struct {
+    int fd;
+    int n;
+    struct iovec iov[LOG_BATCH_IOV];
+    size_t used;
+    char scratch[16 * LOG_DECOR_LEN];
+} batch;
+
+static void batch_flush(void)
+{
+    struct iovec *iov = batch.iov;
+    int n = batch.n;
+    ssize_t r;
+
+    while (n > 0) {
+        r = writev(batch.fd, iov, n);
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        while (n > 0 && (size_t)r >= iov->iov_len) {
+            r -= iov->iov_len;
+            iov++;
+            n--;
+        }
+        if (n > 0) {
+            iov->iov_base = (char *)iov->iov_base + r;
+            iov->iov_len -= r;
+        }
+    }
+
+    batch.n = 0;
+    batch.used = 0;
+}
+
+static void batch_add(const char *base, size_t len)
+{
+    if (!len)
+        return;
+
+    batch.iov[batch.n].iov_base = (void *)base;
+    batch.iov[batch.n].iov_len = len;
+    batch.n++;
+}
+
+static void batch_record(ogs_log_t *log, log_record_t *r)
+{
+    char *start, *p, *last;
+
+    if (batch.n + 3 > LOG_BATCH_IOV ||
+        sizeof(batch.scratch) - batch.used < 2 * LOG_DECOR_LEN)
+        batch_flush();
+
+    start = p = batch.scratch + batch.used;
+    last = p + LOG_DECOR_LEN;
+
+    if (!r->content_only) {
+        if (log->print.timestamp)
+            p = log_timestamp(p, last, &r->tv, log->print.color);
+        if (log->print.domain)
+            p = log_domain(p, last, r->domain, log->print.color);
+        if (log->print.level)
+            p = log_level(p, last, r->level, log->print.color);
+    }
+    batch_add(start, p - start);
+
+    batch_add(r->content, strlen(r->content));
+
+    start = p;
+    last = p + LOG_DECOR_LEN;
+
+    if (r->err) {
+        char errbuf[OGS_HUGE_LEN];
+        p = ogs_slprintf(p, last, " (%d:%s)",
+                (int)r->err, ogs_strerror(r->err, errbuf, OGS_HUGE_LEN));
+    }
+
+    if (!r->content_only) {
+        if (log->print.fileline)
+            p = ogs_slprintf(p, last, " (%s:%d)", r->file, r->line);
+        if (log->print.function)
+            p = ogs_slprintf(p, last, " %s()", r->func);
+        if (log->print.linefeed)
+            p = log_linefeed(p, last);
+    }
+    batch_add(start, p - start);
+
+    batch.used = p - batch.scratch;
+}
+
+static void batch_ring(ogs_log_t *log,
+        log_ring_t *ring, size_t head, size_t tail)
+{
+    log_record_t *r = NULL;
+
+    batch.fd = fileno(log->file.out);
+
+    while (head != tail) {
+        r = (log_record_t *)(ring->buf + (head & (LOG_RING_SIZE - 1)));
+        if (r->level != LOG_RECORD_PAD)
+            batch_record(log, r);
+        head += r->size;
+    }
+
+    batch_flush();
+}
+
+static void async_drain(void)
+{
+    log_ring_t *ring = NULL;
+    ogs_log_t *log = NULL;
+    ogs_log_t fallback;
+    int wrote_stderr = 0;
+    unsigned long dropped;
+
+    /* Same output as ogs_log_vprintf() without a stderr log */
+    memset(&fallback, 0, sizeof(fallback));
+    fallback.type = OGS_LOG_STDERR_TYPE;
+    fallback.file.out = stderr;
+    fallback.print.timestamp = 1;
+    fallback.print.level = 1;
+    fallback.print.fileline = 1;
+    fallback.print.function = 1;
+    fallback.print.linefeed = 1;
+#if !defined(_WIN32)
+    fallback.print.color = 1;
+#endif
+
+    ogs_list_for_each(&log_list, log)
+        if (log->type == OGS_LOG_STDERR_TYPE)
+            wrote_stderr = 1;
+
+    for (ring = ogs_atomic_load(&async.ring_list, OGS_ATOMIC_ACQUIRE);
+            ring; ring = ring->next) {
+        size_t head = ring->head;
+        size_t tail = ogs_atomic_load(&ring->tail, OGS_ATOMIC_ACQUIRE);
+
+        if (head == tail)
+            continue;
+
+        ogs_list_for_each(&log_list, log)
+            batch_ring(log, ring, head, tail);
+        if (!wrote_stderr)
+            batch_ring(&fallback, ring, head, tail);
+
+        ogs_atomic_store(&ring->head, tail, OGS_ATOMIC_RELEASE);
+    }
+
+    dropped = ogs_atomic_load(&async.dropped, OGS_ATOMIC_RELAXED);
+    if (dropped != async.reported) {
+        uint64_t buf[(sizeof(log_record_t) + 64) / sizeof(uint64_t) + 1];
+        log_record_t *r = (log_record_t *)buf;
+
+        memset(r, 0, sizeof(*r));
+        r->level = OGS_LOG_WARN;
+        ogs_gettimeofday(&r->tv);
+        r->domain = "core";
+        r->file = __FILE__;
+        r->line = __LINE__;
+        r->func = OGS_FUNC;
+        ogs_snprintf(r->content, 64, "%lu log messages dropped",
+                dropped - async.reported);
+
+        ogs_list_for_each(&log_list, log) {
+            batch.fd = fileno(log->file.out);
+            batch_record(log, r);
+            batch_flush();
+        }
+        if (!wrote_stderr) {
+            batch.fd = fileno(fallback.file.out);
+            batch_record(&fallback, r);
+            batch_flush();
+        }
+
+        async.reported = dropped;
+    }
+}
+
+/* Writes out whatever is left in the rings from the calling thread */
+static void async_flush(void)
+{
+    ogs_thread_mutex_lock(&async.drain);
+    if (ogs_atomic_load(&async.ring_list, OGS_ATOMIC_ACQUIRE))
+        async_drain();
+    ogs_thread_mutex_unlock(&async.drain);
+}
+
+static void async_main(void *data)
+{
+    ogs_log_t *log = NULL;
+    int stop;
+
+    for ( ;; ) {
+        stop = ogs_atomic_load(&async.stop, OGS_ATOMIC_ACQUIRE);
+
+        ogs_thread_mutex_lock(&async.drain);
+        async_drain();
+        ogs_thread_mutex_unlock(&async.drain);
+
+        if (ogs_atomic_exchange(&async.cycle, 0, OGS_ATOMIC_ACQ_REL)) {
+            ogs_list_for_each(&log_list, log) {
+                if (log->type == OGS_LOG_FILE_TYPE)
+                    file_cycle(log);
+            }
+        }
+
+        if (stop)
+            break;
+
+        ogs_thread_mutex_lock(&async.mutex);
+        ogs_atomic_store(&async.sleeping, 1, OGS_ATOMIC_RELEASE);
+        if (!ogs_atomic_load(&async.stop, OGS_ATOMIC_ACQUIRE) &&
+            !ogs_atomic_load(&async.cycle, OGS_ATOMIC_ACQUIRE))
+            ogs_thread_cond_timedwait(
+                    &async.cond, &async.mutex, LOG_WRITER_INTERVAL);
+        ogs_atomic_store(&async.sleeping, 0, OGS_ATOMIC_RELAXED);
+        ogs_thread_mutex_unlock(&async.mutex);
+    }
+}
+
+int ogs_log_async_start(void)
+{
+    if (ogs_atomic_load(&async.running, OGS_ATOMIC_ACQUIRE))
+        return OGS_OK;
+
+    async.stop = 0;
+    async.cycle = 0;
+    async.reported = ogs_atomic_load(&async.dropped, OGS_ATOMIC_RELAXED);
+
+    async.thread = ogs_thread_create(async_main, NULL);
+    if (!async.thread) {
+        ogs_error("ogs_thread_create() failed");
+        return OGS_ERROR;
+    }
+
+    ogs_atomic_store(&async.running, 1, OGS_ATOMIC_RELEASE);
+
+    return OGS_OK;
+}
+
+void ogs_log_async_stop(void)
+{
+    log_ring_t *ring = NULL, *next = NULL;
+
+    if (!ogs_atomic_load(&async.running, OGS_ATOMIC_ACQUIRE))
+        return;
+
+    ogs_atomic_store(&async.running, 0, OGS_ATOMIC_SEQ_CST);
+
+    /* New messages are written synchronously : wait for the pushes */
+    while (ogs_atomic_load(&async.producers, OGS_ATOMIC_SEQ_CST))
+        ogs_usleep(100);
+
+    ogs_thread_mutex_lock(&async.mutex);
+    ogs_atomic_store(&async.stop, 1, OGS_ATOMIC_RELEASE);
+    ogs_thread_cond_signal(&async.cond);
+    ogs_thread_mutex_unlock(&async.mutex);
+
+    /* The writer drains the rings once more before exiting */
+    ogs_thread_destroy(async.thread);
+    async.thread = NULL;
+
+    ogs_thread_mutex_lock(&async.drain);
+    for (ring = async.ring_list; ring; ring = next) {
+        next = ring->next;
+        free(ring->buf);
+        free(ring);
+    }
+    ogs_atomic_store(&async.ring_list, NULL, OGS_ATOMIC_RELEASE);
+    ogs_thread_mutex_unlock(&async.drain);
+
+    /* Threads allocate a new ring if started again */
+    ogs_atomic_fetch_add(&async.generation, 1, OGS_ATOMIC_RELEASE);
+}
+
 static ogs_log_t *add_log(ogs_log_type_e type)
 {
     ogs_log_t *log = NULL;
@@ -560,19 +1170,22 @@ static int file_cycle(ogs_log_t *log)
 }
 
 static char *log_timestamp(char *buf, char *last,
-        int use_color)
+        const struct timeval *tv, int use_color)
 {
-    struct timeval tv;
+    struct timeval now;
     struct tm tm;
     char nowstr[32];
 
-    ogs_gettimeofday(&tv);
-    ogs_localtime(tv.tv_sec, &tm);
+    if (!tv) {
+        ogs_gettimeofday(&now);
+        tv = &now;
+    }
+    ogs_localtime(tv->tv_sec, &tm);
     strftime(nowstr, sizeof nowstr, "%m/%d %H:%M:%S", &tm);
 
     buf = ogs_slprintf(buf, last, "%s%s.%03d%s: ",
             use_color ? TA_FGC_GREEN : "",
-            nowstr, (int)(tv.tv_usec/1000),
+            nowstr, (int)(tv->tv_usec/1000),
             use_color ? TA_NOR : "");
 
     return buf;
@@ -98,6 +98,15 @@ int ogs_log_config_domain(const char *domain, const char *level);
 void ogs_log_set_mask_level(const char *mask, ogs_log_level_e level);
 void ogs_log_set_timestamp(ogs_log_ts_e ts_default, ogs_log_ts_e ts_file);
 
+void ogs_log_set_rate_limit(const char *mask, unsigned int rate);
+unsigned long ogs_log_get_domain_dropped(int id);
+
+/*
+ * Log targets must not be added or removed while the writer is running.
+ */
+int ogs_log_async_start(void);
+void ogs_log_async_stop(void);
+
 void ogs_log_vprintf(ogs_log_level_e level, int id,
     ogs_err_t err, const char *file, int line, const char *func,
     int content_only, const char *format, va_list ap);
@@ -0,0 +1,324 @@
+/*
+ * Copyright (C) 2019-2024 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-core.h"
+
+#define LPM_ROOT_STRIDE     16
+#define LPM_STRIDE          8
+
+#define LPM_MAX_BYTES       16
+#define LPM_MAX_LEVEL       (1 + (LPM_MAX_BYTES*8 - LPM_ROOT_STRIDE) / LPM_STRIDE)
+
+typedef struct lpm_table_s lpm_table_t;
+
+typedef struct lpm_slot_s {
+    void *value;
+    lpm_table_t *child;
+    uint8_t depth;                  /* Prefix length of the value */
+} lpm_slot_t;
+
+struct lpm_table_s {
+    int used;                       /* Slots with value or child */
+    lpm_slot_t slot[];
+};
+
+typedef struct lpm_rule_s {
+    uint8_t key[1 + LPM_MAX_BYTES]; /* Prefix length, masked address */
+    void *value;
+} lpm_rule_t;
+
+struct ogs_lpm_s {
+    int bits;
+    int bytes;
+
+    lpm_table_t *root;
+    ogs_hash_t *rule_hash;          /* Prefixes as added */
+};
+
+static int level_of(int len)
+{
+    if (len <= LPM_ROOT_STRIDE)
+        return 0;
+    return (len - LPM_ROOT_STRIDE + LPM_STRIDE - 1) / LPM_STRIDE;
+}
+
+static int level_end(int level)
+{
+    return LPM_ROOT_STRIDE + level * LPM_STRIDE;
+}
+
+static int level_index(const uint8_t *addr, int level)
+{
+    if (level == 0)
+        return (addr[0] << 8) | addr[1];
+    return addr[level + 1];
+}
+
+static lpm_table_t *table_alloc(int level)
+{
+    lpm_table_t *t = NULL;
+    int size = level == 0 ? 1 << LPM_ROOT_STRIDE : 1 << LPM_STRIDE;
+
+    t = ogs_calloc(1, sizeof(*t) + size * sizeof(lpm_slot_t));
+    ogs_assert(t);
+
+    return t;
+}
+
+static void table_free(lpm_table_t *t, int level)
+{
+    int i, size = level == 0 ? 1 << LPM_ROOT_STRIDE : 1 << LPM_STRIDE;
+
+    for (i = 0; t->used && i < size; i++) {
+        if (t->slot[i].child)
+            table_free(t->slot[i].child, level + 1);
+    }
+    ogs_free(t);
+}
+
+static int rule_key(ogs_lpm_t *lpm, uint8_t *key, const void *addr, int len)
+{
+    int i;
+
+    key[0] = len;
+    memcpy(key + 1, addr, lpm->bytes);
+    for (i = 0; i < lpm->bytes; i++) {
+        if (len >= 8)
+            len -= 8;
+        else {
+            key[1 + i] &= (uint8_t)(0xff << (8 - len));
+            len = 0;
+        }
+    }
+
+    return 1 + lpm->bytes;
+}
+
+ogs_lpm_t *ogs_lpm_create(int bits)
+{
+    ogs_lpm_t *lpm = NULL;
+
+    ogs_assert(bits == 32 || bits == 128);
+
+    lpm = ogs_calloc(1, sizeof(*lpm));
+    ogs_assert(lpm);
+
+    lpm->bits = bits;
+    lpm->bytes = bits >> 3;
+
+    lpm->root = table_alloc(0);
+    lpm->rule_hash = ogs_hash_make();
+    ogs_assert(lpm->rule_hash);
+
+    return lpm;
+}
+
+void ogs_lpm_destroy(ogs_lpm_t *lpm)
+{
+    ogs_hash_index_t *hi = NULL;
+
+    ogs_assert(lpm);
+
+    while ((hi = ogs_hash_first(lpm->rule_hash))) {
+        lpm_rule_t *rule = ogs_hash_this_val(hi);
+
+        ogs_hash_set(lpm->rule_hash,
+                rule->key, ogs_hash_this_key_len(hi), NULL);
+        ogs_free(rule);
+    }
+    ogs_hash_destroy(lpm->rule_hash);
+
+    table_free(lpm->root, 0);
+    ogs_free(lpm);
+}
+
+int ogs_lpm_add(ogs_lpm_t *lpm, const void *addr, int len, void *value)
+{
+    lpm_rule_t *rule = NULL;
+    lpm_table_t *t = NULL;
+    uint8_t key[1 + LPM_MAX_BYTES];
+    const uint8_t *prefix = key + 1;
+    int klen, level, i, base, span;
+
+    ogs_assert(lpm);
+    ogs_assert(addr);
+    ogs_assert(value);
+
+    if (len < 0 || len > lpm->bits) {
+        ogs_error("Invalid prefix length [%d]", len);
+        return OGS_ERROR;
+    }
+
+    klen = rule_key(lpm, key, addr, len);
+    rule = ogs_hash_get(lpm->rule_hash, key, klen);
+    if (!rule) {
+        rule = ogs_calloc(1, sizeof(*rule));
+        ogs_assert(rule);
+        memcpy(rule->key, key, klen);
+        ogs_hash_set(lpm->rule_hash, rule->key, klen, rule);
+    }
+    rule->value = value;
+
+    t = lpm->root;
+    level = level_of(len);
+    for (i = 0; i < level; i++) {
+        lpm_slot_t *s = &t->slot[level_index(prefix, i)];
+        if (!s->child) {
+            s->child = table_alloc(i + 1);
+            if (!s->value)
+                t->used++;
+        }
+        t = s->child;
+    }
+
+    base = level_index(prefix, level);
+    span = 1 << (level_end(level) - len);
+    for (i = base; i < base + span; i++) {
+        lpm_slot_t *s = &t->slot[i];
+
+        if (!s->value) {
+            if (!s->child)
+                t->used++;
+        } else if (s->depth > len) {
+            /* A longer prefix is already expanded into this slot */
+            continue;
+        }
+        s->value = value;
+        s->depth = len;
+    }
+
+    return OGS_OK;
+}
+
+void *ogs_lpm_delete(ogs_lpm_t *lpm, const void *addr, int len)
+{
+    lpm_rule_t *rule = NULL, *next = NULL;
+    lpm_table_t *path[LPM_MAX_LEVEL];
+    int index[LPM_MAX_LEVEL];
+    uint8_t key[1 + LPM_MAX_BYTES], next_key[1 + LPM_MAX_BYTES];
+    const uint8_t *prefix = key + 1;
+    void *value = NULL;
+    int klen, level, next_len, i, base, span;
+
+    ogs_assert(lpm);
+    ogs_assert(addr);
+
+    if (len < 0 || len > lpm->bits)
+        return NULL;
+
+    klen = rule_key(lpm, key, addr, len);
+    rule = ogs_hash_get(lpm->rule_hash, key, klen);
+    if (!rule)
+        return NULL;
+
+    value = rule->value;
+    ogs_hash_set(lpm->rule_hash, rule->key, klen, NULL);
+    ogs_free(rule);
+
+    level = level_of(len);
+    path[0] = lpm->root;
+    for (i = 0; i < level; i++) {
+        index[i] = level_index(prefix, i);
+        path[i + 1] = path[i]->slot[index[i]].child;
+        ogs_assert(path[i + 1]);
+    }
+
+    /* The next shorter prefix expanded at the same level, if any */
+    for (next_len = len - 1;
+            next_len >= (level ? level_end(level - 1) + 1 : 0); next_len--) {
+        rule_key(lpm, next_key, addr, next_len);
+        next = ogs_hash_get(lpm->rule_hash, next_key, klen);
+        if (next)
+            break;
+    }
+
+    base = level_index(prefix, level);
+    span = 1 << (level_end(level) - len);
+    for (i = base; i < base + span; i++) {
+        lpm_slot_t *s = &path[level]->slot[i];
+
+        if (!s->value || s->depth != len)
+            continue;
+
+        if (next) {
+            s->value = next->value;
+            s->depth = next_len;
+        } else {
+            s->value = NULL;
+            s->depth = 0;
+            if (!s->child)
+                path[level]->used--;
+        }
+    }
+
+    /* Release the tables left empty */
+    for (i = level; i > 0 && path[i]->used == 0; i--) {
+        lpm_slot_t *s = &path[i - 1]->slot[index[i - 1]];
+
+        ogs_free(path[i]);
+        s->child = NULL;
+        if (!s->value)
+            path[i - 1]->used--;
+    }
+
+    return value;
+}
+
+void *ogs_lpm_get(ogs_lpm_t *lpm, const void *addr, int len)
+{
+    lpm_rule_t *rule = NULL;
+    uint8_t key[1 + LPM_MAX_BYTES];
+    int klen;
+
+    ogs_assert(lpm);
+    ogs_assert(addr);
+
+    if (len < 0 || len > lpm->bits)
+        return NULL;
+
+    klen = rule_key(lpm, key, addr, len);
+    rule = ogs_hash_get(lpm->rule_hash, key, klen);
+
+    return rule ? rule->value : NULL;
+}
+
+void *ogs_lpm_find(ogs_lpm_t *lpm, const void *addr)
+{
+    lpm_table_t *t = NULL;
+    lpm_slot_t *s = NULL;
+    void *value = NULL;
+    int level = 0;
+
+    ogs_assert(lpm);
+    ogs_assert(addr);
+
+    for (t = lpm->root; t; t = s->child) {
+        s = &t->slot[level_index(addr, level++)];
+        if (s->value)
+            value = s->value;
+    }
+
+    return value;
+}
+
+unsigned int ogs_lpm_count(ogs_lpm_t *lpm)
+{
+    ogs_assert(lpm);
+    return ogs_hash_count(lpm->rule_hash);
+}
@@ -30,10 +30,270 @@ void *__ogs_talloc_core;
 
 static ogs_thread_mutex_t mutex;
 
+/*
+ * Per-thread arenas
+ *
+ * Unless ogs_core()->mem.arena is cleared before ogs_core_initialize(),
+ * the ogs_talloc_*() functions below bypass talloc and its global mutex.
+ * Each thread allocates from size classes of its own arena without any
+ * lock. A block freed by another thread is pushed onto the 'remote' list
+ * of its arena, which the owner takes over when a class runs empty.
+ *
+ * The talloc context is ignored in this mode, so talloc_report_full()
+ * is only meaningful with mem.arena cleared. The number of blocks still
+ * allocated is reported by ogs_mem_final() in both modes.
+ *
+ * Memory is kept in the arenas until ogs_mem_final(). The arena of a
+ * thread created by ogs_thread_create() is handed over to the next
+ * thread when it exits.
+ */
+#define MEM_CLASSES         21
+#define MEM_MIN_SIZE        32
+#define MEM_MAX_SIZE        32768
+#define MEM_CHUNK_SIZE      (64*1024)
+
+typedef struct mem_arena_s mem_arena_t;
+
+typedef struct mem_header_s {
+    mem_arena_t *arena;     /* NULL if allocated with malloc() directly */
+    size_t size;            /* As requested */
+} mem_header_t;
+
+/* The first word of a free block links it to the next one */
+#define MEM_LINK(__h) (*(mem_header_t **)((__h) + 1))
+
+struct mem_arena_s {
+    mem_arena_t *next;
+    int orphan;
+
+    mem_header_t *free[MEM_CLASSES];
+    void *chunk_list;
+
+    size_t size;            /* Written by the owner only */
+    size_t blocks;
+
+    char pad[64];
+    mem_header_t *remote;   /* Freed by the other threads */
+    size_t remote_size;
+    size_t remote_blocks;
+};
+
+static int mem_arena;
+static mem_arena_t *arena_list;
+static size_t large_size, large_blocks;
+
+static OGS_THREAD_LOCAL mem_arena_t *thread_arena;
+
+/* 32, 48, 64, 96, 128, 192, ... 24576, 32768 */
+static int size_class(size_t size)
+{
+    int p;
+
+    if (size <= MEM_MIN_SIZE)
+        return 0;
+
+    size--;
+    p = (int)(sizeof(long) * 8 - 1) - __builtin_clzl((unsigned long)size);
+
+    return 2 * (p - 5) + 1 + (int)((size >> (p - 1)) & 1);
+}
+
+static size_t class_size(int klass)
+{
+    if (klass & 1)
+        return (size_t)3 << (4 + klass / 2);
+    return (size_t)1 << (5 + klass / 2);
+}
+
+static mem_arena_t *arena_get(void)
+{
+    mem_arena_t *arena = NULL;
+
+    for (arena = ogs_atomic_load(&arena_list, OGS_ATOMIC_ACQUIRE);
+            arena; arena = arena->next) {
+        int orphan = 1;
+
+        if (ogs_atomic_load(&arena->orphan, OGS_ATOMIC_RELAXED) &&
+            ogs_atomic_cas(&arena->orphan, &orphan, 0,
+                OGS_ATOMIC_ACQUIRE, OGS_ATOMIC_RELAXED)) {
+            thread_arena = arena;
+            return arena;
+        }
+    }
+
+    /* The arenas themselves come from the system allocator */
+    arena = calloc(1, sizeof(*arena));
+    if (!arena)
+        return NULL;
+
+    arena->next = ogs_atomic_load(&arena_list, OGS_ATOMIC_RELAXED);
+    while (!ogs_atomic_cas(&arena_list, &arena->next, arena,
+                OGS_ATOMIC_RELEASE, OGS_ATOMIC_RELAXED));
+
+    thread_arena = arena;
+
+    return arena;
+}
+
+static void arena_put(mem_arena_t *arena, mem_header_t *h)
+{
+    int klass = size_class(h->size);
+
+    MEM_LINK(h) = arena->free[klass];
+    arena->free[klass] = h;
+
+    arena->size -= h->size;
+    arena->blocks--;
+}
+
+static void arena_drain(mem_arena_t *arena)
+{
+    mem_header_t *h = NULL, *next = NULL;
+
+    h = ogs_atomic_exchange(&arena->remote, NULL, OGS_ATOMIC_ACQUIRE);
+    for (; h; h = next) {
+        next = MEM_LINK(h);
+        ogs_atomic_fetch_sub(&arena->remote_size, h->size, OGS_ATOMIC_RELAXED);
+        ogs_atomic_fetch_sub(&arena->remote_blocks, 1, OGS_ATOMIC_RELAXED);
+        arena_put(arena, h);
+    }
+}
+
+static int arena_refill(mem_arena_t *arena, int klass)
+{
+    size_t stride = sizeof(mem_header_t) + class_size(klass);
+    size_t n = ogs_max(1, MEM_CHUNK_SIZE / stride);
+    char *chunk = NULL, *p = NULL;
+    mem_header_t *h = NULL;
+    size_t i;
+
+    chunk = malloc(sizeof(mem_header_t) + n * stride);
+    if (!chunk)
+        return OGS_ERROR;
+
+    *(void **)chunk = arena->chunk_list;
+    arena->chunk_list = chunk;
+
+    p = chunk + sizeof(mem_header_t);
+    for (i = 0; i < n; i++, p += stride) {
+        h = (mem_header_t *)p;
+        h->arena = arena;
+        MEM_LINK(h) = arena->free[klass];
+        arena->free[klass] = h;
+    }
+
+    return OGS_OK;
+}
+
+static void *arena_alloc(size_t size, int zero)
+{
+    mem_arena_t *arena = NULL;
+    mem_header_t *h = NULL;
+    int klass;
+
+    if (size > MEM_MAX_SIZE) {
+        h = zero ? calloc(1, sizeof(*h) + size) : malloc(sizeof(*h) + size);
+        if (!h)
+            return NULL;
+        h->arena = NULL;
+        h->size = size;
+
+        ogs_atomic_fetch_add(&large_size, size, OGS_ATOMIC_RELAXED);
+        ogs_atomic_fetch_add(&large_blocks, 1, OGS_ATOMIC_RELAXED);
+
+        return h + 1;
+    }
+
+    arena = thread_arena;
+    if (!arena) {
+        arena = arena_get();
+        if (!arena)
+            return NULL;
+    }
+
+    klass = size_class(size);
+    if (!arena->free[klass]) {
+        arena_drain(arena);
+        if (!arena->free[klass] && arena_refill(arena, klass) != OGS_OK)
+            return NULL;
+    }
+
+    h = arena->free[klass];
+    arena->free[klass] = MEM_LINK(h);
+    h->size = size;
+
+    arena->size += size;
+    arena->blocks++;
+
+    if (zero)
+        memset(h + 1, 0, size);
+
+    return h + 1;
+}
+
+static void arena_free(void *ptr)
+{
+    mem_header_t *h = (mem_header_t *)ptr - 1;
+    mem_arena_t *arena = h->arena;
+
+    if (!arena) {
+        ogs_atomic_fetch_sub(&large_size, h->size, OGS_ATOMIC_RELAXED);
+        ogs_atomic_fetch_sub(&large_blocks, 1, OGS_ATOMIC_RELAXED);
+        free(h);
+        return;
+    }
+
+    if (arena == thread_arena) {
+        arena_put(arena, h);
+        return;
+    }
+
+    ogs_atomic_fetch_add(&arena->remote_size, h->size, OGS_ATOMIC_RELAXED);
+    ogs_atomic_fetch_add(&arena->remote_blocks, 1, OGS_ATOMIC_RELAXED);
+
+    MEM_LINK(h) = ogs_atomic_load(&arena->remote, OGS_ATOMIC_RELAXED);
+    while (!ogs_atomic_cas(&arena->remote, &MEM_LINK(h), h,
+                OGS_ATOMIC_RELEASE, OGS_ATOMIC_RELAXED));
+}
+
+static void *arena_realloc(void *oldptr, size_t size)
+{
+    mem_header_t *h = NULL;
+    void *ptr = NULL;
+
+    if (!oldptr)
+        return arena_alloc(size, 0);
+
+    if (!size) {
+        arena_free(oldptr);
+        return NULL;
+    }
+
+    h = (mem_header_t *)oldptr - 1;
+    if (h->arena == thread_arena && h->arena &&
+        size <= class_size(size_class(h->size))) {
+        h->arena->size += size;
+        h->arena->size -= h->size;
+        h->size = size;
+        return oldptr;
+    }
+
+    ptr = arena_alloc(size, 0);
+    if (!ptr)
+        return NULL;
+
+    memcpy(ptr, oldptr, ogs_min(size, h->size));
+    arena_free(oldptr);
+
+    return ptr;
+}
+
 void ogs_mem_init(void)
 {
     ogs_thread_mutex_init(&mutex);
 
+    mem_arena = ogs_core()->mem.arena;
+
     talloc_enable_null_tracking();
 
 #define TALLOC_MEMSIZE 1
@@ -42,6 +302,32 @@ void ogs_mem_init(void)
 
 void ogs_mem_final(void)
 {
+    mem_arena_t *arena = NULL, *next = NULL;
+    ogs_mem_stat_t stat;
+
+    /* All the other threads are gone by now */
+    for (arena = arena_list; arena; arena = arena->next)
+        arena_drain(arena);
+
+    ogs_mem_stat(&stat);
+    if (mem_arena && stat.blocks)
+        fprintf(stderr, "%zu bytes in %zu blocks not freed\n",
+                stat.size, stat.blocks);
+
+    for (arena = arena_list; arena; arena = next) {
+        void *chunk = NULL;
+
+        next = arena->next;
+        while ((chunk = arena->chunk_list)) {
+            arena->chunk_list = *(void **)chunk;
+            free(chunk);
+        }
+        free(arena);
+    }
+    arena_list = NULL;
+    thread_arena = NULL;
+    mem_arena = 0;
+
     if (talloc_total_size(__ogs_talloc_core) != TALLOC_MEMSIZE)
         talloc_report_full(__ogs_talloc_core, stderr);
 
@@ -50,6 +336,45 @@ void ogs_mem_final(void)
     ogs_thread_mutex_destroy(&mutex);
 }
 
+void ogs_mem_arena_release(void)
+{
+    if (!thread_arena)
+        return;
+
+    ogs_atomic_store(&thread_arena->orphan, 1, OGS_ATOMIC_RELEASE);
+    thread_arena = NULL;
+}
+
+bool ogs_mem_arena_enabled(void)
+{
+    return mem_arena != 0;
+}
+
+void ogs_mem_stat(ogs_mem_stat_t *stat)
+{
+    mem_arena_t *arena = NULL;
+
+    ogs_assert(stat);
+    memset(stat, 0, sizeof(*stat));
+
+    if (!mem_arena) {
+        stat->size = talloc_total_size(__ogs_talloc_core) - TALLOC_MEMSIZE;
+        stat->blocks = talloc_total_blocks(__ogs_talloc_core) - 1;
+        return;
+    }
+
+    /* The counters of the other threads are read as they are */
+    for (arena = ogs_atomic_load(&arena_list, OGS_ATOMIC_ACQUIRE);
+            arena; arena = arena->next) {
+        stat->size += arena->size -
+            ogs_atomic_load(&arena->remote_size, OGS_ATOMIC_RELAXED);
+        stat->blocks += arena->blocks -
+            ogs_atomic_load(&arena->remote_blocks, OGS_ATOMIC_RELAXED);
+    }
+    stat->size += ogs_atomic_load(&large_size, OGS_ATOMIC_RELAXED);
+    stat->blocks += ogs_atomic_load(&large_blocks, OGS_ATOMIC_RELAXED);
+}
+
 void *ogs_mem_get_mutex(void)
 {
     return &mutex;
@@ -59,6 +384,12 @@ void *ogs_talloc_size(const void *ctx, size_t size, const char *name)
 {
     void *ptr = NULL;
 
+    if (mem_arena) {
+        ptr = arena_alloc(size, 0);
+        ogs_expect(ptr);
+        return ptr;
+    }
+
     ogs_thread_mutex_lock(&mutex);
 
     ptr = talloc_named_const(ctx, size, name);
@@ -73,6 +404,12 @@ void *ogs_talloc_zero_size(const void *ctx, size_t size, const char *name)
 {
     void *ptr = NULL;
 
+    if (mem_arena) {
+        ptr = arena_alloc(size, 1);
+        ogs_expect(ptr);
+        return ptr;
+    }
+
     ogs_thread_mutex_lock(&mutex);
 
     ptr = _talloc_zero(ctx, size, name);
@@ -88,6 +425,12 @@ void *ogs_talloc_realloc_size(
 {
     void *ptr = NULL;
 
+    if (mem_arena) {
+        ptr = arena_realloc(oldptr, size);
+        ogs_expect(ptr || !size);
+        return ptr;
+    }
+
     ogs_thread_mutex_lock(&mutex);
 
     ptr = _talloc_realloc(context, oldptr, size, name);
@@ -102,6 +445,13 @@ int ogs_talloc_free(void *ptr, const char *location)
 {
     int ret;
 
+    if (mem_arena) {
+        if (!ptr)
+            return -1;
+        arena_free(ptr);
+        return 0;
+    }
+
     ogs_thread_mutex_lock(&mutex);
 
     ret = _talloc_free(ptr, location);
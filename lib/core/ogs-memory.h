@@ -33,6 +33,18 @@ void ogs_mem_final(void);
 
 void *ogs_mem_get_mutex(void);
 
+typedef struct ogs_mem_stat_s {
+    size_t size;
+    size_t blocks;
+} ogs_mem_stat_t;
+
+void ogs_mem_stat(ogs_mem_stat_t *stat);
+
+bool ogs_mem_arena_enabled(void);
+
+/* Hand the arena of the calling thread over before it exits */
+void ogs_mem_arena_release(void);
+
 #define OGS_MEM_CLEAR(__dATA) \
     do { \
         if ((__dATA)) { \
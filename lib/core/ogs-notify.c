@@ -47,8 +47,9 @@ void ogs_notify_init(ogs_pollset_t *pollset)
     ogs_assert(rc == OGS_OK);
 #endif
 
+    pollset->notify.pending = 0;
     pollset->notify.poll = ogs_pollset_add(pollset, OGS_POLLIN,
-            pollset->notify.fd[0], ogs_drain_pollset, NULL);
+            pollset->notify.fd[0], ogs_drain_pollset, pollset);
     ogs_assert(pollset->notify.poll);
 }
 
@@ -76,6 +77,14 @@ int ogs_notify_pollset(ogs_pollset_t *pollset)
 
     ogs_assert(pollset);
 
+    /*
+     * Only the first notification after the last drain reaches the
+     * descriptor. The others are already covered by the pending wakeup,
+     * since the loop empties its event queue after draining.
+     */
+    if (ogs_atomic_exchange(&pollset->notify.pending, 1, OGS_ATOMIC_ACQ_REL))
+        return OGS_OK;
+
 #if defined(HAVE_EVENTFD)
     r = write(pollset->notify.fd[0], (void*)&msg, sizeof(msg));
 #else
@@ -84,6 +93,7 @@ int ogs_notify_pollset(ogs_pollset_t *pollset)
 
     if (r < 0) {
         ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno, "notify failed");
+        ogs_atomic_store(&pollset->notify.pending, 0, OGS_ATOMIC_RELEASE);
         return OGS_ERROR;
     }
 
@@ -92,6 +102,7 @@ int ogs_notify_pollset(ogs_pollset_t *pollset)
 
 static void ogs_drain_pollset(short when, ogs_socket_t fd, void *data)
 {
+    ogs_pollset_t *pollset = data;
     ssize_t r;
 #if defined(HAVE_EVENTFD)
     uint64_t msg;
@@ -100,6 +111,7 @@ static void ogs_drain_pollset(short when, ogs_socket_t fd, void *data)
 #endif
 
     ogs_assert(when == OGS_POLLIN);
+    ogs_assert(pollset);
 
 #if defined(HAVE_EVENTFD)
     r = read(fd, (char *)&msg, sizeof(msg));
@@ -109,4 +121,7 @@ static void ogs_drain_pollset(short when, ogs_socket_t fd, void *data)
     if (r < 0) {
         ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno, "drain failed");
     }
+
+    /* Any notification from now on has to wake up the next poll */
+    ogs_atomic_exchange(&pollset->notify.pending, 0, OGS_ATOMIC_ACQ_REL);
 }
@@ -260,6 +260,7 @@ ogs_pkbuf_t *ogs_pkbuf_alloc_debug(
     ogs_pool_alloc(&pool->pkbuf, &pkbuf);
     if (!pkbuf) {
         ogs_error("ogs_pkbuf_alloc() failed [size=%d]", size);
+        cluster_free(pool, cluster);
         ogs_thread_mutex_unlock(&pool->mutex);
         return NULL;
     }
@@ -286,14 +287,11 @@ ogs_pkbuf_t *ogs_pkbuf_alloc_debug(
 #endif
 }
 
-void ogs_pkbuf_free(ogs_pkbuf_t *pkbuf)
+#if OGS_USE_TALLOC == 0
+static void pkbuf_free(ogs_pkbuf_t *pkbuf)
 {
-#if OGS_USE_TALLOC == 1
-    ogs_talloc_free(pkbuf, OGS_FILE_LINE);
-#else
     ogs_pkbuf_pool_t *pool = NULL;
     ogs_cluster_t *cluster = NULL;
-    ogs_assert(pkbuf);
 
     pool = pkbuf->pool;
     ogs_assert(pool);
@@ -311,10 +309,29 @@ void ogs_pkbuf_free(ogs_pkbuf_t *pkbuf)
     ogs_pool_free(&pool->pkbuf, pkbuf);
 
     ogs_thread_mutex_unlock(&pool->mutex);
+}
+#endif
+
+void ogs_pkbuf_free(ogs_pkbuf_t *pkbuf)
+{
+    ogs_pkbuf_t *next = NULL;
+
+#if OGS_USE_TALLOC == 1
+    for (; pkbuf; pkbuf = next) {
+        next = pkbuf->next;
+        ogs_talloc_free(pkbuf, OGS_FILE_LINE);
+    }
+#else
+    ogs_assert(pkbuf);
+
+    for (; pkbuf; pkbuf = next) {
+        next = pkbuf->next;
+        pkbuf_free(pkbuf);
+    }
 #endif
 }
 
-ogs_pkbuf_t *ogs_pkbuf_copy_debug(ogs_pkbuf_t *pkbuf, const char *file_line)
+static ogs_pkbuf_t *pkbuf_copy(ogs_pkbuf_t *pkbuf, const char *file_line)
 {
 #if OGS_USE_TALLOC == 1
     ogs_pkbuf_t *newbuf;
@@ -363,6 +380,7 @@ ogs_pkbuf_t *ogs_pkbuf_copy_debug(ogs_pkbuf_t *pkbuf, const char *file_line)
     }
     ogs_assert(newbuf);
     memcpy(newbuf, pkbuf, sizeof *pkbuf);
+    newbuf->next = NULL;
 
     OGS_OBJECT_REF(newbuf->cluster);
 
@@ -372,6 +390,111 @@ ogs_pkbuf_t *ogs_pkbuf_copy_debug(ogs_pkbuf_t *pkbuf, const char *file_line)
     return newbuf;
 }
 
+ogs_pkbuf_t *ogs_pkbuf_copy_debug(ogs_pkbuf_t *pkbuf, const char *file_line)
+{
+    ogs_pkbuf_t *head = NULL, *tail = NULL, *newbuf = NULL;
+
+    ogs_assert(pkbuf);
+
+    for (; pkbuf; pkbuf = pkbuf->next) {
+        newbuf = pkbuf_copy(pkbuf, file_line);
+        if (!newbuf) {
+            if (head)
+                ogs_pkbuf_free(head);
+            return NULL;
+        }
+
+        if (tail)
+            tail->next = newbuf;
+        else
+            head = newbuf;
+        tail = newbuf;
+    }
+
+    return head;
+}
+
+void ogs_pkbuf_chain(ogs_pkbuf_t *pkbuf, ogs_pkbuf_t *next)
+{
+    ogs_assert(pkbuf);
+    ogs_assert(next);
+
+    while (pkbuf->next)
+        pkbuf = pkbuf->next;
+    pkbuf->next = next;
+}
+
+unsigned int ogs_pkbuf_chain_len(const ogs_pkbuf_t *pkbuf)
+{
+    unsigned int len = 0;
+
+    for (; pkbuf; pkbuf = pkbuf->next)
+        len += pkbuf->len;
+
+    return len;
+}
+
+/*
+ * Same as ogs_pkbuf_push() if the headroom is large enough. Otherwise,
+ * a new segment is put in front of the chain instead of copying it all.
+ */
+void *ogs_pkbuf_prepend(ogs_pkbuf_t **pkbuf, unsigned int len)
+{
+    ogs_pkbuf_t *head = NULL;
+
+    ogs_assert(pkbuf);
+    ogs_assert(*pkbuf);
+
+    if (ogs_pkbuf_headroom(*pkbuf) >= (int)len)
+        return ogs_pkbuf_push(*pkbuf, len);
+
+    head = ogs_pkbuf_alloc((*pkbuf)->pool, OGS_PKBUF_PREPEND_HEADROOM + len);
+    if (!head) {
+        ogs_error("ogs_pkbuf_alloc() failed [size=%d]", len);
+        return NULL;
+    }
+    ogs_pkbuf_reserve(head, OGS_PKBUF_PREPEND_HEADROOM + len);
+
+    memcpy(head->param, (*pkbuf)->param, sizeof(head->param));
+    head->next = *pkbuf;
+    *pkbuf = head;
+
+    return ogs_pkbuf_push(head, len);
+}
+
+/*
+ * For the consumers that need contiguous data. The chain is freed
+ * and replaced, or left as it is if the allocation fails.
+ */
+ogs_pkbuf_t *ogs_pkbuf_linearize(ogs_pkbuf_t *pkbuf)
+{
+    ogs_pkbuf_t *newbuf = NULL, *seg = NULL;
+    int headroom;
+
+    ogs_assert(pkbuf);
+
+    if (!pkbuf->next)
+        return pkbuf;
+
+    headroom = ogs_pkbuf_headroom(pkbuf);
+    newbuf = ogs_pkbuf_alloc(pkbuf->pool,
+            headroom + ogs_pkbuf_chain_len(pkbuf));
+    if (!newbuf) {
+        ogs_error("ogs_pkbuf_alloc() failed [size=%d]",
+                headroom + ogs_pkbuf_chain_len(pkbuf));
+        return NULL;
+    }
+    ogs_pkbuf_reserve(newbuf, headroom);
+    memcpy(newbuf->param, pkbuf->param, sizeof(newbuf->param));
+
+    for (seg = pkbuf; seg; seg = seg->next)
+        ogs_pkbuf_put_data(newbuf, seg->data, seg->len);
+
+    ogs_pkbuf_free(pkbuf);
+
+    return newbuf;
+}
+
 #if OGS_USE_TALLOC == 0
 static ogs_cluster_t *cluster_alloc(
         ogs_pkbuf_pool_t *pool, unsigned int size)
@@ -388,6 +511,7 @@ static ogs_cluster_t *cluster_alloc(
         ogs_pool_alloc(&pool->cluster_128, (ogs_cluster_128_t**)&buffer);
         if (!buffer) {
             ogs_error("ogs_pool_alloc() failed");
+            ogs_pool_free(&pool->cluster, cluster);
             return NULL;
         }
         cluster->size = OGS_CLUSTER_128_SIZE;
@@ -395,6 +519,7 @@ static ogs_cluster_t *cluster_alloc(
         ogs_pool_alloc(&pool->cluster_256, (ogs_cluster_256_t**)&buffer);
         if (!buffer) {
             ogs_error("ogs_pool_alloc() failed");
+            ogs_pool_free(&pool->cluster, cluster);
             return NULL;
         }
         cluster->size = OGS_CLUSTER_256_SIZE;
@@ -402,6 +527,7 @@ static ogs_cluster_t *cluster_alloc(
         ogs_pool_alloc(&pool->cluster_512, (ogs_cluster_512_t**)&buffer);
         if (!buffer) {
             ogs_error("ogs_pool_alloc() failed");
+            ogs_pool_free(&pool->cluster, cluster);
             return NULL;
         }
         cluster->size = OGS_CLUSTER_512_SIZE;
@@ -409,6 +535,7 @@ static ogs_cluster_t *cluster_alloc(
         ogs_pool_alloc(&pool->cluster_1024, (ogs_cluster_1024_t**)&buffer);
         if (!buffer) {
             ogs_error("ogs_pool_alloc() failed");
+            ogs_pool_free(&pool->cluster, cluster);
             return NULL;
         }
         cluster->size = OGS_CLUSTER_1024_SIZE;
@@ -416,6 +543,7 @@ static ogs_cluster_t *cluster_alloc(
         ogs_pool_alloc(&pool->cluster_2048, (ogs_cluster_2048_t**)&buffer);
         if (!buffer) {
             ogs_error("ogs_pool_alloc() failed");
+            ogs_pool_free(&pool->cluster, cluster);
             return NULL;
         }
         cluster->size = OGS_CLUSTER_2048_SIZE;
@@ -423,6 +551,7 @@ static ogs_cluster_t *cluster_alloc(
         ogs_pool_alloc(&pool->cluster_8192, (ogs_cluster_8192_t**)&buffer);
         if (!buffer) {
             ogs_error("ogs_pool_alloc() failed");
+            ogs_pool_free(&pool->cluster, cluster);
             return NULL;
         }
         cluster->size = OGS_CLUSTER_8192_SIZE;
@@ -430,6 +559,7 @@ static ogs_cluster_t *cluster_alloc(
         ogs_pool_alloc(&pool->cluster_32768, (ogs_cluster_32768_t**)&buffer);
         if (!buffer) {
             ogs_error("ogs_pool_alloc() failed");
+            ogs_pool_free(&pool->cluster, cluster);
             return NULL;
         }
         cluster->size = OGS_CLUSTER_32768_SIZE;
@@ -437,6 +567,7 @@ static ogs_cluster_t *cluster_alloc(
         ogs_pool_alloc(&pool->cluster_big, (ogs_cluster_big_t**)&buffer);
         if (!buffer) {
             ogs_error("ogs_pool_alloc() failed");
+            ogs_pool_free(&pool->cluster, cluster);
             return NULL;
         }
         cluster->size = OGS_CLUSTER_BIG_SIZE;
@@ -55,6 +55,12 @@ typedef struct ogs_pkbuf_s {
     unsigned char *data;
     unsigned char *end;
 
+    /*
+     * Next segment of a chained pkbuf. 'len' covers this segment only.
+     * ogs_pkbuf_free() and ogs_pkbuf_copy() apply to the whole chain.
+     */
+    struct ogs_pkbuf_s *next;
+
     const char *file_line;
     
     ogs_pkbuf_pool_t *pool;
@@ -95,6 +101,14 @@ void *ogs_pkbuf_put_data(
     ogs_pkbuf_copy_debug(pkbuf, OGS_FILE_LINE)
 ogs_pkbuf_t *ogs_pkbuf_copy_debug(ogs_pkbuf_t *pkbuf, const char *file_line);
 
+/* Headroom left in a segment added by ogs_pkbuf_prepend() */
+#define OGS_PKBUF_PREPEND_HEADROOM 64
+
+void ogs_pkbuf_chain(ogs_pkbuf_t *pkbuf, ogs_pkbuf_t *next);
+unsigned int ogs_pkbuf_chain_len(const ogs_pkbuf_t *pkbuf);
+void *ogs_pkbuf_prepend(ogs_pkbuf_t **pkbuf, unsigned int len);
+ogs_pkbuf_t *ogs_pkbuf_linearize(ogs_pkbuf_t *pkbuf);
+
 static ogs_inline int ogs_pkbuf_tailroom(const ogs_pkbuf_t *pkbuf)
 {
     return pkbuf->end - pkbuf->tail;
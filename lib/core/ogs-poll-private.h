@@ -38,6 +38,18 @@ typedef struct ogs_poll_s {
     void *data;
 
     ogs_pollset_t *pollset;
+
+    struct {
+        ogs_poll_recv_f handler;
+        void *data;
+
+        ogs_pkbuf_pool_t *pool;
+        unsigned int size;
+        unsigned int headroom;
+        bool socket;                /* Otherwise a TUN device */
+
+        void *context;              /* Backend state */
+    } recv;
 } ogs_poll_t;
 
 typedef struct ogs_pollset_s {
@@ -47,11 +59,16 @@ typedef struct ogs_pollset_s {
     struct {
         ogs_socket_t fd[2];
         ogs_poll_t *poll;
+        int pending;    /* Written but not yet drained */
     } notify;
 
     unsigned int capacity;
 } ogs_pollset_t;
 
+void ogs_poll_recv_ready(short when, ogs_socket_t fd, void *data);
+
+bool ogs_io_uring_probe(void);
+
 #ifdef __cplusplus
 }
 #endif
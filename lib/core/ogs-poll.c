@@ -26,6 +26,9 @@
 extern const ogs_pollset_actions_t ogs_kqueue_actions;
 extern const ogs_pollset_actions_t ogs_epoll_actions;
 extern const ogs_pollset_actions_t ogs_select_actions;
+#if defined(HAVE_IO_URING)
+extern const ogs_pollset_actions_t ogs_io_uring_actions;
+#endif
 
 static void *self_handler_data = NULL;
 
@@ -99,6 +102,7 @@ ogs_poll_t *ogs_pollset_add(ogs_pollset_t *pollset, short when,
         poll->data = data;
 
     poll->pollset = pollset;
+    poll->recv.context = NULL;
 
     rc = ogs_pollset_actions.add(poll);
     if (rc != OGS_OK) {
@@ -131,3 +135,120 @@ void *ogs_pollset_self_handler_data(void)
 {
     return &self_handler_data;
 }
+
+ogs_poll_t *ogs_pollset_add_recv(ogs_pollset_t *pollset,
+        ogs_socket_t fd, ogs_pkbuf_pool_t *pool,
+        unsigned int size, unsigned int headroom,
+        ogs_poll_recv_f handler, void *data)
+{
+    ogs_poll_t *poll = NULL;
+    int type, rc;
+    socklen_t len = sizeof(type);
+
+    ogs_assert(pollset);
+
+    ogs_assert(fd != INVALID_SOCKET);
+    ogs_assert(handler);
+    ogs_assert(size > headroom);
+
+    if (!ogs_pollset_actions.add_recv) {
+        poll = ogs_pollset_add(pollset, OGS_POLLIN, fd,
+                ogs_poll_recv_ready, &self_handler_data);
+        if (!poll)
+            return NULL;
+    } else {
+        ogs_pool_alloc(&pollset->pool, &poll);
+        ogs_assert(poll);
+
+        rc = ogs_nonblocking(fd);
+        ogs_assert(rc == OGS_OK);
+        rc = ogs_closeonexec(fd);
+        ogs_assert(rc == OGS_OK);
+
+        poll->when = OGS_POLLIN;
+        poll->fd = fd;
+        poll->handler = ogs_poll_recv_ready;
+        poll->data = poll;
+        poll->pollset = pollset;
+    }
+
+    poll->recv.handler = handler;
+    poll->recv.data = data;
+    poll->recv.pool = pool;
+    poll->recv.size = size;
+    poll->recv.headroom = headroom;
+    poll->recv.socket = getsockopt(fd, SOL_SOCKET, SO_TYPE,
+            (void *)&type, &len) == 0;
+    poll->recv.context = NULL;
+
+    if (ogs_pollset_actions.add_recv) {
+        rc = ogs_pollset_actions.add_recv(poll);
+        if (rc != OGS_OK) {
+            ogs_error("cannot add poll");
+            ogs_pool_free(&pollset->pool, poll);
+            return NULL;
+        }
+    }
+
+    return poll;
+}
+
+/*
+ * Readiness fallback of ogs_pollset_add_recv() :
+ * drains the fd into a batch and hands it to the receive handler.
+ */
+void ogs_poll_recv_ready(short when, ogs_socket_t fd, void *data)
+{
+    ogs_poll_t *poll = data;
+    ogs_pkbuf_t *pkbuf[OGS_POLL_RECV_BATCH];
+    ogs_sockaddr_t from[OGS_POLL_RECV_BATCH];
+    ssize_t size;
+    int n;
+
+    ogs_assert(poll);
+    ogs_assert(poll->recv.handler);
+
+    for (n = 0; n < OGS_POLL_RECV_BATCH; n++) {
+        pkbuf[n] = ogs_pkbuf_alloc(poll->recv.pool, poll->recv.size);
+        if (!pkbuf[n]) {
+            ogs_error("ogs_pkbuf_alloc() failed");
+            break;
+        }
+        ogs_pkbuf_reserve(pkbuf[n], poll->recv.headroom);
+        ogs_pkbuf_put(pkbuf[n], poll->recv.size - poll->recv.headroom);
+
+        if (poll->recv.socket)
+            size = ogs_recvfrom(fd,
+                    pkbuf[n]->data, pkbuf[n]->len, 0, &from[n]);
+        else
+            size = ogs_read(fd, pkbuf[n]->data, pkbuf[n]->len);
+        if (size <= 0) {
+            if (size < 0 && ogs_socket_errno != OGS_EAGAIN)
+                ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
+                        "recv(%d) failed", fd);
+            ogs_pkbuf_free(pkbuf[n]);
+            break;
+        }
+        ogs_pkbuf_trim(pkbuf[n], size);
+    }
+
+    if (n)
+        poll->recv.handler(fd, pkbuf,
+                poll->recv.socket ? from : NULL, n, poll->recv.data);
+}
+
+bool ogs_pollset_use_io_uring(void)
+{
+#if defined(HAVE_IO_URING)
+    if (ogs_io_uring_probe() == false)
+        return false;
+
+    ogs_pollset_actions = ogs_io_uring_actions;
+    ogs_pollset_actions_initialized = true;
+
+    return true;
+#else
+    ogs_warn("io_uring is not supported on this platform");
+    return false;
+#endif
+}
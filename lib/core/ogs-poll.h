@@ -42,6 +42,28 @@ void ogs_pollset_remove(ogs_poll_t *poll);
 
 void *ogs_pollset_self_handler_data(void);
 
+/*
+ * Completion-style receive for the hot datagram sockets and TUN devices.
+ *
+ * The handler gets up to OGS_POLL_RECV_BATCH packets at a time and owns
+ * them. 'from' is NULL for a TUN device. With the io_uring backend the
+ * packets come from a multishot receive into a ring of pkbufs registered
+ * with the kernel; the other backends read them when the fd is ready.
+ * The poll is removed with ogs_pollset_remove() as usual.
+ */
+#define OGS_POLL_RECV_BATCH 32
+
+typedef void (*ogs_poll_recv_f)(ogs_socket_t fd,
+        ogs_pkbuf_t **pkbuf, ogs_sockaddr_t *from, int num, void *data);
+
+ogs_poll_t *ogs_pollset_add_recv(ogs_pollset_t *pollset,
+        ogs_socket_t fd, ogs_pkbuf_pool_t *pool,
+        unsigned int size, unsigned int headroom,
+        ogs_poll_recv_f handler, void *data);
+
+/* Selects the io_uring backend for the pollsets created from now on */
+bool ogs_pollset_use_io_uring(void);
+
 typedef struct ogs_pollset_actions_s {
     void (*init)(ogs_pollset_t *pollset);
     void (*cleanup)(ogs_pollset_t *pollset);
@@ -51,6 +73,9 @@ typedef struct ogs_pollset_actions_s {
 
     int (*poll)(ogs_pollset_t *pollset, ogs_time_t timeout);
     int (*notify)(ogs_pollset_t *pollset);
+
+    /* Optional : native completion-style receive */
+    int (*add_recv)(ogs_poll_t *poll);
 } ogs_pollset_actions_t;
 
 extern ogs_pollset_actions_t ogs_pollset_actions;
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2019-2024 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "core-config-private.h"
+
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include "ogs-core.h"
+
+#define OGS_POOL_CHUNK_SIZE (64*1024)
+
+#if HAVE_SYS_MMAN_H
+static size_t page_size(void)
+{
+    static size_t size = 0;
+
+    if (!size) {
+        long rv = sysconf(_SC_PAGESIZE);
+        size = rv > 0 ? rv : 4096;
+    }
+
+    return size;
+}
+
+static size_t chunk_bytes(ogs_pool_chunk_t *chunk)
+{
+    return (size_t)chunk->nodes * chunk->node_size;
+}
+
+static size_t total_bytes(ogs_pool_chunk_t *chunk)
+{
+    return (size_t)chunk->num * chunk_bytes(chunk);
+}
+#endif
+
+ogs_pool_chunk_t *ogs_pool_chunk_create(size_t node_size, int size)
+{
+    ogs_pool_chunk_t *chunk = NULL;
+    int i;
+
+    ogs_assert(node_size);
+    ogs_assert(size > 0);
+
+    /*
+     * ogs_pool_init_chunked() is used in the initialization routine
+     * like ogs_pool_init(), so system malloc() is used here as well.
+     */
+    chunk = calloc(1, sizeof(*chunk));
+    ogs_assert(chunk);
+
+    chunk->node_size = node_size;
+    chunk->nodes = ogs_max(1, OGS_POOL_CHUNK_SIZE / node_size);
+    chunk->nodes = ogs_min(chunk->nodes, size);
+    chunk->num = (size + chunk->nodes - 1) / chunk->nodes;
+
+    chunk->live = malloc(sizeof(*chunk->live) * chunk->num);
+    ogs_assert(chunk->live);
+
+#if HAVE_SYS_MMAN_H
+    /* Address space only : nothing is backed until committed */
+    chunk->base = mmap(NULL, total_bytes(chunk), PROT_NONE,
+            MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if (chunk->base == MAP_FAILED) {
+        ogs_error("mmap(%zu) failed", total_bytes(chunk));
+        free(chunk->live);
+        free(chunk);
+        return NULL;
+    }
+
+    for (i = 0; i < chunk->num; i++)
+        chunk->live[i] = -1;
+#else
+    chunk->base = malloc(node_size * size);
+    ogs_assert(chunk->base);
+
+    for (i = 0; i < chunk->num; i++)
+        chunk->live[i] = 0;
+    chunk->committed = chunk->num;
+#endif
+
+    return chunk;
+}
+
+void ogs_pool_chunk_destroy(ogs_pool_chunk_t *chunk)
+{
+    ogs_assert(chunk);
+
+#if HAVE_SYS_MMAN_H
+    ogs_assert(munmap(chunk->base, total_bytes(chunk)) == 0);
+#else
+    free(chunk->base);
+#endif
+    free(chunk->live);
+    free(chunk);
+}
+
+void ogs_pool_chunk_commit(ogs_pool_chunk_t *chunk, int c)
+{
+    ogs_assert(chunk);
+    ogs_assert(c >= 0 && c < chunk->num);
+    ogs_assert(chunk->live[c] < 0);
+
+#if HAVE_SYS_MMAN_H
+    {
+        /* Pages on the chunk boundary may be shared with a neighbor */
+        uintptr_t mask = page_size() - 1;
+        uintptr_t start = (uintptr_t)chunk->base + c * chunk_bytes(chunk);
+        uintptr_t end = start + chunk_bytes(chunk);
+
+        start &= ~mask;
+        end = (end + mask) & ~mask;
+
+        ogs_assert(mprotect((void *)start, end - start,
+                    PROT_READ|PROT_WRITE) == 0);
+    }
+#endif
+
+    chunk->live[c] = 0;
+    chunk->committed++;
+}
+
+int ogs_pool_chunk_trim(ogs_pool_chunk_t *chunk)
+{
+    int n = 0;
+#if HAVE_SYS_MMAN_H
+    int c;
+#endif
+
+    ogs_assert(chunk);
+
+#if HAVE_SYS_MMAN_H
+    for (c = 0; c < chunk->num; c++) {
+        uintptr_t mask = page_size() - 1;
+        uintptr_t start, end;
+
+        if (chunk->live[c] != 0)
+            continue;
+
+        /* Only the pages owned by this chunk alone are released */
+        start = (uintptr_t)chunk->base + c * chunk_bytes(chunk);
+        end = start + chunk_bytes(chunk);
+
+        start = (start + mask) & ~mask;
+        end &= ~mask;
+
+        if (end > start)
+            ogs_assert(mmap((void *)start, end - start, PROT_NONE,
+                    MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE|MAP_FIXED,
+                    -1, 0) != MAP_FAILED);
+
+        chunk->live[c] = -1;
+        chunk->committed--;
+        n++;
+    }
+#endif
+
+    return n;
+}
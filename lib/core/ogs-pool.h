@@ -28,21 +28,97 @@
 extern "C" {
 #endif
 
+/*
+ * Ids are carried through timer and event data as a pointer, so they
+ * use every bit of a pointer but the sign: 63 bits on a 64-bit host.
+ */
 #define OGS_INVALID_POOL_ID 0
 #define OGS_MIN_POOL_ID     1
-#define OGS_MAX_POOL_ID     0x7fffffff
+#define OGS_MAX_POOL_ID     ((ogs_pool_id_t)INTPTR_MAX)
+
+#define OGS_POOL_ID_BITS    ((int)(sizeof(intptr_t) * 8) - 1)
+
+typedef int64_t ogs_pool_id_t;
+
+/*
+ * Backing storage of a chunked pool
+ *
+ * The whole array is reserved as address space up front, so pointers
+ * stay stable and ogs_pool_index()/ogs_pool_find() remain O(1), but
+ * memory is committed one chunk at a time as nodes are handed out.
+ */
+typedef struct ogs_pool_chunk_s {
+    char *base;
+    size_t node_size;
+    int nodes;          /* Nodes per chunk */
+    int num;            /* Number of chunks */
+    int committed;      /* Chunks backed by memory */
+    int *live;          /* Nodes in use per chunk, -1 if not committed */
+} ogs_pool_chunk_t;
+
+ogs_pool_chunk_t *ogs_pool_chunk_create(size_t node_size, int size);
+void ogs_pool_chunk_destroy(ogs_pool_chunk_t *chunk);
+void ogs_pool_chunk_commit(ogs_pool_chunk_t *chunk, int c);
+int ogs_pool_chunk_trim(ogs_pool_chunk_t *chunk);
+
+static ogs_inline void ogs_pool_chunk_get(ogs_pool_chunk_t *chunk, int index)
+{
+    int c = index / chunk->nodes;
+    if (chunk->live[c] < 0)
+        ogs_pool_chunk_commit(chunk, c);
+    chunk->live[c]++;
+}
+
+static ogs_inline void ogs_pool_chunk_put(ogs_pool_chunk_t *chunk, int index)
+{
+    chunk->live[index / chunk->nodes]--;
+}
 
-typedef int32_t ogs_pool_id_t;
+static ogs_inline int ogs_pool_id_bits(int size)
+{
+    int bits = 1;
+    while (bits < 31 && (1 << bits) <= size)
+        bits++;
+    return bits;
+}
+
+static ogs_inline ogs_pool_id_t ogs_pool_id_next(
+        ogs_pool_id_t *last, int bits, int index)
+{
+    uint64_t gen = ((uint64_t)last[index] >> bits) + 1;
 
+    gen &= (UINT64_C(1) << (OGS_POOL_ID_BITS - bits)) - 1;
+    last[index] = (ogs_pool_id_t)((gen << bits) | (uint64_t)(index + 1));
+
+    return last[index];
+}
+
+static ogs_inline int ogs_pool_id_slot(ogs_pool_id_t id, int bits, int size)
+{
+    uint64_t slot = (uint64_t)id & ((UINT64_C(1) << bits) - 1);
+
+    if (id < OGS_MIN_POOL_ID || id > OGS_MAX_POOL_ID ||
+        slot < 1 || slot > (uint64_t)size)
+        return 0;
+    return (int)slot - 1;
+}
+
+/*
+ * The free ring is filled lazily : nodes that were never handed out
+ * are taken from the frontier array[hwm], so initialization does not
+ * touch every slot.
+ */
 #define OGS_POOL(pool, type) \
     struct { \
         const char *name; \
         int head, tail; \
         int size, avail; \
+        int hwm, peak; \
         type **free, *array, **index; \
+        ogs_pool_chunk_t *chunk; \
         \
-        ogs_hash_t *id_hash; \
-        ogs_pool_id_t id; \
+        ogs_pool_id_t *id_last; \
+        int id_bits; \
     } pool
 
 /*
@@ -50,23 +126,50 @@ typedef int32_t ogs_pool_id_t;
  * Otherwise, memory will be fragment since this function uses system malloc()
  */
 #define ogs_pool_init(pool, _size) do { \
-    int i; \
     (pool)->name = #pool; \
     (pool)->free = malloc(sizeof(*(pool)->free) * _size); \
     ogs_assert((pool)->free); \
     (pool)->array = malloc(sizeof(*(pool)->array) * _size); \
     ogs_assert((pool)->array); \
-    (pool)->index = malloc(sizeof(*(pool)->index) * _size); \
+    (pool)->index = calloc(_size, sizeof(*(pool)->index)); \
     ogs_assert((pool)->index); \
+    (pool)->chunk = NULL; \
     (pool)->size = (pool)->avail = _size; \
     (pool)->head = (pool)->tail = 0; \
-    for (i = 0; i < _size; i++) { \
-        (pool)->free[i] = &((pool)->array[i]); \
-        (pool)->index[i] = NULL; \
-    } \
+    (pool)->hwm = (pool)->peak = 0; \
+    \
+    (pool)->id_last = calloc(_size, sizeof(*(pool)->id_last)); \
+    ogs_assert((pool)->id_last); \
+    (pool)->id_bits = ogs_pool_id_bits(_size); \
+} while (0)
+
+/*
+ * ogs_pool_init_chunked() is a drop-in for ogs_pool_init() meant for
+ * large context pools sized from the configured maximum.
+ *
+ * Memory is committed as the pool grows, and freed nodes are reused
+ * before new ones so that it follows the peak usage. ogs_pool_trim()
+ * may return chunks with no live node to the system. Since the array
+ * is not backed until used, do not access (pool)->array directly and
+ * do not use ogs_pool_{sequence,random}_id_generate() on such a pool.
+ * It is released with ogs_pool_final().
+ */
+#define ogs_pool_init_chunked(pool, _size) do { \
+    (pool)->name = #pool; \
+    (pool)->free = malloc(sizeof(*(pool)->free) * _size); \
+    ogs_assert((pool)->free); \
+    (pool)->chunk = ogs_pool_chunk_create(sizeof(*(pool)->array), _size); \
+    ogs_assert((pool)->chunk); \
+    (pool)->array = (void *)(pool)->chunk->base; \
+    (pool)->index = calloc(_size, sizeof(*(pool)->index)); \
+    ogs_assert((pool)->index); \
+    (pool)->size = (pool)->avail = _size; \
+    (pool)->head = (pool)->tail = 0; \
+    (pool)->hwm = (pool)->peak = 0; \
     \
-    (pool)->id_hash = ogs_hash_make(); \
-    ogs_assert((pool)->id_hash); \
+    (pool)->id_last = calloc(_size, sizeof(*(pool)->id_last)); \
+    ogs_assert((pool)->id_last); \
+    (pool)->id_bits = ogs_pool_id_bits(_size); \
 } while (0)
 
 /*
@@ -78,11 +181,12 @@ typedef int32_t ogs_pool_id_t;
         ogs_error("%d in '%s[%d]' were not released.", \
                 (pool)->size - (pool)->avail, (pool)->name, (pool)->size); \
     free((pool)->free); \
-    free((pool)->array); \
+    if ((pool)->chunk) \
+        ogs_pool_chunk_destroy((pool)->chunk); \
+    else \
+        free((pool)->array); \
     free((pool)->index); \
-    \
-    ogs_assert((pool)->id_hash); \
-    ogs_hash_destroy((pool)->id_hash); \
+    free((pool)->id_last); \
 } while (0)
 
 /*
@@ -92,23 +196,21 @@ typedef int32_t ogs_pool_id_t;
  * so this function should use ogs_malloc() instead of system malloc()
  */
 #define ogs_pool_create(pool, _size) do { \
-    int i; \
     (pool)->name = #pool; \
     (pool)->free = ogs_malloc(sizeof(*(pool)->free) * _size); \
     ogs_assert((pool)->free); \
     (pool)->array = ogs_malloc(sizeof(*(pool)->array) * _size); \
     ogs_assert((pool)->array); \
-    (pool)->index = ogs_malloc(sizeof(*(pool)->index) * _size); \
+    (pool)->index = ogs_calloc(_size, sizeof(*(pool)->index)); \
     ogs_assert((pool)->index); \
+    (pool)->chunk = NULL; \
     (pool)->size = (pool)->avail = _size; \
     (pool)->head = (pool)->tail = 0; \
-    for (i = 0; i < _size; i++) { \
-        (pool)->free[i] = &((pool)->array[i]); \
-        (pool)->index[i] = NULL; \
-    } \
+    (pool)->hwm = (pool)->peak = 0; \
     \
-    (pool)->id_hash = ogs_hash_make(); \
-    ogs_assert((pool)->id_hash); \
+    (pool)->id_last = ogs_calloc(_size, sizeof(*(pool)->id_last)); \
+    ogs_assert((pool)->id_last); \
+    (pool)->id_bits = ogs_pool_id_bits(_size); \
 } while (0)
 
 /*
@@ -124,18 +226,32 @@ typedef int32_t ogs_pool_id_t;
     ogs_free((pool)->free); \
     ogs_free((pool)->array); \
     ogs_free((pool)->index); \
-    \
-    ogs_assert((pool)->id_hash); \
-    ogs_hash_destroy((pool)->id_hash); \
+    ogs_free((pool)->id_last); \
 } while (0)
 
+/*
+ * A plain pool hands out the frontier before reusing freed nodes,
+ * which keeps the FIFO reuse order of a fully pre-filled free ring.
+ * A chunked pool reuses freed nodes first to stay within the chunks
+ * already committed.
+ */
 #define ogs_pool_alloc(pool, node) do { \
     *(node) = NULL; \
     if ((pool)->avail > 0) { \
+        if ((pool)->hwm < (pool)->size && (!(pool)->chunk || \
+                (pool)->hwm == (pool)->size - (pool)->avail)) { \
+            *(node) = (void*)&((pool)->array[(pool)->hwm++]); \
+        } else { \
+            *(node) = (void*)(pool)->free[(pool)->head]; \
+            (pool)->free[(pool)->head] = NULL; \
+            (pool)->head = ((pool)->head + 1) % ((pool)->size); \
+        } \
         (pool)->avail--; \
-        *(node) = (void*)(pool)->free[(pool)->head]; \
-        (pool)->free[(pool)->head] = NULL; \
-        (pool)->head = ((pool)->head + 1) % ((pool)->size); \
+        if ((pool)->size - (pool)->avail > (pool)->peak) \
+            (pool)->peak = (pool)->size - (pool)->avail; \
+        if ((pool)->chunk) \
+            ogs_pool_chunk_get((pool)->chunk, \
+                    ogs_pool_index(pool, *(node))-1); \
         (pool)->index[ogs_pool_index(pool, *(node))-1] = *(node); \
     } \
 } while (0)
@@ -146,39 +262,80 @@ typedef int32_t ogs_pool_id_t;
         (pool)->free[(pool)->tail] = (void*)(node); \
         (pool)->tail = ((pool)->tail + 1) % ((pool)->size); \
         (pool)->index[ogs_pool_index(pool, node)-1] = NULL; \
+        if ((pool)->chunk) \
+            ogs_pool_chunk_put((pool)->chunk, \
+                    ogs_pool_index(pool, node)-1); \
     } \
 } while (0)
 
+/*
+ * ogs_pool_trim() returns the chunks with no node in use to the system
+ * and gives the number of chunks released. The contents of free nodes
+ * are lost, so it shall not be used if they are read after free.
+ *
+ * A chunked pool keeps the memory of its busiest moment until trimmed.
+ * The NFs trim their pools from a periodic timer rather than on every
+ * free, so that a burst of sessions does not map and unmap the same
+ * chunks over and over.
+ */
+#define ogs_pool_trim(pool) \
+    ((pool)->chunk ? ogs_pool_chunk_trim((pool)->chunk) : 0)
+
 #define ogs_pool_index(pool, node) (((node) - (pool)->array)+1)
 #define ogs_pool_find(pool, _index) \
     (_index > 0 && _index <= (pool)->size) ? (pool)->index[_index-1] : NULL
 
+/*
+ * A pool id is a handle made of the slot index plus one in the low
+ * id_bits and a per-slot generation above it. ogs_pool_find_by_id()
+ * is a bounds check and one compare with the id of the node in the
+ * slot, so an id kept after ogs_pool_id_free() does not match the
+ * node that reuses the slot.
+ *
+ * A chunked pool hands a freed slot out again first, so the generation
+ * of a busy slot grows with every reuse. With 63-bit ids it is at least
+ * 32 bits wide for any pool size.
+ */
 #define ogs_pool_id_calloc(pool, node) do { \
     ogs_pool_alloc(pool, node); \
     if (*node) { \
         memset(*(node), 0, sizeof(**(node))); \
-        (*(node))->id = OGS_NEXT_ID((pool)->id, 1, OGS_MAX_POOL_ID); \
-        ogs_hash_set((pool)->id_hash, \
-                &((*(node))->id), sizeof(ogs_pool_id_t), *(node)); \
+        (*(node))->id = ogs_pool_id_next((pool)->id_last, \
+                (pool)->id_bits, ogs_pool_index(pool, *(node))-1); \
     } \
 } while (0)
 
 #define ogs_pool_id_free(pool, node) do { \
     ogs_assert(((node)->id) >= OGS_MIN_POOL_ID && \
             ((node)->id) <= OGS_MAX_POOL_ID); \
-    ogs_hash_set((pool)->id_hash, \
-            &((node)->id), sizeof(ogs_pool_id_t), NULL); \
     ogs_pool_free(pool, node); \
 } while (0)
 
-#define ogs_pool_find_by_id(pool, id) \
-    ogs_hash_get((pool)->id_hash, &id, sizeof(ogs_pool_id_t))
+#define ogs_pool_find_by_id(pool, _id) \
+    (((pool)->size > 0 && \
+      (pool)->index[ogs_pool_id_index(pool, _id)] && \
+      (pool)->index[ogs_pool_id_index(pool, _id)]->id == (_id)) ? \
+        (pool)->index[ogs_pool_id_index(pool, _id)] : NULL)
+
+/* Slot of the id, or 0 whose node never matches an invalid id */
+#define ogs_pool_id_index(pool, _id) \
+    ogs_pool_id_slot(_id, (pool)->id_bits, (pool)->size)
 
 #define ogs_pool_size(pool) ((pool)->size)
 #define ogs_pool_avail(pool) ((pool)->avail)
 
+/* High-water mark of nodes in use */
+#define ogs_pool_peak(pool) ((pool)->peak)
+/* Bytes of the array backed by memory */
+#define ogs_pool_committed(pool) \
+    ((pool)->chunk ? \
+        (size_t)(pool)->chunk->committed * \
+            (pool)->chunk->nodes * (pool)->chunk->node_size : \
+        (size_t)(pool)->size * sizeof(*(pool)->array))
+
 #define ogs_pool_sequence_id_generate(pool) do { \
     int i; \
+    ogs_assert(!(pool)->chunk); \
     for (i = 0; i < (pool)->size; i++) \
         (pool)->array[i] = i+1; \
 } while (0)
@@ -186,6 +343,7 @@ typedef int32_t ogs_pool_id_t;
 #define ogs_pool_random_id_generate(pool) do { \
     int i, j; \
     ogs_pool_id_t temp; \
+    ogs_assert(!(pool)->chunk); \
     for (i = 0; i < (pool)->size; i++) \
         (pool)->array[i] = i+1; \
     for (i = (pool)->size - 1; i > 0; i--) { \
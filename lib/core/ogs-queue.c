@@ -37,39 +37,51 @@
 #undef OGS_LOG_DOMAIN
 #define OGS_LOG_DOMAIN __ogs_event_domain
 
+/*
+ * Bounded ring of cells, each stamped with a sequence number telling
+ * whether it is free for the producer at a position or holds the item
+ * for the consumer at that position (D. Vyukov). Producers and consumers
+ * only contend on a compare-and-swap of 'in' or 'out'.
+ *
+ * The mutex and the condition variables are only used by the blocking
+ * calls, when the queue is found full or empty.
+ */
+typedef struct ogs_queue_cell_s {
+    size_t              sequence;
+    void                *data;
+} ogs_queue_cell_t;
+
+#define OGS_QUEUE_CACHELINE 64
+
 typedef struct ogs_queue_s {
-    void              **data;
-    unsigned int        nelts; /**< # elements */
-    unsigned int        in;    /**< next empty location */
-    unsigned int        out;   /**< next filled location */
+    ogs_queue_cell_t    *cell;
+    size_t              mask;  /**< ring size - 1 */
     unsigned int        bounds;/**< max size of queue */
+
+    char                pad0[OGS_QUEUE_CACHELINE];
+    size_t              in;    /**< next empty location */
+    char                pad1[OGS_QUEUE_CACHELINE];
+    size_t              out;   /**< next filled location */
+    char                pad2[OGS_QUEUE_CACHELINE];
+
     unsigned int        full_waiters;
     unsigned int        empty_waiters;
     ogs_thread_mutex_t  one_big_mutex;
     ogs_thread_cond_t   not_empty;
     ogs_thread_cond_t   not_full;
     int                 terminated;
+    unsigned int        interrupted;   /**< ogs_queue_interrupt_all() calls */
 } ogs_queue_t;
 
-/**
- * Detects when the ogs_queue_t is full. This utility function is expected
- * to be called from within critical sections, and is not threadsafe.
- */
-#define ogs_queue_full(queue) ((queue)->nelts == (queue)->bounds)
+#define ogs_queue_terminated(queue) \
+    ogs_atomic_load(&(queue)->terminated, OGS_ATOMIC_ACQUIRE)
 
-/**
- * Detects when the ogs_queue_t is empty. This utility function is expected
- * to be called from within critical sections, and is not threadsafe.
- */
-#define ogs_queue_empty(queue) ((queue)->nelts == 0)
-
-/**
- * Callback routine that is called to destroy this
- * ogs_queue_t when its pool is destroyed.
- */
 ogs_queue_t *ogs_queue_create(unsigned int capacity)
 {
     ogs_queue_t *queue = ogs_calloc(1, sizeof *queue);
+    size_t size = 1;
+    size_t i;
+
     if (!queue) {
         ogs_error("ogs_calloc() failed");
         return NULL;
@@ -80,14 +92,20 @@ ogs_queue_t *ogs_queue_create(unsigned int capacity)
     ogs_thread_cond_init(&queue->not_empty);
     ogs_thread_cond_init(&queue->not_full);
 
-    queue->data = ogs_calloc(1, capacity * sizeof(void*));
-    if (!queue->data) {
-        ogs_error("ogs_calloc[capacity:%d, sizeof(void*):%d] failed",
-                (int)capacity, (int)sizeof(void*));
+    while (size < capacity)
+        size <<= 1;
+
+    queue->cell = ogs_calloc(1, size * sizeof(ogs_queue_cell_t));
+    if (!queue->cell) {
+        ogs_error("ogs_calloc[capacity:%d, sizeof(ogs_queue_cell_t):%d] "
+                "failed", (int)capacity, (int)sizeof(ogs_queue_cell_t));
         return NULL;
     }
+    for (i = 0; i < size; i++)
+        queue->cell[i].sequence = i;
+
+    queue->mask = size - 1;
     queue->bounds = capacity;
-    queue->nelts = 0;
     queue->in = 0;
     queue->out = 0;
     queue->terminated = 0;
@@ -101,7 +119,7 @@ void ogs_queue_destroy(ogs_queue_t *queue)
 {
     ogs_assert(queue);
 
-    ogs_free(queue->data);
+    ogs_free(queue->cell);
 
     ogs_thread_cond_destroy(&queue->not_empty);
     ogs_thread_cond_destroy(&queue->not_full);
@@ -110,63 +128,161 @@ void ogs_queue_destroy(ogs_queue_t *queue)
     ogs_free(queue);
 }
 
+static int ring_push(ogs_queue_t *queue, void *data)
+{
+    ogs_queue_cell_t *cell = NULL;
+    size_t pos, out;
+    intptr_t dif;
+
+    pos = ogs_atomic_load(&queue->in, OGS_ATOMIC_RELAXED);
+    for ( ;; ) {
+        cell = &queue->cell[pos & queue->mask];
+        dif = (intptr_t)ogs_atomic_load(
+                &cell->sequence, OGS_ATOMIC_ACQUIRE) - (intptr_t)pos;
+        if (dif == 0) {
+            /* The ring may be larger than the requested capacity */
+            out = ogs_atomic_load(&queue->out, OGS_ATOMIC_ACQUIRE);
+            if ((intptr_t)(pos - out) >= (intptr_t)queue->bounds)
+                return OGS_RETRY;
+            if (ogs_atomic_cas(&queue->in, &pos, pos + 1,
+                        OGS_ATOMIC_RELAXED, OGS_ATOMIC_RELAXED))
+                break;
+        } else if (dif < 0) {
+            return OGS_RETRY;
+        } else {
+            pos = ogs_atomic_load(&queue->in, OGS_ATOMIC_RELAXED);
+        }
+    }
+
+    cell->data = data;
+    ogs_atomic_store(&cell->sequence, pos + 1, OGS_ATOMIC_RELEASE);
+
+    return OGS_OK;
+}
+
+/*
+ * Claims up to 'n' consecutive filled cells with a single
+ * compare-and-swap, and returns how many were taken.
+ */
+static unsigned int ring_pop(ogs_queue_t *queue, void **data, unsigned int n)
+{
+    size_t pos;
+    intptr_t dif = 0;
+    unsigned int i, k;
+
+    pos = ogs_atomic_load(&queue->out, OGS_ATOMIC_RELAXED);
+    for ( ;; ) {
+        for (k = 0; k < n; k++) {
+            ogs_queue_cell_t *cell = &queue->cell[(pos + k) & queue->mask];
+            dif = (intptr_t)ogs_atomic_load(
+                    &cell->sequence, OGS_ATOMIC_ACQUIRE) -
+                (intptr_t)(pos + k + 1);
+            if (dif != 0)
+                break;
+        }
+        if (k == 0) {
+            if (dif < 0)
+                return 0;
+            pos = ogs_atomic_load(&queue->out, OGS_ATOMIC_RELAXED);
+            continue;
+        }
+        if (ogs_atomic_cas(&queue->out, &pos, pos + k,
+                    OGS_ATOMIC_RELAXED, OGS_ATOMIC_RELAXED))
+            break;
+    }
+
+    for (i = 0; i < k; i++) {
+        ogs_queue_cell_t *cell = &queue->cell[(pos + i) & queue->mask];
+        data[i] = cell->data;
+        ogs_atomic_store(&cell->sequence,
+                pos + i + queue->mask + 1, OGS_ATOMIC_RELEASE);
+    }
+
+    return k;
+}
+
+/*
+ * A waiter registers itself and looks at the ring again before sleeping,
+ * while the other side publishes its item and then looks for waiters.
+ * The full fences on both sides guarantee one of them sees the other.
+ */
+static void queue_wakeup(ogs_queue_t *queue,
+        unsigned int *waiters, ogs_thread_cond_t *cond)
+{
+    ogs_atomic_fence(OGS_ATOMIC_SEQ_CST);
+    if (ogs_atomic_load(waiters, OGS_ATOMIC_RELAXED)) {
+        ogs_thread_mutex_lock(&queue->one_big_mutex);
+        ogs_trace("signal");
+        ogs_thread_cond_signal(cond);
+        ogs_thread_mutex_unlock(&queue->one_big_mutex);
+    }
+}
+
 static int queue_push(ogs_queue_t *queue, void *data, ogs_time_t timeout)
 {
     int rv;
+    unsigned int interrupted;
+    ogs_time_t deadline;
 
-    if (queue->terminated) {
+    if (ogs_queue_terminated(queue)) {
         return OGS_DONE; /* no more elements ever again */
     }
 
-    ogs_thread_mutex_lock(&queue->one_big_mutex);
-
-    if (ogs_queue_full(queue)) {
+    rv = ring_push(queue, data);
+    if (rv != OGS_OK) {
         if (!timeout) {
-            ogs_thread_mutex_unlock(&queue->one_big_mutex);
             return OGS_RETRY;
         }
-        if (!queue->terminated) {
-            queue->full_waiters++;
-            if (timeout > 0) {
-                rv = ogs_thread_cond_timedwait(&queue->not_full,
-                                               &queue->one_big_mutex,
-                                               timeout);
-            }
-            else {
-                rv = ogs_thread_cond_wait(&queue->not_full,
-                                          &queue->one_big_mutex);
-            }
-            queue->full_waiters--;
-            if (rv != OGS_OK) {
-                ogs_thread_mutex_unlock(&queue->one_big_mutex);
-                return rv;
-            }
-        }
-        /* If we wake up and it's still empty, then we were interrupted */
-        if (ogs_queue_full(queue)) {
-            ogs_warn("queue full (intr)");
-            ogs_thread_mutex_unlock(&queue->one_big_mutex);
-            if (queue->terminated) {
-                return OGS_DONE; /* no more elements ever again */
-            }
-            else {
-                return OGS_ERROR;
+
+        ogs_thread_mutex_lock(&queue->one_big_mutex);
+
+        ogs_atomic_fetch_add(&queue->full_waiters, 1, OGS_ATOMIC_RELAXED);
+        ogs_atomic_fence(OGS_ATOMIC_SEQ_CST);
+
+        rv = ring_push(queue, data);
+        if (rv != OGS_OK && !queue->terminated) {
+            interrupted = queue->interrupted;
+            deadline = ogs_get_monotonic_time() + timeout;
+            for ( ;; ) {
+                if (timeout > 0) {
+                    rv = ogs_thread_cond_timedwait(&queue->not_full,
+                            &queue->one_big_mutex,
+                            ogs_max(deadline - ogs_get_monotonic_time(), 0));
+                }
+                else {
+                    rv = ogs_thread_cond_wait(&queue->not_full,
+                                              &queue->one_big_mutex);
+                }
+                if (rv != OGS_OK)
+                    break;
+                rv = ring_push(queue, data);
+                if (rv == OGS_OK)
+                    break;
+                /* If we wake up and it's still full, we were interrupted */
+                if (queue->terminated || queue->interrupted != interrupted) {
+                    ogs_warn("queue full (intr)");
+                    rv = queue->terminated ? OGS_DONE : OGS_ERROR;
+                    break;
+                }
+                /*
+                 * Or a consumer made up its mind to signal before
+                 * we registered, and its cell has been taken since.
+                 */
             }
+        } else if (rv != OGS_OK) {
+            rv = OGS_DONE; /* no more elements ever again */
         }
-    }
 
-    queue->data[queue->in] = data;
-    queue->in++;
-    if (queue->in >= queue->bounds)
-        queue->in -= queue->bounds;
-    queue->nelts++;
+        ogs_atomic_fetch_sub(&queue->full_waiters, 1, OGS_ATOMIC_RELAXED);
 
-    if (queue->empty_waiters) {
-        ogs_trace("signal !empty");
-        ogs_thread_cond_signal(&queue->not_empty);
+        ogs_thread_mutex_unlock(&queue->one_big_mutex);
+
+        if (rv != OGS_OK)
+            return rv;
     }
 
-    ogs_thread_mutex_unlock(&queue->one_big_mutex);
+    queue_wakeup(queue, &queue->empty_waiters, &queue->not_empty);
+
     return OGS_OK;
 }
 
@@ -194,7 +310,8 @@ int ogs_queue_timedpush(ogs_queue_t *queue, void *data, ogs_time_t timeout)
  * not thread safe
  */
 unsigned int ogs_queue_size(ogs_queue_t *queue) {
-    return queue->nelts;
+    return ogs_atomic_load(&queue->in, OGS_ATOMIC_RELAXED) -
+        ogs_atomic_load(&queue->out, OGS_ATOMIC_RELAXED);
 }
 
 /**
@@ -206,61 +323,66 @@ unsigned int ogs_queue_size(ogs_queue_t *queue) {
  */
 static int queue_pop(ogs_queue_t *queue, void **data, ogs_time_t timeout)
 {
-    int rv;
+    int rv = OGS_OK;
+    unsigned int interrupted;
+    ogs_time_t deadline;
 
-    if (queue->terminated) {
+    if (ogs_queue_terminated(queue)) {
         return OGS_DONE; /* no more elements ever again */
     }
 
-    ogs_thread_mutex_lock(&queue->one_big_mutex);
-
-    /* Keep waiting until we wake up and find that the queue is not empty. */
-    if (ogs_queue_empty(queue)) {
+    if (!ring_pop(queue, data, 1)) {
         if (!timeout) {
-            ogs_thread_mutex_unlock(&queue->one_big_mutex);
             return OGS_RETRY;
         }
-        if (!queue->terminated) {
-            queue->empty_waiters++;
-            if (timeout > 0) {
-                rv = ogs_thread_cond_timedwait(&queue->not_empty,
-                                               &queue->one_big_mutex,
-                                               timeout);
-            }
-            else {
-                rv = ogs_thread_cond_wait(&queue->not_empty,
-                                          &queue->one_big_mutex);
-            }
-            queue->empty_waiters--;
-            if (rv != OGS_OK) {
-                ogs_thread_mutex_unlock(&queue->one_big_mutex);
-                return rv;
-            }
-        }
-        /* If we wake up and it's still empty, then we were interrupted */
-        if (ogs_queue_empty(queue)) {
-            ogs_warn("queue empty (intr)");
-            ogs_thread_mutex_unlock(&queue->one_big_mutex);
-            if (queue->terminated) {
-                return OGS_DONE; /* no more elements ever again */
-            } else {
-                return OGS_ERROR;
+
+        ogs_thread_mutex_lock(&queue->one_big_mutex);
+
+        ogs_atomic_fetch_add(&queue->empty_waiters, 1, OGS_ATOMIC_RELAXED);
+        ogs_atomic_fence(OGS_ATOMIC_SEQ_CST);
+
+        /* Look again now that a producer is bound to see us waiting */
+        if (!ring_pop(queue, data, 1)) {
+            interrupted = queue->interrupted;
+            deadline = ogs_get_monotonic_time() + timeout;
+            for ( ;; ) {
+                if (!queue->terminated) {
+                    if (timeout > 0) {
+                        rv = ogs_thread_cond_timedwait(&queue->not_empty,
+                                &queue->one_big_mutex,
+                                ogs_max(deadline - ogs_get_monotonic_time(),
+                                    0));
+                    }
+                    else {
+                        rv = ogs_thread_cond_wait(&queue->not_empty,
+                                                  &queue->one_big_mutex);
+                    }
+                }
+                if (rv != OGS_OK || ring_pop(queue, data, 1))
+                    break;
+                /* If we wake up and it's still empty, then we were interrupted */
+                if (queue->terminated || queue->interrupted != interrupted) {
+                    ogs_warn("queue empty (intr)");
+                    rv = queue->terminated ? OGS_DONE : OGS_ERROR;
+                    break;
+                }
+                /*
+                 * Or a producer made up its mind to signal before
+                 * we registered, and its item has been taken since.
+                 */
             }
         }
-    } 
 
-    *data = queue->data[queue->out];
-    queue->nelts--;
+        ogs_atomic_fetch_sub(&queue->empty_waiters, 1, OGS_ATOMIC_RELAXED);
+
+        ogs_thread_mutex_unlock(&queue->one_big_mutex);
 
-    queue->out++;
-    if (queue->out >= queue->bounds)
-        queue->out -= queue->bounds;
-    if (queue->full_waiters) {
-        ogs_trace("signal !full");
-        ogs_thread_cond_signal(&queue->not_full);
+        if (rv != OGS_OK)
+            return rv;
     }
 
-    ogs_thread_mutex_unlock(&queue->one_big_mutex);
+    queue_wakeup(queue, &queue->full_waiters, &queue->not_full);
+
     return OGS_OK;
 }
 
@@ -279,11 +401,41 @@ int ogs_queue_timedpop(ogs_queue_t *queue, void **data, ogs_time_t timeout)
     return queue_pop(queue, data, timeout);
 }
 
+/**
+ * Retrieves up to 'n' items at once without blocking. The number of
+ * items placed into 'data' is returned in 'count'. Returns OGS_RETRY
+ * if the queue is empty, and OGS_DONE once it has been terminated.
+ */
+int ogs_queue_trypop_bulk(ogs_queue_t *queue,
+        void **data, unsigned int n, unsigned int *count)
+{
+    ogs_assert(data);
+    ogs_assert(n);
+    ogs_assert(count);
+
+    *count = 0;
+
+    if (ogs_queue_terminated(queue)) {
+        return OGS_DONE; /* no more elements ever again */
+    }
+
+    *count = ring_pop(queue, data, n);
+    if (!*count) {
+        return OGS_RETRY;
+    }
+
+    queue_wakeup(queue, &queue->full_waiters, &queue->not_full);
+
+    return OGS_OK;
+}
+
 int ogs_queue_interrupt_all(ogs_queue_t *queue)
 {
     ogs_debug("interrupt all");
     ogs_thread_mutex_lock(&queue->one_big_mutex);
 
+    queue->interrupted++;
+
     ogs_thread_cond_broadcast(&queue->not_empty);
     ogs_thread_cond_broadcast(&queue->not_full);
 
@@ -300,9 +452,8 @@ int ogs_queue_term(ogs_queue_t *queue)
      * we could end up setting it and waking everybody up just after a 
      * would-be popper checks it but right before they block
      */
-    queue->terminated = 1;
+    ogs_atomic_store(&queue->terminated, 1, OGS_ATOMIC_RELEASE);
     ogs_thread_mutex_unlock(&queue->one_big_mutex);
 
     return ogs_queue_interrupt_all(queue);
 }
-
@@ -41,6 +41,8 @@ const ogs_pollset_actions_t ogs_select_actions = {
     select_process,
 
     ogs_notify_pollset,
+
+    NULL,
 };
 
 struct select_context_s {
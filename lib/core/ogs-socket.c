@@ -245,6 +245,143 @@ ssize_t ogs_recvfrom(ogs_socket_t fd,
     return recvfrom(fd, buf, len, flags, &from->sa, &addrlen);
 }
 
+static ssize_t send_pkbuf(ogs_socket_t fd, const ogs_pkbuf_t *pkbuf,
+        int flags, const struct sockaddr *sa, socklen_t addrlen)
+{
+#if !defined(_WIN32)
+    struct msghdr msg;
+    struct iovec iov[OGS_MAX_IOVEC];
+    int n = 0;
+
+    memset(&msg, 0, sizeof(msg));
+    for (; pkbuf; pkbuf = pkbuf->next) {
+        if (!pkbuf->len)
+            continue;
+        if (n == OGS_MAX_IOVEC) {
+            ogs_error("Too many segments [%d]", n);
+            errno = EMSGSIZE;
+            return -1;
+        }
+        iov[n].iov_base = pkbuf->data;
+        iov[n].iov_len = pkbuf->len;
+        n++;
+    }
+
+    msg.msg_name = (void *)sa;
+    msg.msg_namelen = addrlen;
+    msg.msg_iov = iov;
+    msg.msg_iovlen = n;
+
+    return sendmsg(fd, &msg, flags);
+#else
+    unsigned char *buf = NULL;
+    unsigned int len = ogs_pkbuf_chain_len(pkbuf);
+    ssize_t sent;
+
+    buf = ogs_malloc(len);
+    if (!buf) {
+        ogs_error("ogs_malloc(%d) failed", len);
+        return -1;
+    }
+
+    for (len = 0; pkbuf; pkbuf = pkbuf->next) {
+        memcpy(buf + len, pkbuf->data, pkbuf->len);
+        len += pkbuf->len;
+    }
+
+    if (sa)
+        sent = sendto(fd, buf, len, flags, sa, addrlen);
+    else
+        sent = send(fd, buf, len, flags);
+
+    ogs_free(buf);
+    return sent;
+#endif
+}
+
+ssize_t ogs_send_pkbuf(ogs_socket_t fd, const ogs_pkbuf_t *pkbuf, int flags)
+{
+    ogs_assert(fd != INVALID_SOCKET);
+    ogs_assert(pkbuf);
+
+    if (!pkbuf->next)
+        return send(fd, pkbuf->data, pkbuf->len, flags);
+
+    return send_pkbuf(fd, pkbuf, flags, NULL, 0);
+}
+
+ssize_t ogs_sendto_pkbuf(ogs_socket_t fd,
+        const ogs_pkbuf_t *pkbuf, int flags, const ogs_sockaddr_t *to)
+{
+    socklen_t addrlen;
+
+    ogs_assert(fd != INVALID_SOCKET);
+    ogs_assert(pkbuf);
+    ogs_assert(to);
+
+    addrlen = ogs_sockaddr_len(to);
+    ogs_assert(addrlen);
+
+    if (!pkbuf->next)
+        return sendto(fd, pkbuf->data, pkbuf->len, flags, &to->sa, addrlen);
+
+    return send_pkbuf(fd, pkbuf, flags, &to->sa, addrlen);
+}
+
+#if !defined(_WIN32)
+#if HAVE_RECVMMSG || HAVE_SENDMMSG
+OGS_STATIC_ASSERT(sizeof(ogs_mmsghdr_t) == sizeof(struct mmsghdr));
+#endif
+
+int ogs_recvmmsg(ogs_socket_t fd,
+        ogs_mmsghdr_t *msgvec, unsigned int vlen, int flags)
+{
+#if HAVE_RECVMMSG
+    ogs_assert(fd != INVALID_SOCKET);
+    ogs_assert(msgvec);
+    return recvmmsg(fd, (struct mmsghdr *)msgvec, vlen, flags, NULL);
+#else
+    unsigned int i;
+
+    ogs_assert(fd != INVALID_SOCKET);
+    ogs_assert(msgvec);
+
+    for (i = 0; i < vlen; i++) {
+        ssize_t size = recvmsg(fd, &msgvec[i].msg_hdr, flags);
+        if (size < 0)
+            return i ? (int)i : -1;
+        msgvec[i].msg_len = size;
+    }
+
+    return vlen;
+#endif
+}
+
+int ogs_sendmmsg(ogs_socket_t fd,
+        ogs_mmsghdr_t *msgvec, unsigned int vlen, int flags)
+{
+#if HAVE_SENDMMSG
+    ogs_assert(fd != INVALID_SOCKET);
+    ogs_assert(msgvec);
+    return sendmmsg(fd, (struct mmsghdr *)msgvec, vlen, flags);
+#else
+    unsigned int i;
+
+    ogs_assert(fd != INVALID_SOCKET);
+    ogs_assert(msgvec);
+
+    for (i = 0; i < vlen; i++) {
+        ssize_t size = sendmsg(fd, &msgvec[i].msg_hdr, flags);
+        if (size < 0)
+            return i ? (int)i : -1;
+        msgvec[i].msg_len = size;
+    }
+
+    return vlen;
+#endif
+}
+#endif
+
 int ogs_closesocket(ogs_socket_t fd)
 {
     int r;
@@ -69,6 +69,33 @@ ssize_t ogs_recv(ogs_socket_t fd, void *buf, size_t len, int flags);
 ssize_t ogs_recvfrom(ogs_socket_t fd,
         void *buf, size_t len, int flags, ogs_sockaddr_t *from);
 
+/*
+ * Send every segment of a chained pkbuf as one datagram.
+ * A chain is gathered with sendmsg(2) instead of being copied.
+ */
+#define OGS_MAX_IOVEC 16
+ssize_t ogs_send_pkbuf(ogs_socket_t fd, const ogs_pkbuf_t *pkbuf, int flags);
+ssize_t ogs_sendto_pkbuf(ogs_socket_t fd,
+        const ogs_pkbuf_t *pkbuf, int flags, const ogs_sockaddr_t *to);
+
+#if !defined(_WIN32)
+/*
+ * Same layout as Linux 'struct mmsghdr', so that it can be handed
+ * to recvmmsg(2)/sendmmsg(2) directly. On platforms without these
+ * system calls, ogs_recvmmsg()/ogs_sendmmsg() fall back to
+ * one recvmsg(2)/sendmsg(2) per message.
+ */
+typedef struct ogs_mmsghdr_s {
+    struct msghdr msg_hdr;
+    unsigned int msg_len;
+} ogs_mmsghdr_t;
+
+int ogs_recvmmsg(ogs_socket_t fd,
+        ogs_mmsghdr_t *msgvec, unsigned int vlen, int flags);
+int ogs_sendmmsg(ogs_socket_t fd,
+        ogs_mmsghdr_t *msgvec, unsigned int vlen, int flags);
+#endif
+
 int ogs_closesocket(ogs_socket_t fd);
 
 #ifdef __cplusplus
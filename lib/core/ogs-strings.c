@@ -147,10 +147,42 @@ char *ogs_cpystrn(char *dst, const char *src, size_t dst_size)
  * Memory Pool - Use talloc library
  *****************************************/
 
+/*
+ * With per-thread arenas, talloc is not involved at all and
+ * the strings are built on ogs_talloc_size() and friends instead.
+ */
+static char *arena_vasprintf_append(char *s, const char *fmt, va_list ap)
+{
+    va_list ap2;
+    size_t len;
+    int n;
+
+    va_copy(ap2, ap);
+    n = vsnprintf(NULL, 0, fmt, ap2);
+    va_end(ap2);
+    if (n < 0)
+        return NULL;
+
+    len = s ? strlen(s) : 0;
+    s = ogs_talloc_realloc_size(__ogs_talloc_core, s, len + n + 1, NULL);
+    if (!s)
+        return NULL;
+
+    vsnprintf(s + len, n + 1, fmt, ap);
+
+    return s;
+}
+
 char *ogs_talloc_strdup(const void *t, const char *p)
 {
     char *ptr = NULL;
 
+    if (ogs_mem_arena_enabled()) {
+        if (!p)
+            return NULL;
+        return ogs_talloc_memdup(t, p, strlen(p) + 1);
+    }
+
     ogs_thread_mutex_lock(ogs_mem_get_mutex());
 
     ptr = talloc_strdup(t, p);
@@ -165,6 +197,26 @@ char *ogs_talloc_strndup(const void *t, const char *p, size_t n)
 {
     char *ptr = NULL;
 
+    if (ogs_mem_arena_enabled()) {
+        const char *end = NULL;
+
+        if (!p)
+            return NULL;
+
+        end = memchr(p, '\0', n);
+        if (end)
+            n = end - p;
+
+        ptr = ogs_talloc_size(t, n + 1, NULL);
+        if (!ptr)
+            return NULL;
+
+        memcpy(ptr, p, n);
+        ptr[n] = '\0';
+
+        return ptr;
+    }
+
     ogs_thread_mutex_lock(ogs_mem_get_mutex());
 
     ptr = talloc_strndup(t, p, n);
@@ -179,6 +231,13 @@ void *ogs_talloc_memdup(const void *t, const void *p, size_t size)
 {
     void *ptr = NULL;
 
+    if (ogs_mem_arena_enabled()) {
+        ptr = ogs_talloc_size(t, size, NULL);
+        if (ptr)
+            memcpy(ptr, p, size);
+        return ptr;
+    }
+
     ogs_thread_mutex_lock(ogs_mem_get_mutex());
 
     ptr = talloc_memdup(t, p, size);
@@ -194,6 +253,15 @@ char *ogs_talloc_asprintf(const void *t, const char *fmt, ...)
     va_list ap;
     char *ret;
 
+    if (ogs_mem_arena_enabled()) {
+        va_start(ap, fmt);
+        ret = arena_vasprintf_append(NULL, fmt, ap);
+        ogs_expect(ret);
+        va_end(ap);
+
+        return ret;
+    }
+
     ogs_thread_mutex_lock(ogs_mem_get_mutex());
 
     va_start(ap, fmt);
@@ -210,6 +278,15 @@ char *ogs_talloc_asprintf_append(char *s, const char *fmt, ...)
 {
     va_list ap;
 
+    if (ogs_mem_arena_enabled()) {
+        va_start(ap, fmt);
+        s = arena_vasprintf_append(s, fmt, ap);
+        ogs_expect(s);
+        va_end(ap);
+
+        return s;
+    }
+
     ogs_thread_mutex_lock(ogs_mem_get_mutex());
 
     va_start(ap, fmt);
@@ -66,6 +66,8 @@ static void *thread_worker(void *arg)
     ogs_debug("[%p] worker signal", thread);
     thread->func(thread->data);
 
+    ogs_mem_arena_release();
+
     ogs_thread_mutex_lock(&thread->mutex);
     thread->running = false;
     ogs_thread_mutex_unlock(&thread->mutex);
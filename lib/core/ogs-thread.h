@@ -36,6 +36,7 @@ extern "C" {
 #define ogs_thread_mutex_t pthread_mutex_t
 #define ogs_thread_mutex_init(_n) (void)pthread_mutex_init((_n), NULL)
 #define ogs_thread_mutex_lock (void)pthread_mutex_lock
+#define ogs_thread_mutex_trylock(_n) (pthread_mutex_trylock(_n) == 0)
 #define ogs_thread_mutex_unlock (void)pthread_mutex_unlock
 #define ogs_thread_mutex_destroy (void)pthread_mutex_destroy
 #define ogs_thread_cond_t pthread_cond_t
@@ -69,10 +70,12 @@ static ogs_inline int ogs_thread_cond_timedwait(
 #define ogs_thread_cond_destroy (void)pthread_cond_destroy
 #define ogs_thread_id_t pthread_t
 #define ogs_thread_join(_n) pthread_join((_n), NULL)
+#define OGS_THREAD_LOCAL __thread
 #else
 #define ogs_thread_mutex_t CRITICAL_SECTION
 #define ogs_thread_mutex_init InitializeCriticalSection
 #define ogs_thread_mutex_lock EnterCriticalSection
+#define ogs_thread_mutex_trylock(_n) (TryEnterCriticalSection(_n) != 0)
 #define ogs_thread_mutex_unlock LeaveCriticalSection
 #define ogs_thread_mutex_destroy DeleteCriticalSection
 #define ogs_thread_cond_t CONDITION_VARIABLE
@@ -103,6 +106,7 @@ static ogs_inline int ogs_thread_cond_destroy(ogs_thread_cond_t *_ignored)
 {
    return 0;
 }
+#define OGS_THREAD_LOCAL __declspec(thread)
 #endif
 
 typedef struct ogs_thread_s ogs_thread_t;
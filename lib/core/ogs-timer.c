@@ -22,34 +22,138 @@
 #undef OGS_LOG_DOMAIN
 #define OGS_LOG_DOMAIN __ogs_event_domain
 
+/*
+ * Level L holds the timers whose tick first differs from the current one
+ * in the L-th group of WHEEL_BITS, indexed by that group. Level 0 is
+ * therefore sorted by tick, and the slots of a higher level are moved
+ * down when the current tick reaches them. Enough levels are kept to
+ * cover any 64-bit tick, so no timer falls outside the wheel.
+ */
+#define WHEEL_BITS      6
+#define WHEEL_SIZE      (1 << WHEEL_BITS)
+#define WHEEL_MASK      (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS    ((64 + WHEEL_BITS - 1) / WHEEL_BITS)
+
 typedef struct ogs_timer_mgr_s {
     OGS_POOL(pool, ogs_timer_t);
-    ogs_rbtree_t tree;
+
+    ogs_time_t resolution;
+    uint64_t tick;              /* First tick not yet expired */
+    unsigned int running;
+
+    uint64_t next;              /* Earliest tick, if next_valid */
+    bool next_valid;
+
+    uint64_t bitmap[WHEEL_LEVELS];
+    ogs_list_t slot[WHEEL_LEVELS][WHEEL_SIZE];
 } ogs_timer_mgr_t;
 
-static void add_timer_node(
-        ogs_rbtree_t *tree, ogs_timer_t *timer, ogs_time_t duration)
+static ogs_inline int lowest_bit(uint64_t x)
 {
-    ogs_rbnode_t **new = NULL;
-    ogs_rbnode_t *parent = NULL;
-    ogs_assert(tree);
-    ogs_assert(timer);
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    int n = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
 
-    timer->timeout = ogs_get_monotonic_time() + duration;
+static ogs_inline int level_of(uint64_t expires, uint64_t tick)
+{
+    uint64_t diff = (expires ^ tick) >> WHEEL_BITS;
+    int level = 0;
 
-    new = &tree->root;
-    while (*new) {
-        ogs_timer_t *this = ogs_rb_entry(*new, ogs_timer_t, rbnode);
+    while (diff) {
+        diff >>= WHEEL_BITS;
+        level++;
+    }
+
+    return level;
+}
 
-        parent = *new;
-        if (timer->timeout < this->timeout)
-            new = &(*new)->left;
-        else
-            new = &(*new)->right;
+static ogs_inline int slot_of(uint64_t expires, int level)
+{
+    return (expires >> (level * WHEEL_BITS)) & WHEEL_MASK;
+}
+
+static void wheel_add(ogs_timer_mgr_t *manager, ogs_timer_t *timer)
+{
+    uint64_t expires = ogs_max(timer->expires, manager->tick);
+    int level = level_of(expires, manager->tick);
+    int slot = slot_of(expires, level);
+
+    timer->list = &manager->slot[level][slot];
+    ogs_list_add(timer->list, &timer->lnode);
+    manager->bitmap[level] |= 1ULL << slot;
+}
+
+static void wheel_remove(ogs_timer_mgr_t *manager, ogs_timer_t *timer)
+{
+    ogs_list_t *list = timer->list;
+    int index;
+
+    ogs_list_remove(list, &timer->lnode);
+    timer->list = NULL;
+
+    index = list - &manager->slot[0][0];
+    if (index >= 0 && index < WHEEL_LEVELS * WHEEL_SIZE &&
+        ogs_list_empty(list))
+        manager->bitmap[index / WHEEL_SIZE] &=
+            ~(1ULL << (index % WHEEL_SIZE));
+}
+
+/*
+ * The first tick at which the wheel has work : a level-0 slot to expire
+ * or a higher slot to move down. Every level is considered, since a slot
+ * of a higher level may be due before the first slot of level 0, e.g.
+ * when the current tick has just reached the start of its block. On a tie,
+ * the higher level comes first so that its timers join the level-0 batch.
+ * Returns the level, or -1 if empty.
+ */
+static int wheel_event(ogs_timer_mgr_t *manager, uint64_t *tick, int *slot)
+{
+    int level, found = -1, s;
+    uint64_t base, event;
+
+    for (level = WHEEL_LEVELS - 1; level >= 0; level--) {
+        if (!manager->bitmap[level])
+            continue;
+
+        s = lowest_bit(manager->bitmap[level]);
+        base = (level + 1) * WHEEL_BITS < 64 ?
+            manager->tick &
+                ~((1ULL << ((level + 1) * WHEEL_BITS)) - 1) : 0;
+        event = base | ((uint64_t)s << (level * WHEEL_BITS));
+        if (event < manager->tick)
+            event = manager->tick;
+
+        if (found < 0 || event < *tick) {
+            found = level;
+            *tick = event;
+            *slot = s;
+        }
     }
 
-    ogs_rbtree_link_node(timer, parent, new);
-    ogs_rbtree_insert_color(tree, timer);
+    return found;
+}
+
+static void wheel_cascade(ogs_timer_mgr_t *manager, int level, int slot)
+{
+    ogs_list_t list = manager->slot[level][slot];
+
+    ogs_list_init(&manager->slot[level][slot]);
+    manager->bitmap[level] &= ~(1ULL << slot);
+
+    while (ogs_list_first(&list)) {
+        ogs_timer_t *timer = ogs_list_first(&list);
+
+        ogs_list_remove(&list, &timer->lnode);
+        wheel_add(manager, timer);
+    }
 }
 
 ogs_timer_mgr_t *ogs_timer_mgr_create(unsigned int capacity)
@@ -62,6 +166,9 @@ ogs_timer_mgr_t *ogs_timer_mgr_create(unsigned int capacity)
 
     ogs_pool_init(&manager->pool, capacity);
 
+    manager->resolution = OGS_TIMER_RESOLUTION;
+    manager->tick = ogs_get_monotonic_time() / manager->resolution;
+
     return manager;
 }
 
@@ -73,6 +180,21 @@ void ogs_timer_mgr_destroy(ogs_timer_mgr_t *manager)
     ogs_free(manager);
 }
 
+/*
+ * A coarser resolution batches more timers per tick at the cost of
+ * accuracy. It can only be changed while no timer is running.
+ */
+void ogs_timer_mgr_set_resolution(
+        ogs_timer_mgr_t *manager, ogs_time_t resolution)
+{
+    ogs_assert(manager);
+    ogs_assert(resolution > 0);
+    ogs_assert(manager->running == 0);
+
+    manager->resolution = resolution;
+    manager->tick = ogs_get_monotonic_time() / manager->resolution;
+}
+
 ogs_timer_t *ogs_timer_add(
         ogs_timer_mgr_t *manager, void (*cb)(void *data), void *data)
 {
@@ -117,10 +239,21 @@ void ogs_timer_start_debug(
     ogs_assert(manager);
 
     if (timer->running == true)
-        ogs_rbtree_delete(&manager->tree, timer);
+        ogs_timer_stop(timer);
 
     timer->running = true;
-    add_timer_node(&manager->tree, timer, duration);
+    manager->running++;
+
+    timer->timeout = ogs_get_monotonic_time() + duration;
+    timer->expires = (timer->timeout + manager->resolution - 1) /
+                        manager->resolution;
+    if (timer->expires < manager->tick)
+        timer->expires = manager->tick;
+
+    wheel_add(manager, timer);
+
+    if (manager->next_valid && timer->expires < manager->next)
+        manager->next = timer->expires;
 }
 
 void ogs_timer_stop_debug(ogs_timer_t *timer, const char *file_line)
@@ -134,54 +267,99 @@ void ogs_timer_stop_debug(ogs_timer_t *timer, const char *file_line)
         return;
 
     timer->running = false;
-    ogs_rbtree_delete(&manager->tree, timer);
+    manager->running--;
+
+    wheel_remove(manager, timer);
+
+    if (manager->next_valid && timer->expires == manager->next)
+        manager->next_valid = false;
 }
 
 ogs_time_t ogs_timer_mgr_next(ogs_timer_mgr_t *manager)
 {
-    ogs_time_t current;
-    ogs_rbnode_t *rbnode = NULL;
+    ogs_time_t current, timeout;
+    int level;
     ogs_assert(manager);
 
-    current = ogs_get_monotonic_time();
-    rbnode = ogs_rbtree_first(&manager->tree);
-    if (rbnode) {
-        ogs_timer_t *this = ogs_rb_entry(rbnode, ogs_timer_t, rbnode);
-        if (this->timeout > current) {
-            return (this->timeout - current);
-        } else {
-            return OGS_NO_WAIT_TIME;
+    if (!manager->running)
+        return OGS_INFINITE_TIME;
+
+    if (!manager->next_valid) {
+        manager->next = UINT64_MAX;
+
+        for (level = 0; level < WHEEL_LEVELS; level++) {
+            ogs_list_t *list = NULL;
+            ogs_timer_t *timer = NULL;
+
+            if (!manager->bitmap[level])
+                continue;
+
+            /* Only the first slot of each level can hold the earliest */
+            list = &manager->slot[level][lowest_bit(manager->bitmap[level])];
+            ogs_list_for_each(list, timer) {
+                if (timer->expires < manager->next)
+                    manager->next = timer->expires;
+            }
         }
+        ogs_assert(manager->next != UINT64_MAX);
+        manager->next_valid = true;
     }
 
-    return OGS_INFINITE_TIME;
+    current = ogs_get_monotonic_time();
+    timeout = (ogs_time_t)manager->next * manager->resolution;
+    if (timeout > current)
+        return (timeout - current);
+
+    return OGS_NO_WAIT_TIME;
 }
 
 void ogs_timer_mgr_expire(ogs_timer_mgr_t *manager)
 {
     OGS_LIST(list);
-    ogs_lnode_t *lnode;
-
-    ogs_time_t current;
-    ogs_rbnode_t *rbnode;
+    uint64_t current, tick;
+    int level, slot;
     ogs_timer_t *this;
     ogs_assert(manager);
 
-    current = ogs_get_monotonic_time();
-
-    ogs_rbtree_for_each(&manager->tree, rbnode) {
-        this = ogs_rb_entry(rbnode, ogs_timer_t, rbnode);
+    current = ogs_get_monotonic_time() / manager->resolution;
 
-        if (this->timeout > current)
+    while (manager->tick <= current) {
+        level = wheel_event(manager, &tick, &slot);
+        if (level < 0 || tick > current) {
+            manager->tick = current + 1;
             break;
+        }
+
+        manager->tick = tick;
+        if (level > 0) {
+            wheel_cascade(manager, level, slot);
+            continue;
+        }
+
+        /* Collect the whole slot as one batch */
+        this = ogs_list_first(&manager->slot[0][slot]);
+        while (this) {
+            ogs_timer_t *next = ogs_list_next(this);
 
-        ogs_list_add(&list, &this->lnode);
+            ogs_list_remove(this->list, &this->lnode);
+            this->list = &list;
+            ogs_list_add(&list, &this->lnode);
+            this = next;
+        }
+        manager->bitmap[0] &= ~(1ULL << slot);
+        manager->tick = tick + 1;
     }
 
-    /* You should not perform a delete on a timer using ogs_timer_delete()
-     * in a callback function this->cb(). */
-    ogs_list_for_each(&list, lnode) {
-        this = ogs_rb_entry(lnode, ogs_timer_t, lnode);
+    if (!ogs_list_first(&list))
+        return;
+
+    manager->next_valid = false;
+
+    /*
+     * A timer stopped, restarted or deleted by an earlier callback
+     * in the batch leaves the list and does not fire.
+     */
+    while ((this = ogs_list_first(&list))) {
         ogs_timer_stop(this);
         if (this->cb)
             this->cb(this->data);
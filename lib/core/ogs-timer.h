@@ -28,10 +28,17 @@
 extern "C" {
 #endif
 
+/*
+ * Timers are kept in a hierarchical timing wheel. Start and stop are O(1)
+ * and all timers due at the same tick expire as one batch. A timer never
+ * expires early, but may expire up to one resolution late.
+ */
+#define OGS_TIMER_RESOLUTION ogs_time_from_msec(1)
+
 typedef struct ogs_timer_mgr_s ogs_timer_mgr_t;
 typedef struct ogs_timer_s {
-    ogs_rbnode_t rbnode;
     ogs_lnode_t lnode;
+    ogs_list_t *list;           /* Wheel slot or expired batch */
 
     void (*cb)(void*);
     void *data;
@@ -39,10 +46,13 @@ typedef struct ogs_timer_s {
     ogs_timer_mgr_t *manager;
     bool running;
     ogs_time_t timeout;
+    uint64_t expires;           /* Tick of timeout, rounded up */
 } ogs_timer_t;
 
 ogs_timer_mgr_t *ogs_timer_mgr_create(unsigned int capacity);
 void ogs_timer_mgr_destroy(ogs_timer_mgr_t *manager);
+void ogs_timer_mgr_set_resolution(
+        ogs_timer_mgr_t *manager, ogs_time_t resolution);
 
 ogs_timer_t *ogs_timer_add(
         ogs_timer_mgr_t *manager, void (*cb)(void *data), void *data);
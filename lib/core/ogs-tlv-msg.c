@@ -95,11 +95,67 @@ static uint8_t tlv_ctype2mode(ogs_tlv_type_e ctype, uint8_t msg_mode)
     }
 }
 
-static ogs_tlv_t *tlv_add_leaf(
-        ogs_tlv_t *parent_tlv, ogs_tlv_t *tlv, ogs_tlv_desc_t *desc, void *msg, uint8_t msg_mode)
+static uint8_t tlv_header_size(uint8_t mode)
 {
-    uint8_t tlv_mode = tlv_ctype2mode(desc->ctype, msg_mode);
+    switch(mode) {
+    case OGS_TLV_MODE_T1_L1:
+        return 2;
+    case OGS_TLV_MODE_T1_L2:
+        return 3;
+    case OGS_TLV_MODE_T1_L2_I1:
+    case OGS_TLV_MODE_T2_L2:
+        return 4;
+    case OGS_TLV_MODE_T1:
+        return 1;
+    default:
+        ogs_assert_if_reached();
+        break;
+    }
+
+    return 0;
+}
+
+static void tlv_put_header(uint8_t *pos, uint8_t mode,
+        uint16_t type, uint32_t length, uint8_t instance)
+{
+    switch(mode) {
+    case OGS_TLV_MODE_T1_L1:
+        pos[0] = type & 0xFF;
+        pos[1] = length & 0xFF;
+        break;
+    case OGS_TLV_MODE_T1_L2:
+        pos[0] = type & 0xFF;
+        pos[1] = (length >> 8) & 0xFF;
+        pos[2] = length & 0xFF;
+        break;
+    case OGS_TLV_MODE_T1_L2_I1:
+        pos[0] = type & 0xFF;
+        pos[1] = (length >> 8) & 0xFF;
+        pos[2] = length & 0xFF;
+        pos[3] = instance & 0xFF;
+        break;
+    case OGS_TLV_MODE_T2_L2:
+        pos[0] = (type >> 8) & 0xFF;
+        pos[1] = type & 0xFF;
+        pos[2] = (length >> 8) & 0xFF;
+        pos[3] = length & 0xFF;
+        break;
+    case OGS_TLV_MODE_T1:
+        pos[0] = type & 0xFF;
+        break;
+    default:
+        ogs_assert_if_reached();
+        break;
+    }
+}
 
+/*
+ * Compute the value length of a leaf and, if pos is not NULL,
+ * write the value in network byte order.
+ */
+static int tlv_build_leaf(
+        ogs_tlv_desc_t *desc, void *msg, uint8_t *pos, uint32_t *length)
+{
     switch (desc->ctype) {
     case OGS_TLV_UINT8:
     case OGS_TLV_INT8:
@@ -107,21 +163,10 @@ static ogs_tlv_t *tlv_add_leaf(
     case OGS_TV_INT8:
     {
         ogs_tlv_uint8_t *v = (ogs_tlv_uint8_t *)msg;
-        if (parent_tlv) {
-            tlv = ogs_tlv_embed(parent_tlv, tlv_mode,
-                    desc->type, 1, desc->instance, &v->u8);
-            if (!tlv) {
-                ogs_error("ogs_tlv_embed()");
-                return NULL;
-            }
-        } else {
-            tlv = ogs_tlv_add(tlv, tlv_mode,
-                    desc->type, 1, desc->instance, &v->u8);
-            if (!tlv) {
-                ogs_error("ogs_tlv_add()");
-                return NULL;
-            }
-        }
+
+        *length = 1;
+        if (pos)
+            pos[0] = v->u8;
         break;
     }
     case OGS_TLV_UINT16:
@@ -131,22 +176,10 @@ static ogs_tlv_t *tlv_add_leaf(
     {
         ogs_tlv_uint16_t *v = (ogs_tlv_uint16_t *)msg;
 
-        v->u16 = htobe16(v->u16);
-
-        if (parent_tlv) {
-            tlv = ogs_tlv_embed(parent_tlv, tlv_mode,
-                    desc->type, 2, desc->instance, &v->u16);
-            if (!tlv) {
-                ogs_error("ogs_tlv_embed()");
-                return NULL;
-            }
-        } else {
-            tlv = ogs_tlv_add(tlv, tlv_mode,
-                    desc->type, 2, desc->instance, &v->u16);
-            if (!tlv) {
-                ogs_error("ogs_tlv_add()");
-                return NULL;
-            }
+        *length = 2;
+        if (pos) {
+            pos[0] = (v->u16 >> 8) & 0xFF;
+            pos[1] = v->u16 & 0xFF;
         }
         break;
     }
@@ -157,23 +190,11 @@ static ogs_tlv_t *tlv_add_leaf(
     {
         ogs_tlv_uint24_t *v = (ogs_tlv_uint24_t *)msg;
 
-        v->u24 = v->u24 << 8;
-        v->u24 = htobe32(v->u24);
-
-        if (parent_tlv) {
-            tlv = ogs_tlv_embed(parent_tlv, tlv_mode,
-                    desc->type, 3, desc->instance, &v->u24);
-            if (!tlv) {
-                ogs_error("ogs_tlv_embed()");
-                return NULL;
-            }
-        } else {
-            tlv = ogs_tlv_add(tlv, tlv_mode,
-                    desc->type, 3, desc->instance, &v->u24);
-            if (!tlv) {
-                ogs_error("ogs_tlv_add()");
-                return NULL;
-            }
+        *length = 3;
+        if (pos) {
+            pos[0] = (v->u24 >> 16) & 0xFF;
+            pos[1] = (v->u24 >> 8) & 0xFF;
+            pos[2] = v->u24 & 0xFF;
         }
         break;
     }
@@ -184,22 +205,12 @@ static ogs_tlv_t *tlv_add_leaf(
     {
         ogs_tlv_uint32_t *v = (ogs_tlv_uint32_t *)msg;
 
-        v->u32 = htobe32(v->u32);
-
-        if (parent_tlv) {
-            tlv = ogs_tlv_embed(parent_tlv, tlv_mode,
-                    desc->type, 4, desc->instance, &v->u32);
-            if (!tlv) {
-                ogs_error("ogs_tlv_embed()");
-                return NULL;
-            }
-        } else {
-            tlv = ogs_tlv_add(tlv, tlv_mode,
-                    desc->type, 4, desc->instance, &v->u32);
-            if (!tlv) {
-                ogs_error("ogs_tlv_add()");
-                return NULL;
-            }
+        *length = 4;
+        if (pos) {
+            pos[0] = (v->u32 >> 24) & 0xFF;
+            pos[1] = (v->u32 >> 16) & 0xFF;
+            pos[2] = (v->u32 >> 8) & 0xFF;
+            pos[3] = v->u32 & 0xFF;
         }
         break;
     }
@@ -208,21 +219,11 @@ static ogs_tlv_t *tlv_add_leaf(
     {
         ogs_tlv_octet_t *v = (ogs_tlv_octet_t *)msg;
 
-        if (parent_tlv) {
-            tlv = ogs_tlv_embed(parent_tlv, tlv_mode,
-                    desc->type, desc->length, desc->instance, v->data);
-            if (!tlv) {
-                ogs_error("ogs_tlv_embed()");
-                return NULL;
-            }
-        } else {
-            tlv = ogs_tlv_add(tlv, tlv_mode,
-                    desc->type, desc->length, desc->instance, v->data);
-            if (!tlv) {
-                ogs_error("ogs_tlv_add()");
-                return NULL;
-            }
-        }
+        *length = desc->length;
+        if (*length)
+            ogs_assert(v->data);
+        if (pos)
+            memcpy(pos, v->data, *length);
         break;
     }
     case OGS_TLV_VAR_STR:
@@ -232,125 +233,114 @@ static ogs_tlv_t *tlv_add_leaf(
         if (v->len == 0) {
             ogs_error("No TLV length - [%s] T:%d I:%d (vsz=%d)",
                     desc->name, desc->type, desc->instance, desc->vsize);
-            return NULL;
+            return OGS_ERROR;
         }
+        ogs_assert(v->data);
 
-        if (parent_tlv) {
-            tlv = ogs_tlv_embed(parent_tlv, tlv_mode,
-                    desc->type, v->len, desc->instance, v->data);
-            if (!tlv) {
-                ogs_error("ogs_tlv_embed()");
-                return NULL;
-            }
-        } else {
-            tlv = ogs_tlv_add(tlv, tlv_mode,
-                    desc->type, v->len, desc->instance, v->data);
-            if (!tlv) {
-                ogs_error("ogs_tlv_add()");
-                return NULL;
-            }
-        }
+        *length = v->len;
+        if (pos)
+            memcpy(pos, v->data, *length);
         break;
     }
     case OGS_TLV_NULL:
     case OGS_TV_NULL:
-    {
-        if (parent_tlv) {
-            tlv = ogs_tlv_embed(parent_tlv, tlv_mode,
-                    desc->type, 0, desc->instance, NULL);
-            if (!tlv) {
-                ogs_error("ogs_tlv_embed()");
-                return NULL;
-            }
-        } else {
-            tlv = ogs_tlv_add(tlv, tlv_mode,
-                    desc->type, 0, desc->instance, NULL);
-            if (!tlv) {
-                ogs_error("ogs_tlv_add()");
-                return NULL;
-            }
-        }
+        *length = 0;
         break;
-    }
     default:
         ogs_error("Unknown type [%d]", desc->ctype);
-        return NULL;
+        return OGS_ERROR;
     }
 
-    return tlv;
+    return OGS_OK;
 }
 
-static uint32_t tlv_add_compound(ogs_tlv_t **root, ogs_tlv_t *parent_tlv,
-        ogs_tlv_desc_t *parent_desc, void *msg, int depth, uint8_t mode)
+static uint32_t tlv_build_compound(ogs_tlv_desc_t *parent_desc, void *msg,
+        uint8_t *data, uint32_t *length, int depth, uint8_t mode);
+
+/*
+ * Encode one IE at data + *length and advance *length past it.
+ * With data == NULL, only the length is computed.
+ * A compound is written as its children first, then its header
+ * is filled in with the length they took.
+ */
+static uint32_t tlv_build_element(ogs_tlv_desc_t *desc, void *msg,
+        uint8_t *data, uint32_t *length, int depth, uint8_t mode)
+{
+    uint8_t tlv_mode = tlv_ctype2mode(desc->ctype, mode);
+    uint32_t header = *length, value = 0, count;
+    char indent[17] = "                "; /* 16 spaces */
+
+    ogs_assert(depth <= 8);
+    indent[depth*2] = 0;
+
+    *length += tlv_header_size(tlv_mode);
+
+    if (desc->ctype == OGS_TLV_COMPOUND) {
+        ogs_trace("BUILD %sC [%s] T:%d I:%d (vsz=%d) off:%p ",
+                indent, desc->name, desc->type, desc->instance,
+                desc->vsize, msg);
+
+        count = tlv_build_compound(desc,
+                (uint8_t *)msg + sizeof(ogs_tlv_presence_t),
+                data, length, depth + 1, mode);
+        if (count == 0) {
+            ogs_error("tlv_build_compound() failed");
+            return 0;
+        }
+        count++;
+
+        value = *length - header - tlv_header_size(tlv_mode);
+    } else {
+        ogs_trace("BUILD %sL [%s] T:%d L:%d I:%d (cls:%d vsz:%d) off:%p ",
+                indent, desc->name, desc->type, desc->length,
+                desc->instance, desc->ctype, desc->vsize, msg);
+
+        if (tlv_build_leaf(desc, msg,
+                    data ? data + *length : NULL, &value) != OGS_OK) {
+            ogs_error("tlv_build_leaf() failed");
+            return 0;
+        }
+        count = 1;
+
+        *length += value;
+    }
+
+    if (data)
+        tlv_put_header(data + header, tlv_mode,
+                desc->type, value, desc->instance);
+
+    return count;
+}
+
+/* Return the number of IEs encoded, or 0 on failure or if none is present */
+static uint32_t tlv_build_compound(ogs_tlv_desc_t *parent_desc, void *msg,
+        uint8_t *data, uint32_t *length, int depth, uint8_t mode)
 {
     ogs_tlv_presence_t *presence_p;
     ogs_tlv_desc_t *desc = NULL, *next_desc = NULL;
-    ogs_tlv_t *tlv = NULL, *emb_tlv = NULL;
     uint8_t *p = msg;
-    uint32_t offset = 0, count = 0;
-    int i, j, r;
-    char indent[17] = "                "; /* 16 spaces */
+    uint32_t offset = 0, count = 0, r;
+    int i, j;
 
-    ogs_assert(root);
     ogs_assert(parent_desc);
     ogs_assert(msg);
 
-    ogs_assert(depth <= 8);
-    indent[depth*2] = 0;
-
-    *root = NULL;
-
     for (i = 0, desc = parent_desc->child_descs[i]; desc != NULL;
             i++, desc = parent_desc->child_descs[i]) {
         next_desc = parent_desc->child_descs[i+1];
         if (next_desc != NULL && next_desc->ctype == OGS_TLV_MORE) {
-            int offset2 = offset;
+            uint32_t offset2 = offset;
             for (j = 0; j < next_desc->length; j++) {
                 presence_p = (ogs_tlv_presence_t *)(p + offset2);
 
                 if (*presence_p == 0)
                     break;
 
-                if (desc->ctype == OGS_TLV_COMPOUND) {
-                    ogs_trace("BUILD %sC#%d [%s] T:%d I:%d (vsz=%d) off:%p ",
-                            indent, i, desc->name, desc->type, desc->instance,
-                            desc->vsize, p + offset2);
-
-                    if (parent_tlv)
-                        tlv = ogs_tlv_embed(parent_tlv,
-                                tlv_ctype2mode(desc->ctype, mode),
-                                desc->type, 0, desc->instance, NULL);
-                    else
-                        tlv = ogs_tlv_add(tlv,
-                                tlv_ctype2mode(desc->ctype, mode),
-                                desc->type, 0, desc->instance, NULL);
-
-                    r = tlv_add_compound(&emb_tlv, tlv, desc,
-                            p + offset2 + sizeof(ogs_tlv_presence_t),
-                            depth + 1, mode);
-                    if (r <= 0 || !emb_tlv) {
-                        ogs_error("tlv_add_compound() failed");
-                        return 0;
-                    }
-                    count += 1 + r;
-                } else {
-                    ogs_trace("BUILD %sL#%d [%s] T:%d L:%d I:%d "
-                            "(cls:%d vsz:%d) off:%p ",
-                            indent, i, desc->name, desc->type, desc->length,
-                            desc->instance, desc->ctype, desc->vsize,
-                            p + offset2);
-
-                    tlv = tlv_add_leaf(parent_tlv, tlv, desc,
-                            p + offset2, mode);
-                    if (!tlv) {
-                        ogs_error("tlv_add_leaf() failed");
-                        return 0;
-                    }
-                    count++;
-                }
-
-                if (*root == NULL)
-                    *root = tlv;
+                r = tlv_build_element(
+                        desc, p + offset2, data, length, depth, mode);
+                if (r == 0)
+                    return 0;
+                count += r;
 
                 offset2 += desc->vsize;
             }
@@ -360,45 +350,11 @@ static uint32_t tlv_add_compound(ogs_tlv_t **root, ogs_tlv_t *parent_tlv,
             presence_p = (ogs_tlv_presence_t *)(p + offset);
 
             if (*presence_p) {
-                if (desc->ctype == OGS_TLV_COMPOUND) {
-                    ogs_trace("BUILD %sC#%d [%s] T:%d I:%d (vsz=%d) off:%p ",
-                            indent, i, desc->name, desc->type, desc->instance,
-                            desc->vsize, p + offset);
-
-                    if (parent_tlv)
-                        tlv = ogs_tlv_embed(parent_tlv,
-                                tlv_ctype2mode(desc->ctype, mode),
-                                desc->type, 0, desc->instance, NULL);
-                    else
-                        tlv = ogs_tlv_add(tlv,
-                                tlv_ctype2mode(desc->ctype, mode),
-                                desc->type, 0, desc->instance, NULL);
-
-                    r = tlv_add_compound(&emb_tlv, tlv, desc,
-                            p + offset + sizeof(ogs_tlv_presence_t),
-                            depth + 1, mode);
-                    if (r <= 0 || !emb_tlv) {
-                        ogs_error("tlv_add_compound() failed");
-                        return 0;
-                    }
-                    count += 1 + r;
-                } else {
-                    ogs_trace("BUILD %sL#%d [%s] T:%d L:%d I:%d "
-                            "(cls:%d vsz:%d) off:%p ",
-                            indent, i, desc->name, desc->type, desc->length,
-                            desc->instance, desc->ctype, desc->vsize,
-                            p + offset);
-
-                    tlv = tlv_add_leaf(parent_tlv, tlv, desc, p + offset, mode);
-                    if (!tlv) {
-                        ogs_error("tlv_add_leaf() failed");
-                        return 0;
-                    }
-                    count++;
-                }
-
-                if (*root == NULL)
-                    *root = tlv;
+                r = tlv_build_element(
+                        desc, p + offset, data, length, depth, mode);
+                if (r == 0)
+                    return 0;
+                count += r;
             }
             offset += desc->vsize;
         }
@@ -407,10 +363,14 @@ static uint32_t tlv_add_compound(ogs_tlv_t **root, ogs_tlv_t *parent_tlv,
     return count;
 }
 
+/*
+ * The message is encoded straight into the pkbuf.
+ * A first walk over the descriptions computes the length
+ * so that the pkbuf is allocated at its exact size.
+ */
 ogs_pkbuf_t *ogs_tlv_build_msg(ogs_tlv_desc_t *desc, void *msg, int mode)
 {
-    ogs_tlv_t *root = NULL;
-    uint32_t r, length, rendlen;
+    uint32_t r, length = 0, rendlen = 0;
     ogs_pkbuf_t *pkbuf = NULL;
 
     ogs_assert(desc);
@@ -419,16 +379,13 @@ ogs_pkbuf_t *ogs_tlv_build_msg(ogs_tlv_desc_t *desc, void *msg, int mode)
     ogs_assert(desc->ctype == OGS_TLV_MESSAGE);
 
     if (desc->child_descs[0]) {
-        r = tlv_add_compound(&root, NULL, desc, msg, 0, mode);
-        if (r <= 0 || !root) {
-            ogs_error("tlv_add_compound() failed");
+        r = tlv_build_compound(desc, msg, NULL, &length, 0, mode);
+        if (r == 0) {
+            ogs_error("tlv_build_compound() failed");
             return NULL;
         }
-
-        length = ogs_tlv_calc_length(root);
-    } else {
-        length = 0;
     }
+
     pkbuf = ogs_pkbuf_alloc(NULL, OGS_TLV_MAX_HEADROOM+length);
     if (!pkbuf) {
         ogs_error("ogs_pkbuf_alloc() failed");
@@ -438,24 +395,32 @@ ogs_pkbuf_t *ogs_tlv_build_msg(ogs_tlv_desc_t *desc, void *msg, int mode)
     ogs_pkbuf_put(pkbuf, length);
 
     if (desc->child_descs[0]) {
-        rendlen = ogs_tlv_render(root, pkbuf->data, length);
+        tlv_build_compound(desc, msg, pkbuf->data, &rendlen, 0, mode);
         if (rendlen != length) {
-            ogs_error("ogs_tlv_render[rendlen:%d != length:%d] failed",
+            ogs_error("tlv_build_compound[rendlen:%d != length:%d] failed",
                     rendlen, length);
+            ogs_pkbuf_free(pkbuf);
             return NULL;
         }
-
-        ogs_tlv_free_all(root);
     }
 
     return pkbuf;
 }
 
-static ogs_tlv_desc_t* tlv_find_desc_by_type_inst(uint8_t *desc_index,
-        uint32_t *tlv_offset, ogs_tlv_desc_t *parent_desc, uint16_t match_type, uint8_t match_instance, uint8_t match_type_pos)
+/*
+ * Find the n-th description matching <type,instance>, where n is the
+ * number of such IEs already parsed in this compound. The count is kept
+ * per description index, at the first description of that <type,instance>.
+ * With count == NULL, the first match is returned.
+ */
+static ogs_tlv_desc_t *tlv_find_desc(uint8_t *desc_index,
+        uint32_t *tlv_offset, uint8_t *first_index,
+        ogs_tlv_desc_t *parent_desc, uint8_t *count,
+        uint16_t match_type, uint8_t match_instance)
 {
     ogs_tlv_desc_t *prev_desc = NULL, *desc = NULL;
-    int i, offset = 0;
+    int i, first = -1;
+    uint32_t offset = 0;
     unsigned match_i = 0;
 
     ogs_assert(parent_desc);
@@ -463,9 +428,12 @@ static ogs_tlv_desc_t* tlv_find_desc_by_type_inst(uint8_t *desc_index,
     for (i = 0, desc = parent_desc->child_descs[i]; desc != NULL;
             i++, desc = parent_desc->child_descs[i]) {
         if (desc->type == match_type && desc->instance == match_instance) {
-            if (match_i == match_type_pos) {
+            if (first < 0)
+                first = i;
+            if (match_i == (count ? count[first] : 0)) {
                 *desc_index = i;
                 *tlv_offset = offset;
+                *first_index = first;
                 break;
             }
             match_i++;
@@ -484,11 +452,12 @@ static ogs_tlv_desc_t* tlv_find_desc_by_type_inst(uint8_t *desc_index,
     return desc;
 }
 
-static int tlv_parse_leaf(void *msg, ogs_tlv_desc_t *desc, ogs_tlv_t *tlv)
+static int tlv_parse_leaf(void *msg, ogs_tlv_desc_t *desc,
+        uint8_t *value, uint32_t length)
 {
     ogs_assert(msg);
     ogs_assert(desc);
-    ogs_assert(tlv);
+    ogs_assert(value);
 
     switch (desc->ctype) {
     case OGS_TV_UINT8:
@@ -498,11 +467,11 @@ static int tlv_parse_leaf(void *msg, ogs_tlv_desc_t *desc, ogs_tlv_t *tlv)
     {
         ogs_tlv_uint8_t *v = (ogs_tlv_uint8_t *)msg;
 
-        if (tlv->length != 1) {
-            ogs_error("Invalid TLV length %d. It should be 1", tlv->length);
+        if (length != 1) {
+            ogs_error("Invalid TLV length %d. It should be 1", length);
             return OGS_ERROR;
         }
-        v->u8 = *(uint8_t*)(tlv->value);
+        v->u8 = value[0];
         break;
     }
     case OGS_TV_UINT16:
@@ -512,12 +481,12 @@ static int tlv_parse_leaf(void *msg, ogs_tlv_desc_t *desc, ogs_tlv_t *tlv)
     {
         ogs_tlv_uint16_t *v = (ogs_tlv_uint16_t *)msg;
 
-        if (tlv->length < 1 || tlv->length > 2) {
-            ogs_error("Invalid TLV length %d.", tlv->length);
+        if (length < 1 || length > 2) {
+            ogs_error("Invalid TLV length %d.", length);
             return OGS_ERROR;
         }
-        v->u16 = ((((uint8_t*)tlv->value)[0]<< 8)&0xff00) |
-               ((((uint8_t*)tlv->value)[1]    )&0x00ff);
+        v->u16 = ((value[0]<< 8)&0xff00) |
+               ((value[1]    )&0x00ff);
         break;
     }
     case OGS_TV_UINT24:
@@ -527,13 +496,13 @@ static int tlv_parse_leaf(void *msg, ogs_tlv_desc_t *desc, ogs_tlv_t *tlv)
     {
         ogs_tlv_uint24_t *v = (ogs_tlv_uint24_t *)msg;
 
-        if (tlv->length < 1 || tlv->length > 3) {
-            ogs_error("Invalid TLV length %d.", tlv->length);
+        if (length < 1 || length > 3) {
+            ogs_error("Invalid TLV length %d.", length);
             return OGS_ERROR;
         }
-        v->u24 = ((((uint8_t*)tlv->value)[0]<<16)&0x00ff0000) |
-               ((((uint8_t*)tlv->value)[1]<< 8)&0x0000ff00) |
-               ((((uint8_t*)tlv->value)[2]    )&0x000000ff);
+        v->u24 = ((value[0]<<16)&0x00ff0000) |
+               ((value[1]<< 8)&0x0000ff00) |
+               ((value[2]    )&0x000000ff);
         break;
     }
     case OGS_TV_UINT32:
@@ -543,14 +512,14 @@ static int tlv_parse_leaf(void *msg, ogs_tlv_desc_t *desc, ogs_tlv_t *tlv)
     {
         ogs_tlv_uint32_t *v = (ogs_tlv_uint32_t *)msg;
 
-        if (tlv->length < 1 || tlv->length > 4) {
-            ogs_error("Invalid TLV length %d.", tlv->length);
+        if (length < 1 || length > 4) {
+            ogs_error("Invalid TLV length %d.", length);
             return OGS_ERROR;
         }
-        v->u32 = ((((uint8_t*)tlv->value)[0]<<24)&0xff000000) |
-               ((((uint8_t*)tlv->value)[1]<<16)&0x00ff0000) |
-               ((((uint8_t*)tlv->value)[2]<< 8)&0x0000ff00) |
-               ((((uint8_t*)tlv->value)[3]    )&0x000000ff);
+        v->u32 = ((value[0]<<24)&0xff000000) |
+               ((value[1]<<16)&0x00ff0000) |
+               ((value[2]<< 8)&0x0000ff00) |
+               ((value[3]    )&0x000000ff);
         break;
     }
     case OGS_TV_FIXED_STR:
@@ -558,30 +527,30 @@ static int tlv_parse_leaf(void *msg, ogs_tlv_desc_t *desc, ogs_tlv_t *tlv)
     {
         ogs_tlv_octet_t *v = (ogs_tlv_octet_t *)msg;
 
-        if (tlv->length != desc->length)
+        if (length != desc->length)
         {
             ogs_error("Invalid TLV length %d. It should be %d",
-                    tlv->length, desc->length);
+                    length, desc->length);
             return OGS_ERROR;
         }
 
-        v->data = tlv->value;
-        v->len = tlv->length;
+        v->data = value;
+        v->len = length;
         break;
     }
     case OGS_TLV_VAR_STR:
     {
         ogs_tlv_octet_t *v = (ogs_tlv_octet_t *)msg;
 
-        v->data = tlv->value;
-        v->len = tlv->length;
+        v->data = value;
+        v->len = length;
         break;
     }
     case OGS_TV_NULL:
     case OGS_TLV_NULL:
     {
-        if (tlv->length != 0) {
-            ogs_error("Invalid TLV length %d. It should be 0", tlv->length);
+        if (length != 0) {
+            ogs_error("Invalid TLV length %d. It should be 0", length);
             return OGS_ERROR;
         }
         break;
@@ -594,83 +563,149 @@ static int tlv_parse_leaf(void *msg, ogs_tlv_desc_t *desc, ogs_tlv_t *tlv)
     return OGS_OK;
 }
 
-/* rbtree structure used to keep track count of TLVs with given <type,instance>
- * while parsing. This is used to link it to the matching nth field in a
- * ogs_tlv_desc_t struct */
-typedef struct tlv_count_node_s {
-    ogs_rbnode_t node;
-    uint32_t key; /* type<<8 + instance */
-    unsigned count;
-} tlv_count_node_t;
-
-static tlv_count_node_t *tlv_count_node_find(ogs_rbtree_t *tree, tlv_count_node_t *count_node_arr, unsigned count_node_arr_len,
-        unsigned *count_alloc_next, uint16_t type, uint8_t instance)
+/*
+ * Decode the element header at pos. Return a pointer to its value,
+ * or NULL if the element does not fit in the block.
+ */
+static uint8_t *tlv_get_header(uint8_t *pos, uint8_t *end,
+        uint8_t mode, uint32_t fixed_length,
+        uint16_t *type, uint32_t *length, uint8_t *instance)
 {
-    ogs_rbnode_t **new = NULL;
-    ogs_rbnode_t *parent = NULL;
-    tlv_count_node_t *this;
-
-    uint64_t key = (((uint32_t)type)<<8) | instance;
-
-    new = &tree->root;
-    while (*new) {
-        this = ogs_rb_entry(*new, tlv_count_node_t, node);
-        parent = *new;
-        if (key < this->key) {
-            new = &(*new)->left;
-        } else if (key > this->key) {
-            new = &(*new)->right;
-        } else { /* found entry: */
-            return this;
-        }
+    if (end - pos < tlv_header_size(mode))
+        return NULL;
+
+    *instance = 0;
+
+    switch(mode) {
+    case OGS_TLV_MODE_T1_L1:
+        *type = pos[0];
+        *length = pos[1];
+        break;
+    case OGS_TLV_MODE_T1_L2:
+        *type = pos[0];
+        *length = (pos[1] << 8) | pos[2];
+        break;
+    case OGS_TLV_MODE_T1_L2_I1:
+        *type = pos[0];
+        *length = (pos[1] << 8) | pos[2];
+        *instance = pos[3] & 0b00001111;
+        break;
+    case OGS_TLV_MODE_T2_L2:
+        *type = (pos[0] << 8) | pos[1];
+        *length = (pos[2] << 8) | pos[3];
+        break;
+    case OGS_TLV_MODE_T1:
+        *type = pos[0];
+        *length = fixed_length;
+        break;
+    default:
+        ogs_assert_if_reached();
+        break;
     }
 
-    /* No entry, need to add one: */
-    if (*count_alloc_next == count_node_arr_len) {
-        ogs_error("This TLV has to many entries, can't parse");
+    pos += tlv_header_size(mode);
+    if (end - pos < *length)
         return NULL;
+
+    return pos;
+}
+
+static uint16_t parse_get_element_type(uint8_t *pos, uint8_t mode)
+{
+    uint16_t type;
+
+    switch(mode) {
+    case OGS_TLV_MODE_T1_L1:
+    case OGS_TLV_MODE_T1_L2:
+    case OGS_TLV_MODE_T1_L2_I1:
+    case OGS_TLV_MODE_T1:
+        type = *pos;
+        break;
+    case OGS_TLV_MODE_T2_L2:
+        type = *(pos++) << 8;
+        type += *(pos++);
+        break;
+    default:
+        ogs_assert_if_reached();
+        break;
     }
-    this = &count_node_arr[(*count_alloc_next)++];
-    this->key = key;
-    this->count = 0;
-    ogs_rbtree_link_node(&this->node, parent, new);
-    ogs_rbtree_insert_color(tree, &this->node);
-    return this;
+
+    return type;
 }
 
+/*
+ * Walk the IEs of a block and store each one straight into the message.
+ *
+ * If by_desc is true, the format of each IE (TLV or TV, and the length
+ * of a TV) is taken from its description instead of the message mode.
+ * This allows parsing messages which mix both (for instance GTPv1-C).
+ */
 static int tlv_parse_compound(void *msg, ogs_tlv_desc_t *parent_desc,
-        ogs_tlv_t *parent_tlv, int depth, int mode)
+        uint8_t *data, uint32_t length, int depth, uint8_t mode,
+        bool by_desc)
 {
     int rv;
     ogs_tlv_presence_t *presence_p = (ogs_tlv_presence_t *)msg;
     ogs_tlv_desc_t *desc = NULL, *next_desc = NULL;
-    ogs_tlv_t *tlv = NULL, *emb_tlv = NULL;
     uint8_t *p = msg;
-    uint32_t offset = 0;
-    uint8_t index = 0;
+    uint8_t *pos = data, *end = data + length, *value = NULL;
+    uint32_t offset = 0, value_len = 0, fixed_length;
+    uint16_t type = 0;
+    uint8_t instance = 0, tlv_mode, index = 0, first = 0;
+    uint8_t count[OGS_TLV_MAX_CHILD_DESC];
     int i = 0, j;
-    OGS_RBTREE(tree);
-    tlv_count_node_t count_node[OGS_TLV_MAX_CHILD_DESC];
-    unsigned count_node_alloc_next = 0;
     char indent[17] = "                "; /* 16 spaces */
 
     ogs_assert(msg);
     ogs_assert(parent_desc);
-    ogs_assert(parent_tlv);
+    ogs_assert(data);
 
     ogs_assert(depth <= 8);
     indent[depth*2] = 0;
 
-    tlv = parent_tlv;
-    while (tlv) {
-        tlv_count_node_t *curr_count = tlv_count_node_find(&tree, &count_node[0],
-                OGS_ARRAY_SIZE(count_node), &count_node_alloc_next, tlv->type, tlv->instance);
-        if (!curr_count)
+    if (length == 0) {
+        ogs_error("No TLV in [%s]", parent_desc->name);
+        return OGS_ERROR;
+    }
+
+    memset(count, 0, sizeof(count));
+
+    while (pos < end) {
+        tlv_mode = mode;
+        fixed_length = 0;
+
+        if (by_desc) {
+            if (end - pos < (mode == OGS_TLV_MODE_T2_L2 ? 2 : 1)) {
+                ogs_error("Truncated TLV type [%d]", (int)(end - pos));
+                return OGS_ERROR;
+            }
+            type = parse_get_element_type(pos, mode);
+            desc = tlv_find_desc(&index, &offset, &first,
+                    parent_desc, NULL, type, 0);
+            if (!desc) {
+                ogs_error("Can't parse find TLV description for type %u",
+                        type);
+                return OGS_ERROR;
+            }
+            tlv_mode = tlv_ctype2mode(desc->ctype, mode);
+            if (tlv_mode == OGS_TLV_MODE_T1)
+                fixed_length = desc->length;
+        }
+
+        value = tlv_get_header(pos, end, tlv_mode, fixed_length,
+                &type, &value_len, &instance);
+        if (!value) {
+            ogs_error("Can't parse TLV [%s] [LEN:%d,MODE:%d,POS:%d]",
+                    parent_desc->name, length, tlv_mode, (int)(pos - data));
+            ogs_log_hexdump(OGS_LOG_ERROR, data, length);
             return OGS_ERROR;
-        desc = tlv_find_desc_by_type_inst(&index, &offset, parent_desc, tlv->type, tlv->instance, curr_count->count);
+        }
+        pos = value + value_len;
+
+        desc = tlv_find_desc(&index, &offset, &first,
+                parent_desc, count, type, instance);
         if (desc == NULL) {
-            ogs_warn("Unknown TLV type [%d]", tlv->type);
-            tlv = tlv->next;
+            ogs_warn("Unknown TLV type [%d]", type);
             continue;
         }
 
@@ -689,28 +724,21 @@ static int tlv_parse_compound(void *msg, ogs_tlv_desc_t *parent_desc,
             }
             if (j == next_desc->length) {
                 ogs_fatal("Multiple of the same type TLV need more room");
-                tlv = tlv->next;
                 continue;
             }
         } else {
-            curr_count->count++;
+            count[first]++;
         }
 
         if (desc->ctype == OGS_TLV_COMPOUND) {
-            emb_tlv = ogs_tlv_parse_embedded_block(tlv, mode);
-            if (emb_tlv == NULL) {
-                ogs_error("Error while parse TLV");
-                return OGS_ERROR;
-            }
-
             ogs_trace("PARSE %sC#%d [%s] T:%d I:%d (vsz=%d) off:%p ",
                     indent, i++, desc->name, desc->type, desc->instance,
                     desc->vsize, p + offset);
 
             offset += sizeof(ogs_tlv_presence_t);
 
-            rv = tlv_parse_compound(
-                    p + offset, desc, emb_tlv, depth + 1, mode);
+            rv = tlv_parse_compound(p + offset, desc,
+                    value, value_len, depth + 1, mode, false);
             if (rv != OGS_OK) {
                 ogs_error("Can't parse compound TLV");
                 return OGS_ERROR;
@@ -723,7 +751,7 @@ static int tlv_parse_compound(void *msg, ogs_tlv_desc_t *parent_desc,
                     indent, i++, desc->name, desc->type, desc->length,
                     desc->instance, desc->ctype, desc->vsize, p + offset);
 
-            rv = tlv_parse_leaf(p + offset, desc, tlv);
+            rv = tlv_parse_leaf(p + offset, desc, value, value_len);
             if (rv != OGS_OK) {
                 ogs_error("Can't parse leaf TLV");
                 return OGS_ERROR;
@@ -731,8 +759,6 @@ static int tlv_parse_compound(void *msg, ogs_tlv_desc_t *parent_desc,
 
             *presence_p = 1;
         }
-
-        tlv = tlv->next;
     }
 
     return OGS_OK;
@@ -742,7 +768,6 @@ int ogs_tlv_parse_msg(void *msg, ogs_tlv_desc_t *desc, ogs_pkbuf_t *pkbuf,
         int mode)
 {
     int rv;
-    ogs_tlv_t *root;
 
     ogs_assert(msg);
     ogs_assert(desc);
@@ -754,112 +779,14 @@ int ogs_tlv_parse_msg(void *msg, ogs_tlv_desc_t *desc, ogs_pkbuf_t *pkbuf,
         ogs_assert_if_reached();
     }
 
-    root = ogs_tlv_parse_block(pkbuf->len, pkbuf->data, mode);
-    if (root == NULL) {
+    rv = tlv_parse_compound(msg, desc,
+            pkbuf->data, pkbuf->len, 0, mode, false);
+    if (rv != OGS_OK)
         ogs_error("Can't parse TLV message");
-        return OGS_ERROR;
-    }
-
-    rv = tlv_parse_compound(msg, desc, root, 0, mode);
-
-    ogs_tlv_free_all(root);
 
     return rv;
 }
 
-static uint16_t parse_get_element_type(uint8_t *pos, uint8_t mode)
-{
-    uint16_t type;
-
-    switch(mode) {
-    case OGS_TLV_MODE_T1_L1:
-    case OGS_TLV_MODE_T1_L2:
-    case OGS_TLV_MODE_T1_L2_I1:
-    case OGS_TLV_MODE_T1:
-        type = *pos;
-        break;
-    case OGS_TLV_MODE_T2_L2:
-        type = *(pos++) << 8;
-        type += *(pos++);
-        break;
-    default:
-        ogs_assert_if_reached();
-        break;
-    }
-
-    return type;
-}
-
-/* Get TLV element taking into account msg_mode (to know TLV tag length) +
- * specific TLV information from "desc" (to know whether the specific IE is TLV
- * or TV, and its expected length in the later case). */
-static uint8_t *tlv_get_element_desc(ogs_tlv_t *tlv, uint8_t *blk, uint8_t msg_mode, ogs_tlv_desc_t *desc)
-{
-    uint8_t instance;
-    unsigned tlv_tag_pos;
-    uint8_t desc_index = 0;
-    uint32_t tlv_offset = 0;
-    uint16_t tlv_tag;
-    uint8_t tlv_mode;
-    static ogs_tlv_desc_t* tlv_desc;
-
-    tlv_tag = parse_get_element_type(blk, msg_mode);
-    instance = 0;  /* TODO: support instance != 0 if ever really needed by looking it up in pos */
-    tlv_tag_pos = 0; /* All tags with same instance should use the same tlv_desc, so take the first one */
-    tlv_desc = tlv_find_desc_by_type_inst(&desc_index, &tlv_offset, desc, tlv_tag, instance, tlv_tag_pos);
-    if (!tlv_desc) {
-        ogs_error("Can't parse find TLV description for type %u", tlv_tag);
-        return NULL;
-    }
-    tlv_mode = tlv_ctype2mode(tlv_desc->ctype, msg_mode);
-
-    if (tlv_mode == OGS_TLV_MODE_T1)
-        return tlv_get_element_fixed(tlv, blk, tlv_mode, tlv_desc->length);
-    return tlv_get_element(tlv, blk, tlv_mode);
-}
-
-/* Similar to ogs_tlv_parse_block(), but taking into account each TLV format from "desc". */
-static ogs_tlv_t *ogs_tlv_parse_block_desc(uint32_t length, void *data, uint8_t msg_mode, ogs_tlv_desc_t *desc)
-{
-    uint8_t *pos = data;
-    uint8_t *blk = data;
-
-    ogs_tlv_t *root = NULL;
-    ogs_tlv_t *prev = NULL;
-    ogs_tlv_t *curr = NULL;
-
-    root = curr = ogs_tlv_get();
-
-    ogs_assert(curr);
-
-    pos = tlv_get_element_desc(curr, pos, msg_mode, desc);
-
-    ogs_assert(pos);
-
-    while(pos - blk < length) {
-        prev = curr;
-
-        curr = ogs_tlv_get();
-        ogs_assert(curr);
-        prev->next = curr;
-
-        pos = tlv_get_element_desc(curr, pos, msg_mode, desc);
-        ogs_assert(pos);
-    }
-
-    if (length != (pos - blk)) {
-        ogs_error("ogs_tlv_parse_block() failed[LEN:%d,MODE:%d]",
-                length, msg_mode);
-        ogs_error("POS[%p] BLK[%p] POS-BLK[%d]", pos, blk, (int)(pos - blk));
-        ogs_log_hexdump(OGS_LOG_FATAL, data, length);
-
-        ogs_tlv_free_all(root);
-        return NULL;
-    }
-
-    return root;
-}
-
 /* Similar to ogs_tlv_parse_msg(), but takes each TLV type from the desc
  * defintion. This allows parsing messages which have different types of TLVs in
  * it (for instance GTPv1-C). */
@@ -867,7 +794,6 @@ int ogs_tlv_parse_msg_desc(
         void *msg, ogs_tlv_desc_t *desc, ogs_pkbuf_t *pkbuf, int msg_mode)
 {
     int rv;
-    ogs_tlv_t *root;
 
     ogs_assert(msg);
     ogs_assert(desc);
@@ -876,15 +802,40 @@ int ogs_tlv_parse_msg_desc(
     ogs_assert(desc->ctype == OGS_TLV_MESSAGE);
     ogs_assert(desc->child_descs[0]);
 
-    root = ogs_tlv_parse_block_desc(pkbuf->len, pkbuf->data, msg_mode, desc);
-    if (root == NULL) {
+    rv = tlv_parse_compound(msg, desc,
+            pkbuf->data, pkbuf->len, 0, msg_mode, true);
+    if (rv != OGS_OK)
         ogs_error("Can't parse TLV message");
-        return OGS_ERROR;
-    }
 
-    rv = tlv_parse_compound(msg, desc, root, 0, msg_mode);
+    return rv;
+}
+
+/*
+ * Decode the value of a single IE described by desc into ie.
+ * The IE header has already been consumed by the caller,
+ * which lets a message be decoded one IE at a time.
+ */
+int ogs_tlv_parse_ie(void *ie, ogs_tlv_desc_t *desc,
+        uint8_t *data, uint32_t length, int mode)
+{
+    int rv;
+    ogs_tlv_presence_t *presence_p = (ogs_tlv_presence_t *)ie;
+
+    ogs_assert(ie);
+    ogs_assert(desc);
+    ogs_assert(data);
 
-    ogs_tlv_free_all(root);
+    if (desc->ctype == OGS_TLV_COMPOUND)
+        rv = tlv_parse_compound((uint8_t *)ie + sizeof(ogs_tlv_presence_t),
+                desc, data, length, 1, mode, false);
+    else
+        rv = tlv_parse_leaf(ie, desc, data, length);
+    if (rv != OGS_OK) {
+        ogs_error("Can't parse TLV [%s]", desc->name);
+        return rv;
+    }
 
-    return rv;
+    *presence_p = 1;
+
+    return OGS_OK;
 }
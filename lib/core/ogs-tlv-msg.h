@@ -181,6 +181,8 @@ int ogs_tlv_parse_msg(
         void *msg, ogs_tlv_desc_t *desc, ogs_pkbuf_t *pkbuf, int mode);
 int ogs_tlv_parse_msg_desc(
         void *msg, ogs_tlv_desc_t *desc, ogs_pkbuf_t *pkbuf, int msg_mode);
+int ogs_tlv_parse_ie(void *ie, ogs_tlv_desc_t *desc,
+        uint8_t *data, uint32_t length, int mode);
 
 #ifdef __cplusplus
 }
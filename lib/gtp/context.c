@@ -69,6 +69,12 @@ static int ogs_gtp_context_prepare(void)
 
 static int ogs_gtp_context_validation(const char *local)
 {
+    if (self.gtpu_batch.size > OGS_GTPU_MAX_BATCH) {
+        ogs_warn("gtpu.batch [%d] is limited to %d",
+                self.gtpu_batch.size, OGS_GTPU_MAX_BATCH);
+        self.gtpu_batch.size = OGS_GTPU_MAX_BATCH;
+    }
+
     return OGS_OK;
 }
 
@@ -554,6 +560,9 @@ int ogs_gtp_context_parse_config(const char *local, const char *remote)
 
                             } while (ogs_yaml_iter_type(&server_array) ==
                                     YAML_SEQUENCE_NODE);
+                        } else if (!strcmp(gtpu_key, "batch")) {
+                            const char *v = ogs_yaml_iter_value(&gtpu_iter);
+                            if (v) self.gtpu_batch.size = atoi(v);
                         } else
                             ogs_warn("unknown key `%s`", gtpu_key);
                     }
@@ -47,6 +47,17 @@ typedef struct ogs_gtp_context_s {
 
     ogs_ip_t        gtpu_ip;        /* GTPU IP */;
 
+    struct {
+        int         size;           /* recvmmsg/sendmmsg batch (<=1: off) */
+        bool        gso;            /* UDP GSO on GTPU egress */
+    } gtpu_batch;
+
+    struct {
+        uint64_t    pool_hit;       /* Received buffers sent on in place */
+        uint64_t    pool_miss;      /* Allocation failed or header chained */
+        uint64_t    copy;           /* Header chained for lack of headroom */
+    } gtpu_pkbuf_stat;
+
     ogs_list_t      gtpu_peer_list; /* GTPU Node List */
     ogs_list_t      gtpu_resource_list; /* UP IP Resource List */
 
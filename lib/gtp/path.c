@@ -19,6 +19,26 @@
 
 #include "ogs-gtp.h"
 
+#if defined(__linux__)
+#include <netinet/udp.h>
+#endif
+
+#if defined(UDP_SEGMENT)
+#define OGS_GTPU_MAX_GSO_BYTES 65000
+#endif
+
+static struct {
+    bool active;
+    int num;
+    struct {
+        ogs_socket_t fd;
+        ogs_sockaddr_t addr;
+        ogs_pkbuf_t *pkbuf;
+    } item[OGS_GTPU_MAX_BATCH];
+} send_batch;
+
+static void send_batch_flush(void);
+
 ogs_sock_t *ogs_gtp_server(ogs_socknode_t *node)
 {
     char buf[OGS_ADDRSTRLEN];
@@ -88,8 +108,8 @@ int ogs_gtp_send(ogs_gtp_node_t *gnode, ogs_pkbuf_t *pkbuf)
     sock = gnode->sock;
     ogs_assert(sock);
 
-    sent = ogs_send(sock->fd, pkbuf->data, pkbuf->len, 0);
-    if (sent < 0 || sent != pkbuf->len) {
+    sent = ogs_send_pkbuf(sock->fd, pkbuf, 0);
+    if (sent < 0 || sent != ogs_pkbuf_chain_len(pkbuf)) {
         if (ogs_socket_errno != OGS_EAGAIN) {
             ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
                     "ogs_gtp_send() failed");
@@ -113,14 +133,14 @@ int ogs_gtp_sendto(ogs_gtp_node_t *gnode, ogs_pkbuf_t *pkbuf)
     addr = &gnode->addr;
     ogs_assert(addr);
 
-    sent = ogs_sendto(sock->fd, pkbuf->data, pkbuf->len, 0, addr);
-    if (sent < 0 || sent != pkbuf->len) {
+    sent = ogs_sendto_pkbuf(sock->fd, pkbuf, 0, addr);
+    if (sent < 0 || sent != ogs_pkbuf_chain_len(pkbuf)) {
         if (ogs_socket_errno != OGS_EAGAIN) {
             char buf[OGS_ADDRSTRLEN];
             int err = ogs_socket_errno;
             ogs_log_message(OGS_LOG_ERROR, err,
                     "ogs_gtp_sendto(%u, %p, %u, 0, %s:%u) failed",
-                    sock->fd, pkbuf->data, pkbuf->len,
+                    sock->fd, pkbuf->data, ogs_pkbuf_chain_len(pkbuf),
                     OGS_ADDR(addr, buf), OGS_PORT(addr));
         }
         return OGS_ERROR;
@@ -129,6 +149,252 @@ int ogs_gtp_sendto(ogs_gtp_node_t *gnode, ogs_pkbuf_t *pkbuf)
     return OGS_OK;
 }
 
+int ogs_gtp_recv_batch(ogs_socket_t fd,
+        ogs_pkbuf_pool_t *pool, unsigned int headroom,
+        ogs_pkbuf_t **pkbuf, ogs_sockaddr_t *from, int num)
+{
+    ogs_mmsghdr_t msg[OGS_GTPU_MAX_BATCH];
+    struct iovec iov[OGS_GTPU_MAX_BATCH];
+    int i, n;
+
+    ogs_assert(fd != INVALID_SOCKET);
+    ogs_assert(pkbuf);
+    ogs_assert(from);
+    ogs_assert(num > 0 && num <= OGS_GTPU_MAX_BATCH);
+
+    for (i = 0; i < num; i++) {
+        if (!pkbuf[i]) {
+            pkbuf[i] = ogs_pkbuf_alloc(pool, OGS_MAX_PKT_LEN);
+            if (!pkbuf[i]) {
+                ogs_error("ogs_pkbuf_alloc() failed");
+                ogs_gtp_self()->gtpu_pkbuf_stat.pool_miss++;
+                break;
+            }
+            ogs_pkbuf_reserve(pkbuf[i], headroom);
+            ogs_pkbuf_put(pkbuf[i], OGS_MAX_PKT_LEN-headroom);
+        }
+
+        memset(&msg[i], 0, sizeof(msg[i]));
+        iov[i].iov_base = pkbuf[i]->data;
+        iov[i].iov_len = pkbuf[i]->len;
+        msg[i].msg_hdr.msg_iov = &iov[i];
+        msg[i].msg_hdr.msg_iovlen = 1;
+        msg[i].msg_hdr.msg_name = &from[i].sa;
+        msg[i].msg_hdr.msg_namelen = sizeof(from[i]);
+    }
+    if (i == 0)
+        return 0;
+
+    n = ogs_recvmmsg(fd, msg, i, MSG_DONTWAIT);
+    if (n < 0) {
+        if (ogs_socket_errno != OGS_EAGAIN)
+            ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
+                    "ogs_recvmmsg() failed");
+        return 0;
+    }
+
+    for (i = 0; i < n; i++)
+        ogs_pkbuf_trim(pkbuf[i], msg[i].msg_len);
+
+    return n;
+}
+
+void ogs_gtp_send_batch_begin(void)
+{
+    ogs_assert(send_batch.num == 0);
+    send_batch.active = true;
+}
+
+bool ogs_gtp_send_batch_enqueue(ogs_gtp_node_t *gnode, ogs_pkbuf_t *pkbuf)
+{
+    ogs_assert(gnode);
+    ogs_assert(gnode->sock);
+    ogs_assert(pkbuf);
+
+    if (send_batch.active == false)
+        return false;
+
+    /* A chained pkbuf is sent on its own, after the ones queued before */
+    if (pkbuf->next) {
+        send_batch_flush();
+        return false;
+    }
+
+    if (send_batch.num == OGS_GTPU_MAX_BATCH)
+        send_batch_flush();
+
+    /* Copy the peer, since the GTP node may go away before the flush */
+    send_batch.item[send_batch.num].fd = gnode->sock->fd;
+    memcpy(&send_batch.item[send_batch.num].addr,
+            &gnode->addr, sizeof(gnode->addr));
+    send_batch.item[send_batch.num].pkbuf = pkbuf;
+    send_batch.num++;
+
+    return true;
+}
+
+int ogs_gtp_send_batch_end(void)
+{
+    int num = send_batch.num;
+
+    send_batch_flush();
+    send_batch.active = false;
+
+    return num;
+}
+
+bool ogs_gtp_probe_gso(ogs_sock_t *sock)
+{
+#if defined(UDP_SEGMENT)
+    int val = 0;
+    socklen_t len = sizeof(val);
+
+    ogs_assert(sock);
+
+    return getsockopt(sock->fd, IPPROTO_UDP, UDP_SEGMENT, &val, &len) == 0;
+#else
+    return false;
+#endif
+}
+
+static void send_one(int i)
+{
+    char buf[OGS_ADDRSTRLEN];
+    ssize_t sent;
+    ogs_pkbuf_t *pkbuf = send_batch.item[i].pkbuf;
+    ogs_sockaddr_t *addr = &send_batch.item[i].addr;
+
+    sent = ogs_sendto(send_batch.item[i].fd,
+            pkbuf->data, pkbuf->len, 0, addr);
+    if (sent < 0 || sent != pkbuf->len) {
+        if (ogs_socket_errno != OGS_EAGAIN)
+            ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
+                    "ogs_sendto(%u, %s:%u) failed",
+                    pkbuf->len, OGS_ADDR(addr, buf), OGS_PORT(addr));
+    }
+}
+
+static void send_batch_flush(void)
+{
+    ogs_mmsghdr_t msg[OGS_GTPU_MAX_BATCH];
+    struct iovec iov[OGS_GTPU_MAX_BATCH];
+    int first[OGS_GTPU_MAX_BATCH], count[OGS_GTPU_MAX_BATCH];
+#if defined(UDP_SEGMENT)
+    union {
+        char buf[CMSG_SPACE(sizeof(uint16_t))];
+        struct cmsghdr align;
+    } control[OGS_GTPU_MAX_BATCH];
+#endif
+    bool done[OGS_GTPU_MAX_BATCH];
+    int i, j, k, n, vlen;
+
+    if (send_batch.num == 0)
+        return;
+
+    memset(done, 0, sizeof(done));
+
+    /* One sendmmsg(2) per socket; typically the IPv4 and IPv6 servers */
+    for (i = 0; i < send_batch.num; i++) {
+        ogs_socket_t fd;
+        int prev = -1;
+
+        if (done[i])
+            continue;
+
+        fd = send_batch.item[i].fd;
+        vlen = 0;
+
+        for (j = i; j < send_batch.num; j++) {
+            ogs_pkbuf_t *pkbuf = send_batch.item[j].pkbuf;
+
+            if (done[j] || send_batch.item[j].fd != fd)
+                continue;
+            done[j] = true;
+
+            iov[j].iov_base = pkbuf->data;
+            iov[j].iov_len = pkbuf->len;
+
+#if defined(UDP_SEGMENT)
+            /*
+             * Append to the previous message as another GSO segment
+             * if it goes to the same peer with the same size.
+             * The segments must be adjacent in iov[].
+             */
+            if (ogs_gtp_self()->gtpu_batch.gso && prev >= 0 &&
+                prev == j - 1 &&
+                ogs_sockaddr_is_equal(&send_batch.item[j].addr,
+                    &send_batch.item[first[vlen-1]].addr) &&
+                iov[first[vlen-1]].iov_len == pkbuf->len &&
+                (count[vlen-1] + 1) * pkbuf->len <=
+                    OGS_GTPU_MAX_GSO_BYTES &&
+                count[vlen-1] < OGS_GTPU_MAX_BATCH) {
+                count[vlen-1]++;
+                msg[vlen-1].msg_hdr.msg_iovlen = count[vlen-1];
+                prev = j;
+                continue;
+            }
+#endif
+
+            memset(&msg[vlen], 0, sizeof(msg[vlen]));
+            msg[vlen].msg_hdr.msg_iov = &iov[j];
+            msg[vlen].msg_hdr.msg_iovlen = 1;
+            msg[vlen].msg_hdr.msg_name = &send_batch.item[j].addr.sa;
+            msg[vlen].msg_hdr.msg_namelen =
+                ogs_sockaddr_len(&send_batch.item[j].addr);
+            first[vlen] = j;
+            count[vlen] = 1;
+            vlen++;
+            prev = j;
+        }
+
+#if defined(UDP_SEGMENT)
+        for (k = 0; k < vlen; k++) {
+            struct cmsghdr *cm;
+
+            if (count[k] == 1)
+                continue;
+
+            msg[k].msg_hdr.msg_control = control[k].buf;
+            msg[k].msg_hdr.msg_controllen = sizeof(control[k].buf);
+            cm = CMSG_FIRSTHDR(&msg[k].msg_hdr);
+            cm->cmsg_level = IPPROTO_UDP;
+            cm->cmsg_type = UDP_SEGMENT;
+            cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            *(uint16_t *)CMSG_DATA(cm) = iov[first[k]].iov_len;
+        }
+#endif
+
+        k = 0;
+        while (k < vlen) {
+            n = ogs_sendmmsg(fd, &msg[k], vlen - k, 0);
+            if (n > 0) {
+                k += n;
+                continue;
+            }
+
+            /*
+             * The message at k could not be sent. If it is a GSO train
+             * (e.g. segment larger than the path MTU), retry its
+             * packets one by one, otherwise report and skip it.
+             */
+            if (count[k] > 1) {
+                int l;
+                for (l = 0; l < count[k]; l++)
+                    send_one(first[k] + l);
+            } else {
+                send_one(first[k]);
+            }
+            k++;
+        }
+    }
+
+    for (i = 0; i < send_batch.num; i++) {
+        ogs_pkbuf_free(send_batch.item[i].pkbuf);
+        send_batch.item[i].pkbuf = NULL;
+    }
+    send_batch.num = 0;
+}
+
 void ogs_gtp_send_error_message(
         ogs_gtp_xact_t *xact, uint32_t teid, uint8_t type, uint8_t cause_value)
 {
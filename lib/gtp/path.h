@@ -62,12 +62,39 @@ extern "C" {
                 &ogs_gtp_self()->gtpu_ip); \
     } while(0)
 
+#define OGS_GTPU_MAX_BATCH 64
+
 ogs_sock_t *ogs_gtp_server(ogs_socknode_t *node);
 int ogs_gtp_connect(ogs_sock_t *ipv4, ogs_sock_t *ipv6, ogs_gtp_node_t *gnode);
 
 int ogs_gtp_send(ogs_gtp_node_t *gnode, ogs_pkbuf_t *pkbuf);
 int ogs_gtp_sendto(ogs_gtp_node_t *gnode, ogs_pkbuf_t *pkbuf);
 
+/*
+ * Batched GTP-U I/O (gtpu.batch > 1)
+ *
+ * ogs_gtp_recv_batch() refills every NULL slot of pkbuf[0..num) from the
+ * pool and receives up to num datagrams with one recvmmsg(2). It returns
+ * the number of datagrams received; the caller owns pkbuf[0..n) and
+ * must set those slots to NULL. Unused buffers remain for the next call.
+ *
+ * Between ogs_gtp_send_batch_begin() and ogs_gtp_send_batch_end(),
+ * ogs_gtp2_send_user_plane() queues the packet instead of sending it.
+ * The queue is flushed with sendmmsg(2) per socket, and consecutive
+ * packets of the same size to the same peer are coalesced with
+ * UDP GSO when available. ogs_gtp_send_batch_end() returns the number
+ * of queued packets.
+ */
+int ogs_gtp_recv_batch(ogs_socket_t fd,
+        ogs_pkbuf_pool_t *pool, unsigned int headroom,
+        ogs_pkbuf_t **pkbuf, ogs_sockaddr_t *from, int num);
+
+void ogs_gtp_send_batch_begin(void);
+bool ogs_gtp_send_batch_enqueue(ogs_gtp_node_t *gnode, ogs_pkbuf_t *pkbuf);
+int ogs_gtp_send_batch_end(void);
+
+bool ogs_gtp_probe_gso(ogs_sock_t *sock);
+
 void ogs_gtp_send_error_message(
         ogs_gtp_xact_t *xact, uint32_t teid, uint8_t type, uint8_t cause_value);
 
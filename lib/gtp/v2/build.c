@@ -188,7 +188,8 @@ void ogs_gtp2_fill_header(
      * the N-PDU Number or any Extension headers shall be considered
      * to be part of the payload, i.e. included in the length count.
      */
-    gtp_h->length = htobe16(pkbuf->len - OGS_GTPV1U_HEADER_LEN);
+    gtp_h->length = htobe16(
+            ogs_pkbuf_chain_len(pkbuf) - OGS_GTPV1U_HEADER_LEN);
 
     /* Fill Extention Header */
     if (gtp_h->flags & OGS_GTPU_FLAGS_E) {
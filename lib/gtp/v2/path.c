@@ -25,7 +25,7 @@ int ogs_gtp2_send_user_plane(
         ogs_pkbuf_t *pkbuf)
 {
     char buf[OGS_ADDRSTRLEN];
-    int rv, i;
+    int rv, i, hlen;
 
     ogs_gtp2_header_t gtp_hdesc;
     ogs_gtp2_extension_header_t ext_hdesc;
@@ -65,12 +65,50 @@ int ogs_gtp2_send_user_plane(
         i++;
     }
 
+    /*
+     * The header is pushed into the headroom of the packet.
+     * A packet received without enough headroom gets the header
+     * in a segment of its own, chained in front of the payload.
+     */
+    if (i)
+        hlen = OGS_GTPV1U_HEADER_LEN +
+            OGS_GTPV1U_EXTENSION_HEADER_LEN + i * 4;
+    else if (gtp_hdesc.flags & (OGS_GTPU_FLAGS_S|OGS_GTPU_FLAGS_PN))
+        hlen = OGS_GTPV1U_HEADER_LEN + OGS_GTPV1U_EXTENSION_HEADER_LEN;
+    else
+        hlen = OGS_GTPV1U_HEADER_LEN;
+
+    if (ogs_unlikely(ogs_pkbuf_headroom(pkbuf) < hlen)) {
+        ogs_pkbuf_t *head = NULL;
+
+        ogs_gtp_self()->gtpu_pkbuf_stat.pool_miss++;
+
+        head = ogs_pkbuf_alloc(NULL, hlen);
+        if (!head) {
+            ogs_error("ogs_pkbuf_alloc() failed");
+            ogs_pkbuf_free(pkbuf);
+            return OGS_ERROR;
+        }
+        ogs_pkbuf_reserve(head, hlen);
+        ogs_pkbuf_chain(head, pkbuf);
+        pkbuf = head;
+
+        ogs_gtp_self()->gtpu_pkbuf_stat.copy++;
+    } else if (header_desc->type == OGS_GTPU_MSGTYPE_GPDU) {
+        /* The received buffer is sent on as is */
+        ogs_gtp_self()->gtpu_pkbuf_stat.pool_hit++;
+    }
+
     ogs_gtp2_fill_header(&gtp_hdesc, &ext_hdesc, pkbuf);
 
     ogs_trace("SEND GTP-U[%d] to Peer[%s] : TEID[0x%x]",
             header_desc->type,
             OGS_ADDR(&gnode->addr, buf), header_desc->teid);
 
+    /* Batched I/O : the pkbuf is sent and freed by the batch flush */
+    if (ogs_gtp_send_batch_enqueue(gnode, pkbuf) == true)
+        return OGS_OK;
+
     rv = ogs_gtp_sendto(gnode, pkbuf);
     if (rv != OGS_OK) {
         if (ogs_socket_errno != OGS_EAGAIN) {
@@ -756,7 +756,8 @@ static void response_timeout(void *data)
 
     xact = ogs_gtp_xact_find_by_id(xact_id);
     if (!xact) {
-        ogs_error("GTP Transaction has already been removed [%d]", xact_id);
+        ogs_error("GTP Transaction has already been removed [%lld]",
+                (long long)xact_id);
         return;;
     }
     ogs_assert(xact->gnode);
@@ -808,7 +809,8 @@ static void holding_timeout(void *data)
 
     xact = ogs_gtp_xact_find_by_id(xact_id);
     if (!xact) {
-        ogs_error("GTP Transaction has already been removed [%d]", xact_id);
+        ogs_error("GTP Transaction has already been removed [%lld]",
+                (long long)xact_id);
         return;;
     }
     ogs_assert(xact->gnode);
@@ -849,7 +851,8 @@ static void peer_timeout(void *data)
 
     xact = ogs_gtp_xact_find_by_id(xact_id);
     if (!xact) {
-        ogs_error("GTP Transaction has already been removed [%d]", xact_id);
+        ogs_error("GTP Transaction has already been removed [%lld]",
+                (long long)xact_id);
         return;;
     }
     ogs_assert(xact->gnode);
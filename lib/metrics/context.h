@@ -41,6 +41,9 @@ typedef struct ogs_metrics_context_s {
     ogs_list_t  spec_list;
 
     uint16_t    metrics_port;
+
+    /* Folds counters kept outside the metrics in, before each scrape */
+    void        (*collect)(void);
 } ogs_metrics_context_t;
 
 typedef enum ogs_metrics_histogram_bucket_type_s  {
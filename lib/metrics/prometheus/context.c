@@ -57,6 +57,16 @@ static OGS_POOL(metrics_server_pool, ogs_metrics_server_t);
 static int ogs_metrics_context_server_start(ogs_metrics_server_t *server);
 static int ogs_metrics_context_server_stop(ogs_metrics_server_t *server);
 
+/* Event allocator counters of this NF, published at scrape time */
+static struct {
+    ogs_metrics_inst_t *alloc;
+    ogs_metrics_inst_t *outstanding;
+    uint64_t published;
+} event_metrics;
+
+static void event_metrics_init(ogs_metrics_context_t *ctx);
+static void event_metrics_collect(void);
+
 void ogs_metrics_server_init(ogs_metrics_context_t *ctx)
 {
     ogs_list_init(&ctx->server_list);
@@ -207,6 +217,9 @@ static _MHD_Result mhd_server_access_handler(void *cls, struct MHD_Connection *c
         return ret;
     }
     if (strcmp(url, "/metrics") == 0) {
+        event_metrics_collect();
+        if (ogs_metrics_self()->collect)
+            ogs_metrics_self()->collect();
         buf = prom_collector_registry_bridge(PROM_COLLECTOR_REGISTRY_DEFAULT);
         rsp = MHD_create_response_from_buffer(strlen(buf), (void *)buf, MHD_RESPMEM_MUST_FREE);
         MHD_add_response_header(rsp, "Content-Type", "text/plain; version=0.0.4; charset=utf-8");
@@ -323,6 +336,8 @@ void ogs_metrics_spec_init(ogs_metrics_context_t *ctx)
     ogs_pool_init(&metrics_spec_pool, ogs_app()->metrics.max_specs);
 
     prom_collector_registry_default_init();
+
+    event_metrics_init(ctx);
 }
 
 void ogs_metrics_spec_final(ogs_metrics_context_t *ctx)
@@ -335,6 +350,44 @@ void ogs_metrics_spec_final(ogs_metrics_context_t *ctx)
     prom_collector_registry_destroy(PROM_COLLECTOR_REGISTRY_DEFAULT);
 
     ogs_pool_final(&metrics_spec_pool);
+
+    memset(&event_metrics, 0, sizeof(event_metrics));
+}
+
+static void event_metrics_init(ogs_metrics_context_t *ctx)
+{
+    ogs_metrics_spec_t *spec = NULL;
+
+    spec = ogs_metrics_spec_new(ctx, OGS_METRICS_METRIC_TYPE_COUNTER,
+            "events_allocated", "Events allocated", 0, 0, NULL, NULL);
+    event_metrics.alloc = ogs_metrics_inst_new(spec, 0, NULL);
+
+    spec = ogs_metrics_spec_new(ctx, OGS_METRICS_METRIC_TYPE_GAUGE,
+            "events_outstanding", "Events allocated and not yet freed",
+            0, 0, NULL, NULL);
+    event_metrics.outstanding = ogs_metrics_inst_new(spec, 0, NULL);
+
+    event_metrics.published = 0;
+}
+
+static void event_metrics_collect(void)
+{
+    ogs_event_stat_t stat;
+
+    if (!event_metrics.alloc)
+        return;
+
+    ogs_event_stat(&stat);
+
+    if (stat.alloc > event_metrics.published) {
+        prom_counter_add(event_metrics.alloc->spec->prom,
+                (double)(stat.alloc - event_metrics.published),
+                (const char **)event_metrics.alloc->label_values);
+        event_metrics.published = stat.alloc;
+    }
+    prom_gauge_set(event_metrics.outstanding->spec->prom,
+            (double)stat.outstanding,
+            (const char **)event_metrics.outstanding->label_values);
 }
 
 ogs_metrics_spec_t *ogs_metrics_spec_new(
@@ -60,6 +60,60 @@ int ogs_ngap_decode(ogs_ngap_message_t *message, ogs_pkbuf_t *pkbuf)
     return OGS_OK;
 }
 
+int ogs_ngap_decode_route(ogs_ngap_route_t *route, ogs_pkbuf_t *pkbuf)
+{
+    ogs_asn_route_t r;
+    ogs_asn_route_ie_t ie;
+    uint64_t value;
+    int i;
+
+    ogs_assert(route);
+    ogs_assert(pkbuf);
+    ogs_assert(pkbuf->data);
+
+    memset(route, 0, sizeof(*route));
+
+    if (ogs_asn_route_parse(&r, pkbuf->data, pkbuf->len) != OGS_OK) {
+        ogs_warn("Failed to route NGAP-PDU");
+        return OGS_ERROR;
+    }
+
+    route->present = r.present;
+    route->procedure_code = r.procedure_code;
+    route->criticality = r.criticality;
+
+    for (i = 0; i < r.num_of_ie; i++) {
+        if (ogs_asn_route_next_ie(&r, &ie) != OGS_OK) {
+            ogs_warn("Failed to route NGAP-PDU [%d/%d]", i, r.num_of_ie);
+            return OGS_ERROR;
+        }
+
+        switch (ie.id) {
+        case NGAP_ProtocolIE_ID_id_RAN_UE_NGAP_ID:
+            if (ogs_asn_route_decode_uint(&ie, 32, &value) != OGS_OK)
+                return OGS_ERROR;
+            route->ran_ue_ngap_id = value;
+            route->ran_ue_ngap_id_presence = true;
+            break;
+        case NGAP_ProtocolIE_ID_id_AMF_UE_NGAP_ID:
+            if (ogs_asn_route_decode_uint(&ie, 40, &value) != OGS_OK)
+                return OGS_ERROR;
+            route->amf_ue_ngap_id = value;
+            route->amf_ue_ngap_id_presence = true;
+            break;
+        case NGAP_ProtocolIE_ID_id_NAS_PDU:
+            if (ogs_asn_route_decode_octet_string(&ie,
+                        &route->nas_pdu, &route->nas_pdu_len) != OGS_OK)
+                return OGS_ERROR;
+            break;
+        default:
+            break;
+        }
+    }
+
+    return OGS_OK;
+}
+
 void ogs_ngap_free(ogs_ngap_message_t *message)
 {
     ogs_assert(message);
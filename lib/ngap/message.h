@@ -30,7 +30,27 @@ extern "C" {
 
 typedef struct NGAP_NGAP_PDU ogs_ngap_message_t;
 
+/*
+ * Fields needed to route an NGAP-PDU to its UE and procedure,
+ * read directly from the APER bitstream by ogs_ngap_decode_route().
+ * nas_pdu points into the pkbuf that was given.
+ */
+typedef struct ogs_ngap_route_s {
+    uint8_t present;            /* NGAP_NGAP_PDU_PR_XXX */
+    uint8_t procedure_code;
+    uint8_t criticality;
+
+    bool ran_ue_ngap_id_presence;
+    uint64_t ran_ue_ngap_id;
+    bool amf_ue_ngap_id_presence;
+    uint64_t amf_ue_ngap_id;
+
+    uint8_t *nas_pdu;
+    size_t nas_pdu_len;
+} ogs_ngap_route_t;
+
 int ogs_ngap_decode(ogs_ngap_message_t *message, ogs_pkbuf_t *pkbuf);
+int ogs_ngap_decode_route(ogs_ngap_route_t *route, ogs_pkbuf_t *pkbuf);
 ogs_pkbuf_t *ogs_ngap_encode(ogs_ngap_message_t *message);
 void ogs_ngap_free(ogs_ngap_message_t *message);
 
@@ -54,16 +54,16 @@ void ogs_pfcp_context_init(void)
 
     ogs_pool_init(&ogs_pfcp_node_pool, ogs_app()->pool.nf);
 
-    ogs_pool_init(&ogs_pfcp_far_pool,
+    ogs_pool_init_chunked(&ogs_pfcp_far_pool,
             ogs_app()->pool.sess * OGS_MAX_NUM_OF_FAR);
-    ogs_pool_init(&ogs_pfcp_urr_pool,
+    ogs_pool_init_chunked(&ogs_pfcp_urr_pool,
             ogs_app()->pool.sess * OGS_MAX_NUM_OF_URR);
-    ogs_pool_init(&ogs_pfcp_qer_pool,
+    ogs_pool_init_chunked(&ogs_pfcp_qer_pool,
             ogs_app()->pool.sess * OGS_MAX_NUM_OF_QER);
-    ogs_pool_init(&ogs_pfcp_bar_pool,
+    ogs_pool_init_chunked(&ogs_pfcp_bar_pool,
             ogs_app()->pool.sess * OGS_MAX_NUM_OF_BAR);
 
-    ogs_pool_init(&ogs_pfcp_pdr_pool,
+    ogs_pool_init_chunked(&ogs_pfcp_pdr_pool,
             ogs_app()->pool.sess * OGS_MAX_NUM_OF_PDR);
     ogs_pool_init(&ogs_pfcp_pdr_teid_pool, ogs_pfcp_pdr_pool.size);
     ogs_pool_random_id_generate(&ogs_pfcp_pdr_teid_pool);
@@ -74,7 +74,7 @@ void ogs_pfcp_context_init(void)
     for (i = 0; i < ogs_pfcp_pdr_pool.size; i++)
         pdr_random_to_index[ogs_pfcp_pdr_teid_pool.array[i]] = i;
 
-    ogs_pool_init(&ogs_pfcp_rule_pool,
+    ogs_pool_init_chunked(&ogs_pfcp_rule_pool,
             ogs_app()->pool.sess *
             OGS_MAX_NUM_OF_PDR * OGS_MAX_NUM_OF_FLOW_IN_PDR);
 
@@ -130,6 +130,35 @@ ogs_pfcp_context_t *ogs_pfcp_self(void)
     return &self;
 }
 
+/*
+ * Returns the chunks of the PDR/FAR/URR/QER/BAR/rule pools
+ * that no longer hold a node to the system.
+ */
+int ogs_pfcp_pool_trim(void)
+{
+    return ogs_pool_trim(&ogs_pfcp_pdr_pool) +
+        ogs_pool_trim(&ogs_pfcp_far_pool) +
+        ogs_pool_trim(&ogs_pfcp_urr_pool) +
+        ogs_pool_trim(&ogs_pfcp_qer_pool) +
+        ogs_pool_trim(&ogs_pfcp_bar_pool) +
+        ogs_pool_trim(&ogs_pfcp_rule_pool);
+}
+
+void ogs_pfcp_pool_stat(ogs_pfcp_pool_stat_t *stat)
+{
+    ogs_assert(stat);
+
+    memset(stat, 0, sizeof(*stat));
+
+    stat->pdr_peak = ogs_pool_peak(&ogs_pfcp_pdr_pool);
+    stat->committed = ogs_pool_committed(&ogs_pfcp_pdr_pool) +
+        ogs_pool_committed(&ogs_pfcp_far_pool) +
+        ogs_pool_committed(&ogs_pfcp_urr_pool) +
+        ogs_pool_committed(&ogs_pfcp_qer_pool) +
+        ogs_pool_committed(&ogs_pfcp_bar_pool) +
+        ogs_pool_committed(&ogs_pfcp_rule_pool);
+}
+
 static int ogs_pfcp_context_prepare(void)
 {
     self.pfcp_port = OGS_PFCP_UDP_PORT;
@@ -313,6 +313,13 @@ typedef struct ogs_pfcp_qer_s {
 
     uint8_t                 qfi;
 
+    /* MBR token bucket in bytes (User Plane) */
+    struct {
+        uint64_t            tokens;
+        uint64_t            remainder;  /* Fraction of a byte, in 1/1000000 */
+        ogs_time_t          time;
+    } bucket[2];                        /* 0 : Uplink, 1 : Downlink */
+
     ogs_pfcp_sess_t         *sess;
 } ogs_pfcp_qer_t;
 
@@ -409,6 +416,14 @@ void ogs_pfcp_context_final(void);
 ogs_pfcp_context_t *ogs_pfcp_self(void);
 int ogs_pfcp_context_parse_config(const char *local, const char *remote);
 
+typedef struct ogs_pfcp_pool_stat_s {
+    int pdr_peak;           /* Most PDRs in use at once */
+    size_t committed;       /* Bytes backed by memory in the rule pools */
+} ogs_pfcp_pool_stat_t;
+
+int ogs_pfcp_pool_trim(void);
+void ogs_pfcp_pool_stat(ogs_pfcp_pool_stat_t *stat);
+
 ogs_pfcp_node_t *ogs_pfcp_node_new(ogs_sockaddr_t *config_addr);
 void ogs_pfcp_node_free(ogs_pfcp_node_t *node);
 
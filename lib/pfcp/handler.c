@@ -1197,6 +1197,7 @@ ogs_pfcp_qer_t *ogs_pfcp_handle_create_qer(ogs_pfcp_sess_t *sess,
 
     memset(&qer->mbr, 0, sizeof(qer->mbr));
     memset(&qer->gbr, 0, sizeof(qer->gbr));
+    memset(qer->bucket, 0, sizeof(qer->bucket));
 
     if (message->maximum_bitrate.presence)
         ogs_pfcp_parse_bitrate(&qer->mbr, &message->maximum_bitrate);
@@ -1238,8 +1239,13 @@ ogs_pfcp_qer_t *ogs_pfcp_handle_update_qer(ogs_pfcp_sess_t *sess,
         return NULL;
     }
 
-    if (message->maximum_bitrate.presence)
+    if (message->gate_status.presence)
+        qer->gate_status.value = message->gate_status.u8;
+
+    if (message->maximum_bitrate.presence) {
         ogs_pfcp_parse_bitrate(&qer->mbr, &message->maximum_bitrate);
+        memset(qer->bucket, 0, sizeof(qer->bucket));
+    }
     if (message->guaranteed_bitrate.presence)
         ogs_pfcp_parse_bitrate(&qer->gbr, &message->guaranteed_bitrate);
 
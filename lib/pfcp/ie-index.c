@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2019-2024 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-pfcp.h"
+
+ogs_pfcp_ie_index_t *ogs_pfcp_ie_index_parse(ogs_pkbuf_t *pkbuf)
+{
+    ogs_pfcp_ie_index_t *index = NULL;
+    ogs_pfcp_header_t *h = NULL;
+    ogs_pfcp_ie_t *ie = NULL;
+    uint8_t *data = NULL;
+    uint32_t pos = 0, length = 0;
+    uint16_t size = 0;
+
+    ogs_assert(pkbuf);
+    ogs_assert(pkbuf->len);
+
+    h = (ogs_pfcp_header_t *)pkbuf->data;
+    ogs_assert(h);
+
+    index = ogs_malloc(sizeof(*index));
+    if (!index) {
+        ogs_error("No memory");
+        return NULL;
+    }
+
+    if (h->seid_presence)
+        size = OGS_PFCP_HEADER_LEN;
+    else
+        size = OGS_PFCP_HEADER_LEN-OGS_PFCP_SEID_LEN;
+
+    if (ogs_pkbuf_pull(pkbuf, size) == NULL) {
+        ogs_error("ogs_pkbuf_pull() failed [len:%d]", pkbuf->len);
+        ogs_free(index);
+        return NULL;
+    }
+    memset(&index->h, 0, sizeof(index->h));
+    memcpy(&index->h, pkbuf->data - size, size);
+
+    if (h->seid_presence) {
+        index->h.seid = be64toh(index->h.seid);
+    } else {
+        index->h.sqn = index->h.sqn_only;
+    }
+
+    index->pkbuf = pkbuf;
+    index->header_len = size;
+    index->num_of_ie = 0;
+    index->message = NULL;
+
+    data = pkbuf->data;
+    length = pkbuf->len;
+
+    if (length > 0xffff) {
+        ogs_error("Invalid message length [%d]", length);
+        goto error;
+    }
+
+    while (pos < length) {
+        if (length - pos < 4) {
+            ogs_error("Truncated IE header [type:%d,pos:%d]",
+                    index->h.type, pos);
+            goto error;
+        }
+        if (index->num_of_ie == OGS_PFCP_MAX_NUM_OF_IE) {
+            ogs_error("Too many IEs [type:%d]", index->h.type);
+            goto error;
+        }
+
+        ie = &index->ie[index->num_of_ie];
+        ie->type = (data[pos] << 8) | data[pos+1];
+        ie->length = (data[pos+2] << 8) | data[pos+3];
+        pos += 4;
+
+        if (length - pos < ie->length) {
+            ogs_error("Truncated IE [type:%d,ie:%d,len:%d,pos:%d]",
+                    index->h.type, ie->type, ie->length, pos);
+            goto error;
+        }
+        ie->offset = pos;
+        pos += ie->length;
+
+        index->num_of_ie++;
+    }
+
+    return index;
+
+error:
+    ogs_log_hexdump(OGS_LOG_ERROR, data, length);
+    ogs_free(index);
+    return NULL;
+}
+
+void ogs_pfcp_ie_index_free(ogs_pfcp_ie_index_t *index)
+{
+    ogs_assert(index);
+
+    if (index->message)
+        ogs_pfcp_message_free(index->message);
+
+    ogs_free(index);
+}
+
+/*
+ * Returns the next IE of the given type after prev,
+ * or the first one if prev is NULL.
+ */
+ogs_pfcp_ie_t *ogs_pfcp_ie_find(
+        ogs_pfcp_ie_index_t *index, uint16_t type, ogs_pfcp_ie_t *prev)
+{
+    ogs_pfcp_ie_t *ie = NULL, *end = NULL;
+
+    ogs_assert(index);
+
+    end = index->ie + index->num_of_ie;
+    for (ie = prev ? prev + 1 : index->ie; ie < end; ie++) {
+        if (ie->type == type)
+            return ie;
+    }
+
+    return NULL;
+}
+
+/*
+ * Decodes the value of ie into the TLV structure of desc.
+ * Octet strings in the result point into the pkbuf of the index.
+ */
+int ogs_pfcp_ie_decode(ogs_pfcp_ie_index_t *index,
+        ogs_pfcp_ie_t *ie, ogs_tlv_desc_t *desc, void *value)
+{
+    ogs_assert(index);
+    ogs_assert(ie);
+    ogs_assert(desc);
+    ogs_assert(value);
+    ogs_assert(ie->type == desc->type);
+
+    memset(value, 0, desc->vsize);
+
+    return ogs_tlv_parse_ie(value, desc,
+            index->pkbuf->data + ie->offset, ie->length,
+            OGS_TLV_MODE_T2_L2);
+}
+
+int ogs_pfcp_ie_decode_create_pdr(ogs_pfcp_ie_index_t *index,
+        ogs_pfcp_ie_t *ie, ogs_pfcp_tlv_create_pdr_t *create_pdr)
+{
+    return ogs_pfcp_ie_decode(index, ie,
+            &ogs_pfcp_tlv_desc_create_pdr, create_pdr);
+}
+
+int ogs_pfcp_ie_decode_create_far(ogs_pfcp_ie_index_t *index,
+        ogs_pfcp_ie_t *ie, ogs_pfcp_tlv_create_far_t *create_far)
+{
+    return ogs_pfcp_ie_decode(index, ie,
+            &ogs_pfcp_tlv_desc_create_far, create_far);
+}
+
+int ogs_pfcp_ie_decode_create_urr(ogs_pfcp_ie_index_t *index,
+        ogs_pfcp_ie_t *ie, ogs_pfcp_tlv_create_urr_t *create_urr)
+{
+    return ogs_pfcp_ie_decode(index, ie,
+            &ogs_pfcp_tlv_desc_create_urr, create_urr);
+}
+
+int ogs_pfcp_ie_decode_create_qer(ogs_pfcp_ie_index_t *index,
+        ogs_pfcp_ie_t *ie, ogs_pfcp_tlv_create_qer_t *create_qer)
+{
+    return ogs_pfcp_ie_decode(index, ie,
+            &ogs_pfcp_tlv_desc_create_qer, create_qer);
+}
+
+int ogs_pfcp_ie_decode_create_bar(ogs_pfcp_ie_index_t *index,
+        ogs_pfcp_ie_t *ie, ogs_pfcp_tlv_create_bar_t *create_bar)
+{
+    return ogs_pfcp_ie_decode(index, ie,
+            &ogs_pfcp_tlv_desc_create_bar, create_bar);
+}
+
+/*
+ * Decodes the whole message body into the message structure of desc,
+ * such as &ogs_pfcp_msg_desc_pfcp_heartbeat_request.
+ * The caller provides a zeroed structure of the matching type,
+ * which lets small messages be decoded on the stack.
+ */
+int ogs_pfcp_ie_index_decode_msg(
+        ogs_pfcp_ie_index_t *index, ogs_tlv_desc_t *desc, void *msg)
+{
+    ogs_assert(index);
+    ogs_assert(desc);
+    ogs_assert(msg);
+
+    if (index->pkbuf->len == 0)
+        return OGS_OK;
+
+    return ogs_tlv_parse_msg(msg, desc, index->pkbuf, OGS_TLV_MODE_T2_L2);
+}
+
+/*
+ * Compatibility path for handlers still taking ogs_pfcp_message_t.
+ * The full message is decoded once and freed with the index.
+ */
+ogs_pfcp_message_t *ogs_pfcp_ie_index_message(ogs_pfcp_ie_index_t *index)
+{
+    ogs_assert(index);
+
+    if (index->message)
+        return index->message;
+
+    ogs_assert(ogs_pkbuf_push(index->pkbuf, index->header_len));
+
+    index->message = ogs_pfcp_parse_msg(index->pkbuf);
+    if (!index->message) {
+        ogs_error("ogs_pfcp_parse_msg() failed");
+        return NULL;
+    }
+
+    return index->message;
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2019-2024 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#if !defined(OGS_PFCP_INSIDE) && !defined(OGS_PFCP_COMPILATION)
+#error "This header cannot be included directly."
+#endif
+
+#ifndef OGS_PFCP_IE_INDEX_H
+#define OGS_PFCP_IE_INDEX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Compact form of a received PFCP message.
+ *
+ * ogs_pfcp_message_t is over 100kb in size because every message
+ * embeds fixed arrays of grouped IEs such as create_pdr[16].
+ * The IE index only records where each top-level IE lies in the pkbuf.
+ * The IE values are decoded on demand by the caller, one IE at a time,
+ * so only the TLV framing is validated when the index is built.
+ *
+ * The index refers to the pkbuf it was built from,
+ * which must outlive it.
+ */
+#define OGS_PFCP_MAX_NUM_OF_IE          256
+
+typedef struct ogs_pfcp_ie_s {
+    uint16_t type;
+    uint16_t length;
+    uint16_t offset;    /* Offset of the value in the message body */
+} ogs_pfcp_ie_t;
+
+typedef struct ogs_pfcp_ie_index_s {
+    ogs_pfcp_header_t h;
+
+    ogs_pkbuf_t *pkbuf;
+    uint8_t header_len;
+
+    int num_of_ie;
+    ogs_pfcp_ie_t ie[OGS_PFCP_MAX_NUM_OF_IE];
+
+    /* Full message for the compatibility path, decoded on first use */
+    ogs_pfcp_message_t *message;
+} ogs_pfcp_ie_index_t;
+
+ogs_pfcp_ie_index_t *ogs_pfcp_ie_index_parse(ogs_pkbuf_t *pkbuf);
+void ogs_pfcp_ie_index_free(ogs_pfcp_ie_index_t *index);
+
+ogs_pfcp_ie_t *ogs_pfcp_ie_find(
+        ogs_pfcp_ie_index_t *index, uint16_t type, ogs_pfcp_ie_t *prev);
+int ogs_pfcp_ie_decode(ogs_pfcp_ie_index_t *index,
+        ogs_pfcp_ie_t *ie, ogs_tlv_desc_t *desc, void *value);
+
+int ogs_pfcp_ie_decode_create_pdr(ogs_pfcp_ie_index_t *index,
+        ogs_pfcp_ie_t *ie, ogs_pfcp_tlv_create_pdr_t *create_pdr);
+int ogs_pfcp_ie_decode_create_far(ogs_pfcp_ie_index_t *index,
+        ogs_pfcp_ie_t *ie, ogs_pfcp_tlv_create_far_t *create_far);
+int ogs_pfcp_ie_decode_create_urr(ogs_pfcp_ie_index_t *index,
+        ogs_pfcp_ie_t *ie, ogs_pfcp_tlv_create_urr_t *create_urr);
+int ogs_pfcp_ie_decode_create_qer(ogs_pfcp_ie_index_t *index,
+        ogs_pfcp_ie_t *ie, ogs_pfcp_tlv_create_qer_t *create_qer);
+int ogs_pfcp_ie_decode_create_bar(ogs_pfcp_ie_index_t *index,
+        ogs_pfcp_ie_t *ie, ogs_pfcp_tlv_create_bar_t *create_bar);
+
+int ogs_pfcp_ie_index_decode_msg(
+        ogs_pfcp_ie_index_t *index, ogs_tlv_desc_t *desc, void *msg);
+ogs_pfcp_message_t *ogs_pfcp_ie_index_message(ogs_pfcp_ie_index_t *index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OGS_PFCP_IE_INDEX_H */
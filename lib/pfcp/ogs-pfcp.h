@@ -35,6 +35,7 @@
 #define OGS_PFCP_INSIDE
 
 #include "pfcp/message.h"
+#include "pfcp/ie-index.h"
 #include "pfcp/types.h"
 #include "pfcp/conv.h"
 #include "pfcp/context.h"
@@ -157,14 +157,14 @@ int ogs_pfcp_sendto(ogs_pfcp_node_t *node, ogs_pkbuf_t *pkbuf)
     } else
         ogs_assert_if_reached();
 
-    sent = ogs_sendto(sock->fd, pkbuf->data, pkbuf->len, 0, addr);
-    if (sent < 0 || sent != pkbuf->len) {
+    sent = ogs_sendto_pkbuf(sock->fd, pkbuf, 0, addr);
+    if (sent < 0 || sent != ogs_pkbuf_chain_len(pkbuf)) {
         if (ogs_socket_errno != OGS_EAGAIN) {
             char buf[OGS_ADDRSTRLEN];
             int err = ogs_socket_errno;
             ogs_log_message(OGS_LOG_ERROR, err,
                     "ogs_sendto(%u, %p, %u, 0, %s:%u) failed",
-                    sock->fd, pkbuf->data, pkbuf->len,
+                    sock->fd, pkbuf->data, ogs_pkbuf_chain_len(pkbuf),
                     OGS_ADDR(addr, buf), OGS_PORT(addr));
         }
         return OGS_ERROR;
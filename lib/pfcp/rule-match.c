@@ -109,172 +109,347 @@ static int decode_ipv6_header(
     return OGS_OK;
 }
 
-ogs_pfcp_rule_t *ogs_pfcp_pdr_rule_find_by_packet(
-                    ogs_pfcp_pdr_t *pdr, ogs_pkbuf_t *pkbuf)
+int ogs_pfcp_packet_info_parse(
+        ogs_pfcp_packet_info_t *info, ogs_pkbuf_t *pkbuf)
 {
     struct ip *ip_h =  NULL;
     struct ip6_hdr *ip6_h = NULL;
-    uint32_t *src_addr = NULL;
-    uint32_t *dst_addr = NULL;
-    int addr_len = 0;
-    uint8_t proto = 0;
-    uint16_t ip_hlen = 0;
-
-    ogs_pfcp_rule_t *rule = NULL;
 
+    ogs_assert(info);
     ogs_assert(pkbuf);
     ogs_assert(pkbuf->len);
     ogs_assert(pkbuf->data);
 
+    memset(info, 0, sizeof(*info));
+
+    ip_h = (struct ip *)pkbuf->data;
+    if (ip_h->ip_v == 4) {
+        if (pkbuf->len < sizeof(struct ip) ||
+            pkbuf->len < (ip_h->ip_hl)*4 || ip_h->ip_hl < 5) {
+            ogs_error("Truncated IPv4 packet [Packet Length:%d]",
+                    pkbuf->len);
+            return OGS_ERROR;
+        }
+
+        info->version = 4;
+        info->proto = ip_h->ip_p;
+        info->hlen = (ip_h->ip_hl)*4;
+
+        info->src[0] = ip_h->ip_src.s_addr;
+        info->dst[0] = ip_h->ip_dst.s_addr;
+    } else if (ip_h->ip_v == 6) {
+        if (pkbuf->len < sizeof(struct ip6_hdr)) {
+            ogs_error("Truncated IPv6 packet [Packet Length:%d]",
+                    pkbuf->len);
+            return OGS_ERROR;
+        }
+
+        ip6_h = (struct ip6_hdr *)pkbuf->data;
+
+        info->version = 6;
+        decode_ipv6_header(ip6_h, &info->proto, &info->hlen);
+
+        memcpy(info->src, ip6_h->ip6_src.s6_addr, OGS_IPV6_LEN);
+        memcpy(info->dst, ip6_h->ip6_dst.s6_addr, OGS_IPV6_LEN);
+    } else {
+        ogs_error("Invalid packet [IP version:%d, Packet Length:%d]",
+                ip_h->ip_v, pkbuf->len);
+        ogs_log_hexdump(OGS_LOG_ERROR, pkbuf->data, pkbuf->len);
+        return OGS_ERROR;
+    }
+
+    /* Source and destination ports are at the same offset in TCP/UDP */
+    if ((info->proto == IPPROTO_TCP || info->proto == IPPROTO_UDP) &&
+        info->hlen + sizeof(struct udphdr) <= pkbuf->len) {
+        struct udphdr *udph =
+            (struct udphdr *)((char *)pkbuf->data + info->hlen);
+
+        info->sport = be16toh(udph->uh_sport);
+        info->dport = be16toh(udph->uh_dport);
+    }
+
+    ogs_trace("PROTO:%d SRC:%08x %08x %08x %08x",
+            info->proto, be32toh(info->src[0]), be32toh(info->src[1]),
+            be32toh(info->src[2]), be32toh(info->src[3]));
+    ogs_trace("HLEN:%d  DST:%08x %08x %08x %08x",
+            info->hlen, be32toh(info->dst[0]), be32toh(info->dst[1]),
+            be32toh(info->dst[2]), be32toh(info->dst[3]));
+
+    return OGS_OK;
+}
+
+static bool rule_match_port(
+        ogs_ipfw_rule_t *ipfw, ogs_pfcp_packet_info_t *info)
+{
+    if (ipfw->proto != IPPROTO_TCP && ipfw->proto != IPPROTO_UDP) {
+        /* No need to match port */
+        return true;
+    }
+
+    /* Source port */
+    if (ipfw->port.src.low && info->sport < ipfw->port.src.low)
+        return false;
+    if (ipfw->port.src.high && info->sport > ipfw->port.src.high)
+        return false;
+
+    /* Dst Port*/
+    if (ipfw->port.dst.low && info->dport < ipfw->port.dst.low)
+        return false;
+    if (ipfw->port.dst.high && info->dport > ipfw->port.dst.high)
+        return false;
+
+    return true;
+}
+
+/* Anything else was not filled in by ogs_pfcp_packet_info_parse() */
+#define PACKET_INFO_PARSED(__iNFO) \
+    ((__iNFO)->version == 4 || (__iNFO)->version == 6)
+
+static bool rule_match(ogs_ipfw_rule_t *ipfw, ogs_pfcp_packet_info_t *info)
+{
+    int k, n = info->version == 4 ? 1 : 4;
+
+    for (k = 0; k < n; k++) {
+        if ((info->src[k] & ipfw->ip.src.mask[k]) != ipfw->ip.src.addr[k] ||
+            (info->dst[k] & ipfw->ip.dst.mask[k]) != ipfw->ip.dst.addr[k])
+            return false;
+    }
+
+    /* Protocol match */
+    if (ipfw->proto == 0) /* IP */
+        return true;
+    if (ipfw->proto != info->proto)
+        return false;
+
+    return rule_match_port(ipfw, info);
+}
+
+ogs_pfcp_rule_t *ogs_pfcp_pdr_rule_find_by_info(
+                    ogs_pfcp_pdr_t *pdr, ogs_pfcp_packet_info_t *info)
+{
+    ogs_pfcp_rule_t *rule = NULL;
+
+    ogs_assert(pdr);
+    ogs_assert(info);
+
+    if (!PACKET_INFO_PARSED(info))
+        return NULL;
+
     ogs_list_for_each(&pdr->rule_list, rule) {
-        int k;
-        uint32_t src_mask[4];
-        uint32_t dst_mask[4];
-        ogs_ipfw_rule_t *ipfw = NULL;
-
-        ipfw = &rule->ipfw;
-        ogs_assert(ipfw);
-
-        ip_h = (struct ip *)pkbuf->data;
-        if (ip_h->ip_v == 4) {
-            ip_h = (struct ip *)pkbuf->data;
-            ip6_h = NULL;
-
-            proto = ip_h->ip_p;
-            ip_hlen = (ip_h->ip_hl)*4;
-
-            src_addr = (void *)&ip_h->ip_src.s_addr;
-            dst_addr = (void *)&ip_h->ip_dst.s_addr;
-            addr_len = OGS_IPV4_LEN;
-        } else if (ip_h->ip_v == 6) {
-            ip_h = NULL;
-            ip6_h = (struct ip6_hdr *)pkbuf->data;
-
-            decode_ipv6_header(ip6_h, &proto, &ip_hlen);
-
-            src_addr = (void *)ip6_h->ip6_src.s6_addr;
-            dst_addr = (void *)ip6_h->ip6_dst.s6_addr;
-            addr_len = OGS_IPV6_LEN;
-        } else {
-            ogs_error("Invalid packet [IP version:%d, Packet Length:%d]",
-                    ip_h->ip_v, pkbuf->len);
-            ogs_log_hexdump(OGS_LOG_ERROR, pkbuf->data, pkbuf->len);
+        if (rule_match(&rule->ipfw, info) == true)
+            return rule;
+    }
+
+    return NULL;
+}
+
+ogs_pfcp_rule_t *ogs_pfcp_pdr_rule_find_by_packet(
+                    ogs_pfcp_pdr_t *pdr, ogs_pkbuf_t *pkbuf)
+{
+    ogs_pfcp_packet_info_t info;
+
+    if (ogs_pfcp_packet_info_parse(&info, pkbuf) != OGS_OK)
+        return NULL;
+
+    return ogs_pfcp_pdr_rule_find_by_info(pdr, &info);
+}
+
+/*
+ * Hash key : masked source, masked destination and protocol.
+ * IPv4 packets are only compared on the first word of each address,
+ * so every filter is keyed twice, once per IP version.
+ */
+#define CLASSIFIER_KEY_LEN (OGS_IPV6_LEN * 2 + 1)
+
+typedef struct classifier_entry_s {
+    int prio;                       /* Lower is better */
+    ogs_pfcp_pdr_t *pdr;
+    ogs_ipfw_rule_t *ipfw;          /* NULL : PDR without SDF filter */
+
+    uint8_t key[2][CLASSIFIER_KEY_LEN];
+    struct classifier_entry_s *next[2];
+} classifier_entry_t;
+
+typedef struct classifier_tuple_s {
+    uint32_t src_mask[4];
+    uint32_t dst_mask[4];
+    bool proto;                     /* Protocol is part of the key */
+
+    int best;                       /* Best prio in this tuple */
+    ogs_hash_t *hash;
+} classifier_tuple_t;
+
+struct ogs_pfcp_classifier_s {
+    int num_of_entry;
+    classifier_entry_t *entry;
+
+    int num_of_tuple;
+    classifier_tuple_t *tuple;
+};
+
+static int classifier_key(uint8_t *key, int n,
+        const uint32_t *src, const uint32_t *dst, uint8_t proto)
+{
+    int len = n * sizeof(uint32_t);
+
+    memcpy(key, src, len);
+    memcpy(key + len, dst, len);
+    key[len * 2] = proto;
+
+    return len * 2 + 1;
+}
+
+static int classifier_tuple_compare(const void *a, const void *b)
+{
+    return ((const classifier_tuple_t *)a)->best -
+            ((const classifier_tuple_t *)b)->best;
+}
+
+ogs_pfcp_classifier_t *ogs_pfcp_classifier_build(
+        ogs_pfcp_pdr_t **pdr, int num_of_pdr)
+{
+    static ogs_ipfw_rule_t any;     /* all-zero: matches every packet */
+
+    ogs_pfcp_classifier_t *cls = NULL;
+    ogs_pfcp_rule_t *rule = NULL;
+    int i, j, v, n;
+
+    ogs_assert(pdr || num_of_pdr == 0);
+
+    cls = ogs_calloc(1, sizeof(*cls));
+    ogs_assert(cls);
+
+    for (i = 0; i < num_of_pdr; i++) {
+        j = ogs_list_count(&pdr[i]->rule_list);
+        cls->num_of_entry += j ? j : 1;
+    }
+    if (cls->num_of_entry == 0)
+        return cls;
+
+    cls->entry = ogs_calloc(cls->num_of_entry, sizeof(classifier_entry_t));
+    ogs_assert(cls->entry);
+    cls->tuple = ogs_calloc(cls->num_of_entry, sizeof(classifier_tuple_t));
+    ogs_assert(cls->tuple);
+
+    n = 0;
+    for (i = 0; i < num_of_pdr; i++) {
+        if (ogs_list_first(&pdr[i]->rule_list) == NULL) {
+            cls->entry[n].prio = n;
+            cls->entry[n].pdr = pdr[i];
+            cls->entry[n].ipfw = &any;
+            n++;
             continue;
         }
+        ogs_list_for_each(&pdr[i]->rule_list, rule) {
+            cls->entry[n].prio = n;
+            cls->entry[n].pdr = pdr[i];
+            cls->entry[n].ipfw = &rule->ipfw;
+            n++;
+        }
+    }
+    ogs_assert(n == cls->num_of_entry);
+
+    /*
+     * Insert from the worst to the best priority so that
+     * every hash chain ends up sorted by priority.
+     */
+    for (i = cls->num_of_entry - 1; i >= 0; i--) {
+        classifier_entry_t *e = &cls->entry[i];
+        classifier_tuple_t *t = NULL;
+        ogs_ipfw_rule_t *ipfw = e->ipfw;
+
+        for (j = 0; j < cls->num_of_tuple; j++) {
+            t = &cls->tuple[j];
+            if (memcmp(t->src_mask, ipfw->ip.src.mask,
+                        sizeof(t->src_mask)) == 0 &&
+                memcmp(t->dst_mask, ipfw->ip.dst.mask,
+                        sizeof(t->dst_mask)) == 0 &&
+                t->proto == (ipfw->proto != 0))
+                break;
+        }
+        if (j == cls->num_of_tuple) {
+            t = &cls->tuple[cls->num_of_tuple++];
+            memcpy(t->src_mask, ipfw->ip.src.mask, sizeof(t->src_mask));
+            memcpy(t->dst_mask, ipfw->ip.dst.mask, sizeof(t->dst_mask));
+            t->proto = (ipfw->proto != 0);
+            t->hash = ogs_hash_make();
+            ogs_assert(t->hash);
+        }
+        t->best = e->prio;
 
-        ogs_trace("PROTO:%d SRC:%08x %08x %08x %08x",
-                proto, be32toh(src_addr[0]), be32toh(src_addr[1]),
-                be32toh(src_addr[2]), be32toh(src_addr[3]));
-        ogs_trace("HLEN:%d  DST:%08x %08x %08x %08x",
-                ip_hlen, be32toh(dst_addr[0]), be32toh(dst_addr[1]),
-                be32toh(dst_addr[2]), be32toh(dst_addr[3]));
-
-        ogs_trace("PROTO:%d SRC:%d-%d DST:%d-%d",
-                ipfw->proto,
-                ipfw->port.src.low,
-                ipfw->port.src.high,
-                ipfw->port.dst.low,
-                ipfw->port.dst.high);
-        ogs_trace("SRC:%08x %08x %08x %08x/%08x %08x %08x %08x",
-                be32toh(ipfw->ip.src.addr[0]),
-                be32toh(ipfw->ip.src.addr[1]),
-                be32toh(ipfw->ip.src.addr[2]),
-                be32toh(ipfw->ip.src.addr[3]),
-                be32toh(ipfw->ip.src.mask[0]),
-                be32toh(ipfw->ip.src.mask[1]),
-                be32toh(ipfw->ip.src.mask[2]),
-                be32toh(ipfw->ip.src.mask[3]));
-        ogs_trace("DST:%08x %08x %08x %08x/%08x %08x %08x %08x",
-                be32toh(ipfw->ip.dst.addr[0]),
-                be32toh(ipfw->ip.dst.addr[1]),
-                be32toh(ipfw->ip.dst.addr[2]),
-                be32toh(ipfw->ip.dst.addr[3]),
-                be32toh(ipfw->ip.dst.mask[0]),
-                be32toh(ipfw->ip.dst.mask[1]),
-                be32toh(ipfw->ip.dst.mask[2]),
-                be32toh(ipfw->ip.dst.mask[3]));
-
-        for (k = 0; k < 4; k++) {
-            src_mask[k] = src_addr[k] & ipfw->ip.src.mask[k];
-            dst_mask[k] = dst_addr[k] & ipfw->ip.dst.mask[k];
+        for (v = 0; v < 2; v++) {
+            int klen = classifier_key(e->key[v], v ? 4 : 1,
+                    ipfw->ip.src.addr, ipfw->ip.dst.addr, ipfw->proto);
+            e->next[v] = ogs_hash_get(t->hash, e->key[v], klen);
+            ogs_hash_set(t->hash, e->key[v], klen, e);
         }
+    }
+
+    qsort(cls->tuple, cls->num_of_tuple,
+            sizeof(classifier_tuple_t), classifier_tuple_compare);
 
-        if (memcmp(src_mask, ipfw->ip.src.addr, addr_len) == 0 &&
-            memcmp(dst_mask, ipfw->ip.dst.addr, addr_len) == 0) {
-            /* Protocol match */
-            if (ipfw->proto == 0) { /* IP */
-                /* No need to match port */
-                return rule;
-            }
-
-            if (ipfw->proto == proto) {
-                if (ipfw->proto == IPPROTO_TCP) {
-                    struct tcphdr *tcph =
-                        (struct tcphdr *)((char *)pkbuf->data + ip_hlen);
-
-                    /* Source port */
-                    if (ipfw->port.src.low &&
-                          be16toh(tcph->th_sport) < ipfw->port.src.low) {
-                        continue;
-                    }
-
-                    if (ipfw->port.src.high &&
-                          be16toh(tcph->th_sport) > ipfw->port.src.high) {
-                        continue;
-                    }
-
-                    /* Dst Port*/
-                    if (ipfw->port.dst.low &&
-                          be16toh(tcph->th_dport) < ipfw->port.dst.low) {
-                        continue;
-                    }
-
-                    if (ipfw->port.dst.high &&
-                          be16toh(tcph->th_dport) > ipfw->port.dst.high) {
-                        continue;
-                    }
-
-                    /* Matched */
-                    return rule;
-
-                } else if (ipfw->proto == IPPROTO_UDP) {
-                    struct udphdr *udph =
-                        (struct udphdr *)((char *)pkbuf->data + ip_hlen);
-
-                    /* Source port */
-                    if (ipfw->port.src.low &&
-                          be16toh(udph->uh_sport) < ipfw->port.src.low) {
-                        continue;
-                    }
-
-                    if (ipfw->port.src.high &&
-                          be16toh(udph->uh_sport) > ipfw->port.src.high) {
-                        continue;
-                    }
-
-                    /* Dst Port*/
-                    if (ipfw->port.dst.low &&
-                          be16toh(udph->uh_dport) < ipfw->port.dst.low) {
-                        continue;
-                    }
-
-                    if (ipfw->port.dst.high &&
-                          be16toh(udph->uh_dport) > ipfw->port.dst.high) {
-                        continue;
-                    }
-
-                    /* Matched */
-                    return rule;
-
-                } else {
-
-                    /* No need to match port */
-                    return rule;
-
-                }
-            }
+    return cls;
+}
+
+void ogs_pfcp_classifier_free(ogs_pfcp_classifier_t *cls)
+{
+    int i;
+
+    ogs_assert(cls);
+
+    for (i = 0; i < cls->num_of_tuple; i++)
+        ogs_hash_destroy(cls->tuple[i].hash);
+
+    if (cls->tuple)
+        ogs_free(cls->tuple);
+    if (cls->entry)
+        ogs_free(cls->entry);
+    ogs_free(cls);
+}
+
+ogs_pfcp_pdr_t *ogs_pfcp_classifier_find(
+        ogs_pfcp_classifier_t *cls, ogs_pfcp_packet_info_t *info,
+        bool (*accept)(ogs_pfcp_pdr_t *pdr, void *data), void *data)
+{
+    classifier_entry_t *best = NULL, *e = NULL;
+    uint8_t key[CLASSIFIER_KEY_LEN];
+    uint32_t src[4], dst[4];
+    int i, k, v, n, klen;
+
+    ogs_assert(cls);
+    ogs_assert(info);
+
+    if (!PACKET_INFO_PARSED(info))
+        return NULL;
+
+    v = info->version == 4 ? 0 : 1;
+    n = v ? 4 : 1;
+
+    for (i = 0; i < cls->num_of_tuple; i++) {
+        classifier_tuple_t *t = &cls->tuple[i];
+
+        /* Tuples are sorted by their best priority */
+        if (best && t->best > best->prio)
+            break;
+
+        for (k = 0; k < n; k++) {
+            src[k] = info->src[k] & t->src_mask[k];
+            dst[k] = info->dst[k] & t->dst_mask[k];
+        }
+        klen = classifier_key(key, n, src, dst, t->proto ? info->proto : 0);
+
+        for (e = ogs_hash_get(t->hash, key, klen); e; e = e->next[v]) {
+            if (best && e->prio > best->prio)
+                break;
+            if (rule_match_port(e->ipfw, info) == false)
+                continue;
+            if (accept && accept(e->pdr, data) == false)
+                continue;
+
+            best = e;
+            break;
         }
     }
 
-    return NULL;
+    return best ? best->pdr : NULL;
 }
@@ -28,8 +28,53 @@
 extern "C" {
 #endif
 
+/*
+ * The 5-tuple of an IP packet, parsed once and matched against
+ * the SDF filters of any number of PDRs.
+ */
+typedef struct ogs_pfcp_packet_info_s {
+    uint8_t     version;
+    uint8_t     proto;
+    uint16_t    hlen;               /* IP header length */
+
+    uint32_t    src[4];             /* Network order, IPv4 in src[0] */
+    uint32_t    dst[4];
+
+    uint16_t    sport;              /* Host order, TCP/UDP only */
+    uint16_t    dport;
+} ogs_pfcp_packet_info_t;
+
+int ogs_pfcp_packet_info_parse(
+        ogs_pfcp_packet_info_t *info, ogs_pkbuf_t *pkbuf);
+
 ogs_pfcp_rule_t *ogs_pfcp_pdr_rule_find_by_packet(
                     ogs_pfcp_pdr_t *pdr, ogs_pkbuf_t *pkbuf);
+ogs_pfcp_rule_t *ogs_pfcp_pdr_rule_find_by_info(
+                    ogs_pfcp_pdr_t *pdr, ogs_pfcp_packet_info_t *info);
+
+/*
+ * SDF classifier compiled from an ordered set of PDRs
+ *
+ * The SDF filters are grouped by (source mask, destination mask,
+ * protocol-or-any) and each group is a hash table on the masked
+ * addresses and protocol (tuple space search). A lookup probes one
+ * hash table per group, best group first, and stops as soon as no
+ * remaining group can hold a better match.
+ *
+ * ogs_pfcp_classifier_find() returns the same PDR as walking pdr[]
+ * in order and returning the first one whose rule_list is empty or
+ * matches the packet, and for which accept() (if given) is true.
+ * A packet that ogs_pfcp_packet_info_parse() failed on matches nothing.
+ */
+typedef struct ogs_pfcp_classifier_s ogs_pfcp_classifier_t;
+
+ogs_pfcp_classifier_t *ogs_pfcp_classifier_build(
+        ogs_pfcp_pdr_t **pdr, int num_of_pdr);
+void ogs_pfcp_classifier_free(ogs_pfcp_classifier_t *cls);
+
+ogs_pfcp_pdr_t *ogs_pfcp_classifier_find(
+        ogs_pfcp_classifier_t *cls, ogs_pfcp_packet_info_t *info,
+        bool (*accept)(ogs_pfcp_pdr_t *pdr, void *data), void *data);
 
 #ifdef __cplusplus
 }
@@ -29,6 +29,111 @@
 #define OGS_PFCP_NODE_ID_OPTIONAL  1
 #define OGS_PFCP_NODE_ID_MANDATORY 2
 
+/*
+ * Returns the Node ID requirement of the given message type,
+ * or -1 if the message type is unknown.
+ */
+static int node_id_requirement(uint8_t type)
+{
+    switch (type) {
+    case OGS_PFCP_PFD_MANAGEMENT_REQUEST_TYPE:
+    case OGS_PFCP_PFD_MANAGEMENT_RESPONSE_TYPE:
+    case OGS_PFCP_SESSION_MODIFICATION_REQUEST_TYPE:
+        return OGS_PFCP_NODE_ID_OPTIONAL;
+
+    case OGS_PFCP_ASSOCIATION_SETUP_REQUEST_TYPE:
+    case OGS_PFCP_ASSOCIATION_SETUP_RESPONSE_TYPE:
+    case OGS_PFCP_ASSOCIATION_UPDATE_REQUEST_TYPE:
+    case OGS_PFCP_ASSOCIATION_UPDATE_RESPONSE_TYPE:
+    case OGS_PFCP_ASSOCIATION_RELEASE_REQUEST_TYPE:
+    case OGS_PFCP_ASSOCIATION_RELEASE_RESPONSE_TYPE:
+    case OGS_PFCP_NODE_REPORT_REQUEST_TYPE:
+    case OGS_PFCP_NODE_REPORT_RESPONSE_TYPE:
+    case OGS_PFCP_SESSION_SET_DELETION_REQUEST_TYPE:
+    case OGS_PFCP_SESSION_SET_DELETION_RESPONSE_TYPE:
+    case OGS_PFCP_SESSION_SET_MODIFICATION_REQUEST_TYPE:
+    case OGS_PFCP_SESSION_SET_MODIFICATION_RESPONSE_TYPE:
+    case OGS_PFCP_SESSION_ESTABLISHMENT_REQUEST_TYPE:
+    case OGS_PFCP_SESSION_ESTABLISHMENT_RESPONSE_TYPE:
+        return OGS_PFCP_NODE_ID_MANDATORY;
+
+    /* Add other message types with node_id here as needed */
+
+    case OGS_PFCP_HEARTBEAT_REQUEST_TYPE:
+    case OGS_PFCP_HEARTBEAT_RESPONSE_TYPE:
+    case OGS_PFCP_VERSION_NOT_SUPPORTED_RESPONSE_TYPE:
+    case OGS_PFCP_SESSION_MODIFICATION_RESPONSE_TYPE:
+    case OGS_PFCP_SESSION_DELETION_REQUEST_TYPE:
+    case OGS_PFCP_SESSION_DELETION_RESPONSE_TYPE:
+    case OGS_PFCP_SESSION_REPORT_REQUEST_TYPE:
+    case OGS_PFCP_SESSION_REPORT_RESPONSE_TYPE:
+        /* Node ID must not be present for these messages */
+        return OGS_PFCP_NODE_ID_NONE;
+
+    default:
+        return -1;
+    }
+}
+
+/*
+ * Validates the Node ID TLV against the requirement of the message
+ * type and copies it into 'node_id'. tlv_node_id is NULL
+ * if the message type has no Node ID field.
+ */
+static ogs_pfcp_status_e node_id_check(uint8_t type,
+        ogs_pfcp_tlv_node_id_t *tlv_node_id, ogs_pfcp_node_id_t *node_id)
+{
+    int requirement = node_id_requirement(type);
+
+    /* Initialize the output structure */
+    memset(node_id, 0, sizeof(*node_id));
+
+    /* Check requirement vs. tlv_node_id existence */
+    switch (requirement) {
+    case OGS_PFCP_NODE_ID_MANDATORY:
+        /* Must have tlv_node_id. presence must be 1. */
+        ogs_assert(tlv_node_id);
+        if (!tlv_node_id->presence)
+            return OGS_PFCP_ERROR_NODE_ID_NOT_PRESENT;
+        break;
+
+    case OGS_PFCP_NODE_ID_OPTIONAL:
+        /*
+         * Must have tlv_node_id. presence=1 => real Node ID
+         * presence=0 => no Node ID
+         */
+        ogs_assert(tlv_node_id);
+        if (!tlv_node_id->presence)
+            return OGS_PFCP_STATUS_NODE_ID_OPTIONAL_ABSENT;
+        break;
+
+    case OGS_PFCP_NODE_ID_NONE:
+        /* Must be NULL => no Node ID field */
+        ogs_assert(tlv_node_id == NULL);
+        return OGS_PFCP_STATUS_NODE_ID_NONE;
+
+    default:
+        /* Unknown message type */
+        ogs_error("Unknown message type %d", type);
+        return OGS_PFCP_ERROR_UNKNOWN_MESSAGE;
+    }
+
+    memcpy(node_id, tlv_node_id->data,
+            ogs_min(tlv_node_id->len, sizeof(ogs_pfcp_node_id_t)));
+    node_id->fqdn[OGS_MAX_FQDN_LEN - 1] = '\0';
+
+    if (node_id->type != OGS_PFCP_NODE_ID_IPV4 &&
+        node_id->type != OGS_PFCP_NODE_ID_IPV6 &&
+        node_id->type != OGS_PFCP_NODE_ID_FQDN) {
+        ogs_error("Semantic incorrect message[%d] type[%d]",
+                type, node_id->type);
+        return OGS_PFCP_ERROR_SEMANTIC_INCORRECT_MESSAGE;
+    }
+
+    /* Node ID is valid */
+    return OGS_PFCP_STATUS_SUCCESS;
+}
+
 /*
  * This function extracts the PFCP Node ID from the given PFCP message.
  * It determines the Node ID field location and requirement based on
@@ -40,176 +145,101 @@ ogs_pfcp_status_e
 ogs_pfcp_extract_node_id(ogs_pfcp_message_t *message,
                          ogs_pfcp_node_id_t *node_id)
 {
-
     /* For C89 compliance, all variables are declared upfront. */
     ogs_pfcp_tlv_node_id_t *tlv_node_id = NULL;
-    int requirement = OGS_PFCP_NODE_ID_NONE;
-    ogs_pfcp_status_e status = OGS_PFCP_STATUS_SUCCESS;
 
     /* Validate input pointers */
     ogs_assert(message);
     ogs_assert(node_id);
 
-    /* Initialize the output structure */
-    memset(node_id, 0, sizeof(*node_id));
-
-    /* Determine the location of node_id TLV and requirement */
+    /* Determine the location of node_id TLV */
     switch (message->h.type) {
     case OGS_PFCP_PFD_MANAGEMENT_REQUEST_TYPE:
         tlv_node_id = &message->pfcp_pfd_management_request.node_id;
-        requirement = OGS_PFCP_NODE_ID_OPTIONAL;
         break;
-
     case OGS_PFCP_PFD_MANAGEMENT_RESPONSE_TYPE:
         tlv_node_id = &message->pfcp_pfd_management_response.node_id;
-        requirement = OGS_PFCP_NODE_ID_OPTIONAL;
         break;
-
     case OGS_PFCP_ASSOCIATION_SETUP_REQUEST_TYPE:
         tlv_node_id = &message->pfcp_association_setup_request.node_id;
-        requirement = OGS_PFCP_NODE_ID_MANDATORY;
         break;
-
     case OGS_PFCP_ASSOCIATION_SETUP_RESPONSE_TYPE:
         tlv_node_id = &message->pfcp_association_setup_response.node_id;
-        requirement = OGS_PFCP_NODE_ID_MANDATORY;
         break;
-
     case OGS_PFCP_ASSOCIATION_UPDATE_REQUEST_TYPE:
         tlv_node_id = &message->pfcp_association_update_request.node_id;
-        requirement = OGS_PFCP_NODE_ID_MANDATORY;
         break;
-
     case OGS_PFCP_ASSOCIATION_UPDATE_RESPONSE_TYPE:
         tlv_node_id = &message->pfcp_association_update_response.node_id;
-        requirement = OGS_PFCP_NODE_ID_MANDATORY;
         break;
-
     case OGS_PFCP_ASSOCIATION_RELEASE_REQUEST_TYPE:
         tlv_node_id = &message->pfcp_association_release_request.node_id;
-        requirement = OGS_PFCP_NODE_ID_MANDATORY;
         break;
-
     case OGS_PFCP_ASSOCIATION_RELEASE_RESPONSE_TYPE:
         tlv_node_id = &message->pfcp_association_release_response.node_id;
-        requirement = OGS_PFCP_NODE_ID_MANDATORY;
         break;
-
     case OGS_PFCP_NODE_REPORT_REQUEST_TYPE:
         tlv_node_id = &message->pfcp_node_report_request.node_id;
-        requirement = OGS_PFCP_NODE_ID_MANDATORY;
         break;
-
     case OGS_PFCP_NODE_REPORT_RESPONSE_TYPE:
         tlv_node_id = &message->pfcp_node_report_response.node_id;
-        requirement = OGS_PFCP_NODE_ID_MANDATORY;
         break;
-
     case OGS_PFCP_SESSION_SET_DELETION_REQUEST_TYPE:
         tlv_node_id = &message->pfcp_session_set_deletion_request.node_id;
-        requirement = OGS_PFCP_NODE_ID_MANDATORY;
         break;
-
     case OGS_PFCP_SESSION_SET_DELETION_RESPONSE_TYPE:
         tlv_node_id = &message->pfcp_session_set_deletion_response.node_id;
-        requirement = OGS_PFCP_NODE_ID_MANDATORY;
         break;
-
     case OGS_PFCP_SESSION_SET_MODIFICATION_REQUEST_TYPE:
         tlv_node_id = &message->pfcp_session_set_modification_request.node_id;
-        requirement = OGS_PFCP_NODE_ID_MANDATORY;
         break;
-
     case OGS_PFCP_SESSION_SET_MODIFICATION_RESPONSE_TYPE:
-        tlv_node_id = &message->pfcp_session_set_modification_response.node_id;
-        requirement = OGS_PFCP_NODE_ID_MANDATORY;
+        tlv_node_id =
+            &message->pfcp_session_set_modification_response.node_id;
         break;
-
     case OGS_PFCP_SESSION_ESTABLISHMENT_REQUEST_TYPE:
         tlv_node_id = &message->pfcp_session_establishment_request.node_id;
-        requirement = OGS_PFCP_NODE_ID_MANDATORY;
         break;
-
     case OGS_PFCP_SESSION_ESTABLISHMENT_RESPONSE_TYPE:
         tlv_node_id = &message->pfcp_session_establishment_response.node_id;
-        requirement = OGS_PFCP_NODE_ID_MANDATORY;
         break;
-
     case OGS_PFCP_SESSION_MODIFICATION_REQUEST_TYPE:
         tlv_node_id = &message->pfcp_session_modification_request.node_id;
-        requirement = OGS_PFCP_NODE_ID_OPTIONAL;
-        break;
-
-    /* Add other message types with node_id here as needed */
-
-    case OGS_PFCP_HEARTBEAT_REQUEST_TYPE:
-    case OGS_PFCP_HEARTBEAT_RESPONSE_TYPE:
-    case OGS_PFCP_VERSION_NOT_SUPPORTED_RESPONSE_TYPE:
-    case OGS_PFCP_SESSION_MODIFICATION_RESPONSE_TYPE:
-    case OGS_PFCP_SESSION_DELETION_REQUEST_TYPE:
-    case OGS_PFCP_SESSION_DELETION_RESPONSE_TYPE:
-    case OGS_PFCP_SESSION_REPORT_REQUEST_TYPE:
-    case OGS_PFCP_SESSION_REPORT_RESPONSE_TYPE:
-        /* Node ID must not be present for these messages */
-        requirement = OGS_PFCP_NODE_ID_NONE;
         break;
-
     default:
-        /* Unknown message type */
-        ogs_error("Unknown message type %d", message->h.type);
-        return OGS_PFCP_ERROR_UNKNOWN_MESSAGE;
+        break;
     }
 
-    /* Check requirement vs. tlv_node_id existence */
-    switch (requirement) {
-    case OGS_PFCP_NODE_ID_MANDATORY:
-        /* Must have tlv_node_id. presence must be 1. */
-        ogs_assert(tlv_node_id);
-        if (!tlv_node_id->presence) {
-            status = OGS_PFCP_ERROR_NODE_ID_NOT_PRESENT;
-            goto done;
-        }
-        break;
+    return node_id_check(message->h.type, tlv_node_id, node_id);
+}
 
-    case OGS_PFCP_NODE_ID_OPTIONAL:
-        /*
-         * Must have tlv_node_id. presence=1 => real Node ID
-         * presence=0 => no Node ID
-         */
-        ogs_assert(tlv_node_id);
-        if (!tlv_node_id->presence) {
-            status = OGS_PFCP_STATUS_NODE_ID_OPTIONAL_ABSENT;
-            goto done;
-        }
-        break;
+/*
+ * Same as ogs_pfcp_extract_node_id(), but takes the Node ID IE
+ * straight from the IE index without decoding the message.
+ */
+ogs_pfcp_status_e
+ogs_pfcp_ie_index_extract_node_id(ogs_pfcp_ie_index_t *index,
+                                  ogs_pfcp_node_id_t *node_id)
+{
+    ogs_pfcp_tlv_node_id_t tlv_node_id;
+    ogs_pfcp_ie_t *ie = NULL;
 
-    case OGS_PFCP_NODE_ID_NONE:
-        /* Must be NULL => no Node ID field */
-        ogs_assert(tlv_node_id == NULL);
-        status = OGS_PFCP_STATUS_NODE_ID_NONE;
-        goto done;
+    ogs_assert(index);
+    ogs_assert(node_id);
 
-    default:
-        status = OGS_PFCP_ERROR_UNKNOWN_MESSAGE;
-        goto done;
-    }
+    if (node_id_requirement(index->h.type) == OGS_PFCP_NODE_ID_NONE)
+        return node_id_check(index->h.type, NULL, node_id);
 
-	memcpy(node_id, tlv_node_id->data, ogs_min(tlv_node_id->len, sizeof(ogs_pfcp_node_id_t)));
-    node_id->fqdn[OGS_MAX_FQDN_LEN - 1] = '\0';
+    memset(&tlv_node_id, 0, sizeof(tlv_node_id));
 
-    if (node_id->type != OGS_PFCP_NODE_ID_IPV4 &&
-        node_id->type != OGS_PFCP_NODE_ID_IPV6 &&
-        node_id->type != OGS_PFCP_NODE_ID_FQDN) {
-        ogs_error("Semantic incorrect message[%d] type[%d]",
-                message->h.type, node_id->type);
+    ie = ogs_pfcp_ie_find(index, OGS_PFCP_NODE_ID_TYPE, NULL);
+    if (ie && ogs_pfcp_ie_decode(index, ie,
+                &ogs_pfcp_tlv_desc_node_id, &tlv_node_id) != OGS_OK) {
+        ogs_error("Can't decode Node ID");
         return OGS_PFCP_ERROR_SEMANTIC_INCORRECT_MESSAGE;
     }
 
-     /* Node ID is valid */
-    status = OGS_PFCP_STATUS_SUCCESS;
-
-done:
-    return status;
+    return node_id_check(index->h.type, &tlv_node_id, node_id);
 }
 
 ogs_sockaddr_t *ogs_pfcp_node_id_to_addrinfo(const ogs_pfcp_node_id_t *node_id)
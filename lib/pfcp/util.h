@@ -49,6 +49,9 @@ typedef enum {
 ogs_pfcp_status_e
 ogs_pfcp_extract_node_id(ogs_pfcp_message_t *message,
                          ogs_pfcp_node_id_t *node_id);
+ogs_pfcp_status_e
+ogs_pfcp_ie_index_extract_node_id(ogs_pfcp_ie_index_t *index,
+                                  ogs_pfcp_node_id_t *node_id);
 
 ogs_sockaddr_t *ogs_pfcp_node_id_to_addrinfo(const ogs_pfcp_node_id_t *node_id);
 const char *ogs_pfcp_node_id_to_string_static(
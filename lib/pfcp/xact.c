@@ -575,7 +575,8 @@ static void response_timeout(void *data)
 
     xact = ogs_pfcp_xact_find_by_id(xact_id);
     if (!xact) {
-        ogs_error("PFCP Transaction has already been removed [%d]", xact_id);
+        ogs_error("PFCP Transaction has already been removed [%lld]",
+                (long long)xact_id);
         return;;
     }
     ogs_assert(xact->node);
@@ -624,7 +625,8 @@ static void holding_timeout(void *data)
 
     xact = ogs_pfcp_xact_find_by_id(xact_id);
     if (!xact) {
-        ogs_error("PFCP Transaction has already been removed [%d]", xact_id);
+        ogs_error("PFCP Transaction has already been removed [%lld]",
+                (long long)xact_id);
         return;;
     }
     ogs_assert(xact->node);
@@ -662,7 +664,8 @@ static void delayed_commit_timeout(void *data)
 
     xact = ogs_pfcp_xact_find_by_id(xact_id);
     if (!xact) {
-        ogs_error("PFCP Transaction has already been removed [%d]", xact_id);
+        ogs_error("PFCP Transaction has already been removed [%lld]",
+                (long long)xact_id);
         return;;
     }
     ogs_assert(xact->node);
@@ -23,12 +23,139 @@ const char *OGS_EVENT_NAME_SBI_SERVER = "OGS_EVENT_NAME_SBI_SERVER";
 const char *OGS_EVENT_NAME_SBI_CLIENT = "OGS_EVENT_NAME_SBI_CLIENT";
 const char *OGS_EVENT_NAME_SBI_TIMER = "OGS_EVENT_NAME_SBI_TIMER";
 
+/*
+ * Events are carved out of per-thread slabs in a few size classes.
+ *
+ * The thread allocating an event owns it. When the owner frees it, the
+ * event goes back on the owner's free list. When another thread frees it
+ * (typically the NF main loop freeing an event pushed by a freeDiameter
+ * or SCTP thread), it is pushed on the owner's remote list. The owner
+ * takes the whole remote list over when its own list runs dry.
+ * No lock is taken on either path.
+ *
+ * Events larger than the largest class fall back to ogs_calloc().
+ */
+#define EVENT_SLAB_SIZE         (16*1024)
+#define EVENT_NUM_OF_CLASS      4
+
+static const size_t event_class_size[EVENT_NUM_OF_CLASS] = {
+    128, 256, 512, 1024
+};
+
+typedef struct event_cache_s event_cache_t;
+
+typedef union event_header_u {
+    struct {
+        event_cache_t *cache;   /* NULL if not taken from a slab */
+        int klass;
+    } h;
+    char align[16];
+} event_header_t;
+
+struct event_cache_s {
+    event_cache_t *next;        /* in cache_list, never removed */
+
+    void *free[EVENT_NUM_OF_CLASS];     /* used by the owner only */
+    void *remote[EVENT_NUM_OF_CLASS];   /* pushed by other threads */
+
+    /*
+     * Written by the owner only, and read without a lock by
+     * ogs_event_stat(), which may miss the latest increments.
+     */
+    uint64_t alloc;
+    uint64_t free_count;
+};
+
+static OGS_THREAD_LOCAL event_cache_t *thread_cache;
+
+/*
+ * Caches outlive their threads, as events allocated by a thread may be
+ * freed after it exits. There is one per thread ever having used events.
+ */
+static event_cache_t *cache_list;
+
+#define event_header(e) ((event_header_t *)(e) - 1)
+#define event_next(h) (*(void **)((event_header_t *)(h) + 1))
+
+static event_cache_t *event_cache(void)
+{
+    event_cache_t *cache = thread_cache;
+
+    if (cache)
+        return cache;
+
+    cache = calloc(1, sizeof(*cache));
+    ogs_assert(cache);
+
+    cache->next = ogs_atomic_load(&cache_list, OGS_ATOMIC_RELAXED);
+    while (!ogs_atomic_cas(&cache_list, &cache->next, cache,
+                OGS_ATOMIC_RELEASE, OGS_ATOMIC_RELAXED));
+
+    thread_cache = cache;
+
+    return cache;
+}
+
+static int event_class(size_t size)
+{
+    int k;
+
+    for (k = 0; k < EVENT_NUM_OF_CLASS; k++)
+        if (size <= event_class_size[k])
+            return k;
+
+    return -1;
+}
+
+static void *event_slab(event_cache_t *cache, int k)
+{
+    size_t slot = sizeof(event_header_t) + event_class_size[k];
+    int i, n = EVENT_SLAB_SIZE / slot;
+    char *slab = NULL;
+    event_header_t *h = NULL;
+
+    /* Slabs are never returned : they are kept for reuse by the cache */
+    slab = malloc(n * slot);
+    ogs_assert(slab);
+
+    for (i = 0; i < n; i++) {
+        h = (event_header_t *)(slab + i * slot);
+        h->h.cache = cache;
+        h->h.klass = k;
+        event_next(h) = i + 1 < n ? slab + (i + 1) * slot : NULL;
+    }
+
+    return slab;
+}
+
 void *ogs_event_size(int id, size_t size)
 {
+    event_cache_t *cache = event_cache();
+    event_header_t *h = NULL;
     ogs_event_t *e = NULL;
+    int k;
 
-    e = ogs_calloc(1, size);
-    ogs_assert(e);
+    ogs_assert(size >= sizeof(int));
+
+    k = event_class(size);
+    if (k < 0) {
+        h = ogs_calloc(1, sizeof(*h) + size);
+        ogs_assert(h);
+    } else {
+        h = cache->free[k];
+        if (!h)
+            h = ogs_atomic_exchange(
+                    &cache->remote[k], NULL, OGS_ATOMIC_ACQUIRE);
+        if (!h)
+            h = event_slab(cache, k);
+
+        cache->free[k] = event_next(h);
+    }
+
+    cache->alloc++;
+
+    e = (ogs_event_t *)(h + 1);
+    memset(e, 0, size);
 
     e->id = id;
 
@@ -42,8 +169,48 @@ ogs_event_t *ogs_event_new(int id)
 
 void ogs_event_free(void *e)
 {
+    event_cache_t *cache = event_cache();
+    event_cache_t *owner = NULL;
+    event_header_t *h = NULL;
+    int k;
+
     ogs_assert(e);
-    ogs_free(e);
+
+    h = event_header(e);
+    owner = h->h.cache;
+    k = h->h.klass;
+
+    if (!owner) {
+        ogs_free(h);
+    } else if (owner == cache) {
+        event_next(h) = cache->free[k];
+        cache->free[k] = h;
+    } else {
+        event_next(h) =
+            ogs_atomic_load(&owner->remote[k], OGS_ATOMIC_RELAXED);
+        while (!ogs_atomic_cas(&owner->remote[k], &event_next(h), h,
+                    OGS_ATOMIC_RELEASE, OGS_ATOMIC_RELAXED));
+    }
+
+    cache->free_count++;
+}
+
+void ogs_event_stat(ogs_event_stat_t *stat)
+{
+    event_cache_t *cache = NULL;
+
+    ogs_assert(stat);
+
+    memset(stat, 0, sizeof(*stat));
+
+    for (cache = ogs_atomic_load(&cache_list, OGS_ATOMIC_ACQUIRE);
+            cache; cache = cache->next) {
+        stat->alloc += cache->alloc;
+        stat->free += cache->free_count;
+    }
+
+    stat->outstanding = stat->alloc > stat->free ?
+        stat->alloc - stat->free : 0;
 }
 
 const char *ogs_event_get_name(ogs_event_t *e)
@@ -68,6 +68,14 @@ void *ogs_event_size(int id, size_t size);
 ogs_event_t *ogs_event_new(int id);
 void ogs_event_free(void *e);
 
+typedef struct ogs_event_stat_s {
+    uint64_t alloc;         /* Events allocated so far */
+    uint64_t free;          /* Events freed so far */
+    uint64_t outstanding;   /* Events not yet freed */
+} ogs_event_stat_t;
+
+void ogs_event_stat(ogs_event_stat_t *stat);
+
 const char *ogs_event_get_name(ogs_event_t *e);
 
 #ifdef __cplusplus
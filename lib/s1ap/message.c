@@ -60,6 +60,60 @@ int ogs_s1ap_decode(ogs_s1ap_message_t *message, ogs_pkbuf_t *pkbuf)
     return OGS_OK;
 }
 
+int ogs_s1ap_decode_route(ogs_s1ap_route_t *route, ogs_pkbuf_t *pkbuf)
+{
+    ogs_asn_route_t r;
+    ogs_asn_route_ie_t ie;
+    uint64_t value;
+    int i;
+
+    ogs_assert(route);
+    ogs_assert(pkbuf);
+    ogs_assert(pkbuf->data);
+
+    memset(route, 0, sizeof(*route));
+
+    if (ogs_asn_route_parse(&r, pkbuf->data, pkbuf->len) != OGS_OK) {
+        ogs_warn("Failed to route S1AP-PDU");
+        return OGS_ERROR;
+    }
+
+    route->present = r.present;
+    route->procedure_code = r.procedure_code;
+    route->criticality = r.criticality;
+
+    for (i = 0; i < r.num_of_ie; i++) {
+        if (ogs_asn_route_next_ie(&r, &ie) != OGS_OK) {
+            ogs_warn("Failed to route S1AP-PDU [%d/%d]", i, r.num_of_ie);
+            return OGS_ERROR;
+        }
+
+        switch (ie.id) {
+        case S1AP_ProtocolIE_ID_id_eNB_UE_S1AP_ID:
+            if (ogs_asn_route_decode_uint(&ie, 24, &value) != OGS_OK)
+                return OGS_ERROR;
+            route->enb_ue_s1ap_id = value;
+            route->enb_ue_s1ap_id_presence = true;
+            break;
+        case S1AP_ProtocolIE_ID_id_MME_UE_S1AP_ID:
+            if (ogs_asn_route_decode_uint(&ie, 32, &value) != OGS_OK)
+                return OGS_ERROR;
+            route->mme_ue_s1ap_id = value;
+            route->mme_ue_s1ap_id_presence = true;
+            break;
+        case S1AP_ProtocolIE_ID_id_NAS_PDU:
+            if (ogs_asn_route_decode_octet_string(&ie,
+                        &route->nas_pdu, &route->nas_pdu_len) != OGS_OK)
+                return OGS_ERROR;
+            break;
+        default:
+            break;
+        }
+    }
+
+    return OGS_OK;
+}
+
 void ogs_s1ap_free(ogs_s1ap_message_t *message)
 {
     ogs_assert(message);
@@ -30,7 +30,27 @@ extern "C" {
 
 typedef struct S1AP_S1AP_PDU ogs_s1ap_message_t;
 
+/*
+ * Fields needed to route an S1AP-PDU to its UE and procedure,
+ * read directly from the APER bitstream by ogs_s1ap_decode_route().
+ * nas_pdu points into the pkbuf that was given.
+ */
+typedef struct ogs_s1ap_route_s {
+    uint8_t present;            /* S1AP_S1AP_PDU_PR_XXX */
+    uint8_t procedure_code;
+    uint8_t criticality;
+
+    bool enb_ue_s1ap_id_presence;
+    S1AP_ENB_UE_S1AP_ID_t enb_ue_s1ap_id;
+    bool mme_ue_s1ap_id_presence;
+    S1AP_MME_UE_S1AP_ID_t mme_ue_s1ap_id;
+
+    uint8_t *nas_pdu;
+    size_t nas_pdu_len;
+} ogs_s1ap_route_t;
+
 int ogs_s1ap_decode(ogs_s1ap_message_t *message, ogs_pkbuf_t *pkbuf);
+int ogs_s1ap_decode_route(ogs_s1ap_route_t *route, ogs_pkbuf_t *pkbuf);
 ogs_pkbuf_t *ogs_s1ap_encode(ogs_s1ap_message_t *message);
 void ogs_s1ap_free(ogs_s1ap_message_t *message);
 
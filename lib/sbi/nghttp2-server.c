@@ -385,7 +385,7 @@ static int server_start(ogs_sbi_server_t *server,
 
             ogs_assert(server->id >= OGS_MIN_POOL_ID &&
                     server->id <= OGS_MAX_POOL_ID);
-            context = ogs_msprintf("%d", server->id);
+            context = ogs_msprintf("%lld", (long long)server->id);
             if (!context) {
                 ogs_error("ogs_sbi_server_id_context() failed");
 
@@ -468,6 +468,65 @@ int ogs_sctp_sendmsg(ogs_sock_t *sock, const void *msg, size_t len,
             0); /* context */
 }
 
+int ogs_sctp_sendpkbuf(ogs_sock_t *sock,
+        const ogs_pkbuf_t *pkbuf, ogs_sockaddr_t *to)
+{
+    struct msghdr msg;
+    struct iovec iov[OGS_MAX_IOVEC];
+    union {
+        char buf[CMSG_SPACE(sizeof(struct sctp_sndrcvinfo))];
+        struct cmsghdr align;
+    } control;
+    struct cmsghdr *cmsg = NULL;
+    struct sctp_sndrcvinfo *sinfo = NULL;
+    const ogs_pkbuf_t *seg = NULL;
+    int n = 0;
+
+    ogs_assert(sock);
+    ogs_assert(pkbuf);
+
+    if (!pkbuf->next)
+        return ogs_sctp_sendmsg(sock, pkbuf->data, pkbuf->len, to,
+                ogs_sctp_ppid_in_pkbuf(pkbuf),
+                ogs_sctp_stream_no_in_pkbuf(pkbuf));
+
+    for (seg = pkbuf; seg; seg = seg->next) {
+        if (!seg->len)
+            continue;
+        if (n == OGS_MAX_IOVEC) {
+            ogs_error("Too many segments [%d]", n);
+            errno = EMSGSIZE;
+            return -1;
+        }
+        iov[n].iov_base = seg->data;
+        iov[n].iov_len = seg->len;
+        n++;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    memset(&control, 0, sizeof(control));
+
+    if (to) {
+        msg.msg_name = &to->sa;
+        msg.msg_namelen = ogs_sockaddr_len(to);
+    }
+    msg.msg_iov = iov;
+    msg.msg_iovlen = n;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = IPPROTO_SCTP;
+    cmsg->cmsg_type = SCTP_SNDRCV;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(struct sctp_sndrcvinfo));
+
+    sinfo = (struct sctp_sndrcvinfo *)CMSG_DATA(cmsg);
+    sinfo->sinfo_ppid = htobe32(ogs_sctp_ppid_in_pkbuf(pkbuf));
+    sinfo->sinfo_stream = ogs_sctp_stream_no_in_pkbuf(pkbuf);
+
+    return sendmsg(sock->fd, &msg, 0);
+}
+
 int ogs_sctp_recvmsg(ogs_sock_t *sock, void *msg, size_t len,
         ogs_sockaddr_t *from, ogs_sctp_info_t *sinfo, int *msg_flags)
 {
@@ -61,12 +61,11 @@ int ogs_sctp_senddata(ogs_sock_t *sock,
     ogs_assert(sock);
     ogs_assert(pkbuf);
 
-    sent = ogs_sctp_sendmsg(sock, pkbuf->data, pkbuf->len, addr,
-            ogs_sctp_ppid_in_pkbuf(pkbuf), ogs_sctp_stream_no_in_pkbuf(pkbuf));
-    if (sent < 0 || sent != pkbuf->len) {
+    sent = ogs_sctp_sendpkbuf(sock, pkbuf, addr);
+    if (sent < 0 || sent != ogs_pkbuf_chain_len(pkbuf)) {
         ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
                 "ogs_sctp_senddata(len:%d,ssn:%d)",
-                pkbuf->len, (int)ogs_sctp_stream_no_in_pkbuf(pkbuf));
+                ogs_pkbuf_chain_len(pkbuf), (int)ogs_sctp_stream_no_in_pkbuf(pkbuf));
         ogs_pkbuf_free(pkbuf);
         return OGS_ERROR;
     }
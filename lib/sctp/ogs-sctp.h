@@ -125,6 +125,9 @@ int ogs_sctp_so_linger(ogs_sock_t *sock, int l_linger);
 
 int ogs_sctp_sendmsg(ogs_sock_t *sock, const void *msg, size_t len,
         ogs_sockaddr_t *to, uint32_t ppid, uint16_t stream_no);
+/* PPID and stream are taken from the pkbuf; a chain is sent as one message */
+int ogs_sctp_sendpkbuf(ogs_sock_t *sock,
+        const ogs_pkbuf_t *pkbuf, ogs_sockaddr_t *to);
 int ogs_sctp_recvmsg(ogs_sock_t *sock, void *msg, size_t len,
         ogs_sockaddr_t *from, ogs_sctp_info_t *sinfo, int *msg_flags);
 int ogs_sctp_recvdata(ogs_sock_t *sock, void *msg, size_t len,
@@ -316,6 +316,42 @@ int ogs_sctp_sendmsg(ogs_sock_t *sock, const void *msg, size_t len,
             SCTP_SENDV_SNDINFO, 0);
 }
 
+int ogs_sctp_sendpkbuf(ogs_sock_t *sock,
+        const ogs_pkbuf_t *pkbuf, ogs_sockaddr_t *to)
+{
+    const ogs_pkbuf_t *seg = NULL;
+    unsigned char *buf = NULL;
+    unsigned int len;
+    int sent;
+
+    ogs_assert(sock);
+    ogs_assert(pkbuf);
+
+    if (!pkbuf->next)
+        return ogs_sctp_sendmsg(sock, pkbuf->data, pkbuf->len, to,
+                ogs_sctp_ppid_in_pkbuf(pkbuf),
+                ogs_sctp_stream_no_in_pkbuf(pkbuf));
+
+    /* usrsctp_sendv() takes a single buffer */
+    buf = ogs_malloc(ogs_pkbuf_chain_len(pkbuf));
+    if (!buf) {
+        ogs_error("ogs_malloc() failed");
+        return OGS_ERROR;
+    }
+
+    for (len = 0, seg = pkbuf; seg; seg = seg->next) {
+        memcpy(buf + len, seg->data, seg->len);
+        len += seg->len;
+    }
+
+    sent = ogs_sctp_sendmsg(sock, buf, len, to,
+            ogs_sctp_ppid_in_pkbuf(pkbuf),
+            ogs_sctp_stream_no_in_pkbuf(pkbuf));
+
+    ogs_free(buf);
+    return sent;
+}
+
 int ogs_sctp_recvmsg(ogs_sock_t *sock, void *msg, size_t len,
         ogs_sockaddr_t *from, ogs_sctp_info_t *sinfo, int *msg_flags)
 {
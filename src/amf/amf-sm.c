@@ -27,12 +27,21 @@
 #include "nnssf-handler.h"
 #include "nas-security.h"
 
+#define POOL_TRIM_TIME ogs_time_from_sec(60)
+
+static ogs_timer_t *t_pool_trim = NULL;
+
 void amf_state_initial(ogs_fsm_t *s, amf_event_t *e)
 {
     amf_sm_debug(e);
 
     ogs_assert(s);
 
+    t_pool_trim = ogs_timer_add(ogs_app()->timer_mgr,
+            amf_timer_pool_trim, 0);
+    ogs_assert(t_pool_trim);
+    ogs_timer_start(t_pool_trim, POOL_TRIM_TIME);
+
     OGS_FSM_TRAN(s, &amf_state_operational);
 }
 
@@ -40,6 +49,9 @@ void amf_state_final(ogs_fsm_t *s, amf_event_t *e)
 {
     amf_sm_debug(e);
 
+    if (t_pool_trim)
+        ogs_timer_delete(t_pool_trim);
+
     ogs_assert(s);
 }
 
@@ -55,6 +67,7 @@ void amf_state_operational(ogs_fsm_t *s, amf_event_t *e)
     uint16_t max_num_of_ostreams = 0;
 
     ogs_ngap_message_t ngap_message;
+    ogs_ngap_route_t ngap_route;
     ogs_pkbuf_t *pkbuf = NULL;
     int rc;
 
@@ -87,6 +100,8 @@ void amf_state_operational(ogs_fsm_t *s, amf_event_t *e)
         break;
 
     case OGS_FSM_EXIT_SIG:
+        if (t_pool_trim)
+            ogs_timer_stop(t_pool_trim);
         break;
 
     case OGS_EVENT_SBI_SERVER:
@@ -99,7 +114,8 @@ void amf_state_operational(ogs_fsm_t *s, amf_event_t *e)
 
         stream = ogs_sbi_stream_find_by_id(stream_id);
         if (!stream) {
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
             break;
         }
 
@@ -401,8 +417,8 @@ void amf_state_operational(ogs_fsm_t *s, amf_event_t *e)
                 if (!sbi_xact) {
                     /* CLIENT_WAIT timer could remove SBI transaction
                      * before receiving SBI message */
-                    ogs_error("SBI transaction has already been removed [%d]",
-                            sbi_xact_id);
+                    ogs_error("SBI transaction has already been removed [%lld]",
+                            (long long)sbi_xact_id);
                     break;
                 }
 
@@ -441,8 +457,8 @@ void amf_state_operational(ogs_fsm_t *s, amf_event_t *e)
             if (!sbi_xact) {
                 /* CLIENT_WAIT timer could remove SBI transaction
                  * before receiving SBI message */
-                ogs_error("SBI transaction has already been removed [%d]",
-                        sbi_xact_id);
+                ogs_error("SBI transaction has already been removed [%lld]",
+                        (long long)sbi_xact_id);
                 break;
             }
 
@@ -478,8 +494,8 @@ void amf_state_operational(ogs_fsm_t *s, amf_event_t *e)
             if (!sbi_xact) {
                 /* CLIENT_WAIT timer could remove SBI transaction
                  * before receiving SBI message */
-                ogs_error("SBI transaction has already been removed [%d]",
-                        sbi_xact_id);
+                ogs_error("SBI transaction has already been removed [%lld]",
+                        (long long)sbi_xact_id);
                 break;
             }
 
@@ -598,8 +614,8 @@ void amf_state_operational(ogs_fsm_t *s, amf_event_t *e)
             if (!sbi_xact) {
                 /* CLIENT_WAIT timer could remove SBI transaction
                  * before receiving SBI message */
-                ogs_error("SBI transaction has already been removed [%d]",
-                        sbi_xact_id);
+                ogs_error("SBI transaction has already been removed [%lld]",
+                        (long long)sbi_xact_id);
                 break;
             }
 
@@ -724,8 +740,8 @@ void amf_state_operational(ogs_fsm_t *s, amf_event_t *e)
 
             sbi_xact = ogs_sbi_xact_find_by_id(sbi_xact_id);
             if (!sbi_xact) {
-                ogs_error("SBI transaction has already been removed [%d]",
-                        sbi_xact_id);
+                ogs_error("SBI transaction has already been removed [%lld]",
+                        (long long)sbi_xact_id);
                 break;
             }
 
@@ -902,8 +918,18 @@ void amf_state_operational(ogs_fsm_t *s, amf_event_t *e)
             ogs_fsm_dispatch(&gnb->sm, e);
         } else {
             ogs_error("Cannot decode NGAP message");
-            r = ngap_send_error_indication(
-                    gnb, NULL, NULL, NGAP_Cause_PR_protocol, 
+            /*
+             * The UE IDs may still be readable from the bitstream
+             * even if some IE could not be decoded.
+             */
+            if (ogs_ngap_decode_route(&ngap_route, pkbuf) != OGS_OK)
+                memset(&ngap_route, 0, sizeof(ngap_route));
+            r = ngap_send_error_indication(gnb,
+                    ngap_route.ran_ue_ngap_id_presence ?
+                        &ngap_route.ran_ue_ngap_id : NULL,
+                    ngap_route.amf_ue_ngap_id_presence ?
+                        &ngap_route.amf_ue_ngap_id : NULL,
+                    NGAP_Cause_PR_protocol,
                     NGAP_CauseProtocol_abstract_syntax_error_falsely_constructed_message);
             ogs_expect(r == OGS_OK);
             ogs_assert(r != OGS_ERROR);
@@ -1075,6 +1101,19 @@ void amf_state_operational(ogs_fsm_t *s, amf_event_t *e)
         ogs_fsm_dispatch(&amf_ue->sm, e);
         break;
 
+    case AMF_EVENT_POOL_TIMER:
+        switch(e->h.timer_id) {
+        case AMF_TIMER_POOL_TRIM:
+            amf_pool_trim();
+            ogs_timer_start(t_pool_trim, POOL_TRIM_TIME);
+            break;
+
+        default:
+            ogs_error("Unknown timer[%s:%d]",
+                    amf_timer_get_name(e->h.timer_id), e->h.timer_id);
+        }
+        break;
+
     default:
         ogs_error("No handler for event %s", amf_event_get_name(e));
         break;
@@ -60,9 +60,9 @@ void amf_context_init(void)
 
     /* Allocate TWICE the pool to check if maximum number of gNBs is reached */
     ogs_pool_init(&amf_gnb_pool, ogs_global_conf()->max.peer*2);
-    ogs_pool_init(&amf_ue_pool, ogs_global_conf()->max.ue);
-    ogs_pool_init(&ran_ue_pool, ogs_global_conf()->max.ue);
-    ogs_pool_init(&amf_sess_pool, ogs_app()->pool.sess);
+    ogs_pool_init_chunked(&amf_ue_pool, ogs_global_conf()->max.ue);
+    ogs_pool_init_chunked(&ran_ue_pool, ogs_global_conf()->max.ue);
+    ogs_pool_init_chunked(&amf_sess_pool, ogs_app()->pool.sess);
     /* Increase size of TMSI pool (#1827) */
     ogs_pool_init(&m_tmsi_pool, ogs_global_conf()->max.ue*2);
     ogs_pool_random_id_generate(&m_tmsi_pool);
@@ -120,6 +120,19 @@ amf_context_t *amf_self(void)
     return &self;
 }
 
+/* Called periodically, see ogs_pool_trim() */
+int amf_pool_trim(void)
+{
+    int n = ogs_pool_trim(&amf_ue_pool) +
+        ogs_pool_trim(&ran_ue_pool) +
+        ogs_pool_trim(&amf_sess_pool);
+
+    if (n)
+        ogs_debug("[Pool] %d chunks released", n);
+
+    return n;
+}
+
 static int amf_context_prepare(void)
 {
     self.relative_capacity = 0xff;
@@ -1574,7 +1587,8 @@ amf_ue_t *amf_ue_add(ran_ue_t *ran_ue)
 
     gnb = amf_gnb_find_by_id(ran_ue->gnb_id);
     if (!gnb) {
-        ogs_error("[%d] gNB has already been removed", ran_ue->gnb_id);
+        ogs_error("[%lld] gNB has already been removed",
+                (long long)ran_ue->gnb_id);
         return NULL;
     }
 
@@ -2215,7 +2229,8 @@ OpenAPI_rat_type_e amf_ue_rat_type(amf_ue_t *amf_ue)
 
     gnb = amf_gnb_find_by_id(ran_ue->gnb_id);
     if (!gnb) {
-        ogs_error("[%d] gNB has already been removed", ran_ue->gnb_id);
+        ogs_error("[%lld] gNB has already been removed",
+                (long long)ran_ue->gnb_id);
         return OpenAPI_rat_type_NULL;
     }
 
@@ -2274,9 +2289,9 @@ void source_ue_deassociate_target_ue(ran_ue_t *ran_ue)
                     target_ue->source_ue_id <= OGS_MAX_POOL_ID);
             target_ue->source_ue_id = OGS_INVALID_POOL_ID;
         } else
-            ogs_error("Target-UE-ID [%d] has already been removed "
+            ogs_error("Target-UE-ID [%lld] has already been removed "
                     "(RAN_UE_S1AP_ID[%lld] AMF_UE_S1AP_ID[%lld])",
-                    source_ue->target_ue_id,
+                    (long long)source_ue->target_ue_id,
                     (long long)source_ue->ran_ue_ngap_id,
                     (long long)source_ue->amf_ue_ngap_id);
 
@@ -2290,9 +2305,9 @@ void source_ue_deassociate_target_ue(ran_ue_t *ran_ue)
                     source_ue->target_ue_id <= OGS_MAX_POOL_ID);
             source_ue->target_ue_id = OGS_INVALID_POOL_ID;
         } else
-            ogs_error("Source-UE-ID [%d] has already been removed "
+            ogs_error("Source-UE-ID [%lld] has already been removed "
                     "(RAN_UE_S1AP_ID[%lld] AMF_UE_S1AP_ID[%lld])",
-                    target_ue->source_ue_id,
+                    (long long)target_ue->source_ue_id,
                     (long long)target_ue->ran_ue_ngap_id,
                     (long long)target_ue->amf_ue_ngap_id);
 
@@ -2889,7 +2904,8 @@ bool amf_update_allowed_nssai(amf_ue_t *amf_ue)
 
     gnb = amf_gnb_find_by_id(ran_ue->gnb_id);
     if (!gnb) {
-        ogs_error("[%d] gNB has already been removed", ran_ue->gnb_id);
+        ogs_error("[%lld] gNB has already been removed",
+                (long long)ran_ue->gnb_id);
         return false;
     }
 
@@ -922,6 +922,8 @@ void amf_context_init(void);
 void amf_context_final(void);
 amf_context_t *amf_self(void);
 
+int amf_pool_trim(void);
+
 int amf_context_parse_config(void);
 int amf_context_nf_info(void);
 
@@ -71,6 +71,9 @@ const char *amf_event_get_name(amf_event_t *e)
     case AMF_EVENT_5GSM_TIMER:
         return "AMF_EVENT_5GSM_TIMER";
 
+    case AMF_EVENT_POOL_TIMER:
+        return "AMF_EVENT_POOL_TIMER";
+
     default:
         break;
     }
@@ -90,7 +90,8 @@ int ngap_send_to_ran_ue(ran_ue_t *ran_ue, ogs_pkbuf_t *pkbuf)
 
     gnb = amf_gnb_find_by_id(ran_ue->gnb_id);
     if (!gnb) {
-        ogs_error("[%d] gNB has already been removed", ran_ue->gnb_id);
+        ogs_error("[%lld] gNB has already been removed",
+                (long long)ran_ue->gnb_id);
         ogs_pkbuf_free(pkbuf);
         return OGS_NOTFOUND;
     }
@@ -711,7 +712,8 @@ int ngap_send_error_indication2(
 
     gnb = amf_gnb_find_by_id(ran_ue->gnb_id);
     if (!gnb) {
-        ogs_error("[%d] gNB has already been removed", ran_ue->gnb_id);
+        ogs_error("[%lld] gNB has already been removed",
+                (long long)ran_ue->gnb_id);
         return OGS_NOTFOUND;
     }
 
@@ -96,6 +96,8 @@ const char *amf_timer_get_name(int timer_id)
         return "AMF_TIMER_MOBILE_REACHABLE";
     case AMF_TIMER_IMPLICIT_DEREGISTRATION:
         return "AMF_TIMER_IMPLICIT_DEREGISTRATION";
+    case AMF_TIMER_POOL_TRIM:
+        return "AMF_TIMER_POOL_TRIM";
     default: 
         break;
     }
@@ -195,3 +197,19 @@ void amf_timer_implicit_deregistration_expire(void *data)
 {
     gmm_timer_event_send(AMF_TIMER_IMPLICIT_DEREGISTRATION, data);
 }
+
+void amf_timer_pool_trim(void *data)
+{
+    int rv;
+    amf_event_t *e = NULL;
+
+    e = amf_event_new(AMF_EVENT_POOL_TIMER);
+    ogs_assert(e);
+    e->h.timer_id = AMF_TIMER_POOL_TRIM;
+
+    rv = ogs_queue_push(ogs_app()->queue, e);
+    if (rv != OGS_OK) {
+        ogs_error("ogs_queue_push() failed:%d", (int)rv);
+        ogs_event_free(e);
+    }
+}
@@ -42,6 +42,8 @@ typedef enum {
     AMF_TIMER_MOBILE_REACHABLE,
     AMF_TIMER_IMPLICIT_DEREGISTRATION,
 
+    AMF_TIMER_POOL_TRIM,
+
     MAX_NUM_OF_AMF_TIMER,
 
 } amf_timer_e;
@@ -70,6 +72,8 @@ void amf_timer_ng_holding_timer_expire(void *data);
 void amf_timer_mobile_reachable_expire(void *data);
 void amf_timer_implicit_deregistration_expire(void *data);
 
+void amf_timer_pool_trim(void *data);
+
 #ifdef __cplusplus
 }
 #endif
@@ -73,7 +73,8 @@ void ausf_state_operational(ogs_fsm_t *s, ausf_event_t *e)
 
         stream = ogs_sbi_stream_find_by_id(stream_id);
         if (!stream) {
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
             break;
         }
 
@@ -287,8 +288,8 @@ void ausf_state_operational(ogs_fsm_t *s, ausf_event_t *e)
                 if (!sbi_xact) {
                     /* CLIENT_WAIT timer could remove SBI transaction
                      * before receiving SBI message */
-                    ogs_error("SBI transaction has already been removed [%d]",
-                            sbi_xact_id);
+                    ogs_error("SBI transaction has already been removed [%lld]",
+                            (long long)sbi_xact_id);
                     break;
                 }
 
@@ -323,8 +324,8 @@ void ausf_state_operational(ogs_fsm_t *s, ausf_event_t *e)
             if (!sbi_xact) {
                 /* CLIENT_WAIT timer could remove SBI transaction
                  * before receiving SBI message */
-                ogs_error("SBI transaction has already been removed [%d]",
-                        sbi_xact_id);
+                ogs_error("SBI transaction has already been removed [%lld]",
+                        (long long)sbi_xact_id);
                 break;
             }
 
@@ -448,8 +449,8 @@ void ausf_state_operational(ogs_fsm_t *s, ausf_event_t *e)
 
             sbi_xact = ogs_sbi_xact_find_by_id(sbi_xact_id);
             if (!sbi_xact) {
-                ogs_error("SBI transaction has already been removed [%d]",
-                        sbi_xact_id);
+                ogs_error("SBI transaction has already been removed [%lld]",
+                        (long long)sbi_xact_id);
                 break;
             }
 
@@ -462,8 +463,8 @@ void ausf_state_operational(ogs_fsm_t *s, ausf_event_t *e)
             ogs_error("Cannot receive SBI message");
 
             if (!stream) {
-                ogs_error("STREAM has alreadt been removed [%d]",
-                        sbi_xact->assoc_stream_id);
+                ogs_error("STREAM has alreadt been removed [%lld]",
+                        (long long)sbi_xact->assoc_stream_id);
                 break;
             }
             ogs_assert(true ==
@@ -84,7 +84,8 @@ void ausf_ue_state_operational(ogs_fsm_t *s, ausf_event_t *e)
 
         stream = ogs_sbi_stream_find_by_id(stream_id);
         if (!stream) {
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
             break;
         }
 
@@ -161,7 +162,8 @@ void ausf_ue_state_operational(ogs_fsm_t *s, ausf_event_t *e)
 
         stream = ogs_sbi_stream_find_by_id(stream_id);
         if (!stream) {
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
             break;
         }
 
@@ -75,7 +75,8 @@ void bsf_state_operational(ogs_fsm_t *s, bsf_event_t *e)
 
         stream = ogs_sbi_stream_find_by_id(stream_id);
         if (!stream) {
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
             break;
         }
 
@@ -303,8 +304,8 @@ void bsf_state_operational(ogs_fsm_t *s, bsf_event_t *e)
                 if (!sbi_xact) {
                     /* CLIENT_WAIT timer could remove SBI transaction
                      * before receiving SBI message */
-                    ogs_error("SBI transaction has already been removed [%d]",
-                            sbi_xact_id);
+                    ogs_error("SBI transaction has already been removed [%lld]",
+                            (long long)sbi_xact_id);
                     break;
                 }
 
@@ -421,8 +422,8 @@ void bsf_state_operational(ogs_fsm_t *s, bsf_event_t *e)
 
             sbi_xact = ogs_sbi_xact_find_by_id(sbi_xact_id);
             if (!sbi_xact) {
-                ogs_error("SBI transaction has already been removed [%d]",
-                        sbi_xact_id);
+                ogs_error("SBI transaction has already been removed [%lld]",
+                        (long long)sbi_xact_id);
                 break;
             }
 
@@ -122,9 +122,11 @@ static void bsf_main(void *data)
         ogs_timer_mgr_expire(ogs_app()->timer_mgr);
 
         for ( ;; ) {
-            bsf_event_t *e = NULL;
+            bsf_event_t *e[OGS_QUEUE_BULK_SIZE];
+            unsigned int i, n = 0;
 
-            rv = ogs_queue_trypop(ogs_app()->queue, (void**)&e);
+            rv = ogs_queue_trypop_bulk(ogs_app()->queue,
+                    (void**)e, OGS_QUEUE_BULK_SIZE, &n);
             ogs_assert(rv != OGS_ERROR);
 
             if (rv == OGS_DONE)
@@ -133,9 +135,11 @@ static void bsf_main(void *data)
             if (rv == OGS_RETRY)
                 break;
 
-            ogs_assert(e);
-            ogs_fsm_dispatch(&bsf_sm, e);
-            ogs_event_free(e);
+            for (i = 0; i < n; i++) {
+                ogs_assert(e[i]);
+                ogs_fsm_dispatch(&bsf_sm, e[i]);
+                ogs_event_free(e[i]);
+            }
         }
     }
 done:
@@ -110,9 +110,11 @@ static void hss_main(void *data)
         ogs_timer_mgr_expire(ogs_app()->timer_mgr);
 
         for ( ;; ) {
-            hss_event_t *e = NULL;
+            hss_event_t *e[OGS_QUEUE_BULK_SIZE];
+            unsigned int i, n = 0;
 
-            rv = ogs_queue_trypop(ogs_app()->queue, (void**)&e);
+            rv = ogs_queue_trypop_bulk(ogs_app()->queue,
+                    (void**)e, OGS_QUEUE_BULK_SIZE, &n);
             ogs_assert(rv != OGS_ERROR);
 
             if (rv == OGS_DONE)
@@ -121,9 +123,11 @@ static void hss_main(void *data)
             if (rv == OGS_RETRY)
                 break;
 
-            ogs_assert(e);
-            ogs_fsm_dispatch(&hss_sm, e);
-            hss_event_free(e);
+            for (i = 0; i < n; i++) {
+                ogs_assert(e[i]);
+                ogs_fsm_dispatch(&hss_sm, e[i]);
+                hss_event_free(e[i]);
+            }
         }
     }
 done:
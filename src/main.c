@@ -39,6 +39,7 @@ static void show_help(const char *name)
        "   -m domain      : set log-domain (e.g. mme:sgw:gtp)\n"
        "   -d             : print lots of debugging information\n"
        "   -t             : print tracing information for developer\n"
+       "   -M             : track memory with talloc instead of arenas\n"
        "   -D             : start as a daemon\n"
        "   -v             : show version number and exit\n"
        "   -h             : show this message and exit\n"
@@ -61,6 +62,15 @@ static int check_signal(int signum)
 
         break;
     case SIGUSR1:
+        if (ogs_mem_arena_enabled()) {
+            ogs_mem_stat_t stat;
+
+            ogs_mem_stat(&stat);
+            fprintf(stderr, "%*s%-30s contains %6lu bytes in %3lu blocks\n",
+                    0, "", "arena",
+                    (unsigned long)stat.size, (unsigned long)stat.blocks);
+            break;
+        }
         fprintf(stderr,
                 "%*s%-30s contains %6lu bytes in %3lu blocks (ref %d) %p\n",
                 0, "", "core",
@@ -114,7 +124,7 @@ int main(int argc, const char *const argv[])
     memset(&optarg, 0, sizeof(optarg));
 
     ogs_getopt_init(&options, (char**)argv);
-    while ((opt = ogs_getopt(&options, "vhDc:l:e:m:dtk:")) != -1) {
+    while ((opt = ogs_getopt(&options, "vhDc:l:e:m:dtMk:")) != -1) {
         switch (opt) {
         case 'v':
             show_version();
@@ -162,6 +172,9 @@ int main(int argc, const char *const argv[])
         case 't':
             optarg.enable_trace = true;
             break;
+        case 'M':
+            ogs_core()->mem.arena = false;
+            break;
         case 'k':
             optarg.config_section = options.optarg;
             break;
@@ -338,9 +338,9 @@ static void common_register_state(ogs_fsm_t *s, mme_event_t *e,
         enb_ue = enb_ue_find_by_id(mme_ue->enb_ue_id);
         if (!enb_ue) {
             ogs_fatal("No S1 Context IMSI[%s] NAS-Type[%d] "
-                    "ENB-UE-ID[%d:%d][%p:%p]",
+                    "ENB-UE-ID[%lld:%lld][%p:%p]",
                     mme_ue->imsi_bcd, message->emm.h.message_type,
-                    e->enb_ue_id, mme_ue->enb_ue_id,
+                    (long long)e->enb_ue_id, (long long)mme_ue->enb_ue_id,
                     enb_ue_find_by_id(e->enb_ue_id),
                     enb_ue_find_by_id(mme_ue->enb_ue_id));
             ogs_assert(e->pkbuf);
@@ -3495,7 +3495,8 @@ mme_ue_t *mme_ue_add(enb_ue_t *enb_ue)
 
     enb = mme_enb_find_by_id(enb_ue->enb_id);
     if (!enb) {
-        ogs_error("[%d] eNB has already been removed", enb_ue->enb_id);
+        ogs_error("[%lld] eNB has already been removed",
+                (long long)enb_ue->enb_id);
         return NULL;
     }
 
@@ -4211,9 +4212,9 @@ void enb_ue_source_deassociate_target(enb_ue_t *enb_ue)
                     target_ue->source_ue_id <= OGS_MAX_POOL_ID);
             target_ue->source_ue_id = OGS_INVALID_POOL_ID;
         } else
-            ogs_error("Target-UE-ID [%d] has already been removed "
+            ogs_error("Target-UE-ID [%lld] has already been removed "
                     "(ENB_UE_S1AP_ID[%d] MME_UE_S1AP_ID[%d])",
-                    source_ue->target_ue_id,
+                    (long long)source_ue->target_ue_id,
                     source_ue->enb_ue_s1ap_id, source_ue->mme_ue_s1ap_id);
 
 
@@ -4227,9 +4228,9 @@ void enb_ue_source_deassociate_target(enb_ue_t *enb_ue)
                     source_ue->target_ue_id <= OGS_MAX_POOL_ID);
             source_ue->target_ue_id = OGS_INVALID_POOL_ID;
         } else
-            ogs_error("Source-UE-ID [%d] has already been removed "
+            ogs_error("Source-UE-ID [%lld] has already been removed "
                     "(ENB_UE_S1AP_ID[%d] MME_UE_S1AP_ID[%d])",
-                    target_ue->source_ue_id,
+                    (long long)target_ue->source_ue_id,
                     target_ue->enb_ue_s1ap_id, target_ue->mme_ue_s1ap_id);
 
         ogs_assert(target_ue->source_ue_id >= OGS_MIN_POOL_ID &&
@@ -4290,9 +4291,10 @@ void sgw_ue_source_deassociate_target(sgw_ue_t *sgw_ue)
                     target_ue->source_ue_id <= OGS_MAX_POOL_ID);
             target_ue->source_ue_id = OGS_INVALID_POOL_ID;
         } else
-            ogs_error("Target-UE-ID [%d] has already been removed "
+            ogs_error("Target-UE-ID [%lld] has already been removed "
                     "(SGW-S11-TEID[%d])",
-                    source_ue->target_ue_id, source_ue->sgw_s11_teid);
+                    (long long)source_ue->target_ue_id,
+                    source_ue->sgw_s11_teid);
 
     } else if (sgw_ue->source_ue_id >= OGS_MIN_POOL_ID &&
                 sgw_ue->source_ue_id <= OGS_MAX_POOL_ID) {
@@ -4304,9 +4306,10 @@ void sgw_ue_source_deassociate_target(sgw_ue_t *sgw_ue)
                     source_ue->target_ue_id <= OGS_MAX_POOL_ID);
             source_ue->target_ue_id = OGS_INVALID_POOL_ID;
         } else
-            ogs_error("Source-UE-ID [%d] has already been removed "
+            ogs_error("Source-UE-ID [%lld] has already been removed "
                     "(SGW-S11-TEID[%d])",
-                    target_ue->source_ue_id, target_ue->sgw_s11_teid);
+                    (long long)target_ue->source_ue_id,
+                    target_ue->sgw_s11_teid);
 
         ogs_assert(target_ue->source_ue_id >= OGS_MIN_POOL_ID &&
                 target_ue->source_ue_id <= OGS_MAX_POOL_ID);
@@ -34,9 +34,8 @@ mme_event_t *mme_event_new(mme_event_e id)
 {
     mme_event_t *e = NULL;
 
-    e = ogs_calloc(1, sizeof *e);
+    e = ogs_event_size(id, sizeof(*e));
     ogs_assert(e);
-    memset(e, 0, sizeof(*e));
 
     e->id = id;
 
@@ -46,7 +45,7 @@ mme_event_t *mme_event_new(mme_event_e id)
 void mme_event_free(mme_event_t *e)
 {
     ogs_assert(e);
-    ogs_free(e);
+    ogs_event_free(e);
 }
 
 const char *mme_event_get_name(mme_event_t *e)
@@ -933,14 +933,14 @@ static void mme_s6a_aia_cb(void *data, struct msg **msg)
 
     mme_ue = mme_ue_find_by_id(sess_data->mme_ue_id);
     if (!mme_ue) {
-        ogs_error("MME-UE Context has already been removed [%d]",
-                sess_data->mme_ue_id);
+        ogs_error("MME-UE Context has already been removed [%lld]",
+                (long long)sess_data->mme_ue_id);
         return;
     }
     enb_ue = enb_ue_find_by_id(sess_data->enb_ue_id);
     if (!enb_ue) {
-        ogs_error("[%s] ENB-S1 Context has already been removed [%d]",
-                mme_ue->imsi_bcd, sess_data->enb_ue_id);
+        ogs_error("[%s] ENB-S1 Context has already been removed [%lld]",
+                mme_ue->imsi_bcd, (long long)sess_data->enb_ue_id);
         return;
     }
 
@@ -1376,14 +1376,14 @@ static void mme_s6a_ula_cb(void *data, struct msg **msg)
 
     mme_ue = mme_ue_find_by_id(sess_data->mme_ue_id);
     if (!mme_ue) {
-        ogs_error("MME-UE Context has already been removed [%d]",
-                sess_data->mme_ue_id);
+        ogs_error("MME-UE Context has already been removed [%lld]",
+                (long long)sess_data->mme_ue_id);
         return;
     }
     enb_ue = enb_ue_find_by_id(sess_data->enb_ue_id);
     if (!enb_ue) {
-        ogs_error("[%s] ENB-S1 Context has already been removed [%d]",
-                mme_ue->imsi_bcd, sess_data->enb_ue_id);
+        ogs_error("[%s] ENB-S1 Context has already been removed [%lld]",
+                mme_ue->imsi_bcd, (long long)sess_data->enb_ue_id);
         return;
     }
 
@@ -1736,14 +1736,14 @@ static void mme_s6a_pua_cb(void *data, struct msg **msg)
 
     mme_ue = mme_ue_find_by_id(sess_data->mme_ue_id);
     if (!mme_ue) {
-        ogs_error("MME-UE Context has already been removed [%d]",
-                sess_data->mme_ue_id);
+        ogs_error("MME-UE Context has already been removed [%lld]",
+                (long long)sess_data->mme_ue_id);
         return;
     }
     enb_ue = enb_ue_find_by_id(sess_data->enb_ue_id);
     if (!enb_ue) {
-        ogs_error("[%s] ENB-S1 Context has already been removed [%d]",
-                mme_ue->imsi_bcd, sess_data->enb_ue_id);
+        ogs_error("[%s] ENB-S1 Context has already been removed [%lld]",
+                mme_ue->imsi_bcd, (long long)sess_data->enb_ue_id);
         return;
     }
 
@@ -123,8 +123,8 @@ static void timeout(ogs_gtp_xact_t *xact, void *data)
                 mme_ue_id <= OGS_MAX_POOL_ID);
         mme_ue = mme_ue_find_by_id(mme_ue_id);
         if (!mme_ue) {
-            ogs_error("MME-UE[%d] has already been removed [%d]",
-                    mme_ue_id, type);
+            ogs_error("MME-UE[%lld] has already been removed [%d]",
+                    (long long)mme_ue_id, type);
             return;
         }
         break;
@@ -134,8 +134,8 @@ static void timeout(ogs_gtp_xact_t *xact, void *data)
         ogs_assert(sess_id >= OGS_MIN_POOL_ID && sess_id <= OGS_MAX_POOL_ID);
         sess = mme_sess_find_by_id(sess_id);
         if (!sess) {
-            ogs_error("Session[%d] has already been removed [%d]",
-                    sess_id, type);
+            ogs_error("Session[%lld] has already been removed [%d]",
+                    (long long)sess_id, type);
             return;
         }
         mme_ue = mme_ue_find_by_id(sess->mme_ue_id);
@@ -147,8 +147,8 @@ static void timeout(ogs_gtp_xact_t *xact, void *data)
                 bearer_id <= OGS_MAX_POOL_ID);
         bearer = mme_bearer_find_by_id(bearer_id);
         if (!bearer) {
-            ogs_error("Bearer[%d] has already been removed [%d]",
-                    bearer_id, type);
+            ogs_error("Bearer[%lld] has already been removed [%d]",
+                    (long long)bearer_id, type);
             return;
         }
         sess = mme_sess_find_by_id(bearer->sess_id);
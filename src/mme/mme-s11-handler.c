@@ -109,7 +109,8 @@ static void gtp_remote_peer_timeout(ogs_gtp_xact_t *xact, void *data)
         if (ogs_list_exists(
                     &bearer->update.xact_list,
                     &xact->to_update_node) == true) {
-            ogs_error("Bearer-ID [%d] removed from the list", bearer->id);
+            ogs_error("Bearer-ID [%lld] removed from the list",
+                    (long long)bearer->id);
             ogs_list_remove(&bearer->update.xact_list, &xact->to_update_node);
         } else {
             ogs_error("[%d] %s HAVE ALREADY BEEN REMOVED "
@@ -62,6 +62,7 @@ void mme_state_operational(ogs_fsm_t *s, mme_event_t *e)
     uint16_t max_num_of_ostreams = 0;
 
     ogs_s1ap_message_t s1ap_message;
+    ogs_s1ap_route_t s1ap_route;
     ogs_pkbuf_t *pkbuf = NULL;
     int rc, r;
 
@@ -205,8 +206,18 @@ void mme_state_operational(ogs_fsm_t *s, mme_event_t *e)
             ogs_fsm_dispatch(&enb->sm, e);
         } else {
             ogs_warn("Cannot decode S1AP message");
-            r = s1ap_send_error_indication(
-                    enb, NULL, NULL, S1AP_Cause_PR_protocol,
+            /*
+             * The UE IDs may still be readable from the bitstream
+             * even if some IE could not be decoded.
+             */
+            if (ogs_s1ap_decode_route(&s1ap_route, pkbuf) != OGS_OK)
+                memset(&s1ap_route, 0, sizeof(s1ap_route));
+            r = s1ap_send_error_indication(enb,
+                    s1ap_route.mme_ue_s1ap_id_presence ?
+                        &s1ap_route.mme_ue_s1ap_id : NULL,
+                    s1ap_route.enb_ue_s1ap_id_presence ?
+                        &s1ap_route.enb_ue_s1ap_id : NULL,
+                    S1AP_Cause_PR_protocol,
                     S1AP_CauseProtocol_abstract_syntax_error_falsely_constructed_message);
             ogs_expect(r == OGS_OK);
             ogs_assert(r != OGS_ERROR);
@@ -593,7 +604,8 @@ void mme_state_operational(ogs_fsm_t *s, mme_event_t *e)
                     if (rv != OGS_OK)
                         ogs_warn("Failed to send SGSN Context Ack (rv %d)", rv);
                 } else
-                    ogs_warn("Originating SGSN Context xact no longer valid (%d)", e->gtp_xact_id);
+                    ogs_warn("Originating SGSN Context xact no longer valid (%lld)",
+                            (long long)e->gtp_xact_id);
 
                 /* Finally reject the UE: */
                 if (mme_ue->nas_eps.type == MME_EPS_TYPE_ATTACH_REQUEST) {
@@ -91,7 +91,8 @@ int s1ap_send_to_enb_ue(enb_ue_t *enb_ue, ogs_pkbuf_t *pkbuf)
 
     enb = mme_enb_find_by_id(enb_ue->enb_id);
     if (!enb) {
-        ogs_error("[%d] eNB has already been removed", enb_ue->enb_id);
+        ogs_error("[%lld] eNB has already been removed",
+                (long long)enb_ue->enb_id);
         ogs_pkbuf_free(pkbuf);
         return OGS_NOTFOUND;
     }
@@ -113,7 +113,8 @@ void nrf_nf_state_will_register(ogs_fsm_t *s, nrf_event_t *e)
 
         stream = ogs_sbi_stream_find_by_id(stream_id);
         if (!stream) {
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
             break;
         }
 
@@ -235,7 +236,8 @@ void nrf_nf_state_registered(ogs_fsm_t *s, nrf_event_t *e)
 
         stream = ogs_sbi_stream_find_by_id(stream_id);
         if (!stream) {
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
             break;
         }
 
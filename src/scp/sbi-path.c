@@ -141,7 +141,8 @@ static int request_handler(ogs_sbi_request_t *request, void *data)
 
     stream = ogs_sbi_stream_find_by_id(stream_id);
     if (!stream) {
-        ogs_error("STREAM has already been removed [%d]", stream_id);
+        ogs_error("STREAM has already been removed [%lld]",
+                (long long)stream_id);
         return OGS_ERROR;
     }
 
@@ -685,7 +686,8 @@ static int response_handler(
                     OGS_SBI_HTTP_STATUS_INTERNAL_SERVER_ERROR, NULL,
                     "response_handler() failed", NULL, NULL));
         } else
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
 
         return OGS_ERROR;
     }
@@ -703,7 +705,8 @@ static int response_handler(
     scp_assoc_remove(assoc);
 
     if (!stream) {
-        ogs_error("STREAM has already been removed [%d]", stream_id);
+        ogs_error("STREAM has already been removed [%lld]",
+                (long long)stream_id);
         ogs_sbi_response_free(response);
         return OGS_ERROR;
     }
@@ -765,7 +768,8 @@ static int nf_discover_handler(
                     OGS_SBI_HTTP_STATUS_INTERNAL_SERVER_ERROR, NULL,
                     "nf_discover_handler() failed", NULL, NULL));
         } else
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
 
         return OGS_ERROR;
     }
@@ -860,7 +864,8 @@ cleanup:
         ogs_assert(true == ogs_sbi_server_send_error(
                 stream, res_status, NULL, strerror, NULL, NULL));
     } else
-        ogs_error("STREAM has already been removed [%d]", stream_id);
+        ogs_error("STREAM has already been removed [%lld]",
+                (long long)stream_id);
 
     ogs_free(strerror);
 
@@ -905,7 +910,8 @@ static int sepp_discover_handler(
                     OGS_SBI_HTTP_STATUS_INTERNAL_SERVER_ERROR, NULL,
                     "sepp_discover_handler() failed", NULL, NULL));
         } else
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
 
         return OGS_ERROR;
     }
@@ -969,7 +975,8 @@ cleanup:
         ogs_assert(true == ogs_sbi_server_send_error(
                 stream, res_status, NULL, strerror, NULL, NULL));
     } else
-        ogs_error("STREAM has already been removed [%d]", stream_id);
+        ogs_error("STREAM has already been removed [%lld]",
+                (long long)stream_id);
 
     ogs_free(strerror);
 
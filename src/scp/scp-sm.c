@@ -71,7 +71,8 @@ void scp_state_operational(ogs_fsm_t *s, scp_event_t *e)
 
         stream = ogs_sbi_stream_find_by_id(stream_id);
         if (!stream) {
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
             break;
         }
 
@@ -315,8 +316,8 @@ void scp_state_operational(ogs_fsm_t *s, scp_event_t *e)
 
             sbi_xact = ogs_sbi_xact_find_by_id(sbi_xact_id);
             if (!sbi_xact) {
-                ogs_error("SBI transaction has already been removed [%d]",
-                        sbi_xact_id);
+                ogs_error("SBI transaction has already been removed [%lld]",
+                        (long long)sbi_xact_id);
                 break;
             }
 
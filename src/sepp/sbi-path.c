@@ -185,7 +185,8 @@ static int request_handler(ogs_sbi_request_t *request, void *data)
 
     stream = ogs_sbi_stream_find_by_id(stream_id);
     if (!stream) {
-        ogs_error("STREAM has already been removed [%d]", stream_id);
+        ogs_error("STREAM has already been removed [%lld]",
+                (long long)stream_id);
         return OGS_ERROR;
     }
 
@@ -441,7 +442,8 @@ static int response_handler(
                     OGS_SBI_HTTP_STATUS_INTERNAL_SERVER_ERROR, NULL,
                     "response_handler() failed", NULL, NULL));
         } else
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
 
         return OGS_ERROR;
     }
@@ -451,7 +453,8 @@ static int response_handler(
     sepp_assoc_remove(assoc);
 
     if (!stream) {
-        ogs_error("STREAM has already been removed [%d]", stream_id);
+        ogs_error("STREAM has already been removed [%lld]",
+                (long long)stream_id);
         ogs_sbi_response_free(response);
         return OGS_ERROR;
     }
@@ -798,7 +798,7 @@ void sgwc_s11_handle_create_bearer_response(
 
         bearer = sgwc_bearer_find_by_id(bearer_id);
         if (!bearer)
-            ogs_error("No Bearer ID [%d]", bearer_id);
+            ogs_error("No Bearer ID [%lld]", (long long)bearer_id);
     } else {
         ogs_assert(s11_xact->data);
         bearer_id = OGS_POINTER_TO_UINT(s11_xact->data);
@@ -807,13 +807,13 @@ void sgwc_s11_handle_create_bearer_response(
 
         bearer = sgwc_bearer_find_by_id(bearer_id);
         if (!bearer)
-            ogs_error("No Bearer ID [%d]", bearer_id);
+            ogs_error("No Bearer ID [%lld]", (long long)bearer_id);
     }
 
     if (bearer) {
         sess = sgwc_sess_find_by_id(bearer->sess_id);
         if (!sess)
-            ogs_error("No Session ID [%d]", bearer->sess_id);
+            ogs_error("No Session ID [%lld]", (long long)bearer->sess_id);
     }
 
     rv = ogs_gtp_xact_commit(s11_xact);
@@ -1366,7 +1366,8 @@ void sgwc_s11_handle_downlink_data_notification_ack(
         ogs_error("No Cause");
     }
 
-    ogs_debug("Downlink Data Notification Acknowledge [%d]", bearer->id);
+    ogs_debug("Downlink Data Notification Acknowledge [%lld]",
+            (long long)bearer->id);
     if (sgwc_ue) {
         ogs_debug("    MME_S11_TEID[%d] SGW_S11_TEID[%d]",
             sgwc_ue->mme_s11_teid, sgwc_ue->sgw_s11_teid);
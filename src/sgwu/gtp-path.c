@@ -24,40 +24,25 @@
 
 static ogs_pkbuf_pool_t *packet_pool = NULL;
 
-static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
+/* Receive buffers of gtpu.batch, kept across calls until consumed */
+static ogs_pkbuf_t *rx_batch[OGS_GTPU_MAX_BATCH];
+static ogs_sockaddr_t rx_from[OGS_GTPU_MAX_BATCH];
+
+static void sgwu_gtp_handle_gtpu_packet(
+        ogs_sock_t *sock, ogs_pkbuf_t *pkbuf, ogs_sockaddr_t *from)
 {
     int len;
-    ssize_t size;
     char buf1[OGS_ADDRSTRLEN];
     char buf2[OGS_ADDRSTRLEN];
 
     sgwu_sess_t *sess = NULL;
 
-    ogs_pkbuf_t *pkbuf = NULL;
-    ogs_sock_t *sock = NULL;
-    ogs_sockaddr_t from;
-
     ogs_gtp2_header_t *gtp_h = NULL;
     ogs_gtp2_header_desc_t header_desc;
     ogs_pfcp_user_plane_report_t report;
 
-    ogs_assert(fd != INVALID_SOCKET);
-    sock = data;
     ogs_assert(sock);
-
-    pkbuf = ogs_pkbuf_alloc(packet_pool, OGS_MAX_PKT_LEN);
-    ogs_assert(pkbuf);
-    ogs_pkbuf_put(pkbuf, OGS_MAX_PKT_LEN);
-
-    size = ogs_recvfrom(fd, pkbuf->data, pkbuf->len, 0, &from);
-    if (size <= 0) {
-        ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
-                "ogs_recv() failed");
-        goto cleanup;
-    }
-
-    ogs_pkbuf_trim(pkbuf, size);
-
+    ogs_assert(from);
     ogs_assert(pkbuf);
     ogs_assert(pkbuf->len);
 
@@ -77,16 +62,17 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
     if (header_desc.type == OGS_GTPU_MSGTYPE_ECHO_REQ) {
         ogs_pkbuf_t *echo_rsp;
 
-        ogs_debug("[RECV] Echo Request from [%s]", OGS_ADDR(&from, buf1));
+        ogs_debug("[RECV] Echo Request from [%s]", OGS_ADDR(from, buf1));
         echo_rsp = ogs_gtp2_handle_echo_req(pkbuf);
         ogs_expect(echo_rsp);
         if (echo_rsp) {
             ssize_t sent;
 
             /* Echo reply */
-            ogs_debug("[SEND] Echo Response to [%s]", OGS_ADDR(&from, buf1));
+            ogs_debug("[SEND] Echo Response to [%s]", OGS_ADDR(from, buf1));
 
-            sent = ogs_sendto(fd, echo_rsp->data, echo_rsp->len, 0, &from);
+            sent = ogs_sendto(sock->fd,
+                    echo_rsp->data, echo_rsp->len, 0, from);
             if (sent < 0 || sent != echo_rsp->len) {
                 ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
                         "ogs_sendto() failed");
@@ -104,7 +90,7 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
     }
 
     ogs_trace("[RECV] GPU-U Type [%d] from [%s] : TEID[0x%x]",
-            header_desc.type, OGS_ADDR(&from, buf1), header_desc.teid);
+            header_desc.type, OGS_ADDR(from, buf1), header_desc.teid);
 
     /* Remove GTP header and send packets to peer NF */
     ogs_assert(ogs_pkbuf_pull(pkbuf, len));
@@ -113,7 +99,6 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
         ogs_pfcp_object_t *pfcp_object = NULL;
         ogs_pfcp_pdr_t *pdr = NULL;
         ogs_gtp2_header_desc_t sendhdr;
-        ogs_pkbuf_t *sendbuf = NULL;
 
         pfcp_object = ogs_pfcp_object_find_by_teid(header_desc.teid);
         if (!pfcp_object) {
@@ -135,9 +120,9 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
                 ogs_error("[%s] Send Error Indication [TEID:0x%x] to [%s]",
                         OGS_ADDR(&sock->local_addr, buf1),
                         header_desc.teid,
-                        OGS_ADDR(&from, buf2));
+                        OGS_ADDR(from, buf2));
                 ogs_gtp1_send_error_indication(
-                        sock, header_desc.teid, 0, &from);
+                        sock, header_desc.teid, 0, from);
             }
             goto cleanup;
         }
@@ -154,14 +139,17 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
 
         ogs_assert(pdr);
 
-        sendbuf = ogs_pkbuf_copy(pkbuf);
-        ogs_assert(sendbuf);
-
-        /* Forward packet */
+        /*
+         * Forward packet
+         *
+         * The new GTP-U header is pushed into the headroom
+         * left by the received one, so the packet is not copied.
+         */
         memset(&sendhdr, 0, sizeof(sendhdr));
         sendhdr.type = header_desc.type;
 
-        ogs_pfcp_send_g_pdu(pdr, &sendhdr, sendbuf);
+        ogs_pfcp_send_g_pdu(pdr, &sendhdr, pkbuf);
+        return;
 
     } else if (header_desc.type == OGS_GTPU_MSGTYPE_ERR_IND) {
         ogs_pfcp_far_t *far = NULL;
@@ -212,9 +200,9 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
                 ogs_error("[%s] Send Error Indication [TEID:0x%x] to [%s]",
                         OGS_ADDR(&sock->local_addr, buf1),
                         header_desc.teid,
-                        OGS_ADDR(&from, buf2));
+                        OGS_ADDR(from, buf2));
                 ogs_gtp1_send_error_indication(
-                        sock, header_desc.teid, 0, &from);
+                        sock, header_desc.teid, 0, from);
             }
             goto cleanup;
         }
@@ -290,6 +278,57 @@ cleanup:
     ogs_pkbuf_free(pkbuf);
 }
 
+static void _gtpv1_u_recv_batch(ogs_sock_t *sock, int batch)
+{
+    int i, n;
+
+    n = ogs_gtp_recv_batch(sock->fd, packet_pool, 0, rx_batch, rx_from, batch);
+    if (n == 0)
+        return;
+
+    ogs_gtp_send_batch_begin();
+    for (i = 0; i < n; i++) {
+        ogs_pkbuf_t *pkbuf = rx_batch[i];
+        rx_batch[i] = NULL;
+
+        sgwu_gtp_handle_gtpu_packet(sock, pkbuf, &rx_from[i]);
+    }
+    ogs_gtp_send_batch_end();
+}
+
+static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
+{
+    ssize_t size;
+    ogs_pkbuf_t *pkbuf = NULL;
+    ogs_sock_t *sock = NULL;
+    ogs_sockaddr_t from;
+
+    ogs_assert(fd != INVALID_SOCKET);
+    sock = data;
+    ogs_assert(sock);
+
+    if (ogs_gtp_self()->gtpu_batch.size > 1) {
+        _gtpv1_u_recv_batch(sock, ogs_gtp_self()->gtpu_batch.size);
+        return;
+    }
+
+    pkbuf = ogs_pkbuf_alloc(packet_pool, OGS_MAX_PKT_LEN);
+    ogs_assert(pkbuf);
+    ogs_pkbuf_put(pkbuf, OGS_MAX_PKT_LEN);
+
+    size = ogs_recvfrom(fd, pkbuf->data, pkbuf->len, 0, &from);
+    if (size <= 0) {
+        ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
+                "ogs_recv() failed");
+        ogs_pkbuf_free(pkbuf);
+        return;
+    }
+
+    ogs_pkbuf_trim(pkbuf, size);
+
+    sgwu_gtp_handle_gtpu_packet(sock, pkbuf, &from);
+}
+
 int sgwu_gtp_init(void)
 {
     ogs_pkbuf_config_t config;
@@ -311,6 +350,15 @@ int sgwu_gtp_init(void)
 
 void sgwu_gtp_final(void)
 {
+    int i;
+
+    for (i = 0; i < OGS_GTPU_MAX_BATCH; i++) {
+        if (rx_batch[i]) {
+            ogs_pkbuf_free(rx_batch[i]);
+            rx_batch[i] = NULL;
+        }
+    }
+
     ogs_pkbuf_pool_destroy(packet_pool);
 }
 
@@ -318,11 +366,17 @@ int sgwu_gtp_open(void)
 {
     ogs_socknode_t *node = NULL;
     ogs_sock_t *sock = NULL;
+    bool batch = ogs_gtp_self()->gtpu_batch.size > 1;
+
+    ogs_gtp_self()->gtpu_batch.gso = batch;
 
     ogs_list_for_each(&ogs_gtp_self()->gtpu_list, node) {
         sock = ogs_gtp_server(node);
         if (!sock) return OGS_ERROR;
 
+        if (batch && ogs_gtp_probe_gso(sock) == false)
+            ogs_gtp_self()->gtpu_batch.gso = false;
+
         if (sock->family == AF_INET)
             ogs_gtp_self()->gtpu_sock = sock;
         else if (sock->family == AF_INET6)
@@ -335,6 +389,11 @@ int sgwu_gtp_open(void)
 
     OGS_SETUP_GTPU_SERVER;
 
+    if (batch)
+        ogs_info("gtpu batch [%d] UDP GSO [%s]",
+                ogs_gtp_self()->gtpu_batch.size,
+                ogs_gtp_self()->gtpu_batch.gso ? "on" : "off");
+
     return OGS_OK;
 }
 
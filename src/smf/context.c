@@ -84,12 +84,12 @@ void smf_context_init(void)
     ogs_log_install_domain(&__gsm_log_domain, "gsm", ogs_core()->log.level);
 
     ogs_pool_init(&smf_gtp_node_pool, ogs_app()->pool.nf);
-    ogs_pool_init(&smf_ue_pool, ogs_global_conf()->max.ue);
-    ogs_pool_init(&smf_bearer_pool, ogs_app()->pool.bearer);
-    ogs_pool_init(&smf_pf_pool,
+    ogs_pool_init_chunked(&smf_ue_pool, ogs_global_conf()->max.ue);
+    ogs_pool_init_chunked(&smf_bearer_pool, ogs_app()->pool.bearer);
+    ogs_pool_init_chunked(&smf_pf_pool,
             ogs_app()->pool.bearer * OGS_MAX_NUM_OF_FLOW_IN_BEARER);
 
-    ogs_pool_init(&smf_sess_pool, ogs_app()->pool.sess);
+    ogs_pool_init_chunked(&smf_sess_pool, ogs_app()->pool.sess);
     ogs_pool_init(&smf_n4_seid_pool, ogs_app()->pool.sess);
     ogs_pool_random_id_generate(&smf_n4_seid_pool);
 
@@ -153,6 +153,21 @@ smf_context_t *smf_self(void)
     return &self;
 }
 
+/* Called periodically, see ogs_pool_trim() */
+int smf_pool_trim(void)
+{
+    int n = ogs_pool_trim(&smf_ue_pool) +
+        ogs_pool_trim(&smf_sess_pool) +
+        ogs_pool_trim(&smf_bearer_pool) +
+        ogs_pool_trim(&smf_pf_pool) +
+        ogs_pfcp_pool_trim();
+
+    if (n)
+        ogs_debug("[Pool] %d chunks released", n);
+
+    return n;
+}
+
 static int smf_context_prepare(void)
 {
     self.diam_config->cnf_port = DIAMETER_PORT;
@@ -1276,8 +1291,8 @@ smf_sess_t *smf_sess_add_by_apn(smf_ue_t *smf_ue, char *apn, uint8_t rat_type)
         ogs_error("[NEXTRANET-AAA-DEBUG] No Nextranet AAA Host configured in global config");
     }
 
-    ogs_info("[NEXTRANET-AAA-DEBUG] Setting UE ID %d for session (ID:%d) in smf_sess_add_by_apn", 
-             smf_ue->id, sess->index);
+    ogs_info("[NEXTRANET-AAA-DEBUG] Setting UE ID %lld for session (ID:%d) in smf_sess_add_by_apn", 
+             (long long)smf_ue->id, sess->index);
     sess->smf_ue_id = smf_ue->id;
     ogs_info("[NEXTRANET-AAA-DEBUG] UE ID set, now initializing FSM for session (ID:%d)", sess->index);
 
@@ -1497,8 +1512,8 @@ smf_sess_t *smf_sess_add_by_psi(smf_ue_t *smf_ue, uint8_t psi)
     /* Set Charging Id */
     sess->charging.id = sess->index;
 
-    ogs_info("[NEXTRANET-AAA-DEBUG] Setting UE ID %d for session (ID:%d) in smf_sess_add_by_psi", 
-             smf_ue->id, sess->index);
+    ogs_info("[NEXTRANET-AAA-DEBUG] Setting UE ID %lld for session (ID:%d) in smf_sess_add_by_psi", 
+             (long long)smf_ue->id, sess->index);
     sess->smf_ue_id = smf_ue->id;
     ogs_info("[NEXTRANET-AAA-DEBUG] UE ID set, now initializing FSM for session (ID:%d)", sess->index);
 
@@ -526,6 +526,8 @@ void smf_context_init(void);
 void smf_context_final(void);
 smf_context_t *smf_self(void);
 
+int smf_pool_trim(void);
+
 int smf_context_parse_config(void);
 
 int smf_use_gy_iface(void);
@@ -63,6 +63,8 @@ typedef enum {
     SMF_EVT_5GSM_MESSAGE,
     SMF_EVT_5GSM_TIMER,
 
+    SMF_EVT_POOL_TIMER,
+
     SMF_EVT_TOP,
 
 } smf_event_e;
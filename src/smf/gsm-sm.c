@@ -321,7 +321,8 @@ void smf_gsm_state_initial(ogs_fsm_t *s, smf_event_t *e)
 
         stream = ogs_sbi_stream_find_by_id(stream_id);
         if (!stream) {
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
             break;
         }
 
@@ -371,7 +372,8 @@ void smf_gsm_state_initial(ogs_fsm_t *s, smf_event_t *e)
 
         stream = ogs_sbi_stream_find_by_id(stream_id);
         if (!stream) {
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
             break;
         }
 
@@ -601,7 +603,8 @@ void smf_gsm_state_wait_5gc_sm_policy_association(ogs_fsm_t *s, smf_event_t *e)
 
             stream = ogs_sbi_stream_find_by_id(stream_id);
             if (!stream) {
-                ogs_error("STREAM has already been removed [%d]", stream_id);
+                ogs_error("STREAM has already been removed [%lld]",
+                        (long long)stream_id);
                 break;
             }
 
@@ -1054,7 +1057,8 @@ void smf_gsm_state_operational(ogs_fsm_t *s, smf_event_t *e)
 
         stream = ogs_sbi_stream_find_by_id(stream_id);
         if (!stream) {
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
             break;
         }
 
@@ -1256,7 +1260,8 @@ void smf_gsm_state_operational(ogs_fsm_t *s, smf_event_t *e)
 
         stream = ogs_sbi_stream_find_by_id(stream_id);
         if (!stream) {
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
             break;
         }
 
@@ -1342,7 +1347,8 @@ void smf_gsm_state_operational(ogs_fsm_t *s, smf_event_t *e)
 
         stream = ogs_sbi_stream_find_by_id(stream_id);
         if (!stream) {
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
             break;
         }
 
@@ -1508,7 +1514,8 @@ void smf_gsm_state_wait_pfcp_deletion(ogs_fsm_t *s, smf_event_t *e)
 
             stream = ogs_sbi_stream_find_by_id(stream_id);
             if (!stream) {
-                ogs_error("STREAM has already been removed [%d]", stream_id);
+                ogs_error("STREAM has already been removed [%lld]",
+                        (long long)stream_id);
                 break;
             }
 
@@ -1669,7 +1676,8 @@ void smf_gsm_state_wait_pfcp_deletion(ogs_fsm_t *s, smf_event_t *e)
 
             stream = ogs_sbi_stream_find_by_id(stream_id);
             if (!stream) {
-                ogs_error("STREAM has already been removed [%d]", stream_id);
+                ogs_error("STREAM has already been removed [%lld]",
+                        (long long)stream_id);
                 break;
             }
 
@@ -1864,7 +1872,8 @@ void smf_gsm_state_wait_5gc_n1_n2_release(ogs_fsm_t *s, smf_event_t *e)
 
         stream = ogs_sbi_stream_find_by_id(stream_id);
         if (!stream) {
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
             break;
         }
 
@@ -1935,7 +1944,8 @@ void smf_gsm_state_wait_5gc_n1_n2_release(ogs_fsm_t *s, smf_event_t *e)
 
             stream = ogs_sbi_stream_find_by_id(stream_id);
             if (!stream) {
-                ogs_error("STREAM has already been removed [%d]", stream_id);
+                ogs_error("STREAM has already been removed [%lld]",
+                        (long long)stream_id);
                 break;
             }
 
@@ -2012,7 +2022,8 @@ void smf_gsm_state_wait_5gc_n1_n2_release(ogs_fsm_t *s, smf_event_t *e)
 
         stream = ogs_sbi_stream_find_by_id(stream_id);
         if (!stream) {
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
             break;
         }
 
@@ -2091,7 +2102,8 @@ void smf_gsm_state_wait_5gc_n1_n2_release(ogs_fsm_t *s, smf_event_t *e)
 
         stream = ogs_sbi_stream_find_by_id(stream_id);
         if (!stream) {
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
             break;
         }
 
@@ -2282,7 +2294,8 @@ void smf_gsm_state_5gc_session_will_deregister(ogs_fsm_t *s, smf_event_t *e)
 
         stream = ogs_sbi_stream_find_by_id(stream_id);
         if (!stream) {
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
             break;
         }
 
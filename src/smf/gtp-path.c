@@ -112,33 +112,15 @@ static void _gtpv1v2_c_recv_cb(short when, ogs_socket_t fd, void *data)
     }
 }
 
-static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
+static void smf_gtp_handle_gtpu_packet(
+        ogs_socket_t fd, ogs_pkbuf_t *pkbuf, ogs_sockaddr_t *from)
 {
     int len;
-    ssize_t size;
     char buf[OGS_ADDRSTRLEN];
 
-    ogs_pkbuf_t *pkbuf = NULL;
-    ogs_sockaddr_t from;
-
     ogs_gtp2_header_t *gtp_h = NULL;
     ogs_gtp2_header_desc_t header_desc;
 
-    ogs_assert(fd != INVALID_SOCKET);
-
-    pkbuf = ogs_pkbuf_alloc(NULL, OGS_MAX_PKT_LEN);
-    ogs_assert(pkbuf);
-    ogs_pkbuf_put(pkbuf, OGS_MAX_PKT_LEN);
-
-    size = ogs_recvfrom(fd, pkbuf->data, pkbuf->len, 0, &from);
-    if (size <= 0) {
-        ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
-                "ogs_recv() failed");
-        goto cleanup;
-    }
-
-    ogs_pkbuf_trim(pkbuf, size);
-
     ogs_assert(pkbuf);
     ogs_assert(pkbuf->len);
 
@@ -158,16 +140,16 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
     if (header_desc.type == OGS_GTPU_MSGTYPE_ECHO_REQ) {
         ogs_pkbuf_t *echo_rsp;
 
-        ogs_debug("[RECV] Echo Request from [%s]", OGS_ADDR(&from, buf));
+        ogs_debug("[RECV] Echo Request from [%s]", OGS_ADDR(from, buf));
         echo_rsp = ogs_gtp2_handle_echo_req(pkbuf);
         ogs_expect(echo_rsp);
         if (echo_rsp) {
             ssize_t sent;
 
             /* Echo reply */
-            ogs_debug("[SEND] Echo Response to [%s]", OGS_ADDR(&from, buf));
+            ogs_debug("[SEND] Echo Response to [%s]", OGS_ADDR(from, buf));
 
-            sent = ogs_sendto(fd, echo_rsp->data, echo_rsp->len, 0, &from);
+            sent = ogs_sendto(fd, echo_rsp->data, echo_rsp->len, 0, from);
             if (sent < 0 || sent != echo_rsp->len) {
                 ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
                         "ogs_sendto() failed");
@@ -185,7 +167,7 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
     }
 
     ogs_debug("[RECV] GPU-U Type [%d] from [%s] : TEID[0x%x]",
-            header_desc.type, OGS_ADDR(&from, buf), header_desc.teid);
+            header_desc.type, OGS_ADDR(from, buf), header_desc.teid);
 
     /* Remove GTP header and send packets to TUN interface */
     ogs_assert(ogs_pkbuf_pull(pkbuf, len));
@@ -228,6 +210,41 @@ cleanup:
     ogs_pkbuf_free(pkbuf);
 }
 
+static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
+{
+    ssize_t size;
+    ogs_pkbuf_t *pkbuf = NULL;
+    ogs_sockaddr_t from;
+
+    ogs_assert(fd != INVALID_SOCKET);
+
+    pkbuf = ogs_pkbuf_alloc(NULL, OGS_MAX_PKT_LEN);
+    ogs_assert(pkbuf);
+    ogs_pkbuf_put(pkbuf, OGS_MAX_PKT_LEN);
+
+    size = ogs_recvfrom(fd, pkbuf->data, pkbuf->len, 0, &from);
+    if (size <= 0) {
+        ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
+                "ogs_recv() failed");
+        ogs_pkbuf_free(pkbuf);
+        return;
+    }
+
+    ogs_pkbuf_trim(pkbuf, size);
+
+    smf_gtp_handle_gtpu_packet(fd, pkbuf, &from);
+}
+
+/* Packets of parameter.use_io_uring, completed by the pollset */
+static void _gtpv1_u_recv_multi_cb(ogs_socket_t fd,
+        ogs_pkbuf_t **pkbuf, ogs_sockaddr_t *from, int num, void *data)
+{
+    int i;
+
+    for (i = 0; i < num; i++)
+        smf_gtp_handle_gtpu_packet(fd, pkbuf[i], &from[i]);
+}
+
 int smf_gtp_open(void)
 {
     ogs_socknode_t *node = NULL;
@@ -264,8 +281,12 @@ int smf_gtp_open(void)
         else if (sock->family == AF_INET6)
             ogs_gtp_self()->gtpu_sock6 = sock;
 
-        node->poll = ogs_pollset_add(ogs_app()->pollset,
-                OGS_POLLIN, sock->fd, _gtpv1_u_recv_cb, sock);
+        if (ogs_global_conf()->parameter.use_io_uring)
+            node->poll = ogs_pollset_add_recv(ogs_app()->pollset, sock->fd,
+                    NULL, OGS_MAX_PKT_LEN, 0, _gtpv1_u_recv_multi_cb, sock);
+        else
+            node->poll = ogs_pollset_add(ogs_app()->pollset,
+                    OGS_POLLIN, sock->fd, _gtpv1_u_recv_cb, sock);
         ogs_assert(node->poll);
     }
 
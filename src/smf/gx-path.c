@@ -1200,7 +1200,7 @@ static int smf_gx_rar_cb( struct msg **msg, struct avp *avp,
     /* Get Session Information */
     sess = smf_sess_find_by_id(sess_data->sess_id);
     if (!sess) {
-        ogs_error("No Session ID [%d]", sess_data->sess_id);
+        ogs_error("No Session ID [%lld]", (long long)sess_data->sess_id);
         goto out;
     }
 
@@ -150,8 +150,8 @@ static int smf_nextranet_aaa_auth_cb(struct msg **msg, struct avp *avp,
             /* Pass OGS_INVALID_POOL_ID for transaction ID - the state machine already has it */
             e->gtp_xact_id = OGS_INVALID_POOL_ID;
             
-            ogs_info("[NEXTRANET-AAA-DEBUG] Sending AAA authentication event for session ID:%d, auth_success:%d", 
-                     e->sess_id, smf_sess->nextranet_auth_success);
+            ogs_info("[NEXTRANET-AAA-DEBUG] Sending AAA authentication event for session ID:%lld, auth_success:%d", 
+                     (long long)e->sess_id, smf_sess->nextranet_auth_success);
             smf_event_send(e);
         }
     }
@@ -203,7 +203,7 @@ static int smf_nextranet_aaa_auth_err_cb(struct msg **msg, struct avp *avp,
             /* Pass OGS_INVALID_POOL_ID for transaction ID - the state machine already has it */
             e->gtp_xact_id = OGS_INVALID_POOL_ID;
             
-            ogs_info("[NEXTRANET-AAA-DEBUG] Sending AAA authentication failure event for session ID:%d", e->sess_id);
+            ogs_info("[NEXTRANET-AAA-DEBUG] Sending AAA authentication failure event for session ID:%lld", (long long)e->sess_id);
             smf_event_send(e);
         }
         
@@ -237,12 +237,12 @@ int smf_nextranet_aaa_send_auth_request(smf_sess_t *sess)
     }
     
     /* Find UE context - don't crash if not found */
-    ogs_info("[NEXTRANET-AAA-DEBUG] Looking up UE with ID: %d for session (ID:%d)", 
-             sess->smf_ue_id, sess->index);
+    ogs_info("[NEXTRANET-AAA-DEBUG] Looking up UE with ID: %lld for session (ID:%d)", 
+             (long long)sess->smf_ue_id, sess->index);
     smf_ue = smf_ue_find_by_id(sess->smf_ue_id);
     if (!smf_ue) {
-        ogs_error("[NEXTRANET-AAA-DEBUG] Cannot find UE for session (ID:%d), UE ID was: %d", 
-                  sess->index, sess->smf_ue_id);
+        ogs_error("[NEXTRANET-AAA-DEBUG] Cannot find UE for session (ID:%d), UE ID was: %lld", 
+                  sess->index, (long long)sess->smf_ue_id);
         return -1;
     }
     ogs_info("[NEXTRANET-AAA-DEBUG] Successfully found UE context for session (ID:%d)", sess->index);
@@ -31,12 +31,21 @@
 #include "nsmf-handler.h"
 #include "npcf-handler.h"
 
+#define POOL_TRIM_TIME ogs_time_from_sec(60)
+
+static ogs_timer_t *t_pool_trim = NULL;
+
 void smf_state_initial(ogs_fsm_t *s, smf_event_t *e)
 {
     smf_sm_debug(e);
 
     ogs_assert(s);
 
+    t_pool_trim = ogs_timer_add(ogs_app()->timer_mgr,
+            smf_timer_pool_trim, 0);
+    ogs_assert(t_pool_trim);
+    ogs_timer_start(t_pool_trim, POOL_TRIM_TIME);
+
     OGS_FSM_TRAN(s, &smf_state_operational);
 }
 
@@ -44,6 +53,9 @@ void smf_state_final(ogs_fsm_t *s, smf_event_t *e)
 {
     smf_sm_debug(e);
 
+    if (t_pool_trim)
+        ogs_timer_delete(t_pool_trim);
+
     ogs_assert(s);
 }
 
@@ -94,6 +106,8 @@ void smf_state_operational(ogs_fsm_t *s, smf_event_t *e)
         break;
 
     case OGS_FSM_EXIT_SIG:
+        if (t_pool_trim)
+            ogs_timer_stop(t_pool_trim);
         break;
 
     case SMF_EVT_S5C_MESSAGE:
@@ -454,7 +468,8 @@ void smf_state_operational(ogs_fsm_t *s, smf_event_t *e)
 
         stream = ogs_sbi_stream_find_by_id(stream_id);
         if (!stream) {
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
             break;
         }
 
@@ -782,8 +797,8 @@ void smf_state_operational(ogs_fsm_t *s, smf_event_t *e)
                 if (!sbi_xact) {
                     /* CLIENT_WAIT timer could remove SBI transaction
                      * before receiving SBI message */
-                    ogs_error("SBI transaction has already been removed [%d]",
-                            sbi_xact_id);
+                    ogs_error("SBI transaction has already been removed [%lld]",
+                            (long long)sbi_xact_id);
                     break;
                 }
 
@@ -820,8 +835,8 @@ void smf_state_operational(ogs_fsm_t *s, smf_event_t *e)
             if (!sbi_xact) {
                 /* CLIENT_WAIT timer could remove SBI transaction
                  * before receiving SBI message */
-                ogs_error("SBI transaction has already been removed [%d]",
-                        sbi_xact_id);
+                ogs_error("SBI transaction has already been removed [%lld]",
+                        (long long)sbi_xact_id);
                 break;
             }
 
@@ -864,8 +879,8 @@ void smf_state_operational(ogs_fsm_t *s, smf_event_t *e)
             if (!sbi_xact) {
                 /* CLIENT_WAIT timer could remove SBI transaction
                  * before receiving SBI message */
-                ogs_error("SBI transaction has already been removed [%d]",
-                        sbi_xact_id);
+                ogs_error("SBI transaction has already been removed [%lld]",
+                        (long long)sbi_xact_id);
                 break;
             }
 
@@ -1029,8 +1044,8 @@ void smf_state_operational(ogs_fsm_t *s, smf_event_t *e)
 
             sbi_xact = ogs_sbi_xact_find_by_id(sbi_xact_id);
             if (!sbi_xact) {
-                ogs_error("SBI transaction has already been removed [%d]",
-                        sbi_xact_id);
+                ogs_error("SBI transaction has already been removed [%lld]",
+                        (long long)sbi_xact_id);
                 break;
             }
 
@@ -1097,6 +1112,19 @@ void smf_state_operational(ogs_fsm_t *s, smf_event_t *e)
         ogs_pkbuf_free(pkbuf);
         break;
 
+    case SMF_EVT_POOL_TIMER:
+        switch(e->h.timer_id) {
+        case SMF_TIMER_POOL_TRIM:
+            smf_pool_trim();
+            ogs_timer_start(t_pool_trim, POOL_TRIM_TIME);
+            break;
+
+        default:
+            ogs_error("Unknown timer[%s:%d]",
+                    smf_timer_get_name(e->h.timer_id), e->h.timer_id);
+        }
+        break;
+
     default:
         ogs_error("No handler for event %s", smf_event_get_name(e));
         break;
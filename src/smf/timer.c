@@ -44,6 +44,8 @@ const char *smf_timer_get_name(int timer_id)
         return "SMF_TIMER_PFCP_NO_ESTABLISHMENT_RESPONSE";
     case SMF_TIMER_PFCP_NO_DELETION_RESPONSE:
         return "SMF_TIMER_PFCP_NO_DELETION_RESPONSE";
+    case SMF_TIMER_POOL_TRIM:
+        return "SMF_TIMER_POOL_TRIM";
     default: 
        break;
     }
@@ -89,3 +91,20 @@ void smf_timer_pfcp_no_heartbeat(void *data)
 {
     timer_send_event(SMF_TIMER_PFCP_NO_HEARTBEAT, data);
 }
+
+void smf_timer_pool_trim(void *data)
+{
+    int rv;
+    smf_event_t *e = NULL;
+
+    e = smf_event_new(SMF_EVT_POOL_TIMER);
+    ogs_assert(e);
+    e->h.timer_id = SMF_TIMER_POOL_TRIM;
+
+    rv = ogs_queue_push(ogs_app()->queue, e);
+    if (rv != OGS_OK) {
+        ogs_error("ogs_queue_push() failed [%d] in %s",
+                (int)rv, smf_timer_get_name(SMF_TIMER_POOL_TRIM));
+        ogs_event_free(e);
+    }
+}
@@ -76,7 +76,8 @@ void udm_state_operational(ogs_fsm_t *s, udm_event_t *e)
 
         stream = ogs_sbi_stream_find_by_id(stream_id);
         if (!stream) {
-            ogs_error("STREAM has already been removed [%d]", stream_id);
+            ogs_error("STREAM has already been removed [%lld]",
+                    (long long)stream_id);
             break;
         }
 
@@ -360,8 +361,8 @@ void udm_state_operational(ogs_fsm_t *s, udm_event_t *e)
                 if (!sbi_xact) {
                     /* CLIENT_WAIT timer could remove SBI transaction
                      * before receiving SBI message */
-                    ogs_error("SBI transaction has already been removed [%d]",
-                            sbi_xact_id);
+                    ogs_error("SBI transaction has already been removed [%lld]",
+                            (long long)sbi_xact_id);
                     break;
                 }
 
@@ -401,8 +402,8 @@ void udm_state_operational(ogs_fsm_t *s, udm_event_t *e)
                         /* CLIENT_WAIT timer could remove SBI transaction
                          * before receiving SBI message */
                         ogs_error(
-                                "SBI transaction has already been removed [%d]",
-                                sbi_xact_id);
+                                "SBI transaction has already been removed [%lld]",
+                                (long long)sbi_xact_id);
                         break;
                     }
 
@@ -450,8 +451,8 @@ void udm_state_operational(ogs_fsm_t *s, udm_event_t *e)
                         /* CLIENT_WAIT timer could remove SBI transaction
                          * before receiving SBI message */
                         ogs_error(
-                                "SBI transaction has already been removed [%d]",
-                                sbi_xact_id);
+                                "SBI transaction has already been removed [%lld]",
+                                (long long)sbi_xact_id);
                         break;
                     }
 
@@ -583,8 +584,8 @@ void udm_state_operational(ogs_fsm_t *s, udm_event_t *e)
 
             sbi_xact = ogs_sbi_xact_find_by_id(sbi_xact_id);
             if (!sbi_xact) {
-                ogs_error("SBI transaction has already been removed [%d]",
-                        sbi_xact_id);
+                ogs_error("SBI transaction has already been removed [%lld]",
+                        (long long)sbi_xact_id);
                 break;
             }
 
@@ -597,8 +598,8 @@ void udm_state_operational(ogs_fsm_t *s, udm_event_t *e)
             ogs_error("Cannot receive SBI message");
 
             if (!stream) {
-                ogs_error("STREAM has alreadt been removed [%d]",
-                        sbi_xact->assoc_stream_id);
+                ogs_error("STREAM has alreadt been removed [%lld]",
+                        (long long)sbi_xact->assoc_stream_id);
                 break;
             }
             ogs_assert(true ==
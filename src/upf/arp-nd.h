@@ -40,6 +40,7 @@ extern "C" {
 void set_source_mac(uint8_t *data);
 bool is_arp_req(uint8_t *data, uint len);
 uint32_t arp_parse_target_addr(uint8_t *data, uint len);
+/* reply_data may point to request_data : the reply is written in place */
 uint8_t arp_reply(uint8_t *reply_data, uint8_t *request_data, uint len,
         const uint8_t *mac);
 bool is_nd_req(uint8_t *data, uint len);
@@ -29,7 +29,12 @@ static OGS_POOL(upf_n4_seid_pool, ogs_pool_id_t);
 
 static int context_initialized = 0;
 
+static OGS_LIST(urr_check_list);
+
+OGS_STATIC_ASSERT(sizeof(upf_sess_urr_counter_t) == 64);
+
 static void upf_sess_urr_acc_remove_all(upf_sess_t *sess);
+static void dispatch_clear(upf_sess_dispatch_t *d);
 
 void upf_context_init(void)
 {
@@ -49,7 +54,7 @@ void upf_context_init(void)
     ogs_pfcp_self()->up_function_features_len = 4;
 
     ogs_list_init(&self.sess_list);
-    ogs_pool_init(&upf_sess_pool, ogs_app()->pool.sess);
+    ogs_pool_init_chunked(&upf_sess_pool, ogs_app()->pool.sess);
     ogs_pool_init(&upf_n4_seid_pool, ogs_app()->pool.sess);
     ogs_pool_random_id_generate(&upf_n4_seid_pool);
 
@@ -59,23 +64,14 @@ void upf_context_init(void)
     ogs_assert(self.smf_n4_seid_hash);
     self.smf_n4_f_seid_hash = ogs_hash_make();
     ogs_assert(self.smf_n4_f_seid_hash);
-    self.ipv4_hash = ogs_hash_make();
-    ogs_assert(self.ipv4_hash);
-    self.ipv6_hash = ogs_hash_make();
-    ogs_assert(self.ipv6_hash);
+    self.ipv4_lpm = ogs_lpm_create(OGS_IPV4_LEN << 3);
+    ogs_assert(self.ipv4_lpm);
+    self.ipv6_lpm = ogs_lpm_create(OGS_IPV6_LEN << 3);
+    ogs_assert(self.ipv6_lpm);
 
     context_initialized = 1;
 }
 
-static void free_upf_route_trie_node(struct upf_route_trie_node *node)
-{
-    if (!node)
-        return;
-    free_upf_route_trie_node(node->left);
-    free_upf_route_trie_node(node->right);
-    ogs_free(node);
-}
-
 void upf_context_final(void)
 {
     ogs_assert(context_initialized == 1);
@@ -88,13 +84,10 @@ void upf_context_final(void)
     ogs_hash_destroy(self.smf_n4_seid_hash);
     ogs_assert(self.smf_n4_f_seid_hash);
     ogs_hash_destroy(self.smf_n4_f_seid_hash);
-    ogs_assert(self.ipv4_hash);
-    ogs_hash_destroy(self.ipv4_hash);
-    ogs_assert(self.ipv6_hash);
-    ogs_hash_destroy(self.ipv6_hash);
-
-    free_upf_route_trie_node(self.ipv4_framed_routes);
-    free_upf_route_trie_node(self.ipv6_framed_routes);
+    ogs_assert(self.ipv4_lpm);
+    ogs_lpm_destroy(self.ipv4_lpm);
+    ogs_assert(self.ipv6_lpm);
+    ogs_lpm_destroy(self.ipv6_lpm);
 
     ogs_pool_final(&upf_sess_pool);
     ogs_pool_final(&upf_n4_seid_pool);
@@ -107,6 +100,30 @@ upf_context_t *upf_self(void)
     return &self;
 }
 
+/* Called periodically, see ogs_pool_trim() */
+int upf_pool_trim(void)
+{
+    int n = ogs_pool_trim(&upf_sess_pool) + ogs_pfcp_pool_trim();
+
+    if (n)
+        ogs_debug("[Pool] %d chunks released", n);
+
+    return n;
+}
+
+void upf_pool_stat(upf_pool_stat_t *stat)
+{
+    ogs_pfcp_pool_stat_t pfcp;
+
+    ogs_assert(stat);
+
+    ogs_pfcp_pool_stat(&pfcp);
+
+    stat->sess_peak = ogs_pool_peak(&upf_sess_pool);
+    stat->pdr_peak = pfcp.pdr_peak;
+    stat->committed = ogs_pool_committed(&upf_sess_pool) + pfcp.committed;
+}
+
 static int upf_context_prepare(void)
 {
     return OGS_OK;
@@ -171,6 +188,35 @@ int upf_context_parse_config(void)
     return OGS_OK;
 }
 
+/*
+ * UE IP Address and framed routes share the same table.
+ *
+ * A prefix that is still held by a stale session is taken over
+ * by the new session, as the SMF may re-use the UE IP address
+ * before the old session is released. Since a session only removes
+ * the prefixes it owns, the later release of the stale session
+ * leaves the new route in place.
+ */
+static void ue_ip_route_add(
+        ogs_lpm_t *lpm, const void *addr, int len, upf_sess_t *sess)
+{
+    upf_sess_t *old = NULL;
+
+    old = ogs_lpm_get(lpm, addr, len);
+    if (old && old != sess)
+        ogs_warn("Route taken over [UP:0x%lx] -> [UP:0x%lx]",
+                (long)old->upf_n4_seid, (long)sess->upf_n4_seid);
+
+    ogs_assert(OGS_OK == ogs_lpm_add(lpm, addr, len, sess));
+}
+
+static void ue_ip_route_del(
+        ogs_lpm_t *lpm, const void *addr, int len, upf_sess_t *sess)
+{
+    if (ogs_lpm_get(lpm, addr, len) == sess)
+        ogs_lpm_delete(lpm, addr, len);
+}
+
 upf_sess_t *upf_sess_add(ogs_pfcp_f_seid_t *cp_f_seid)
 {
     upf_sess_t *sess = NULL;
@@ -181,6 +227,7 @@ upf_sess_t *upf_sess_add(ogs_pfcp_f_seid_t *cp_f_seid)
     ogs_assert(sess);
 
     ogs_pfcp_pool_init(&sess->pfcp);
+    upf_sess_dispatch_build(sess);
 
     /* Set UPF-N4-SEID */
     ogs_pool_alloc(&upf_n4_seid_pool, &sess->upf_n4_seid_node);
@@ -214,6 +261,8 @@ upf_sess_t *upf_sess_add(ogs_pfcp_f_seid_t *cp_f_seid)
 
 int upf_sess_remove(upf_sess_t *sess)
 {
+    int i;
+
     ogs_assert(sess);
 
     upf_sess_urr_acc_remove_all(sess);
@@ -230,18 +279,24 @@ int upf_sess_remove(upf_sess_t *sess)
             sizeof(sess->smf_n4_f_seid), NULL);
 
     if (sess->ipv4) {
-        ogs_hash_set(self.ipv4_hash, sess->ipv4->addr, OGS_IPV4_LEN, NULL);
+        ue_ip_route_del(self.ipv4_lpm,
+                sess->ipv4->addr, OGS_IPV4_LEN << 3, sess);
         ogs_pfcp_ue_ip_free(sess->ipv4);
     }
     if (sess->ipv6) {
-        ogs_hash_set(self.ipv6_hash,
-                sess->ipv6->addr, OGS_IPV6_DEFAULT_PREFIX_LEN >> 3, NULL);
+        ue_ip_route_del(self.ipv6_lpm,
+                sess->ipv6->addr, OGS_IPV6_DEFAULT_PREFIX_LEN, sess);
         ogs_pfcp_ue_ip_free(sess->ipv6);
     }
 
     upf_sess_set_ue_ipv4_framed_routes(sess, NULL);
     upf_sess_set_ue_ipv6_framed_routes(sess, NULL);
 
+    for (i = 0; i < sess->dispatch.num_of_ul; i++)
+        dispatch_clear(&sess->dispatch.ul[i]);
+    dispatch_clear(&sess->dispatch.dl);
+    ogs_hash_destroy(sess->dispatch.ul_hash);
+
     ogs_pfcp_pool_final(&sess->pfcp);
 
     ogs_pool_free(&upf_n4_seid_pool, sess->upf_n4_seid_node);
@@ -291,66 +346,15 @@ upf_sess_t *upf_sess_find_by_upf_n4_seid(uint64_t seid)
 
 upf_sess_t *upf_sess_find_by_ipv4(uint32_t addr)
 {
-    upf_sess_t *ret;
-    struct upf_route_trie_node *trie = self.ipv4_framed_routes;
-    const int nbits = sizeof(addr) << 3;
-    int i;
-
-    ogs_assert(self.ipv4_hash);
-
-    ret = ogs_hash_get(self.ipv4_hash, &addr, OGS_IPV4_LEN);
-    if (ret)
-        return ret;
-
-    for (i =  0; i <= nbits; i++) {
-        int bit = nbits - i - 1;
-
-        if (!trie)
-            break;
-        if (trie->sess)
-            ret = trie->sess;
-        if (i == nbits)
-            break;
-
-        if ((1 << bit) & be32toh(addr))
-            trie = trie->right;
-        else
-            trie = trie->left;
-    }
-    return ret;
+    ogs_assert(self.ipv4_lpm);
+    return ogs_lpm_find(self.ipv4_lpm, &addr);
 }
 
 upf_sess_t *upf_sess_find_by_ipv6(uint32_t *addr6)
 {
-    upf_sess_t *ret = NULL;
-    struct upf_route_trie_node *trie = self.ipv6_framed_routes;
-    int i;
-    const int chunk_size = sizeof(*addr6) << 3;
-
-    ogs_assert(self.ipv6_hash);
+    ogs_assert(self.ipv6_lpm);
     ogs_assert(addr6);
-    ret = ogs_hash_get(
-            self.ipv6_hash, addr6, OGS_IPV6_DEFAULT_PREFIX_LEN >> 3);
-    if (ret)
-        return ret;
-
-    for (i = 0; i <= OGS_IPV6_128_PREFIX_LEN; i++) {
-        int part = i / chunk_size;
-        int bit = (OGS_IPV6_128_PREFIX_LEN - i - 1) % chunk_size;
-
-        if (!trie)
-            break;
-        if (trie->sess)
-            ret = trie->sess;
-        if (i == OGS_IPV6_128_PREFIX_LEN)
-            break;
-
-        if ((1 << bit) & be32toh(addr6[part]))
-            trie = trie->right;
-        else
-            trie = trie->left;
-    }
-    return ret;
+    return ogs_lpm_find(self.ipv6_lpm, addr6);
 }
 
 upf_sess_t *upf_sess_find_by_id(ogs_pool_id_t id)
@@ -358,28 +362,33 @@ upf_sess_t *upf_sess_find_by_id(ogs_pool_id_t id)
     return ogs_pool_find_by_id(&upf_sess_pool, id);
 }
 
-upf_sess_t *upf_sess_add_by_message(ogs_pfcp_message_t *message)
+upf_sess_t *upf_sess_add_by_ie_index(ogs_pfcp_ie_index_t *index)
 {
     upf_sess_t *sess = NULL;
-    ogs_pfcp_f_seid_t *f_seid = NULL;
+    ogs_pfcp_ie_t *ie = NULL;
+    ogs_pfcp_tlv_f_seid_t cp_f_seid;
+    ogs_pfcp_f_seid_t f_seid;
 
-    ogs_pfcp_session_establishment_request_t *req =
-        &message->pfcp_session_establishment_request;;
+    ogs_assert(index);
 
-    f_seid = req->cp_f_seid.data;
-    if (req->cp_f_seid.presence == 0 || f_seid == NULL) {
+    ie = ogs_pfcp_ie_find(index, OGS_PFCP_F_SEID_TYPE, NULL);
+    if (!ie || ogs_pfcp_ie_decode(index, ie,
+                &ogs_pfcp_tlv_desc_f_seid, &cp_f_seid) != OGS_OK) {
         ogs_error("No CP F-SEID");
         return NULL;
     }
-    if (f_seid->ipv4 == 0 && f_seid->ipv6 == 0) {
+
+    memset(&f_seid, 0, sizeof(f_seid));
+    memcpy(&f_seid, cp_f_seid.data, ogs_min(cp_f_seid.len, sizeof(f_seid)));
+    if (f_seid.ipv4 == 0 && f_seid.ipv6 == 0) {
         ogs_error("No IPv4 or IPv6");
         return NULL;
     }
-    f_seid->seid = be64toh(f_seid->seid);
+    f_seid.seid = be64toh(f_seid.seid);
 
-    sess = upf_sess_find_by_smf_n4_f_seid(f_seid);
+    sess = upf_sess_find_by_smf_n4_f_seid(&f_seid);
     if (!sess) {
-        sess = upf_sess_add(f_seid);
+        sess = upf_sess_add(&f_seid);
         if (!sess) {
             ogs_error("No Session Context");
             return NULL;
@@ -406,13 +415,13 @@ uint8_t upf_sess_set_ue_ip(upf_sess_t *sess,
     ogs_assert(ue_ip);
 
     if (sess->ipv4) {
-        ogs_hash_set(self.ipv4_hash,
-                sess->ipv4->addr, OGS_IPV4_LEN, NULL);
+        ue_ip_route_del(self.ipv4_lpm,
+                sess->ipv4->addr, OGS_IPV4_LEN << 3, sess);
         ogs_pfcp_ue_ip_free(sess->ipv4);
     }
     if (sess->ipv6) {
-        ogs_hash_set(self.ipv6_hash,
-                sess->ipv6->addr, OGS_IPV6_DEFAULT_PREFIX_LEN >> 3, NULL);
+        ue_ip_route_del(self.ipv6_lpm,
+                sess->ipv6->addr, OGS_IPV6_DEFAULT_PREFIX_LEN, sess);
         ogs_pfcp_ue_ip_free(sess->ipv6);
     }
 
@@ -426,7 +435,8 @@ uint8_t upf_sess_set_ue_ip(upf_sess_t *sess,
                 ogs_assert(cause_value != OGS_PFCP_CAUSE_REQUEST_ACCEPTED);
                 return cause_value;
             }
-            ogs_hash_set(self.ipv4_hash, sess->ipv4->addr, OGS_IPV4_LEN, sess);
+            ue_ip_route_add(self.ipv4_lpm,
+                    sess->ipv4->addr, OGS_IPV4_LEN << 3, sess);
         } else {
             ogs_warn("Cannot support PDN-Type[%d], [IPv4:%d IPv6:%d DNN:%s]",
                 session_type, ue_ip->ipv4, ue_ip->ipv6,
@@ -441,8 +451,8 @@ uint8_t upf_sess_set_ue_ip(upf_sess_t *sess,
                 ogs_assert(cause_value != OGS_PFCP_CAUSE_REQUEST_ACCEPTED);
                 return cause_value;
             }
-            ogs_hash_set(self.ipv6_hash, sess->ipv6->addr,
-                    OGS_IPV6_DEFAULT_PREFIX_LEN >> 3, sess);
+            ue_ip_route_add(self.ipv6_lpm,
+                    sess->ipv6->addr, OGS_IPV6_DEFAULT_PREFIX_LEN, sess);
         } else {
             ogs_warn("Cannot support PDN-Type[%d], [IPv4:%d IPv6:%d DNN:%s]",
                 session_type, ue_ip->ipv4, ue_ip->ipv6,
@@ -457,7 +467,8 @@ uint8_t upf_sess_set_ue_ip(upf_sess_t *sess,
                 ogs_assert(cause_value != OGS_PFCP_CAUSE_REQUEST_ACCEPTED);
                 return cause_value;
             }
-            ogs_hash_set(self.ipv4_hash, sess->ipv4->addr, OGS_IPV4_LEN, sess);
+            ue_ip_route_add(self.ipv4_lpm,
+                    sess->ipv4->addr, OGS_IPV4_LEN << 3, sess);
         } else {
             ogs_warn("Cannot support PDN-Type[%d], [IPv4:%d IPv6:%d DNN:%s]",
                 session_type, ue_ip->ipv4, ue_ip->ipv6,
@@ -471,15 +482,15 @@ uint8_t upf_sess_set_ue_ip(upf_sess_t *sess,
                 ogs_error("ogs_pfcp_ue_ip_alloc() failed[%d]", cause_value);
                 ogs_assert(cause_value != OGS_PFCP_CAUSE_REQUEST_ACCEPTED);
                 if (sess->ipv4) {
-                    ogs_hash_set(self.ipv4_hash,
-                            sess->ipv4->addr, OGS_IPV4_LEN, NULL);
+                    ue_ip_route_del(self.ipv4_lpm,
+                            sess->ipv4->addr, OGS_IPV4_LEN << 3, sess);
                     ogs_pfcp_ue_ip_free(sess->ipv4);
                     sess->ipv4 = NULL;
                 }
                 return cause_value;
             }
-            ogs_hash_set(self.ipv6_hash, sess->ipv6->addr,
-                    OGS_IPV6_DEFAULT_PREFIX_LEN >> 3, sess);
+            ue_ip_route_add(self.ipv6_lpm,
+                    sess->ipv6->addr, OGS_IPV6_DEFAULT_PREFIX_LEN, sess);
         } else {
             ogs_warn("Cannot support PDN-Type[%d], [IPv4:%d IPv6:%d DNN:%s]",
                 session_type, ue_ip->ipv4, ue_ip->ipv6,
@@ -502,83 +513,37 @@ uint8_t upf_sess_set_ue_ip(upf_sess_t *sess,
     return cause_value;
 }
 
-/* Remove amd free framed ROUTE from TRIE. It isn't an error if the framed
-   route doesn't exist in TRIE. */
-static void free_framed_route_from_trie(ogs_ipsubnet_t *route)
+static int framed_route_prefixlen(ogs_ipsubnet_t *route)
 {
-    const int chunk_size = sizeof(route->sub[0]) << 3;
-    const int is_ipv4 = route->family == AF_INET;
-    const int nbits = is_ipv4 ? chunk_size : OGS_IPV6_128_PREFIX_LEN;
-    struct upf_route_trie_node **trie =
-        is_ipv4 ? &self.ipv4_framed_routes : &self.ipv6_framed_routes;
-
-    struct upf_route_trie_node **to_free_tries[OGS_IPV6_128_PREFIX_LEN + 1];
-    int free_from = 0;
-    int i = 0;
+    int i, len = 0;
+    int n = route->family == AF_INET ? 1 : 4;
 
-    for (i = 0; i <= nbits; i++) {
-        int part = i / chunk_size;
-        int bit = (nbits - i - 1) % chunk_size;
+    for (i = 0; i < n; i++) {
+        uint32_t mask = be32toh(route->mask[i]);
 
-        if (!*trie)
-            break;
-        to_free_tries[i] = trie;
-
-        if (i == nbits ||
-            ((1 << bit) & be32toh(route->mask[part])) == 0) {
-            (*trie)->sess = NULL;
-            if ((*trie)->left || (*trie)->right)
-                free_from = i + 1;
-            i++;
-            break;
-        }
-
-        if ((1 << bit) & be32toh(route->sub[part])) {
-            if ((*trie)->left || (*trie)->sess)
-                free_from = i + 1;
-            trie = &(*trie)->right;
-        } else {
-            if ((*trie)->right || (*trie)->sess)
-                free_from = i + 1;
-            trie = &(*trie)->left;
+        while (mask & 0x80000000) {
+            mask <<= 1;
+            len++;
         }
+        if (len != (i + 1) * 32)
+            break;
     }
 
-    for (i = i - 1; i >= free_from; i--) {
-        trie = to_free_tries[i];
-        ogs_free(*trie);
-        *trie = NULL;
-    }
+    return len;
 }
 
-static void add_framed_route_to_trie(ogs_ipsubnet_t *route, upf_sess_t *sess)
+static void free_framed_route(ogs_ipsubnet_t *route, upf_sess_t *sess)
 {
-    const int chunk_size = sizeof(route->sub[0]) << 3;
-    const int is_ipv4 = route->family == AF_INET;
-    const int nbits = is_ipv4 ? chunk_size : OGS_IPV6_128_PREFIX_LEN;
-    struct upf_route_trie_node **trie =
-        is_ipv4 ? &self.ipv4_framed_routes : &self.ipv6_framed_routes;
-    int i = 0;
-
-    for (i = 0; i <= nbits; i++) {
-        int part = i / chunk_size;
-        int bit = (nbits - i - 1) % chunk_size;
-
-        if (!*trie)
-            *trie = ogs_calloc(1, sizeof(**trie));
-
-        if (i == nbits ||
-            ((1 << bit) & be32toh(route->mask[part])) == 0) {
-            (*trie)->sess = sess;
-            break;
-        }
+    ue_ip_route_del(
+            route->family == AF_INET ? self.ipv4_lpm : self.ipv6_lpm,
+            route->sub, framed_route_prefixlen(route), sess);
+}
 
-        if ((1 << bit) & be32toh(route->sub[part])) {
-            trie = &(*trie)->right;
-        } else {
-            trie = &(*trie)->left;
-        }
-    }
+static void add_framed_route(ogs_ipsubnet_t *route, upf_sess_t *sess)
+{
+    ue_ip_route_add(
+            route->family == AF_INET ? self.ipv4_lpm : self.ipv6_lpm,
+            route->sub, framed_route_prefixlen(route), sess);
 }
 
 static int parse_framed_route(ogs_ipsubnet_t *subnet, const char *framed_route)
@@ -603,7 +568,7 @@ uint8_t upf_sess_set_ue_ipv4_framed_routes(upf_sess_t *sess,
     for (i = 0; i < OGS_MAX_NUM_OF_FRAMED_ROUTES_IN_PDI; i++) {
         if (!sess->ipv4_framed_routes || !sess->ipv4_framed_routes[i].family)
             break;
-        free_framed_route_from_trie(&sess->ipv4_framed_routes[i]);
+        free_framed_route(&sess->ipv4_framed_routes[i], sess);
         memset(&sess->ipv4_framed_routes[i], 0,
                sizeof(sess->ipv4_framed_routes[i]));
     }
@@ -626,7 +591,7 @@ uint8_t upf_sess_set_ue_ipv4_framed_routes(upf_sess_t *sess,
                    sizeof(sess->ipv4_framed_routes[j]));
             continue;
         }
-        add_framed_route_to_trie(&sess->ipv4_framed_routes[j], sess);
+        add_framed_route(&sess->ipv4_framed_routes[j], sess);
         j++;
     }
     if (j == 0 && sess->ipv4_framed_routes) {
@@ -648,7 +613,7 @@ uint8_t upf_sess_set_ue_ipv6_framed_routes(upf_sess_t *sess,
     for (i = 0; i < OGS_MAX_NUM_OF_FRAMED_ROUTES_IN_PDI; i++) {
         if (!sess->ipv6_framed_routes || !sess->ipv6_framed_routes[i].family)
             break;
-        free_framed_route_from_trie(&sess->ipv6_framed_routes[i]);
+        free_framed_route(&sess->ipv6_framed_routes[i], sess);
     }
 
     for (i = 0, j = 0; i < OGS_MAX_NUM_OF_FRAMED_ROUTES_IN_PDI; i++) {
@@ -669,7 +634,7 @@ uint8_t upf_sess_set_ue_ipv6_framed_routes(upf_sess_t *sess,
                    sizeof(sess->ipv6_framed_routes[j]));
             continue;
         }
-        add_framed_route_to_trie(&sess->ipv6_framed_routes[j], sess);
+        add_framed_route(&sess->ipv6_framed_routes[j], sess);
         j++;
     }
     if (j == 0 && sess->ipv6_framed_routes) {
@@ -680,43 +645,353 @@ uint8_t upf_sess_set_ue_ipv6_framed_routes(upf_sess_t *sess,
     return cause_value;
 }
 
-void upf_sess_urr_acc_add(upf_sess_t *sess, ogs_pfcp_urr_t *urr, size_t size, bool is_uplink)
+static void dispatch_clear(upf_sess_dispatch_t *d)
+{
+    ogs_assert(d);
+
+    if (d->cls)
+        ogs_pfcp_classifier_free(d->cls);
+    d->cls = NULL;
+    d->pdr = NULL;
+    d->no_sdf = NULL;
+}
+
+static void dispatch_set(upf_sess_dispatch_t *d,
+        ogs_pfcp_pdr_t **pdr, int num_of_pdr)
+{
+    int i;
+
+    ogs_assert(d);
+
+    if (num_of_pdr == 0)
+        return;
+
+    /* Check if Rule List in PDR */
+    if (ogs_list_first(&pdr[0]->rule_list) == NULL) {
+        d->pdr = pdr[0];
+        return;
+    }
+
+    d->cls = ogs_pfcp_classifier_build(pdr, num_of_pdr);
+    ogs_assert(d->cls);
+
+    /* No SDF filter can match a packet that is not parsed */
+    for (i = 0; i < num_of_pdr; i++) {
+        if (ogs_list_first(&pdr[i]->rule_list) == NULL) {
+            d->no_sdf = pdr[i];
+            break;
+        }
+    }
+}
+
+static ogs_pfcp_pdr_t *dispatch_find(
+        upf_sess_dispatch_t *d, ogs_pkbuf_t *pkbuf)
+{
+    ogs_pfcp_packet_info_t info;
+
+    ogs_assert(d);
+    ogs_assert(pkbuf);
+
+    if (d->pdr)
+        return d->pdr;
+    if (!d->cls)
+        return NULL;
+
+    if (ogs_pfcp_packet_info_parse(&info, pkbuf) != OGS_OK)
+        return d->no_sdf;
+
+    return ogs_pfcp_classifier_find(d->cls, &info, NULL, NULL);
+}
+
+#define DISPATCH_KEY(__tEID, __qFI) (((uint64_t)(__tEID) << 8) | (__qFI))
+
+void upf_sess_dispatch_build(upf_sess_t *sess)
+{
+    ogs_pfcp_pdr_t *pdr = NULL;
+    ogs_pfcp_far_t *far = NULL;
+    ogs_pfcp_pdr_t *ul[OGS_MAX_NUM_OF_PDR], *dl[OGS_MAX_NUM_OF_PDR];
+    ogs_pfcp_pdr_t *candidate[OGS_MAX_NUM_OF_PDR];
+    int num_of_ul = 0, num_of_dl = 0, num_of_candidate;
+    int i, j, k;
+
+    ogs_assert(sess);
+
+    if (!sess->dispatch.ul_hash)
+        sess->dispatch.ul_hash = ogs_hash_make();
+    ogs_assert(sess->dispatch.ul_hash);
+
+    ogs_hash_clear(sess->dispatch.ul_hash);
+    for (i = 0; i < sess->dispatch.num_of_ul; i++)
+        dispatch_clear(&sess->dispatch.ul[i]);
+    sess->dispatch.num_of_ul = 0;
+    dispatch_clear(&sess->dispatch.dl);
+    sess->dispatch.dl_fallback = NULL;
+
+    /* Keep the PDR precedence order of pdr_list */
+    ogs_list_for_each(&sess->pfcp.pdr_list, pdr) {
+        far = pdr->far;
+
+        if (pdr->src_if == OGS_PFCP_INTERFACE_ACCESS ||
+            pdr->src_if == OGS_PFCP_INTERFACE_CP_FUNCTION) {
+            ogs_assert(num_of_ul < OGS_MAX_NUM_OF_PDR);
+            ul[num_of_ul++] = pdr;
+
+        } else if (pdr->src_if == OGS_PFCP_INTERFACE_CORE) {
+            sess->dispatch.dl_fallback = pdr;
+
+            /* Downlink FAR with Outer header creation */
+            if (!far || far->dst_if != OGS_PFCP_INTERFACE_ACCESS)
+                continue;
+            if (far->outer_header_creation.ip4 == 0 &&
+                far->outer_header_creation.ip6 == 0 &&
+                far->outer_header_creation.udp4 == 0 &&
+                far->outer_header_creation.udp6 == 0 &&
+                far->outer_header_creation.gtpu4 == 0 &&
+                far->outer_header_creation.gtpu6 == 0)
+                continue;
+
+            ogs_assert(num_of_dl < OGS_MAX_NUM_OF_PDR);
+            dl[num_of_dl++] = pdr;
+        }
+    }
+
+    /*
+     * Uplink : one entry for each TEID/QFI of the PDRs, and one entry
+     * for each TEID with QFI 0 that holds the PDRs without QFI.
+     */
+    for (i = 0; i < num_of_ul; i++) {
+        uint8_t qfi[2] = { ul[i]->qfi, 0 };
+
+        for (j = 0; j < 2; j++) {
+            upf_sess_dispatch_t *d = NULL;
+            uint64_t key = DISPATCH_KEY(ul[i]->f_teid.teid, qfi[j]);
+
+            if (ogs_hash_get(sess->dispatch.ul_hash, &key, sizeof(key)))
+                continue;
+
+            num_of_candidate = 0;
+            for (k = 0; k < num_of_ul; k++) {
+                /* Check if TEID */
+                if (ul[k]->f_teid.teid != ul[i]->f_teid.teid)
+                    continue;
+
+                /* Check if QFI */
+                if (ul[k]->qfi && ul[k]->qfi != qfi[j])
+                    continue;
+
+                candidate[num_of_candidate++] = ul[k];
+            }
+
+            ogs_assert(sess->dispatch.num_of_ul < OGS_MAX_NUM_OF_PDR*2);
+            d = &sess->dispatch.ul[sess->dispatch.num_of_ul++];
+            d->key = key;
+            dispatch_set(d, candidate, num_of_candidate);
+
+            ogs_hash_set(sess->dispatch.ul_hash, &d->key, sizeof(d->key), d);
+        }
+    }
+
+    dispatch_set(&sess->dispatch.dl, dl, num_of_dl);
+}
+
+ogs_pfcp_pdr_t *upf_sess_dispatch_uplink(upf_sess_t *sess,
+        uint32_t teid, uint8_t qfi, ogs_pkbuf_t *pkbuf)
+{
+    upf_sess_dispatch_t *d = NULL;
+    uint64_t key;
+
+    ogs_assert(sess);
+    ogs_assert(pkbuf);
+
+    key = DISPATCH_KEY(teid, qfi);
+    d = ogs_hash_get(sess->dispatch.ul_hash, &key, sizeof(key));
+    if (!d && qfi) {
+        /* PDRs without QFI */
+        key = DISPATCH_KEY(teid, 0);
+        d = ogs_hash_get(sess->dispatch.ul_hash, &key, sizeof(key));
+    }
+    if (!d)
+        return NULL;
+
+    return dispatch_find(d, pkbuf);
+}
+
+ogs_pfcp_pdr_t *upf_sess_dispatch_downlink(
+        upf_sess_t *sess, ogs_pkbuf_t *pkbuf)
+{
+    ogs_pfcp_pdr_t *pdr = NULL;
+
+    ogs_assert(sess);
+    ogs_assert(pkbuf);
+
+    pdr = dispatch_find(&sess->dispatch.dl, pkbuf);
+    if (!pdr)
+        pdr = sess->dispatch.dl_fallback;
+
+    return pdr;
+}
+
+/*
+ * Direction of a packet received on GTP-U : from the access side (N3)
+ * is uplink, from the core side (N9 at an I-UPF) is downlink.
+ */
+bool upf_sess_pdr_is_uplink(ogs_pfcp_pdr_t *pdr)
+{
+    ogs_assert(pdr);
+
+    return pdr->src_if != OGS_PFCP_INTERFACE_CORE;
+}
+
+/*
+ * QER enforcement : returns false if the packet must be dropped.
+ * NOW is the time cached by the caller for the whole receive batch,
+ * DP the counters of the calling thread.
+ */
+bool upf_sess_qer_police(ogs_pfcp_pdr_t *pdr,
+        size_t size, bool is_uplink, ogs_time_t now, upf_metrics_dp_t *dp)
+{
+    ogs_pfcp_qer_t *qer = NULL;
+    uint64_t rate, depth, elapsed, credit;
+    int dir = is_uplink ? 0 : 1;
+
+    ogs_assert(pdr);
+
+    qer = pdr->qer;
+    if (!qer)
+        return true;
+
+    if ((is_uplink ? qer->gate_status.uplink : qer->gate_status.downlink) ==
+            OGS_PFCP_GATE_CLOSE) {
+        upf_metrics_dp_by_qfi_add(dp, qer->qfi,
+                UPF_METR_CTR_QER_GATEDROPPKT, 1);
+        return false;
+    }
+
+    rate = is_uplink ? qer->mbr.uplink : qer->mbr.downlink;
+    if (!rate)
+        return true;
+
+    /* Bytes per second */
+    rate >>= 3;
+    depth = ogs_max(rate * UPF_QER_BURST_TIME / OGS_USEC_PER_SEC,
+                    OGS_MAX_PKT_LEN);
+
+    /*
+     * Closely spaced packets of a low bitrate flow earn less than
+     * a byte each. The fraction is carried over to the next packet
+     * so that the flow is still refilled at the configured rate.
+     */
+    elapsed = now - qer->bucket[dir].time;
+    if (!qer->bucket[dir].time || elapsed >= UPF_QER_BURST_TIME) {
+        qer->bucket[dir].tokens = depth;
+        qer->bucket[dir].remainder = 0;
+    } else {
+        credit = rate * elapsed + qer->bucket[dir].remainder;
+        qer->bucket[dir].tokens += credit / OGS_USEC_PER_SEC;
+        qer->bucket[dir].remainder = credit % OGS_USEC_PER_SEC;
+        if (qer->bucket[dir].tokens >= depth) {
+            qer->bucket[dir].tokens = depth;
+            qer->bucket[dir].remainder = 0;
+        }
+    }
+    qer->bucket[dir].time = now;
+
+    if (qer->bucket[dir].tokens < size) {
+        upf_metrics_dp_by_qfi_add(dp, qer->qfi,
+                UPF_METR_CTR_QER_MBRDROPPKT, 1);
+        return false;
+    }
+    qer->bucket[dir].tokens -= size;
+
+    return true;
+}
+
+static bool urr_acc_volume_reached(
+        upf_sess_t *sess, ogs_pfcp_urr_t *urr)
 {
-    upf_sess_urr_acc_t *urr_acc = NULL;
     uint64_t vol;
 
+    vol = sess->urr_counter[urr->id-1].total_octets -
+        sess->urr_acc[urr->id-1].last_report.total_octets;
+
+    return (urr->rep_triggers.volume_quota && urr->vol_quota.tovol &&
+            vol >= urr->vol_quota.total_volume) ||
+        (urr->rep_triggers.volume_threshold && urr->vol_threshold.tovol &&
+            vol >= urr->vol_threshold.total_volume);
+}
+
+/*
+ * Called for every packet : only the counters are updated here.
+ * 'now' is taken once per receive event. A URR with a volume trigger
+ * is queued and checked by upf_sess_urr_acc_check_all()
+ * when the receive event is done.
+ */
+void upf_sess_urr_acc_add(upf_sess_t *sess, ogs_pfcp_urr_t *urr,
+        size_t size, bool is_uplink, ogs_time_t now)
+{
+    upf_sess_urr_counter_t *counter = NULL;
+    upf_sess_urr_acc_t *urr_acc = NULL;
+
     ogs_assert(urr->id > 0 && urr->id <= OGS_MAX_NUM_OF_URR);
-    urr_acc = &sess->urr_acc[urr->id-1];
+    counter = &sess->urr_counter[urr->id-1];
 
     /* Increment total & ul octets + pkts */
-    urr_acc->total_octets += size;
-    urr_acc->total_pkts++;
+    counter->total_octets += size;
+    counter->total_pkts++;
     if (is_uplink) {
-        urr_acc->ul_octets += size;
-        urr_acc->ul_pkts++;
+        counter->ul_octets += size;
+        counter->ul_pkts++;
     } else {
-        urr_acc->dl_octets += size;
-        urr_acc->dl_pkts++;
+        counter->dl_octets += size;
+        counter->dl_pkts++;
     }
 
-    urr_acc->time_of_last_packet = ogs_time_now();
-    if (urr_acc->time_of_first_packet == 0)
-        urr_acc->time_of_first_packet = urr_acc->time_of_last_packet;
+    counter->time_of_last_packet = now;
+    if (counter->time_of_first_packet == 0)
+        counter->time_of_first_packet = now;
 
-    /* generate report if volume threshold/quota is reached */
-    vol = urr_acc->total_octets - urr_acc->last_report.total_octets;
-    if ((urr->rep_triggers.volume_quota && urr->vol_quota.tovol && vol >= urr->vol_quota.total_volume) ||
-        (urr->rep_triggers.volume_threshold && urr->vol_threshold.tovol && vol >= urr->vol_threshold.total_volume)) {
-        ogs_pfcp_user_plane_report_t report;
-        memset(&report, 0, sizeof(report));
-        upf_sess_urr_acc_fill_usage_report(sess, urr, &report, 0);
-        report.num_of_usage_report = 1;
-        upf_sess_urr_acc_snapshot(sess, urr);
+    if (!urr->rep_triggers.volume_quota && !urr->rep_triggers.volume_threshold)
+        return;
 
-        ogs_assert(OGS_OK ==
-            upf_pfcp_send_session_report_request(sess, &report));
-        /* Start new report period/iteration: */
-        upf_sess_urr_acc_timers_setup(sess, urr);
+    urr_acc = &sess->urr_acc[urr->id-1];
+    if (!urr_acc->check.urr) {
+        urr_acc->check.urr = urr;
+        ogs_list_add(&urr_check_list, &urr_acc->check);
+    }
+}
+
+void upf_sess_urr_acc_check_all(void)
+{
+    upf_sess_urr_acc_t *urr_acc = NULL;
+    ogs_lnode_t *lnode = NULL;
+
+    while ((lnode = ogs_list_first(&urr_check_list))) {
+        ogs_pfcp_urr_t *urr = NULL;
+        upf_sess_t *sess = NULL;
+
+        urr_acc = ogs_container_of(lnode, upf_sess_urr_acc_t, check.lnode);
+        ogs_list_remove(&urr_check_list, lnode);
+
+        urr = urr_acc->check.urr;
+        ogs_assert(urr);
+        urr_acc->check.urr = NULL;
+
+        sess = UPF_SESS(urr->sess);
+        ogs_assert(sess);
+
+        /* generate report if volume threshold/quota is reached */
+        if (urr_acc_volume_reached(sess, urr)) {
+            ogs_pfcp_user_plane_report_t report;
+            memset(&report, 0, sizeof(report));
+            upf_sess_urr_acc_fill_usage_report(sess, urr, &report, 0);
+            report.num_of_usage_report = 1;
+            upf_sess_urr_acc_snapshot(sess, urr);
+
+            ogs_assert(OGS_OK ==
+                upf_pfcp_send_session_report_request(sess, &report));
+            /* Start new report period/iteration: */
+            upf_sess_urr_acc_timers_setup(sess, urr);
+        }
     }
 }
 
@@ -725,11 +1000,13 @@ void upf_sess_urr_acc_add(upf_sess_t *sess, ogs_pfcp_urr_t *urr, size_t size, bo
 void upf_sess_urr_acc_fill_usage_report(upf_sess_t *sess, const ogs_pfcp_urr_t *urr,
                                   ogs_pfcp_user_plane_report_t *report, unsigned int idx)
 {
+    upf_sess_urr_counter_t *counter = NULL;
     upf_sess_urr_acc_t *urr_acc = NULL;
     ogs_time_t last_report_timestamp;
     ogs_time_t now;
 
     ogs_assert(urr->id > 0 && urr->id <= OGS_MAX_NUM_OF_URR);
+    counter = &sess->urr_counter[urr->id-1];
     urr_acc = &sess->urr_acc[urr->id-1];
 
     now = ogs_time_now(); /* we need UTC for start_time and end_time */
@@ -751,18 +1028,18 @@ void upf_sess_urr_acc_fill_usage_report(upf_sess_t *sess, const ogs_pfcp_urr_t *
         .dlvol = 1,
         .ulvol = 1,
         .tovol = 1,
-        .total_volume = urr_acc->total_octets - urr_acc->last_report.total_octets,
-        .uplink_volume = urr_acc->ul_octets - urr_acc->last_report.ul_octets,
-        .downlink_volume = urr_acc->dl_octets - urr_acc->last_report.dl_octets,
-        .total_n_packets = urr_acc->total_pkts - urr_acc->last_report.total_pkts,
-        .uplink_n_packets = urr_acc->ul_pkts - urr_acc->last_report.ul_pkts,
-        .downlink_n_packets = urr_acc->dl_pkts - urr_acc->last_report.dl_pkts,
+        .total_volume = counter->total_octets - urr_acc->last_report.total_octets,
+        .uplink_volume = counter->ul_octets - urr_acc->last_report.ul_octets,
+        .downlink_volume = counter->dl_octets - urr_acc->last_report.dl_octets,
+        .total_n_packets = counter->total_pkts - urr_acc->last_report.total_pkts,
+        .uplink_n_packets = counter->ul_pkts - urr_acc->last_report.ul_pkts,
+        .downlink_n_packets = counter->dl_pkts - urr_acc->last_report.dl_pkts,
     };
     if (now >= last_report_timestamp)
         report->usage_report[idx].dur_measurement = ((now - last_report_timestamp) + (OGS_USEC_PER_SEC/2)) / OGS_USEC_PER_SEC; /* FIXME: should use MONOTONIC here */
     /* else memset sets it to 0 */
-    report->usage_report[idx].time_of_first_packet = ogs_time_to_ntp32(urr_acc->time_of_first_packet); /* TODO: First since last report? */
-    report->usage_report[idx].time_of_last_packet = ogs_time_to_ntp32(urr_acc->time_of_last_packet);
+    report->usage_report[idx].time_of_first_packet = ogs_time_to_ntp32(counter->time_of_first_packet); /* TODO: First since last report? */
+    report->usage_report[idx].time_of_last_packet = ogs_time_to_ntp32(counter->time_of_last_packet);
 
     /* Time triggers: */
     if (urr->quota_validity_time > 0 &&
@@ -786,17 +1063,19 @@ void upf_sess_urr_acc_fill_usage_report(upf_sess_t *sess, const ogs_pfcp_urr_t *
 
 void upf_sess_urr_acc_snapshot(upf_sess_t *sess, ogs_pfcp_urr_t *urr)
 {
+    upf_sess_urr_counter_t *counter = NULL;
     upf_sess_urr_acc_t *urr_acc = NULL;
 
     ogs_assert(urr->id > 0 && urr->id <= OGS_MAX_NUM_OF_URR);
+    counter = &sess->urr_counter[urr->id-1];
     urr_acc = &sess->urr_acc[urr->id-1];
 
-    urr_acc->last_report.total_octets = urr_acc->total_octets;
-    urr_acc->last_report.dl_octets = urr_acc->dl_octets;
-    urr_acc->last_report.ul_octets = urr_acc->ul_octets;
-    urr_acc->last_report.total_pkts = urr_acc->total_pkts;
-    urr_acc->last_report.dl_pkts = urr_acc->dl_pkts;
-    urr_acc->last_report.ul_pkts = urr_acc->ul_pkts;
+    urr_acc->last_report.total_octets = counter->total_octets;
+    urr_acc->last_report.dl_octets = counter->dl_octets;
+    urr_acc->last_report.ul_octets = counter->ul_octets;
+    urr_acc->last_report.total_pkts = counter->total_pkts;
+    urr_acc->last_report.dl_pkts = counter->dl_pkts;
+    urr_acc->last_report.ul_pkts = counter->ul_pkts;
     urr_acc->last_report.timestamp = ogs_time_now();
 }
 
@@ -891,6 +1170,10 @@ static void upf_sess_urr_acc_remove_all(upf_sess_t *sess)
 {
     unsigned int i;
     for (i = 0; i < OGS_ARRAY_SIZE(sess->urr_acc); i++) {
+        if (sess->urr_acc[i].check.urr) {
+            ogs_list_remove(&urr_check_list, &sess->urr_acc[i].check);
+            sess->urr_acc[i].check.urr = NULL;
+        }
         if (sess->urr_acc[i].t_time_threshold) {
             ogs_timer_delete(sess->urr_acc[i].t_time_threshold);
             sess->urr_acc[i].t_time_threshold = NULL;
@@ -45,38 +45,25 @@ extern int __upf_log_domain;
 #undef OGS_LOG_DOMAIN
 #define OGS_LOG_DOMAIN __upf_log_domain
 
-struct upf_route_trie_node;
-
 typedef struct upf_context_s {
     ogs_hash_t *upf_n4_seid_hash;   /* hash table (UPF-N4-SEID) */
     ogs_hash_t *smf_n4_seid_hash;   /* hash table (SMF-N4-SEID) */
     ogs_hash_t *smf_n4_f_seid_hash; /* hash table (SMF-N4-F-SEID) */
-    ogs_hash_t *ipv4_hash;  /* hash table (IPv4 Address) */
-    ogs_hash_t *ipv6_hash;  /* hash table (IPv6 Address) */
-
-    /* IPv4 framed routes trie */
-    struct upf_route_trie_node *ipv4_framed_routes;
-    /* IPv6 framed routes trie */
-    struct upf_route_trie_node *ipv6_framed_routes;
+    /* Longest prefix match of UE IP Address and framed routes */
+    ogs_lpm_t *ipv4_lpm;
+    ogs_lpm_t *ipv6_lpm;
 
     ogs_list_t sess_list;
 } upf_context_t;
 
-/* trie mapping from IP framed routes to session. */
-struct upf_route_trie_node {
-    struct upf_route_trie_node *left;
-    struct upf_route_trie_node *right;
-    upf_sess_t *sess;
-};
-
-/* Accounting: */
-typedef struct upf_sess_urr_acc_s {
-    bool reporting_enabled;
-    ogs_timer_t *t_validity_time; /* Quota Validity Time expiration handler */
-    ogs_timer_t *t_time_quota; /* Time Quota expiration handler */
-    ogs_timer_t *t_time_threshold; /* Time Threshold expiration handler */
-    uint32_t time_start; /* When t_time_* started */
-    ogs_pfcp_urr_ur_seqn_t report_seqn; /* Next seqn to use when reporting */
+/*
+ * Accounting:
+ *
+ * The counters updated for every packet are kept apart from the
+ * report state, one cache line per URR. The session pool is page
+ * aligned, so that every upf_sess_t starts on a cache line as well.
+ */
+typedef struct upf_sess_urr_counter_s {
     uint64_t total_octets;
     uint64_t ul_octets;
     uint64_t dl_octets;
@@ -85,6 +72,24 @@ typedef struct upf_sess_urr_acc_s {
     uint64_t dl_pkts;
     ogs_time_t time_of_first_packet;
     ogs_time_t time_of_last_packet;
+} __attribute__ ((aligned (64))) upf_sess_urr_counter_t;
+
+OGS_STATIC_ASSERT(sizeof(upf_sess_urr_counter_t) == 64 &&
+        __alignof__(upf_sess_urr_counter_t) == 64);
+
+typedef struct upf_sess_urr_acc_s {
+    /* Queued for the volume check at the end of the receive event */
+    struct {
+        ogs_lnode_t lnode;
+        ogs_pfcp_urr_t *urr;
+    } check;
+
+    bool reporting_enabled;
+    ogs_timer_t *t_validity_time; /* Quota Validity Time expiration handler */
+    ogs_timer_t *t_time_quota; /* Time Quota expiration handler */
+    ogs_timer_t *t_time_threshold; /* Time Threshold expiration handler */
+    uint32_t time_start; /* When t_time_* started */
+    ogs_pfcp_urr_ur_seqn_t report_seqn; /* Next seqn to use when reporting */
     /* Snapshot of measurement when last report was sent: */
     struct {
         uint64_t total_octets;
@@ -98,6 +103,20 @@ typedef struct upf_sess_urr_acc_s {
 } upf_sess_urr_acc_t;
 
 #define UPF_SESS(pfcp_sess) ogs_container_of(pfcp_sess, upf_sess_t, pfcp)
+
+/* Depth of the QER MBR token bucket, in time at the maximum bitrate */
+#define UPF_QER_BURST_TIME ogs_time_from_msec(100)
+/*
+ * PDRs that may match a packet, in precedence order. If the first one
+ * has no SDF filter, it is the match and the packet is not parsed.
+ */
+typedef struct upf_sess_dispatch_s {
+    uint64_t key;                   /* TEID << 8 | QFI (Uplink only) */
+    ogs_pfcp_pdr_t *pdr;            /* First PDR without SDF filter */
+    ogs_pfcp_classifier_t *cls;     /* Otherwise, SDF classifier */
+    ogs_pfcp_pdr_t *no_sdf;         /* Match of an unparsable packet */
+} upf_sess_dispatch_t;
+
 typedef struct upf_sess_s {
     ogs_lnode_t     lnode;
     ogs_pool_id_t   id;
@@ -121,7 +140,17 @@ typedef struct upf_sess_s {
     char            *gx_sid;            /* Gx Session ID */
     ogs_pfcp_node_t *pfcp_node;
 
+    /* PDR dispatch, rebuilt on PFCP establishment/modification */
+    struct {
+        ogs_hash_t *ul_hash;            /* hash table (TEID/QFI) */
+        int num_of_ul;
+        upf_sess_dispatch_t ul[OGS_MAX_NUM_OF_PDR*2];
+        upf_sess_dispatch_t dl;
+        ogs_pfcp_pdr_t *dl_fallback;    /* Lowest precedence downlink PDR */
+    } dispatch;
+
     /* Accounting: */
+    upf_sess_urr_counter_t urr_counter[OGS_MAX_NUM_OF_URR];
     upf_sess_urr_acc_t urr_acc[OGS_MAX_NUM_OF_URR]; /* FIXME: This probably needs to be mved to a hashtable or alike */
     char            *apn_dnn;            /* APN/DNN Item */
 } upf_sess_t;
@@ -130,9 +159,18 @@ void upf_context_init(void);
 void upf_context_final(void);
 upf_context_t *upf_self(void);
 
+typedef struct upf_pool_stat_s {
+    int sess_peak;          /* Most sessions in use at once */
+    int pdr_peak;           /* Most PDRs in use at once */
+    size_t committed;       /* Bytes backed by memory in the chunked pools */
+} upf_pool_stat_t;
+
+int upf_pool_trim(void);
+void upf_pool_stat(upf_pool_stat_t *stat);
+
 int upf_context_parse_config(void);
 
-upf_sess_t *upf_sess_add_by_message(ogs_pfcp_message_t *message);
+upf_sess_t *upf_sess_add_by_ie_index(ogs_pfcp_ie_index_t *index);
 
 upf_sess_t *upf_sess_add(ogs_pfcp_f_seid_t *f_seid);
 int upf_sess_remove(upf_sess_t *sess);
@@ -151,7 +189,19 @@ uint8_t upf_sess_set_ue_ipv4_framed_routes(upf_sess_t *sess,
 uint8_t upf_sess_set_ue_ipv6_framed_routes(upf_sess_t *sess,
         char *framed_routes[]);
 
-void upf_sess_urr_acc_add(upf_sess_t *sess, ogs_pfcp_urr_t *urr, size_t size, bool is_uplink);
+void upf_sess_dispatch_build(upf_sess_t *sess);
+ogs_pfcp_pdr_t *upf_sess_dispatch_uplink(upf_sess_t *sess,
+        uint32_t teid, uint8_t qfi, ogs_pkbuf_t *pkbuf);
+ogs_pfcp_pdr_t *upf_sess_dispatch_downlink(
+        upf_sess_t *sess, ogs_pkbuf_t *pkbuf);
+
+bool upf_sess_pdr_is_uplink(ogs_pfcp_pdr_t *pdr);
+bool upf_sess_qer_police(ogs_pfcp_pdr_t *pdr,
+        size_t size, bool is_uplink, ogs_time_t now, upf_metrics_dp_t *dp);
+
+void upf_sess_urr_acc_add(upf_sess_t *sess, ogs_pfcp_urr_t *urr,
+        size_t size, bool is_uplink, ogs_time_t now);
+void upf_sess_urr_acc_check_all(void);
 void upf_sess_urr_acc_fill_usage_report(upf_sess_t *sess, const ogs_pfcp_urr_t *urr,
                                         ogs_pfcp_user_plane_report_t *report, unsigned int idx);
 void upf_sess_urr_acc_snapshot(upf_sess_t *sess, ogs_pfcp_urr_t *urr);
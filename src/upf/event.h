@@ -28,7 +28,7 @@ extern "C" {
 
 typedef struct ogs_pfcp_node_s ogs_pfcp_node_t;
 typedef struct ogs_pfcp_xact_s ogs_pfcp_xact_t;
-typedef struct ogs_pfcp_message_s ogs_pfcp_message_t;
+typedef struct ogs_pfcp_ie_index_s ogs_pfcp_ie_index_t;
 typedef struct upf_sess_s upf_sess_t;
 
 typedef enum {
@@ -37,6 +37,7 @@ typedef enum {
     UPF_EVT_N4_MESSAGE,
     UPF_EVT_N4_TIMER,
     UPF_EVT_N4_NO_HEARTBEAT,
+    UPF_EVT_POOL_TIMER,
 
     UPF_EVT_TOP,
 
@@ -50,7 +51,7 @@ typedef struct upf_event_s {
 
     ogs_pfcp_node_t *pfcp_node;
     ogs_pool_id_t pfcp_xact_id;
-    ogs_pfcp_message_t *pfcp_message;
+    ogs_pfcp_ie_index_t *pfcp_index;
 } upf_event_t;
 
 OGS_STATIC_ASSERT(OGS_EVENT_SIZE >= sizeof(upf_event_t));
@@ -59,7 +59,18 @@ const uint8_t proxy_mac_addr[] = { 0x0e, 0x00, 0x00, 0x00, 0x00, 0x01 };
 
 static ogs_pkbuf_pool_t *packet_pool = NULL;
 
-static void upf_gtp_handle_multicast(ogs_pkbuf_t *recvbuf);
+/* Receive buffers of gtpu.batch, kept across calls until consumed */
+static ogs_pkbuf_t *rx_batch[OGS_GTPU_MAX_BATCH];
+static ogs_sockaddr_t rx_from[OGS_GTPU_MAX_BATCH];
+
+/* Time of the current receive batch, shared by all its packets */
+static ogs_time_t rx_time;
+static ogs_time_t rx_now;           /* UTC, for URR accounting */
+
+/* Counters of this forwarding thread, see metrics.h */
+static upf_metrics_dp_t *dp_metrics;
+
+static bool upf_gtp_handle_multicast(ogs_pkbuf_t *recvbuf);
 
 static int check_framed_routes(upf_sess_t *sess, int family, uint32_t *addr)
 {
@@ -99,60 +110,52 @@ static uint16_t _get_eth_type(uint8_t *data, uint len) {
     return 0;
 }
 
-static void _gtpv1_tun_recv_common_cb(
-        short when, ogs_socket_t fd, bool has_eth, void *data)
+static void upf_gtp_handle_tun_packet(
+        ogs_socket_t fd, bool has_eth, ogs_pkbuf_t *recvbuf)
 {
-    ogs_pkbuf_t *recvbuf = NULL;
-
     upf_sess_t *sess = NULL;
     ogs_pfcp_pdr_t *pdr = NULL;
-    ogs_pfcp_pdr_t *fallback_pdr = NULL;
-    ogs_pfcp_far_t *far = NULL;
     ogs_pfcp_user_plane_report_t report;
     int i;
 
-    recvbuf = ogs_tun_read(fd, packet_pool);
-    if (!recvbuf) {
-        ogs_warn("ogs_tun_read() failed");
-        return;
-    }
-
     if (has_eth) {
-        ogs_pkbuf_t *replybuf = NULL;
         uint16_t eth_type = _get_eth_type(recvbuf->data, recvbuf->len);
-        uint8_t size;
+        bool reply = false;
+        uint8_t size = 0;
 
+        /*
+         * The request is parsed before the reply is serialized,
+         * so the reply is written over the request buffer.
+         */
         if (eth_type == ETHERTYPE_ARP) {
             if (is_arp_req(recvbuf->data, recvbuf->len) &&
                     upf_sess_find_by_ipv4(
                         arp_parse_target_addr(recvbuf->data, recvbuf->len))) {
-                replybuf = ogs_pkbuf_alloc(packet_pool, OGS_MAX_PKT_LEN);
-                ogs_assert(replybuf);
-                ogs_pkbuf_reserve(replybuf, OGS_TUN_MAX_HEADROOM);
-                ogs_pkbuf_put(replybuf, OGS_MAX_PKT_LEN-OGS_TUN_MAX_HEADROOM);
-                size = arp_reply(replybuf->data, recvbuf->data, recvbuf->len,
+                size = arp_reply(recvbuf->data, recvbuf->data, recvbuf->len,
                     proxy_mac_addr);
-                ogs_pkbuf_trim(replybuf, size);
                 ogs_info("[SEND] reply to ARP request: %u", size);
+                reply = true;
             } else {
                 goto cleanup;
             }
         } else if (eth_type == ETHERTYPE_IPV6 &&
                     is_nd_req(recvbuf->data, recvbuf->len)) {
-            replybuf = ogs_pkbuf_alloc(packet_pool, OGS_MAX_PKT_LEN);
-            ogs_assert(replybuf);
-            ogs_pkbuf_reserve(replybuf, OGS_TUN_MAX_HEADROOM);
-            ogs_pkbuf_put(replybuf, OGS_MAX_PKT_LEN-OGS_TUN_MAX_HEADROOM);
-            size = nd_reply(replybuf->data, recvbuf->data, recvbuf->len,
+            ogs_assert(ogs_pkbuf_tailroom(recvbuf) + recvbuf->len >=
+                    MAX_ND_SIZE);
+            size = nd_reply(recvbuf->data, recvbuf->data, recvbuf->len,
                 proxy_mac_addr);
-            ogs_pkbuf_trim(replybuf, size);
             ogs_info("[SEND] reply to ND solicit: %u", size);
+            reply = true;
         }
-        if (replybuf) {
-            if (ogs_tun_write(fd, replybuf) != OGS_OK)
+        if (reply) {
+            if (size > recvbuf->len)
+                ogs_pkbuf_put(recvbuf, size - recvbuf->len);
+            else
+                ogs_pkbuf_trim(recvbuf, size);
+
+            if (ogs_tun_write(fd, recvbuf) != OGS_OK)
                 ogs_warn("ogs_tun_write() for reply failed");
-            
-            ogs_pkbuf_free(replybuf);
+
             goto cleanup;
         }
         if (eth_type != ETHERTYPE_IP && eth_type != ETHERTYPE_IPV6) {
@@ -167,68 +170,37 @@ static void _gtpv1_tun_recv_common_cb(
     if (!sess)
         goto cleanup;
 
-    ogs_list_for_each(&sess->pfcp.pdr_list, pdr) {
-        far = pdr->far;
-        ogs_assert(far);
-
-        /* Check if PDR is Downlink */
-        if (pdr->src_if != OGS_PFCP_INTERFACE_CORE)
-            continue;
-
-        /* Save the Fallback PDR : Lowest precedence downlink PDR */
-        fallback_pdr = pdr;
-
-        /* Check if FAR is Downlink */
-        if (far->dst_if != OGS_PFCP_INTERFACE_ACCESS)
-            continue;
-
-        /* Check if Outer header creation */
-        if (far->outer_header_creation.ip4 == 0 &&
-            far->outer_header_creation.ip6 == 0 &&
-            far->outer_header_creation.udp4 == 0 &&
-            far->outer_header_creation.udp6 == 0 &&
-            far->outer_header_creation.gtpu4 == 0 &&
-            far->outer_header_creation.gtpu6 == 0)
-            continue;
-
-        /* Check if Rule List in PDR */
-        if (ogs_list_first(&pdr->rule_list) &&
-            ogs_pfcp_pdr_rule_find_by_packet(pdr, recvbuf) == NULL)
-            continue;
-
-        break;
-    }
-
-    if (!pdr)
-        pdr = fallback_pdr;
+    /*
+     * Downlink PDR with Outer header creation matching the packet,
+     * or the Fallback PDR : Lowest precedence downlink PDR
+     */
+    pdr = upf_sess_dispatch_downlink(sess, recvbuf);
 
     if (!pdr) {
-        if (ogs_global_conf()->parameter.multicast) {
-            upf_gtp_handle_multicast(recvbuf);
-        }
+        if (ogs_global_conf()->parameter.multicast &&
+            upf_gtp_handle_multicast(recvbuf) == true)
+            return;
         goto cleanup;
     }
 
+    if (upf_sess_qer_police(
+                pdr, recvbuf->len, false, rx_time, dp_metrics) == false)
+        goto cleanup;
+
     /* Increment total & dl octets + pkts */
     for (i = 0; i < pdr->num_of_urr; i++)
-        upf_sess_urr_acc_add(sess, pdr->urr[i], recvbuf->len, false);
+        upf_sess_urr_acc_add(sess, pdr->urr[i], recvbuf->len, false, rx_now);
+
+    if (pdr->far && (pdr->far->apply_action & OGS_PFCP_APPLY_ACTION_FORW)) {
+        upf_metrics_dp_global_inc(dp_metrics,
+                UPF_METR_GLOB_CTR_GTP_OUTDATAPKTN3UPF);
+        upf_metrics_dp_by_qfi_add(dp_metrics, pdr->qer ? pdr->qer->qfi : 0,
+                UPF_METR_CTR_GTP_OUTDATAVOLUMEQOSLEVELN3UPF, recvbuf->len);
+    }
 
     ogs_assert(true == ogs_pfcp_up_handle_pdr(
                 pdr, OGS_GTPU_MSGTYPE_GPDU, NULL, recvbuf, &report));
 
-    /*
-     * Issue #2210, Discussion #2208, #2209
-     *
-     * Metrics reduce data plane performance.
-     * It should not be used on the UPF/SGW-U data plane
-     * until this issue is resolved.
-     */
-#if 0
-    upf_metrics_inst_global_inc(UPF_METR_GLOB_CTR_GTP_OUTDATAPKTN3UPF);
-    upf_metrics_inst_by_qfi_add(pdr->qer->qfi,
-        UPF_METR_CTR_GTP_OUTDATAVOLUMEQOSLEVELN3UPF, recvbuf->len);
-#endif
-
     if (report.type.downlink_data_report) {
         ogs_assert(pdr->sess);
         sess = UPF_SESS(pdr->sess);
@@ -252,6 +224,47 @@ cleanup:
     ogs_pkbuf_free(recvbuf);
 }
 
+static void _gtpv1_tun_recv_common_cb(
+        short when, ogs_socket_t fd, bool has_eth, void *data)
+{
+    ogs_pkbuf_t *recvbuf = NULL;
+    int batch = ogs_gtp_self()->gtpu_batch.size;
+    int i, sent;
+
+    rx_time = ogs_get_monotonic_time();
+    rx_now = ogs_time_now();
+
+    if (batch <= 1) {
+        recvbuf = ogs_tun_read(fd, packet_pool);
+        if (!recvbuf) {
+            ogs_warn("ogs_tun_read() failed");
+            return;
+        }
+
+        upf_gtp_handle_tun_packet(fd, has_eth, recvbuf);
+        upf_sess_urr_acc_check_all();
+        return;
+    }
+
+    /*
+     * The TUN device is non-blocking in batch mode.
+     * Drain up to gtpu.batch packets and send the resulting
+     * GTP-U packets together.
+     */
+    ogs_gtp_send_batch_begin();
+    for (i = 0; i < batch; i++) {
+        recvbuf = ogs_tun_read(fd, packet_pool);
+        if (!recvbuf)
+            break;
+
+        upf_gtp_handle_tun_packet(fd, has_eth, recvbuf);
+    }
+    sent = ogs_gtp_send_batch_end();
+    if (sent)
+        upf_metrics_inst_global_add(UPF_METR_GLOB_HIST_GTP_TX_BATCH, sent);
+    upf_sess_urr_acc_check_all();
+}
+
 static void _gtpv1_tun_recv_cb(short when, ogs_socket_t fd, void *data)
 {
     _gtpv1_tun_recv_common_cb(when, fd, false, data);
@@ -262,41 +275,42 @@ static void _gtpv1_tun_recv_eth_cb(short when, ogs_socket_t fd, void *data)
     _gtpv1_tun_recv_common_cb(when, fd, true, data);
 }
 
-static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
+/* Packets of parameter.use_io_uring, completed by the pollset */
+static void _gtpv1_tun_recv_multi_cb(ogs_socket_t fd,
+        ogs_pkbuf_t **pkbuf, ogs_sockaddr_t *from, int num, void *data)
+{
+    ogs_pfcp_dev_t *dev = data;
+    int i, sent;
+
+    ogs_assert(dev);
+
+    rx_time = ogs_get_monotonic_time();
+    rx_now = ogs_time_now();
+
+    ogs_gtp_send_batch_begin();
+    for (i = 0; i < num; i++)
+        upf_gtp_handle_tun_packet(fd, dev->is_tap, pkbuf[i]);
+    sent = ogs_gtp_send_batch_end();
+    if (sent)
+        upf_metrics_inst_global_add(UPF_METR_GLOB_HIST_GTP_TX_BATCH, sent);
+    upf_sess_urr_acc_check_all();
+}
+
+static void upf_gtp_handle_gtpu_packet(
+        ogs_sock_t *sock, ogs_pkbuf_t *pkbuf, ogs_sockaddr_t *from)
 {
     int len;
-    ssize_t size;
     char buf1[OGS_ADDRSTRLEN];
     char buf2[OGS_ADDRSTRLEN];
 
     upf_sess_t *sess = NULL;
 
-    ogs_pkbuf_t *pkbuf = NULL;
-    ogs_sock_t *sock = NULL;
-    ogs_sockaddr_t from;
-
     ogs_gtp2_header_t *gtp_h = NULL;
     ogs_gtp2_header_desc_t header_desc;
     ogs_pfcp_user_plane_report_t report;
 
-    ogs_assert(fd != INVALID_SOCKET);
-    sock = data;
     ogs_assert(sock);
-
-    pkbuf = ogs_pkbuf_alloc(packet_pool, OGS_MAX_PKT_LEN);
-    ogs_assert(pkbuf);
-    ogs_pkbuf_reserve(pkbuf, OGS_TUN_MAX_HEADROOM);
-    ogs_pkbuf_put(pkbuf, OGS_MAX_PKT_LEN-OGS_TUN_MAX_HEADROOM);
-
-    size = ogs_recvfrom(fd, pkbuf->data, pkbuf->len, 0, &from);
-    if (size <= 0) {
-        ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
-                "ogs_recv() failed");
-        goto cleanup;
-    }
-
-    ogs_pkbuf_trim(pkbuf, size);
-
+    ogs_assert(from);
     ogs_assert(pkbuf);
     ogs_assert(pkbuf->len);
 
@@ -316,16 +330,17 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
     if (header_desc.type == OGS_GTPU_MSGTYPE_ECHO_REQ) {
         ogs_pkbuf_t *echo_rsp;
 
-        ogs_debug("[RECV] Echo Request from [%s]", OGS_ADDR(&from, buf1));
+        ogs_debug("[RECV] Echo Request from [%s]", OGS_ADDR(from, buf1));
         echo_rsp = ogs_gtp2_handle_echo_req(pkbuf);
         ogs_expect(echo_rsp);
         if (echo_rsp) {
             ssize_t sent;
 
             /* Echo reply */
-            ogs_debug("[SEND] Echo Response to [%s]", OGS_ADDR(&from, buf1));
+            ogs_debug("[SEND] Echo Response to [%s]", OGS_ADDR(from, buf1));
 
-            sent = ogs_sendto(fd, echo_rsp->data, echo_rsp->len, 0, &from);
+            sent = ogs_sendto(sock->fd,
+                    echo_rsp->data, echo_rsp->len, 0, from);
             if (sent < 0 || sent != echo_rsp->len) {
                 ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
                         "ogs_sendto() failed");
@@ -343,7 +358,7 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
     }
 
     ogs_trace("[RECV] GPU-U Type [%d] from [%s] : TEID[0x%x]",
-            header_desc.type, OGS_ADDR(&from, buf1), header_desc.teid);
+            header_desc.type, OGS_ADDR(from, buf1), header_desc.teid);
 
     /* Remove GTP header and send packets to TUN interface */
     ogs_assert(ogs_pkbuf_pull(pkbuf, len));
@@ -388,19 +403,6 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
         ip_h = (struct ip *)pkbuf->data;
         ogs_assert(ip_h);
 
-        /*
-         * Issue #2210, Discussion #2208, #2209
-         *
-         * Metrics reduce data plane performance.
-         * It should not be used on the UPF/SGW-U data plane
-         * until this issue is resolved.
-         */
-#if 0
-        upf_metrics_inst_global_inc(UPF_METR_GLOB_CTR_GTP_INDATAPKTN3UPF);
-        upf_metrics_inst_by_qfi_add(header_desc.qos_flow_identifier,
-                UPF_METR_CTR_GTP_INDATAVOLUMEQOSLEVELN3UPF, pkbuf->len);
-#endif
-
         pfcp_object = ogs_pfcp_object_find_by_teid(header_desc.teid);
         if (!pfcp_object) {
             /*
@@ -419,10 +421,10 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
                 ogs_error("[%s] Send Error Indication [TEID:0x%x] to [%s]",
                         OGS_ADDR(&sock->local_addr, buf1),
                         header_desc.teid,
-                        OGS_ADDR(&from, buf2));
+                        OGS_ADDR(from, buf2));
                 ogs_gtp1_send_error_indication(
                         sock, header_desc.teid,
-                        header_desc.qos_flow_identifier, &from);
+                        header_desc.qos_flow_identifier, from);
             }
             goto cleanup;
         }
@@ -438,28 +440,11 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
             pfcp_sess = (ogs_pfcp_sess_t *)pfcp_object;
             ogs_assert(pfcp_sess);
 
-            ogs_list_for_each(&pfcp_sess->pdr_list, pdr) {
-
-                /* Check if Source Interface */
-                if (pdr->src_if != OGS_PFCP_INTERFACE_ACCESS &&
-                    pdr->src_if != OGS_PFCP_INTERFACE_CP_FUNCTION)
-                    continue;
-
-                /* Check if TEID */
-                if (header_desc.teid != pdr->f_teid.teid)
-                    continue;
+            sess = UPF_SESS(pfcp_sess);
+            ogs_assert(sess);
 
-                /* Check if QFI */
-                if (pdr->qfi && pdr->qfi != header_desc.qos_flow_identifier)
-                    continue;
-
-                /* Check if Rule List in PDR */
-                if (ogs_list_first(&pdr->rule_list) &&
-                    ogs_pfcp_pdr_rule_find_by_packet(pdr, pkbuf) == NULL)
-                    continue;
-
-                break;
-            }
+            pdr = upf_sess_dispatch_uplink(sess, header_desc.teid,
+                    header_desc.qos_flow_identifier, pkbuf);
 
             if (!pdr) {
                 /*
@@ -479,10 +464,10 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
                             "[%s] Send Error Indication [TEID:0x%x] to [%s]",
                             OGS_ADDR(&sock->local_addr, buf1),
                             header_desc.teid,
-                            OGS_ADDR(&from, buf2));
+                            OGS_ADDR(from, buf2));
                     ogs_gtp1_send_error_indication(
                             sock, header_desc.teid,
-                            header_desc.qos_flow_identifier, &from);
+                            header_desc.qos_flow_identifier, from);
                 }
                 goto cleanup;
             }
@@ -503,6 +488,24 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
         far = pdr->far;
         ogs_assert(far);
 
+        if (pdr->src_if == OGS_PFCP_INTERFACE_CORE) {
+            upf_metrics_dp_global_inc(dp_metrics,
+                    UPF_METR_GLOB_CTR_GTP_INDATAPKTN9UPF);
+            upf_metrics_dp_by_qfi_add(dp_metrics,
+                    header_desc.qos_flow_identifier,
+                    UPF_METR_CTR_GTP_INDATAVOLUMEQOSLEVELN9UPF, pkbuf->len);
+        } else {
+            upf_metrics_dp_global_inc(dp_metrics,
+                    UPF_METR_GLOB_CTR_GTP_INDATAPKTN3UPF);
+            upf_metrics_dp_by_qfi_add(dp_metrics,
+                    header_desc.qos_flow_identifier,
+                    UPF_METR_CTR_GTP_INDATAVOLUMEQOSLEVELN3UPF, pkbuf->len);
+        }
+
+        if (upf_sess_qer_police(pdr, pkbuf->len,
+                    upf_sess_pdr_is_uplink(pdr), rx_time, dp_metrics) == false)
+            goto cleanup;
+
         if (ip_h->ip_v == 4 && sess->ipv4) {
             src_addr = (void *)&ip_h->ip_src.s_addr;
             ogs_assert(src_addr);
@@ -641,7 +644,8 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
 
             /* Increment total & ul octets + pkts */
             for (i = 0; i < pdr->num_of_urr; i++)
-                upf_sess_urr_acc_add(sess, pdr->urr[i], pkbuf->len, true);
+                upf_sess_urr_acc_add(
+                        sess, pdr->urr[i], pkbuf->len, true, rx_now);
 
             if (dev->is_tap) {
                 ogs_assert(eth_type);
@@ -659,6 +663,15 @@ static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
                 ogs_warn("ogs_tun_write() failed");
 
         } else if (far->dst_if == OGS_PFCP_INTERFACE_ACCESS) {
+            if (far->apply_action & OGS_PFCP_APPLY_ACTION_FORW) {
+                upf_metrics_dp_global_inc(dp_metrics,
+                        UPF_METR_GLOB_CTR_GTP_OUTDATAPKTN3UPF);
+                upf_metrics_dp_by_qfi_add(dp_metrics,
+                        pdr->qer ? pdr->qer->qfi : 0,
+                        UPF_METR_CTR_GTP_OUTDATAVOLUMEQOSLEVELN3UPF,
+                        pkbuf->len);
+            }
+
             ogs_assert(true == ogs_pfcp_up_handle_pdr(
                         pdr, header_desc.type, &header_desc, pkbuf, &report));
 
@@ -716,6 +729,116 @@ cleanup:
     ogs_pkbuf_free(pkbuf);
 }
 
+static void _gtpv1_u_recv_batch(ogs_sock_t *sock, int batch)
+{
+    int i, n, sent;
+
+    n = ogs_gtp_recv_batch(sock->fd, packet_pool, OGS_TUN_MAX_HEADROOM,
+            rx_batch, rx_from, batch);
+    if (n == 0)
+        return;
+
+    upf_metrics_inst_global_add(UPF_METR_GLOB_HIST_GTP_RX_BATCH, n);
+
+    ogs_gtp_send_batch_begin();
+    for (i = 0; i < n; i++) {
+        ogs_pkbuf_t *pkbuf = rx_batch[i];
+        rx_batch[i] = NULL;
+
+        upf_gtp_handle_gtpu_packet(sock, pkbuf, &rx_from[i]);
+    }
+    sent = ogs_gtp_send_batch_end();
+    if (sent)
+        upf_metrics_inst_global_add(UPF_METR_GLOB_HIST_GTP_TX_BATCH, sent);
+    upf_sess_urr_acc_check_all();
+}
+
+static void _gtpv1_u_recv_cb(short when, ogs_socket_t fd, void *data)
+{
+    ssize_t size;
+    ogs_pkbuf_t *pkbuf = NULL;
+    ogs_sock_t *sock = NULL;
+    ogs_sockaddr_t from;
+
+    ogs_assert(fd != INVALID_SOCKET);
+    sock = data;
+    ogs_assert(sock);
+
+    rx_time = ogs_get_monotonic_time();
+    rx_now = ogs_time_now();
+
+    if (ogs_gtp_self()->gtpu_batch.size > 1) {
+        _gtpv1_u_recv_batch(sock, ogs_gtp_self()->gtpu_batch.size);
+        return;
+    }
+
+    pkbuf = ogs_pkbuf_alloc(packet_pool, OGS_MAX_PKT_LEN);
+    if (!pkbuf) {
+        ogs_error("ogs_pkbuf_alloc() failed");
+        ogs_gtp_self()->gtpu_pkbuf_stat.pool_miss++;
+        return;
+    }
+    ogs_pkbuf_reserve(pkbuf, OGS_TUN_MAX_HEADROOM);
+    ogs_pkbuf_put(pkbuf, OGS_MAX_PKT_LEN-OGS_TUN_MAX_HEADROOM);
+
+    size = ogs_recvfrom(fd, pkbuf->data, pkbuf->len, 0, &from);
+    if (size <= 0) {
+        ogs_log_message(OGS_LOG_ERROR, ogs_socket_errno,
+                "ogs_recv() failed");
+        ogs_pkbuf_free(pkbuf);
+        return;
+    }
+
+    ogs_pkbuf_trim(pkbuf, size);
+
+    upf_gtp_handle_gtpu_packet(sock, pkbuf, &from);
+    upf_sess_urr_acc_check_all();
+}
+
+static void _gtpv1_u_recv_multi_cb(ogs_socket_t fd,
+        ogs_pkbuf_t **pkbuf, ogs_sockaddr_t *from, int num, void *data)
+{
+    ogs_sock_t *sock = data;
+    int i, sent;
+
+    ogs_assert(sock);
+
+    rx_time = ogs_get_monotonic_time();
+    rx_now = ogs_time_now();
+
+    upf_metrics_inst_global_add(UPF_METR_GLOB_HIST_GTP_RX_BATCH, num);
+
+    ogs_gtp_send_batch_begin();
+    for (i = 0; i < num; i++)
+        upf_gtp_handle_gtpu_packet(sock, pkbuf[i], &from[i]);
+    sent = ogs_gtp_send_batch_end();
+    if (sent)
+        upf_metrics_inst_global_add(UPF_METR_GLOB_HIST_GTP_TX_BATCH, sent);
+    upf_sess_urr_acc_check_all();
+}
+
+static ogs_poll_t *gtpu_poll_add(ogs_sock_t *sock)
+{
+    if (ogs_global_conf()->parameter.use_io_uring)
+        return ogs_pollset_add_recv(ogs_app()->pollset, sock->fd,
+                packet_pool, OGS_MAX_PKT_LEN, OGS_TUN_MAX_HEADROOM,
+                _gtpv1_u_recv_multi_cb, sock);
+
+    return ogs_pollset_add(ogs_app()->pollset,
+            OGS_POLLIN, sock->fd, _gtpv1_u_recv_cb, sock);
+}
+
+static ogs_poll_t *tun_poll_add(ogs_pfcp_dev_t *dev, ogs_socket_t fd)
+{
+    if (ogs_global_conf()->parameter.use_io_uring)
+        return ogs_pollset_add_recv(ogs_app()->pollset, fd,
+                packet_pool, OGS_MAX_PKT_LEN, OGS_TUN_MAX_HEADROOM,
+                _gtpv1_tun_recv_multi_cb, dev);
+
+    return ogs_pollset_add(ogs_app()->pollset, OGS_POLLIN, fd,
+            dev->is_tap ? _gtpv1_tun_recv_eth_cb : _gtpv1_tun_recv_cb, NULL);
+}
+
 int upf_gtp_init(void)
 {
     ogs_pkbuf_config_t config;
@@ -732,12 +855,26 @@ int upf_gtp_init(void)
     packet_pool = ogs_pkbuf_pool_create(&config);
 #endif
 
+    dp_metrics = upf_metrics_dp_add();
+
     return OGS_OK;
 }
 
 void upf_gtp_final(void)
 {
+    int i;
+
+    for (i = 0; i < OGS_GTPU_MAX_BATCH; i++) {
+        if (rx_batch[i]) {
+            ogs_pkbuf_free(rx_batch[i]);
+            rx_batch[i] = NULL;
+        }
+    }
+
     ogs_pkbuf_pool_destroy(packet_pool);
+
+    upf_metrics_dp_remove(dp_metrics);
+    dp_metrics = NULL;
 }
 
 static void _get_dev_mac_addr(char *ifname, uint8_t *mac_addr)
@@ -772,24 +909,34 @@ int upf_gtp_open(void)
     ogs_pfcp_subnet_t *subnet = NULL;
     ogs_socknode_t *node = NULL;
     ogs_sock_t *sock = NULL;
+    bool batch = ogs_gtp_self()->gtpu_batch.size > 1;
     int rc;
 
+    ogs_gtp_self()->gtpu_batch.gso = batch;
+
     ogs_list_for_each(&ogs_gtp_self()->gtpu_list, node) {
         sock = ogs_gtp_server(node);
         if (!sock) return OGS_ERROR;
 
+        if (batch && ogs_gtp_probe_gso(sock) == false)
+            ogs_gtp_self()->gtpu_batch.gso = false;
+
         if (sock->family == AF_INET)
             ogs_gtp_self()->gtpu_sock = sock;
         else if (sock->family == AF_INET6)
             ogs_gtp_self()->gtpu_sock6 = sock;
 
-        node->poll = ogs_pollset_add(ogs_app()->pollset,
-                OGS_POLLIN, sock->fd, _gtpv1_u_recv_cb, sock);
+        node->poll = gtpu_poll_add(sock);
         ogs_assert(node->poll);
     }
 
     OGS_SETUP_GTPU_SERVER;
 
+    if (batch)
+        ogs_info("gtpu batch [%d] UDP GSO [%s]",
+                ogs_gtp_self()->gtpu_batch.size,
+                ogs_gtp_self()->gtpu_batch.gso ? "on" : "off");
+
     /* NOTE : tun device can be created via following command.
      *
      * $ sudo ip tuntap add name ogstun mode tun
@@ -810,17 +957,16 @@ int upf_gtp_open(void)
             return OGS_ERROR;
         }
 
-        if (dev->is_tap) {
-            _get_dev_mac_addr(dev->ifname, dev->mac_addr);
-            dev->poll = ogs_pollset_add(ogs_app()->pollset,
-                    OGS_POLLIN, dev->fd, _gtpv1_tun_recv_eth_cb, NULL);
-            ogs_assert(dev->poll);
-        } else {
-            dev->poll = ogs_pollset_add(ogs_app()->pollset,
-                    OGS_POLLIN, dev->fd, _gtpv1_tun_recv_cb, NULL);
-            ogs_assert(dev->poll);
+        /* In batch mode, the tun device is drained until EAGAIN */
+        if (batch && ogs_nonblocking(dev->fd) != OGS_OK) {
+            ogs_error("ogs_nonblocking(dev:%s) failed", dev->ifname);
+            return OGS_ERROR;
         }
 
+        if (dev->is_tap)
+            _get_dev_mac_addr(dev->ifname, dev->mac_addr);
+
+        dev->poll = tun_poll_add(dev, dev->fd);
         ogs_assert(dev->poll);
     }
 
@@ -860,7 +1006,7 @@ void upf_gtp_close(void)
     }
 }
 
-static void upf_gtp_handle_multicast(ogs_pkbuf_t *recvbuf)
+static bool upf_gtp_handle_multicast(ogs_pkbuf_t *recvbuf)
 {
     struct ip *ip_h =  NULL;
     struct ip6_hdr *ip6_h = NULL;
@@ -888,19 +1034,19 @@ static void upf_gtp_handle_multicast(ogs_pkbuf_t *recvbuf)
 
                     ogs_list_for_each(&sess->pfcp.pdr_list, pdr) {
                         if (pdr->src_if == OGS_PFCP_INTERFACE_CORE) {
-                            ogs_pkbuf_t *sendbuf = ogs_pkbuf_copy(recvbuf);
-                            ogs_assert(sendbuf);
                             ogs_assert(true ==
                                 ogs_pfcp_up_handle_pdr(
                                     pdr, OGS_GTPU_MSGTYPE_GPDU,
-                                    NULL, sendbuf, &report));
-                            break;
+                                    NULL, recvbuf, &report));
+                            return true;
                         }
                     }
 
-                    return;
+                    return false;
                 }
             }
         }
     }
+
+    return false;
 }
@@ -10,6 +10,7 @@ typedef struct upf_metrics_spec_def_s {
     int initial_val;
     unsigned int num_labels;
     const char **labels;
+    ogs_metrics_histogram_params_t histogram_params;
 } upf_metrics_spec_def_t;
 
 /* Helper generic functions: */
@@ -41,7 +42,7 @@ static int upf_metrics_init_spec(ogs_metrics_context_t *ctx,
         dst[i] = ogs_metrics_spec_new(ctx, src[i].type,
                 src[i].name, src[i].description,
                 src[i].initial_val, src[i].num_labels, src[i].labels,
-                NULL);
+                &src[i].histogram_params);
     }
     return OGS_OK;
 }
@@ -61,6 +62,11 @@ upf_metrics_spec_def_t upf_metrics_spec_def_global[_UPF_METR_GLOB_MAX] = {
     .name = "fivegs_ep_n3_gtp_outdatapktn3upf",
     .description = "Number of outgoing GTP data packets on the N3 interface",
 },
+[UPF_METR_GLOB_CTR_GTP_INDATAPKTN9UPF] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "fivegs_ep_n9_gtp_indatapktn9upf",
+    .description = "Number of incoming GTP data packets on the N9 interface",
+},
 [UPF_METR_GLOB_CTR_SM_N4SESSIONESTABREQ] = {
     .type = OGS_METRICS_METRIC_TYPE_COUNTER,
     .name = "fivegs_upffunction_sm_n4sessionestabreq",
@@ -76,6 +82,22 @@ upf_metrics_spec_def_t upf_metrics_spec_def_global[_UPF_METR_GLOB_MAX] = {
     .name = "fivegs_upffunction_sm_n4sessionreportsucc",
     .description = "Number of successful N4 session reports",
 },
+[UPF_METR_GLOB_CTR_GTP_PKBUF_POOL_HIT] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "gtp_pkbuf_pool_hit",
+    .description = "Number of GTP-U packets sent in their receive buffer",
+},
+[UPF_METR_GLOB_CTR_GTP_PKBUF_POOL_MISS] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "gtp_pkbuf_pool_miss",
+    .description = "Number of GTP-U packet buffer allocation failures "
+        "and copies",
+},
+[UPF_METR_GLOB_CTR_GTP_PKBUF_COPY] = {
+    .type = OGS_METRICS_METRIC_TYPE_COUNTER,
+    .name = "gtp_pkbuf_copy",
+    .description = "Number of GTP-U packets copied on the data path",
+},
 /* Global Gauges: */
 [UPF_METR_GLOB_GAUGE_UPF_SESSIONNBR] = {
     .type = OGS_METRICS_METRIC_TYPE_GAUGE,
@@ -87,6 +109,44 @@ upf_metrics_spec_def_t upf_metrics_spec_def_global[_UPF_METR_GLOB_MAX] = {
     .name = "pfcp_peers_active",
     .description = "Active PFCP peers",
 },
+[UPF_METR_GLOB_GAUGE_SESS_POOL_PEAK] = {
+    .type = OGS_METRICS_METRIC_TYPE_GAUGE,
+    .name = "upf_sess_pool_peak",
+    .description = "Most sessions in use at once",
+},
+[UPF_METR_GLOB_GAUGE_PDR_POOL_PEAK] = {
+    .type = OGS_METRICS_METRIC_TYPE_GAUGE,
+    .name = "pfcp_pdr_pool_peak",
+    .description = "Most PDRs in use at once",
+},
+[UPF_METR_GLOB_GAUGE_POOL_COMMITTED] = {
+    .type = OGS_METRICS_METRIC_TYPE_GAUGE,
+    .name = "pool_committed_kbytes",
+    .description = "Memory backing the session and rule pools in KB",
+},
+/* Global Histograms: */
+[UPF_METR_GLOB_HIST_GTP_RX_BATCH] = {
+    .type = OGS_METRICS_METRIC_TYPE_HISTOGRAM,
+    .name = "gtp_rx_batch_size",
+    .description = "Number of GTP-U packets received per batch",
+    .histogram_params = {
+        .type = OGS_METRICS_HISTOGRAM_BUCKET_TYPE_EXPONENTIAL,
+        .count = 7,
+        .exp.start = 1,
+        .exp.factor = 2,
+    },
+},
+[UPF_METR_GLOB_HIST_GTP_TX_BATCH] = {
+    .type = OGS_METRICS_METRIC_TYPE_HISTOGRAM,
+    .name = "gtp_tx_batch_size",
+    .description = "Number of GTP-U packets sent per batch",
+    .histogram_params = {
+        .type = OGS_METRICS_HISTOGRAM_BUCKET_TYPE_EXPONENTIAL,
+        .count = 7,
+        .exp.start = 1,
+        .exp.factor = 2,
+    },
+},
 };
 int upf_metrics_init_inst_global(void)
 {
@@ -122,6 +182,18 @@ UPF_METR_BY_QFI_CTR_ENTRY(
     UPF_METR_CTR_GTP_OUTDATAVOLUMEQOSLEVELN3UPF,
     "fivegs_ep_n3_gtp_outdatavolumeqosleveln3upf",
     "Data volume of outgoing GTP data packets per QoS level on the N3 interface")
+UPF_METR_BY_QFI_CTR_ENTRY(
+    UPF_METR_CTR_GTP_INDATAVOLUMEQOSLEVELN9UPF,
+    "fivegs_ep_n9_gtp_indatavolumeqosleveln9upf",
+    "Data volume of incoming GTP data packets per QoS level on the N9 interface")
+UPF_METR_BY_QFI_CTR_ENTRY(
+    UPF_METR_CTR_QER_GATEDROPPKT,
+    "qer_gate_drop_packets",
+    "Number of packets dropped by a closed QER gate per QoS level")
+UPF_METR_BY_QFI_CTR_ENTRY(
+    UPF_METR_CTR_QER_MBRDROPPKT,
+    "qer_mbr_drop_packets",
+    "Number of packets dropped by QER MBR policing per QoS level")
 };
 void upf_metrics_init_by_qfi(void);
 int upf_metrics_free_inst_by_qfi(ogs_metrics_inst_t **inst);
@@ -139,21 +211,22 @@ void upf_metrics_inst_by_qfi_add(uint8_t qfi,
         upf_metric_type_by_qfi_t t, int val)
 {
     ogs_metrics_inst_t *metrics = NULL;
-    upf_metric_key_by_qfi_t *qfi_key;
-
-    qfi_key = ogs_calloc(1, sizeof(*qfi_key));
-    ogs_assert(qfi_key);
+    upf_metric_key_by_qfi_t key, *qfi_key;
 
-    qfi_key->qfi = qfi;
-    qfi_key->t = t;
+    memset(&key, 0, sizeof(key));
+    key.qfi = qfi;
+    key.t = t;
 
-    metrics = ogs_hash_get(metrics_hash_by_qfi,
-            qfi_key, sizeof(*qfi_key));
+    metrics = ogs_hash_get(metrics_hash_by_qfi, &key, sizeof(key));
 
     if (!metrics) {
         char qfi_str[4];
         ogs_snprintf(qfi_str, sizeof(qfi_str), "%d", qfi);
 
+        qfi_key = ogs_calloc(1, sizeof(*qfi_key));
+        ogs_assert(qfi_key);
+        *qfi_key = key;
+
         metrics = ogs_metrics_inst_new(upf_metrics_spec_by_qfi[t],
                 upf_metrics_spec_def_by_qfi->num_labels,
                 (const char *[]){ qfi_str });
@@ -161,8 +234,6 @@ void upf_metrics_inst_by_qfi_add(uint8_t qfi,
         ogs_assert(metrics);
         ogs_hash_set(metrics_hash_by_qfi,
                 qfi_key, sizeof(*qfi_key), metrics);
-    } else {
-        ogs_free(qfi_key);
     }
 
     ogs_metrics_inst_add(metrics, val);
@@ -321,6 +392,118 @@ int upf_metrics_free_inst_by_dnn(ogs_metrics_inst_t **inst)
     return upf_metrics_free_inst(inst, _UPF_METR_BY_DNN_MAX);
 }
 
+/* DATA PLANE */
+static OGS_LIST(dp_list);
+
+upf_metrics_dp_t *upf_metrics_dp_add(void)
+{
+    upf_metrics_dp_t *dp = NULL;
+
+    dp = ogs_calloc(1, sizeof(*dp));
+    ogs_assert(dp);
+
+    ogs_list_add(&dp_list, dp);
+
+    return dp;
+}
+
+/* The metrics instances take an int : fold large deltas in pieces */
+static void dp_fold(uint64_t val, uint64_t *published,
+        void (*add)(void *arg, int val), void *arg)
+{
+    uint64_t delta = val - *published;
+
+    while (delta) {
+        int chunk = ogs_min(delta, INT32_MAX);
+        add(arg, chunk);
+        delta -= chunk;
+    }
+    *published = val;
+}
+
+static void dp_global_add(void *arg, int val)
+{
+    upf_metrics_inst_global_add((uintptr_t)arg, val);
+}
+
+static void dp_by_qfi_add(void *arg, int val)
+{
+    uintptr_t key = (uintptr_t)arg;
+    upf_metrics_inst_by_qfi_add(key >> 8, key & 0xff, val);
+}
+
+/*
+ * Only the owner thread writes a block. Reading it here without a lock
+ * is safe for naturally aligned 64-bit counters; a value missed by this
+ * scrape is published by the next one.
+ */
+static void dp_collect(upf_metrics_dp_t *dp)
+{
+    int i, qfi;
+
+    for (i = 0; i < _UPF_METR_GLOB_MAX; i++) {
+        if (dp->global[i] != dp->published.global[i])
+            dp_fold(dp->global[i], &dp->published.global[i],
+                    dp_global_add, (void *)(uintptr_t)i);
+    }
+
+    for (qfi = 0; qfi <= OGS_MAX_QOS_FLOW_ID; qfi++) {
+        for (i = 0; i < _UPF_METR_BY_QFI_MAX; i++) {
+            if (dp->by_qfi[qfi][i] != dp->published.by_qfi[qfi][i])
+                dp_fold(dp->by_qfi[qfi][i], &dp->published.by_qfi[qfi][i],
+                        dp_by_qfi_add, (void *)(uintptr_t)(qfi << 8 | i));
+        }
+    }
+}
+
+void upf_metrics_dp_remove(upf_metrics_dp_t *dp)
+{
+    ogs_assert(dp);
+
+    dp_collect(dp);
+
+    ogs_list_remove(&dp_list, dp);
+    ogs_free(dp);
+}
+
+/* Called by the metrics server before each scrape */
+static void upf_metrics_collect(void)
+{
+    upf_metrics_dp_t *dp = NULL;
+    struct {
+        upf_metric_type_global_t t;
+        uint64_t val;
+    } stat[] = {
+        { UPF_METR_GLOB_CTR_GTP_PKBUF_POOL_HIT,
+            ogs_gtp_self()->gtpu_pkbuf_stat.pool_hit },
+        { UPF_METR_GLOB_CTR_GTP_PKBUF_POOL_MISS,
+            ogs_gtp_self()->gtpu_pkbuf_stat.pool_miss },
+        { UPF_METR_GLOB_CTR_GTP_PKBUF_COPY,
+            ogs_gtp_self()->gtpu_pkbuf_stat.copy },
+    };
+    /* The packet buffer counters are cumulative in the GTP context */
+    static uint64_t published[OGS_ARRAY_SIZE(stat)];
+    upf_pool_stat_t pool;
+    int i;
+
+    ogs_list_for_each(&dp_list, dp)
+        dp_collect(dp);
+
+    for (i = 0; i < OGS_ARRAY_SIZE(stat); i++) {
+        if (stat[i].val != published[i])
+            dp_fold(stat[i].val, &published[i],
+                    dp_global_add, (void *)(uintptr_t)stat[i].t);
+    }
+
+    upf_pool_stat(&pool);
+    upf_metrics_inst_global_set(
+            UPF_METR_GLOB_GAUGE_SESS_POOL_PEAK, pool.sess_peak);
+    upf_metrics_inst_global_set(
+            UPF_METR_GLOB_GAUGE_PDR_POOL_PEAK, pool.pdr_peak);
+    upf_metrics_inst_global_set(
+            UPF_METR_GLOB_GAUGE_POOL_COMMITTED, (int)(pool.committed >> 10));
+}
+
 void upf_metrics_init(void)
 {
     ogs_metrics_context_t *ctx = ogs_metrics_self();
@@ -339,11 +522,17 @@ void upf_metrics_init(void)
     upf_metrics_init_by_qfi();
     upf_metrics_init_by_cause();
     upf_metrics_init_by_dnn();
+
+    ctx->collect = upf_metrics_collect;
 }
 
 void upf_metrics_final(void)
 {
     ogs_hash_index_t *hi;
+    upf_metrics_dp_t *dp = NULL, *next_dp = NULL;
+
+    ogs_list_for_each_safe(&dp_list, next_dp, dp)
+        upf_metrics_dp_remove(dp);
 
     if (metrics_hash_by_qfi) {
         for (hi = ogs_hash_first(metrics_hash_by_qfi); hi; hi = ogs_hash_next(hi)) {
@@ -11,11 +11,20 @@ extern "C" {
 typedef enum upf_metric_type_global_s {
     UPF_METR_GLOB_CTR_GTP_INDATAPKTN3UPF = 0,
     UPF_METR_GLOB_CTR_GTP_OUTDATAPKTN3UPF,
+    UPF_METR_GLOB_CTR_GTP_INDATAPKTN9UPF,
     UPF_METR_GLOB_CTR_SM_N4SESSIONESTABREQ,
     UPF_METR_GLOB_CTR_SM_N4SESSIONREPORT,
     UPF_METR_GLOB_CTR_SM_N4SESSIONREPORTSUCC,
+    UPF_METR_GLOB_CTR_GTP_PKBUF_POOL_HIT,
+    UPF_METR_GLOB_CTR_GTP_PKBUF_POOL_MISS,
+    UPF_METR_GLOB_CTR_GTP_PKBUF_COPY,
     UPF_METR_GLOB_GAUGE_UPF_SESSIONNBR,
     UPF_METR_GLOB_GAUGE_PFCP_PEERS_ACTIVE,
+    UPF_METR_GLOB_GAUGE_SESS_POOL_PEAK,
+    UPF_METR_GLOB_GAUGE_PDR_POOL_PEAK,
+    UPF_METR_GLOB_GAUGE_POOL_COMMITTED,
+    UPF_METR_GLOB_HIST_GTP_RX_BATCH,
+    UPF_METR_GLOB_HIST_GTP_TX_BATCH,
     _UPF_METR_GLOB_MAX,
 } upf_metric_type_global_t;
 extern ogs_metrics_inst_t *upf_metrics_inst_global[_UPF_METR_GLOB_MAX];
@@ -36,6 +45,9 @@ static inline void upf_metrics_inst_global_dec(upf_metric_type_global_t t)
 typedef enum upf_metric_type_by_qfi_s {
     UPF_METR_CTR_GTP_INDATAVOLUMEQOSLEVELN3UPF = 0,
     UPF_METR_CTR_GTP_OUTDATAVOLUMEQOSLEVELN3UPF,
+    UPF_METR_CTR_GTP_INDATAVOLUMEQOSLEVELN9UPF,
+    UPF_METR_CTR_QER_GATEDROPPKT,
+    UPF_METR_CTR_QER_MBRDROPPKT,
     _UPF_METR_BY_QFI_MAX,
 } upf_metric_type_by_qfi_t;
 
@@ -60,6 +72,39 @@ typedef enum upf_metric_type_by_dnn_s {
 void upf_metrics_inst_by_dnn_add(
     char *dnn, upf_metric_type_by_dnn_t t, int val);
 
+/*
+ * Data plane counters
+ *
+ * Going through the metrics library on every packet costs too much
+ * (Issue #2210). Each thread forwarding packets owns one block of plain
+ * counters indexed by metric and QFI, updated without hashing or locking.
+ * The blocks are folded into the metrics instances when scraped.
+ */
+typedef struct upf_metrics_dp_s {
+    ogs_lnode_t lnode;
+
+    uint64_t global[_UPF_METR_GLOB_MAX];
+    uint64_t by_qfi[OGS_MAX_QOS_FLOW_ID+1][_UPF_METR_BY_QFI_MAX];
+
+    struct {
+        uint64_t global[_UPF_METR_GLOB_MAX];
+        uint64_t by_qfi[OGS_MAX_QOS_FLOW_ID+1][_UPF_METR_BY_QFI_MAX];
+    } published;
+} upf_metrics_dp_t;
+
+upf_metrics_dp_t *upf_metrics_dp_add(void);
+void upf_metrics_dp_remove(upf_metrics_dp_t *dp);
+
+static inline void upf_metrics_dp_global_add(upf_metrics_dp_t *dp,
+        upf_metric_type_global_t t, uint64_t val)
+{ dp->global[t] += val; }
+static inline void upf_metrics_dp_global_inc(upf_metrics_dp_t *dp,
+        upf_metric_type_global_t t)
+{ dp->global[t]++; }
+static inline void upf_metrics_dp_by_qfi_add(upf_metrics_dp_t *dp,
+        uint8_t qfi, upf_metric_type_by_qfi_t t, uint64_t val)
+{ dp->by_qfi[qfi & OGS_MAX_QOS_FLOW_ID][t] += val; }
+
 void upf_metrics_init(void);
 void upf_metrics_final(void);
 
@@ -22,30 +22,27 @@
 #include "gtp-path.h"
 #include "n4-handler.h"
 
-static void upf_n4_handle_create_urr(upf_sess_t *sess, ogs_pfcp_tlv_create_urr_t *create_urr_arr,
-                              uint8_t *cause_value, uint8_t *offending_ie_value)
+static ogs_pfcp_urr_t *upf_n4_handle_create_urr(upf_sess_t *sess,
+        ogs_pfcp_tlv_create_urr_t *create_urr,
+        uint8_t *cause_value, uint8_t *offending_ie_value)
 {
-    int i;
     ogs_pfcp_urr_t *urr;
 
-    *cause_value = OGS_PFCP_CAUSE_REQUEST_ACCEPTED;
+    urr = ogs_pfcp_handle_create_urr(&sess->pfcp, create_urr,
+                cause_value, offending_ie_value);
+    if (!urr)
+        return NULL;
 
-    for (i = 0; i < OGS_MAX_NUM_OF_URR; i++) {
-        urr = ogs_pfcp_handle_create_urr(&sess->pfcp, &create_urr_arr[i],
-                    cause_value, offending_ie_value);
-        if (!urr)
-            return;
-
-        /* TODO: enable counters somewhere else if ISTM not set, upon first pkt received */
-        if (urr->meas_info.istm) {
-            upf_sess_urr_acc_timers_setup(sess, urr);
-        }
+    /* TODO: enable counters somewhere else if ISTM not set, upon first pkt received */
+    if (urr->meas_info.istm) {
+        upf_sess_urr_acc_timers_setup(sess, urr);
     }
+
+    return urr;
 }
 
 void upf_n4_handle_session_establishment_request(
-        upf_sess_t *sess, ogs_pfcp_xact_t *xact,
-        ogs_pfcp_session_establishment_request_t *req)
+        upf_sess_t *sess, ogs_pfcp_xact_t *xact, ogs_pfcp_ie_index_t *index)
 {
     ogs_pfcp_pdr_t *pdr = NULL;
     ogs_pfcp_far_t *far = NULL;
@@ -55,13 +52,23 @@ void upf_n4_handle_session_establishment_request(
     uint8_t offending_ie_value = 0;
     int i;
 
+    ogs_pfcp_ie_t *ie = NULL;
+    ogs_pfcp_tlv_pfcpsereq_flags_t pfcpsereq_flags;
+    ogs_pfcp_tlv_apn_dnn_t tlv_apn_dnn;
+    ogs_pfcp_tlv_pdn_type_t pdn_type;
+    ogs_pfcp_tlv_create_pdr_t create_pdr;
+    ogs_pfcp_tlv_create_far_t create_far;
+    ogs_pfcp_tlv_create_urr_t create_urr;
+    ogs_pfcp_tlv_create_qer_t create_qer;
+    ogs_pfcp_tlv_create_bar_t create_bar;
+
     ogs_pfcp_sereq_flags_t sereq_flags;
     bool restoration_indication = false;
 
     upf_metrics_inst_global_inc(UPF_METR_GLOB_CTR_SM_N4SESSIONESTABREQ);
 
     ogs_assert(xact);
-    ogs_assert(req);
+    ogs_assert(index);
 
     ogs_debug("Session Establishment Request");
 
@@ -77,13 +84,34 @@ void upf_n4_handle_session_establishment_request(
         return;
     }
 
+    /*
+     * The request is read through the IE index,
+     * decoding each grouped IE only when it is handled.
+     */
     memset(&sereq_flags, 0, sizeof(sereq_flags));
-    if (req->pfcpsereq_flags.presence == 1)
-        sereq_flags.value = req->pfcpsereq_flags.u8;
+    ie = ogs_pfcp_ie_find(index, OGS_PFCP_PFCPSEREQ_FLAGS_TYPE, NULL);
+    if (ie) {
+        if (ogs_pfcp_ie_decode(index, ie, &ogs_pfcp_tlv_desc_pfcpsereq_flags,
+                    &pfcpsereq_flags) != OGS_OK) {
+            cause_value = OGS_PFCP_CAUSE_INVALID_LENGTH;
+            offending_ie_value = OGS_PFCP_PFCPSEREQ_FLAGS_TYPE;
+            goto cleanup;
+        }
+        sereq_flags.value = pfcpsereq_flags.u8;
+    }
 
+    ie = NULL;
     for (i = 0; i < OGS_MAX_NUM_OF_PDR; i++) {
+        ie = ogs_pfcp_ie_find(index, OGS_PFCP_CREATE_PDR_TYPE, ie);
+        if (!ie)
+            break;
+        if (ogs_pfcp_ie_decode_create_pdr(index, ie, &create_pdr) != OGS_OK) {
+            cause_value = OGS_PFCP_CAUSE_MANDATORY_IE_INCORRECT;
+            offending_ie_value = OGS_PFCP_CREATE_PDR_TYPE;
+            break;
+        }
         created_pdr[i] = ogs_pfcp_handle_create_pdr(&sess->pfcp,
-                &req->create_pdr[i], &sereq_flags,
+                &create_pdr, &sereq_flags,
                 &cause_value, &offending_ie_value);
         if (created_pdr[i] == NULL)
             break;
@@ -92,23 +120,48 @@ void upf_n4_handle_session_establishment_request(
     if (cause_value != OGS_PFCP_CAUSE_REQUEST_ACCEPTED)
         goto cleanup;
 
+    ie = NULL;
     for (i = 0; i < OGS_MAX_NUM_OF_FAR; i++) {
-        if (ogs_pfcp_handle_create_far(&sess->pfcp, &req->create_far[i],
+        ie = ogs_pfcp_ie_find(index, OGS_PFCP_CREATE_FAR_TYPE, ie);
+        if (!ie)
+            break;
+        if (ogs_pfcp_ie_decode_create_far(index, ie, &create_far) != OGS_OK) {
+            cause_value = OGS_PFCP_CAUSE_MANDATORY_IE_INCORRECT;
+            offending_ie_value = OGS_PFCP_CREATE_FAR_TYPE;
+            break;
+        }
+        if (ogs_pfcp_handle_create_far(&sess->pfcp, &create_far,
                     &cause_value, &offending_ie_value) == NULL)
             break;
     }
     if (cause_value != OGS_PFCP_CAUSE_REQUEST_ACCEPTED)
         goto cleanup;
 
-    upf_n4_handle_create_urr(sess, &req->create_urr[0], &cause_value, &offending_ie_value);
+    ie = NULL;
+    for (i = 0; i < OGS_MAX_NUM_OF_URR; i++) {
+        ie = ogs_pfcp_ie_find(index, OGS_PFCP_CREATE_URR_TYPE, ie);
+        if (!ie)
+            break;
+        if (ogs_pfcp_ie_decode_create_urr(index, ie, &create_urr) != OGS_OK) {
+            cause_value = OGS_PFCP_CAUSE_MANDATORY_IE_INCORRECT;
+            offending_ie_value = OGS_PFCP_CREATE_URR_TYPE;
+            break;
+        }
+        if (upf_n4_handle_create_urr(sess, &create_urr,
+                    &cause_value, &offending_ie_value) == NULL)
+            break;
+    }
     if (cause_value != OGS_PFCP_CAUSE_REQUEST_ACCEPTED)
         goto cleanup;
 
-    if (req->apn_dnn.presence) {
+    ie = ogs_pfcp_ie_find(index, OGS_PFCP_APN_DNN_TYPE, NULL);
+    if (ie) {
         char apn_dnn[OGS_MAX_DNN_LEN+1];
 
-        if (ogs_fqdn_parse(apn_dnn, req->apn_dnn.data,
-            ogs_min(req->apn_dnn.len, OGS_MAX_DNN_LEN)) <= 0) {
+        if (ogs_pfcp_ie_decode(index, ie, &ogs_pfcp_tlv_desc_apn_dnn,
+                    &tlv_apn_dnn) != OGS_OK ||
+            ogs_fqdn_parse(apn_dnn, tlv_apn_dnn.data,
+            ogs_min(tlv_apn_dnn.len, OGS_MAX_DNN_LEN)) <= 0) {
             ogs_error("Invalid APN");
             cause_value = OGS_PFCP_CAUSE_MANDATORY_IE_INCORRECT;
             goto cleanup;
@@ -120,8 +173,17 @@ void upf_n4_handle_session_establishment_request(
         ogs_assert(sess->apn_dnn);
     }
 
+    ie = NULL;
     for (i = 0; i < OGS_MAX_NUM_OF_QER; i++) {
-        if (ogs_pfcp_handle_create_qer(&sess->pfcp, &req->create_qer[i],
+        ie = ogs_pfcp_ie_find(index, OGS_PFCP_CREATE_QER_TYPE, ie);
+        if (!ie)
+            break;
+        if (ogs_pfcp_ie_decode_create_qer(index, ie, &create_qer) != OGS_OK) {
+            cause_value = OGS_PFCP_CAUSE_MANDATORY_IE_INCORRECT;
+            offending_ie_value = OGS_PFCP_CREATE_QER_TYPE;
+            break;
+        }
+        if (ogs_pfcp_handle_create_qer(&sess->pfcp, &create_qer,
                     &cause_value, &offending_ie_value) == NULL)
             break;
         upf_metrics_inst_by_dnn_add(sess->apn_dnn,
@@ -130,10 +192,18 @@ void upf_n4_handle_session_establishment_request(
     if (cause_value != OGS_PFCP_CAUSE_REQUEST_ACCEPTED)
         goto cleanup;
 
-    ogs_pfcp_handle_create_bar(&sess->pfcp, &req->create_bar,
-                &cause_value, &offending_ie_value);
-    if (cause_value != OGS_PFCP_CAUSE_REQUEST_ACCEPTED)
-        goto cleanup;
+    ie = ogs_pfcp_ie_find(index, OGS_PFCP_CREATE_BAR_TYPE, NULL);
+    if (ie) {
+        if (ogs_pfcp_ie_decode_create_bar(index, ie, &create_bar) != OGS_OK) {
+            cause_value = OGS_PFCP_CAUSE_MANDATORY_IE_INCORRECT;
+            offending_ie_value = OGS_PFCP_CREATE_BAR_TYPE;
+            goto cleanup;
+        }
+        ogs_pfcp_handle_create_bar(&sess->pfcp, &create_bar,
+                    &cause_value, &offending_ie_value);
+        if (cause_value != OGS_PFCP_CAUSE_REQUEST_ACCEPTED)
+            goto cleanup;
+    }
 
     /* Setup GTP Node */
     ogs_list_for_each(&sess->pfcp.far_list, far) {
@@ -177,8 +247,10 @@ void upf_n4_handle_session_establishment_request(
 
         /* Setup UE IP address */
         if (pdr->ue_ip_addr_len) {
-            if (req->pdn_type.presence == 1) {
-                cause_value = upf_sess_set_ue_ip(sess, req->pdn_type.u8, pdr);
+            ie = ogs_pfcp_ie_find(index, OGS_PFCP_PDN_TYPE_TYPE, NULL);
+            if (ie && ogs_pfcp_ie_decode(index, ie,
+                        &ogs_pfcp_tlv_desc_pdn_type, &pdn_type) == OGS_OK) {
+                cause_value = upf_sess_set_ue_ip(sess, pdn_type.u8, pdr);
                 if (cause_value != OGS_PFCP_CAUSE_REQUEST_ACCEPTED)
                     goto cleanup;
             } else {
@@ -208,6 +280,9 @@ void upf_n4_handle_session_establishment_request(
                     OGS_PFCP_OBJ_SESS_TYPE, pdr, restoration_indication);
     }
 
+    /* Rebuild PDR dispatch for the data path */
+    upf_sess_dispatch_build(sess);
+
     /* Send Buffered Packet to gNB/SGW */
     ogs_list_for_each(&sess->pfcp.pdr_list, pdr) {
         if (pdr->src_if == OGS_PFCP_INTERFACE_CORE) { /* Downlink */
@@ -231,6 +306,7 @@ cleanup:
     upf_metrics_inst_by_cause_add(cause_value,
             UPF_METR_CTR_SM_N4SESSIONESTABFAIL, 1);
     ogs_pfcp_sess_clear(&sess->pfcp);
+    upf_sess_dispatch_build(sess);
     ogs_pfcp_send_error_message(xact, sess ? sess->smf_n4_f_seid.seid : 0,
             OGS_PFCP_SESSION_ESTABLISHMENT_RESPONSE_TYPE,
             cause_value, offending_ie_value);
@@ -333,7 +409,11 @@ void upf_n4_handle_session_modification_request(
     if (cause_value != OGS_PFCP_CAUSE_REQUEST_ACCEPTED)
         goto cleanup;
 
-    upf_n4_handle_create_urr(sess, &req->create_urr[0], &cause_value, &offending_ie_value);
+    for (i = 0; i < OGS_MAX_NUM_OF_URR; i++) {
+        if (upf_n4_handle_create_urr(sess, &req->create_urr[i],
+                    &cause_value, &offending_ie_value) == NULL)
+            break;
+    }
     if (cause_value != OGS_PFCP_CAUSE_REQUEST_ACCEPTED)
         goto cleanup;
 
@@ -411,6 +491,9 @@ void upf_n4_handle_session_modification_request(
             ogs_pfcp_object_teid_hash_set(OGS_PFCP_OBJ_SESS_TYPE, pdr, false);
     }
 
+    /* Rebuild PDR dispatch for the data path */
+    upf_sess_dispatch_build(sess);
+
     /* Send Buffered Packet to gNB/SGW */
     ogs_list_for_each(&sess->pfcp.pdr_list, pdr) {
         if (pdr->src_if == OGS_PFCP_INTERFACE_CORE) { /* Downlink */
@@ -430,6 +513,7 @@ void upf_n4_handle_session_modification_request(
 
 cleanup:
     ogs_pfcp_sess_clear(&sess->pfcp);
+    upf_sess_dispatch_build(sess);
     ogs_pfcp_send_error_message(xact, sess ? sess->smf_n4_f_seid.seid : 0,
             OGS_PFCP_SESSION_MODIFICATION_RESPONSE_TYPE,
             cause_value, offending_ie_value);
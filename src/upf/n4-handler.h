@@ -27,8 +27,7 @@ extern "C" {
 #endif
 
 void upf_n4_handle_session_establishment_request(
-        upf_sess_t *sess, ogs_pfcp_xact_t *xact,
-        ogs_pfcp_session_establishment_request_t *req);
+        upf_sess_t *sess, ogs_pfcp_xact_t *xact, ogs_pfcp_ie_index_t *index);
 void upf_n4_handle_session_modification_request(
         upf_sess_t *sess, ogs_pfcp_xact_t *xact,
         ogs_pfcp_session_modification_request_t *req);
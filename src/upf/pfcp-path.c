@@ -63,7 +63,7 @@ static void pfcp_recv_cb(short when, ogs_socket_t fd, void *data)
     ogs_pkbuf_t *pkbuf = NULL;
     ogs_sockaddr_t from;
     ogs_pfcp_node_t *node = NULL;
-    ogs_pfcp_message_t *message = NULL;
+    ogs_pfcp_ie_index_t *index = NULL;
 
     ogs_pfcp_status_e pfcp_status;;
     ogs_pfcp_node_id_t node_id;
@@ -84,23 +84,24 @@ static void pfcp_recv_cb(short when, ogs_socket_t fd, void *data)
      *
      * Because ogs_pfcp_message_t is over 80kb in size,
      * it can cause stack overflow.
-     * To avoid this, the pfcp_message structure uses heap memory.
+     * Only the IE index is built here, and the IEs are decoded
+     * by the handlers as needed.
      */
-    if ((message = ogs_pfcp_parse_msg(pkbuf)) == NULL) {
-        ogs_error("ogs_pfcp_parse_msg() failed");
+    if ((index = ogs_pfcp_ie_index_parse(pkbuf)) == NULL) {
+        ogs_error("ogs_pfcp_ie_index_parse() failed");
         ogs_pkbuf_free(pkbuf);
         upf_event_free(e);
         return;
     }
 
-    pfcp_status = ogs_pfcp_extract_node_id(message, &node_id);
+    pfcp_status = ogs_pfcp_ie_index_extract_node_id(index, &node_id);
     switch (pfcp_status) {
     case OGS_PFCP_STATUS_SUCCESS:
     case OGS_PFCP_STATUS_NODE_ID_NONE:
     case OGS_PFCP_STATUS_NODE_ID_OPTIONAL_ABSENT:
         ogs_debug("ogs_pfcp_extract_node_id() "
                 "type [%d] pfcp_status [%d] node_id [%s] from %s",
-                message->h.type, pfcp_status,
+                index->h.type, pfcp_status,
                 pfcp_status == OGS_PFCP_STATUS_SUCCESS ?
                     ogs_pfcp_node_id_to_string_static(&node_id) :
                     "NULL",
@@ -113,14 +114,14 @@ static void pfcp_recv_cb(short when, ogs_socket_t fd, void *data)
     case OGS_PFCP_ERROR_UNKNOWN_MESSAGE:
         ogs_error("ogs_pfcp_extract_node_id() failed "
                 "type [%d] pfcp_status [%d] from %s",
-                message->h.type, pfcp_status,
+                index->h.type, pfcp_status,
                 ogs_sockaddr_to_string_static(&from));
         goto cleanup;
 
     default:
         ogs_error("Unexpected pfcp_status "
                 "type [%d] pfcp_status [%d] from %s",
-                message->h.type, pfcp_status,
+                index->h.type, pfcp_status,
                 ogs_sockaddr_to_string_static(&from));
         goto cleanup;
     }
@@ -128,8 +129,8 @@ static void pfcp_recv_cb(short when, ogs_socket_t fd, void *data)
     node = ogs_pfcp_node_find(&ogs_pfcp_self()->pfcp_peer_list,
             pfcp_status == OGS_PFCP_STATUS_SUCCESS ? &node_id : NULL, &from);
     if (!node) {
-        if (message->h.type == OGS_PFCP_ASSOCIATION_SETUP_REQUEST_TYPE ||
-            message->h.type == OGS_PFCP_ASSOCIATION_SETUP_RESPONSE_TYPE) {
+        if (index->h.type == OGS_PFCP_ASSOCIATION_SETUP_REQUEST_TYPE ||
+            index->h.type == OGS_PFCP_ASSOCIATION_SETUP_RESPONSE_TYPE) {
             ogs_assert(pfcp_status == OGS_PFCP_STATUS_SUCCESS);
             node = ogs_pfcp_node_add(&ogs_pfcp_self()->pfcp_peer_list,
                     &node_id, &from);
@@ -144,7 +145,7 @@ static void pfcp_recv_cb(short when, ogs_socket_t fd, void *data)
 
         } else {
             ogs_error("Cannot find PFCP-Node: type [%d] node_id %s from %s",
-                    message->h.type,
+                    index->h.type,
                     pfcp_status == OGS_PFCP_STATUS_SUCCESS ?
                         ogs_pfcp_node_id_to_string_static(&node_id) :
                         "NULL",
@@ -164,7 +165,7 @@ static void pfcp_recv_cb(short when, ogs_socket_t fd, void *data)
 
     e->pfcp_node = node;
     e->pkbuf = pkbuf;
-    e->pfcp_message = message;
+    e->pfcp_index = index;
 
     rv = ogs_queue_push(ogs_app()->queue, e);
     if (rv != OGS_OK) {
@@ -176,7 +177,7 @@ static void pfcp_recv_cb(short when, ogs_socket_t fd, void *data)
 
 cleanup:
     ogs_pkbuf_free(pkbuf);
-    ogs_pfcp_message_free(message);
+    ogs_pfcp_ie_index_free(index);
     upf_event_free(e);
 }
 
@@ -25,6 +25,23 @@
 #include "pfcp-path.h"
 #include "n4-handler.h"
 
+/*
+ * Messages small enough to be decoded on the stack
+ * from the IE index of the received message.
+ */
+typedef union upf_pfcp_message_u {
+    ogs_pfcp_heartbeat_request_t pfcp_heartbeat_request;
+    ogs_pfcp_heartbeat_response_t pfcp_heartbeat_response;
+    ogs_pfcp_association_setup_request_t pfcp_association_setup_request;
+    ogs_pfcp_association_setup_response_t pfcp_association_setup_response;
+    ogs_pfcp_session_deletion_request_t pfcp_session_deletion_request;
+    ogs_pfcp_session_report_response_t pfcp_session_report_response;
+} upf_pfcp_message_t;
+
+static int decode_message(
+        ogs_pfcp_ie_index_t *index, upf_pfcp_message_t *message);
+static void decode_error(ogs_pfcp_xact_t *xact,
+        ogs_pfcp_ie_index_t *index, upf_sess_t *sess);
 static void pfcp_restoration(ogs_pfcp_node_t *node);
 static void node_timeout(ogs_pfcp_xact_t *xact, void *data);
 
@@ -65,7 +82,8 @@ void upf_pfcp_state_will_associate(ogs_fsm_t *s, upf_event_t *e)
 {
     ogs_pfcp_node_t *node = NULL;
     ogs_pfcp_xact_t *xact = NULL;
-    ogs_pfcp_message_t *message = NULL;
+    ogs_pfcp_ie_index_t *index = NULL;
+    upf_pfcp_message_t message;
     ogs_assert(s);
     ogs_assert(e);
 
@@ -109,35 +127,42 @@ void upf_pfcp_state_will_associate(ogs_fsm_t *s, upf_event_t *e)
         }
         break;
     case UPF_EVT_N4_MESSAGE:
-        message = e->pfcp_message;
-        ogs_assert(message);
+        index = e->pfcp_index;
+        ogs_assert(index);
         xact = ogs_pfcp_xact_find_by_id(e->pfcp_xact_id);
         ogs_assert(xact);
 
-        switch (message->h.type) {
+        if (decode_message(index, &message) != OGS_OK) {
+            ogs_error("Cannot decode PFCP message type[%d]",
+                    index->h.type);
+            decode_error(xact, index, NULL);
+            break;
+        }
+
+        switch (index->h.type) {
         case OGS_PFCP_HEARTBEAT_REQUEST_TYPE:
             ogs_expect(true ==
                 ogs_pfcp_handle_heartbeat_request(node, xact,
-                    &message->pfcp_heartbeat_request));
+                    &message.pfcp_heartbeat_request));
             break;
         case OGS_PFCP_HEARTBEAT_RESPONSE_TYPE:
             ogs_expect(true ==
                 ogs_pfcp_handle_heartbeat_response(node, xact,
-                    &message->pfcp_heartbeat_response));
+                    &message.pfcp_heartbeat_response));
             break;
         case OGS_PFCP_ASSOCIATION_SETUP_REQUEST_TYPE:
             ogs_pfcp_up_handle_association_setup_request(node, xact,
-                    &message->pfcp_association_setup_request);
+                    &message.pfcp_association_setup_request);
             OGS_FSM_TRAN(s, upf_pfcp_state_associated);
             break;
         case OGS_PFCP_ASSOCIATION_SETUP_RESPONSE_TYPE:
             ogs_pfcp_up_handle_association_setup_response(node, xact,
-                    &message->pfcp_association_setup_response);
+                    &message.pfcp_association_setup_response);
             OGS_FSM_TRAN(s, upf_pfcp_state_associated);
             break;
         default:
             ogs_warn("cannot handle PFCP message type[%d]",
-                    message->h.type);
+                    index->h.type);
             break;
         }
         break;
@@ -151,7 +176,9 @@ void upf_pfcp_state_associated(ogs_fsm_t *s, upf_event_t *e)
 {
     ogs_pfcp_node_t *node = NULL;
     ogs_pfcp_xact_t *xact = NULL;
-    ogs_pfcp_message_t *message = NULL;
+    ogs_pfcp_ie_index_t *index = NULL;
+    ogs_pfcp_message_t *pfcp_message = NULL;
+    upf_pfcp_message_t message;
 
     upf_sess_t *sess = NULL;
 
@@ -188,19 +215,26 @@ void upf_pfcp_state_associated(ogs_fsm_t *s, upf_event_t *e)
         upf_metrics_inst_global_dec(UPF_METR_GLOB_GAUGE_PFCP_PEERS_ACTIVE);
         break;
     case UPF_EVT_N4_MESSAGE:
-        message = e->pfcp_message;
-        ogs_assert(message);
+        index = e->pfcp_index;
+        ogs_assert(index);
         xact = ogs_pfcp_xact_find_by_id(e->pfcp_xact_id);
         ogs_assert(xact);
 
-        if (message->h.seid_presence && message->h.seid != 0)
-            sess = upf_sess_find_by_upf_n4_seid(message->h.seid);
+        if (index->h.seid_presence && index->h.seid != 0)
+            sess = upf_sess_find_by_upf_n4_seid(index->h.seid);
 
-        switch (message->h.type) {
+        if (decode_message(index, &message) != OGS_OK) {
+            ogs_error("Cannot decode PFCP message type[%d]",
+                    index->h.type);
+            decode_error(xact, index, sess);
+            break;
+        }
+
+        switch (index->h.type) {
         case OGS_PFCP_HEARTBEAT_REQUEST_TYPE:
             ogs_expect(true ==
                 ogs_pfcp_handle_heartbeat_request(node, xact,
-                    &message->pfcp_heartbeat_request));
+                    &message.pfcp_heartbeat_request));
             if (node->restoration_required == true) {
                 if (node->t_association) {
         /*
@@ -228,7 +262,7 @@ void upf_pfcp_state_associated(ogs_fsm_t *s, upf_event_t *e)
         case OGS_PFCP_HEARTBEAT_RESPONSE_TYPE:
             ogs_expect(true ==
                 ogs_pfcp_handle_heartbeat_response(node, xact,
-                    &message->pfcp_heartbeat_response));
+                    &message.pfcp_heartbeat_response));
             if (node->restoration_required == true) {
         /*
          * node->t_association that the PFCP entity attempts an association.
@@ -256,36 +290,41 @@ void upf_pfcp_state_associated(ogs_fsm_t *s, upf_event_t *e)
             ogs_warn("PFCP[REQ] has already been associated %s",
                     ogs_sockaddr_to_string_static(node->addr_list));
             ogs_pfcp_up_handle_association_setup_request(node, xact,
-                    &message->pfcp_association_setup_request);
+                    &message.pfcp_association_setup_request);
             break;
         case OGS_PFCP_ASSOCIATION_SETUP_RESPONSE_TYPE:
             ogs_warn("PFCP[RSP] has already been associated %s",
                     ogs_sockaddr_to_string_static(node->addr_list));
             ogs_pfcp_up_handle_association_setup_response(node, xact,
-                    &message->pfcp_association_setup_response);
+                    &message.pfcp_association_setup_response);
             break;
         case OGS_PFCP_SESSION_ESTABLISHMENT_REQUEST_TYPE:
-            sess = upf_sess_add_by_message(message);
+            sess = upf_sess_add_by_ie_index(index);
             if (sess)
                 OGS_SETUP_PFCP_NODE(sess, node);
-            upf_n4_handle_session_establishment_request(
-                sess, xact, &message->pfcp_session_establishment_request);
+            upf_n4_handle_session_establishment_request(sess, xact, index);
             break;
         case OGS_PFCP_SESSION_MODIFICATION_REQUEST_TYPE:
+            pfcp_message = ogs_pfcp_ie_index_message(index);
+            if (!pfcp_message) {
+                ogs_error("ogs_pfcp_ie_index_message() failed");
+                decode_error(xact, index, sess);
+                break;
+            }
             upf_n4_handle_session_modification_request(
-                sess, xact, &message->pfcp_session_modification_request);
+                sess, xact, &pfcp_message->pfcp_session_modification_request);
             break;
         case OGS_PFCP_SESSION_DELETION_REQUEST_TYPE:
             upf_n4_handle_session_deletion_request(
-                sess, xact, &message->pfcp_session_deletion_request);
+                sess, xact, &message.pfcp_session_deletion_request);
             break;
         case OGS_PFCP_SESSION_REPORT_RESPONSE_TYPE:
             upf_n4_handle_session_report_response(
-                sess, xact, &message->pfcp_session_report_response);
+                sess, xact, &message.pfcp_session_report_response);
             break;
         default:
             ogs_error("Not implemented PFCP message type[%d]",
-                    message->h.type);
+                    index->h.type);
             break;
         }
 
@@ -334,6 +373,78 @@ void upf_pfcp_state_exception(ogs_fsm_t *s, upf_event_t *e)
     }
 }
 
+/*
+ * Session establishment and modification requests are not decoded here.
+ * They are too large for the stack and are read through the IE index.
+ */
+static int decode_message(
+        ogs_pfcp_ie_index_t *index, upf_pfcp_message_t *message)
+{
+    ogs_tlv_desc_t *desc = NULL;
+
+    ogs_assert(index);
+    ogs_assert(message);
+
+    memset(message, 0, sizeof(*message));
+
+    switch (index->h.type) {
+    case OGS_PFCP_HEARTBEAT_REQUEST_TYPE:
+        desc = &ogs_pfcp_msg_desc_pfcp_heartbeat_request;
+        break;
+    case OGS_PFCP_HEARTBEAT_RESPONSE_TYPE:
+        desc = &ogs_pfcp_msg_desc_pfcp_heartbeat_response;
+        break;
+    case OGS_PFCP_ASSOCIATION_SETUP_REQUEST_TYPE:
+        desc = &ogs_pfcp_msg_desc_pfcp_association_setup_request;
+        break;
+    case OGS_PFCP_ASSOCIATION_SETUP_RESPONSE_TYPE:
+        desc = &ogs_pfcp_msg_desc_pfcp_association_setup_response;
+        break;
+    case OGS_PFCP_SESSION_DELETION_REQUEST_TYPE:
+        desc = &ogs_pfcp_msg_desc_pfcp_session_deletion_request;
+        break;
+    case OGS_PFCP_SESSION_REPORT_RESPONSE_TYPE:
+        desc = &ogs_pfcp_msg_desc_pfcp_session_report_response;
+        break;
+    default:
+        return OGS_OK;
+    }
+
+    return ogs_pfcp_ie_index_decode_msg(index, desc, message);
+}
+
+/*
+ * The transaction of a message that cannot be decoded has already
+ * been created. A request is rejected if its response carries a cause.
+ * Otherwise, the transaction is deleted.
+ */
+static void decode_error(ogs_pfcp_xact_t *xact,
+        ogs_pfcp_ie_index_t *index, upf_sess_t *sess)
+{
+    uint8_t type;
+
+    ogs_assert(xact);
+    ogs_assert(index);
+
+    switch (index->h.type) {
+    case OGS_PFCP_ASSOCIATION_SETUP_REQUEST_TYPE:
+        type = OGS_PFCP_ASSOCIATION_SETUP_RESPONSE_TYPE;
+        break;
+    case OGS_PFCP_SESSION_MODIFICATION_REQUEST_TYPE:
+        type = OGS_PFCP_SESSION_MODIFICATION_RESPONSE_TYPE;
+        break;
+    case OGS_PFCP_SESSION_DELETION_REQUEST_TYPE:
+        type = OGS_PFCP_SESSION_DELETION_RESPONSE_TYPE;
+        break;
+    default:
+        ogs_pfcp_xact_delete(xact);
+        return;
+    }
+
+    ogs_pfcp_send_error_message(xact, sess ? sess->smf_n4_f_seid.seid : 0,
+            type, OGS_PFCP_CAUSE_MANDATORY_IE_INCORRECT, 0);
+}
+
 static void pfcp_restoration(ogs_pfcp_node_t *node)
 {
     upf_sess_t *sess = NULL, *next = NULL;
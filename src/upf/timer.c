@@ -28,6 +28,8 @@ const char *upf_timer_get_name(upf_timer_e id)
         return "UPF_TIMER_ASSOCIATION";
     case UPF_TIMER_NO_HEARTBEAT:
         return "UPF_TIMER_NO_HEARTBEAT";
+    case UPF_TIMER_POOL_TRIM:
+        return "UPF_TIMER_POOL_TRIM";
     default: 
        break;
     }
@@ -61,3 +63,18 @@ void upf_timer_no_heartbeat(void *data)
 {
     timer_send_event(UPF_TIMER_NO_HEARTBEAT, data);
 }
+
+void upf_timer_pool_trim(void *data)
+{
+    int rv;
+    upf_event_t *e = NULL;
+
+    e = upf_event_new(UPF_EVT_POOL_TIMER);
+    e->timer_id = UPF_TIMER_POOL_TRIM;
+
+    rv = ogs_queue_push(ogs_app()->queue, e);
+    if (rv != OGS_OK) {
+        ogs_error("ogs_queue_push() failed:%d", (int)rv);
+        upf_event_free(e);
+    }
+}
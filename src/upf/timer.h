@@ -32,6 +32,7 @@ typedef enum {
 
     UPF_TIMER_ASSOCIATION,
     UPF_TIMER_NO_HEARTBEAT,
+    UPF_TIMER_POOL_TRIM,
 
     MAX_NUM_OF_UPF_TIMER,
 
@@ -41,6 +42,7 @@ const char *upf_timer_get_name(upf_timer_e id);
 
 void upf_timer_association(void *data);
 void upf_timer_no_heartbeat(void *data);
+void upf_timer_pool_trim(void *data);
 
 #ifdef __cplusplus
 }
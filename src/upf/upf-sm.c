@@ -23,12 +23,21 @@
 #include "pfcp-path.h"
 #include "gtp-path.h"
 
+#define POOL_TRIM_TIME ogs_time_from_sec(60)
+
+static ogs_timer_t *t_pool_trim = NULL;
+
 void upf_state_initial(ogs_fsm_t *s, upf_event_t *e)
 {
     upf_sm_debug(e);
 
     ogs_assert(s);
 
+    t_pool_trim = ogs_timer_add(ogs_app()->timer_mgr,
+            upf_timer_pool_trim, 0);
+    ogs_assert(t_pool_trim);
+    ogs_timer_start(t_pool_trim, POOL_TRIM_TIME);
+
     OGS_FSM_TRAN(s, &upf_state_operational);
 }
 
@@ -36,6 +45,9 @@ void upf_state_final(ogs_fsm_t *s, upf_event_t *e)
 {
     upf_sm_debug(e);
 
+    if (t_pool_trim)
+        ogs_timer_delete(t_pool_trim);
+
     ogs_assert(s);
 }
 
@@ -44,7 +56,7 @@ void upf_state_operational(ogs_fsm_t *s, upf_event_t *e)
     int rv;
     ogs_pkbuf_t *recvbuf = NULL;
 
-    ogs_pfcp_message_t *pfcp_message = NULL;
+    ogs_pfcp_ie_index_t *pfcp_index = NULL;
     ogs_pfcp_node_t *node = NULL;
     ogs_pfcp_xact_t *xact = NULL;
 
@@ -57,22 +69,24 @@ void upf_state_operational(ogs_fsm_t *s, upf_event_t *e)
         break;
 
     case OGS_FSM_EXIT_SIG:
+        if (t_pool_trim)
+            ogs_timer_stop(t_pool_trim);
         break;
 
     case UPF_EVT_N4_MESSAGE:
         ogs_assert(e);
         recvbuf = e->pkbuf;
         ogs_assert(recvbuf);
-        pfcp_message = e->pfcp_message;
-        ogs_assert(pfcp_message);
+        pfcp_index = e->pfcp_index;
+        ogs_assert(pfcp_index);
         node = e->pfcp_node;
         ogs_assert(node);
         ogs_assert(OGS_FSM_STATE(&node->sm));
 
-        rv = ogs_pfcp_xact_receive(node, &pfcp_message->h, &xact);
+        rv = ogs_pfcp_xact_receive(node, &pfcp_index->h, &xact);
         if (rv != OGS_OK) {
             ogs_pkbuf_free(recvbuf);
-            ogs_pfcp_message_free(pfcp_message);
+            ogs_pfcp_ie_index_free(pfcp_index);
             break;
         }
 
@@ -83,7 +97,7 @@ void upf_state_operational(ogs_fsm_t *s, upf_event_t *e)
         }
 
         ogs_pkbuf_free(recvbuf);
-        ogs_pfcp_message_free(pfcp_message);
+        ogs_pfcp_ie_index_free(pfcp_index);
         break;
     case UPF_EVT_N4_TIMER:
     case UPF_EVT_N4_NO_HEARTBEAT:
@@ -93,6 +107,18 @@ void upf_state_operational(ogs_fsm_t *s, upf_event_t *e)
 
         ogs_fsm_dispatch(&node->sm, e);
         break;
+    case UPF_EVT_POOL_TIMER:
+        switch(e->timer_id) {
+        case UPF_TIMER_POOL_TRIM:
+            upf_pool_trim();
+            ogs_timer_start(t_pool_trim, POOL_TRIM_TIME);
+            break;
+
+        default:
+            ogs_error("Unknown timer[%s:%d]",
+                    upf_timer_get_name(e->timer_id), e->timer_id);
+        }
+        break;
     default:
         ogs_error("No handler for event %s", upf_event_get_name(e));
         break;
@@ -0,0 +1,657 @@
+/*
+ * Copyright (C) 2019-2024 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Core primitives microbenchmarks
+ *
+ * Pool, hash, timer, queue, pkbuf, TLV and ASN.1 codecs, measured
+ * with the same inputs on every run : the random sequences come from
+ * a fixed seed, the TLV message is a GTPv2 Create Session Request and
+ * the ASN.1 message is an NGAP NG Setup Request.
+ *
+ *   ./tests/bench/core-bench -r 5 -m 10000000
+ *   ./tests/bench/core-bench -b hash
+ *
+ * Each benchmark is run once to warm up, then 'runs' times.
+ * It prints one line of key=value pairs, with the median, the minimum
+ * and the maximum time per operation in nanoseconds.
+ */
+
+#include <time.h>
+
+#include "ogs-gtp.h"
+#include "ogs-ngap.h"
+
+#define BENCH_MAX_RUNS          32
+#define BENCH_OPS               1000000
+
+static struct {
+    int runs;
+    int max_entries;
+    const char *filter;
+} opt = {
+    .runs = 5,
+    .max_entries = 1000000,
+};
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* xorshift32 with a fixed seed, so that each run does the same work */
+static uint32_t bench_seed;
+
+static void bench_srand(void)
+{
+    bench_seed = 0x9e3779b9;
+}
+
+static uint32_t bench_rand(void)
+{
+    bench_seed ^= bench_seed << 13;
+    bench_seed ^= bench_seed >> 17;
+    bench_seed ^= bench_seed << 5;
+    return bench_seed;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/*
+ * The function sets up, times its operations only and cleans up.
+ * It returns the elapsed nanoseconds and the number of operations.
+ */
+typedef uint64_t (*bench_f)(int param, uint64_t *ops);
+
+static void run(const char *name, const char *param_name, int param,
+        bench_f func)
+{
+    double ns[BENCH_MAX_RUNS];
+    uint64_t elapsed, ops = 0;
+    int i;
+
+    if (opt.filter && strncmp(name, opt.filter, strlen(opt.filter)) != 0)
+        return;
+
+    bench_srand();
+    func(param, &ops);
+
+    for (i = 0; i < opt.runs; i++) {
+        bench_srand();
+        elapsed = func(param, &ops);
+        ns[i] = ops ? (double)elapsed / ops : 0;
+    }
+    qsort(ns, opt.runs, sizeof(ns[0]), compare_double);
+
+    printf("bench=%s %s=%d runs=%d ops=%llu "
+            "ns_per_op=%.1f min=%.1f max=%.1f mops=%.2f\n",
+            name, param_name, param, opt.runs, (unsigned long long)ops,
+            ns[opt.runs/2], ns[0], ns[opt.runs-1],
+            ns[opt.runs/2] > 0 ? 1000 / ns[opt.runs/2] : 0);
+    fflush(stdout);
+}
+
+/*
+ * Pool
+ */
+typedef struct bench_node_s {
+    ogs_pool_id_t id;
+    uint64_t data[3];
+} bench_node_t;
+
+static OGS_POOL(node_pool, bench_node_t);
+
+static uint64_t bench_pool_alloc_free(int size, uint64_t *ops)
+{
+    bench_node_t **node = NULL;
+    uint64_t start, elapsed = 0;
+    int i, round, rounds = ogs_max(1, BENCH_OPS / size);
+
+    ogs_pool_init(&node_pool, size);
+    node = ogs_calloc(size, sizeof(*node));
+    ogs_assert(node);
+
+    start = now_ns();
+    for (round = 0; round < rounds; round++) {
+        for (i = 0; i < size; i++)
+            ogs_pool_id_calloc(&node_pool, &node[i]);
+        for (i = 0; i < size; i++)
+            ogs_pool_id_free(&node_pool, node[i]);
+    }
+    elapsed = now_ns() - start;
+
+    ogs_free(node);
+    ogs_pool_final(&node_pool);
+
+    *ops = (uint64_t)rounds * size;
+    return elapsed;
+}
+
+static uint64_t bench_pool_find_by_id(int size, uint64_t *ops)
+{
+    bench_node_t *node = NULL;
+    ogs_pool_id_t *id = NULL;
+    uint32_t *order = NULL;
+    uint64_t start, elapsed, found = 0;
+    int i;
+
+    ogs_pool_init(&node_pool, size);
+    id = ogs_calloc(size, sizeof(*id));
+    ogs_assert(id);
+    order = ogs_calloc(BENCH_OPS, sizeof(*order));
+    ogs_assert(order);
+
+    for (i = 0; i < size; i++) {
+        ogs_pool_id_calloc(&node_pool, &node);
+        ogs_assert(node);
+        id[i] = node->id;
+    }
+    for (i = 0; i < BENCH_OPS; i++)
+        order[i] = bench_rand() % size;
+
+    start = now_ns();
+    for (i = 0; i < BENCH_OPS; i++)
+        if (ogs_pool_find_by_id(&node_pool, id[order[i]]))
+            found++;
+    elapsed = now_ns() - start;
+    ogs_assert(found == BENCH_OPS);
+
+    for (i = 0; i < size; i++)
+        ogs_pool_id_free(&node_pool, ogs_pool_find_by_id(&node_pool, id[i]));
+    ogs_free(order);
+    ogs_free(id);
+    ogs_pool_final(&node_pool);
+
+    *ops = BENCH_OPS;
+    return elapsed;
+}
+
+/*
+ * Hash : 64-bit binary keys, like the SEID and the TEID tables
+ */
+static uint64_t *hash_keys(int entries)
+{
+    uint64_t *key = ogs_calloc(entries, sizeof(*key));
+    int i;
+
+    ogs_assert(key);
+    for (i = 0; i < entries; i++)
+        key[i] = ((uint64_t)bench_rand() << 32) | i;
+
+    return key;
+}
+
+static uint64_t bench_hash_set(int entries, uint64_t *ops)
+{
+    ogs_hash_t *hash = NULL;
+    uint64_t *key = hash_keys(entries);
+    uint64_t start, elapsed;
+    int i, round, rounds = ogs_max(1, BENCH_OPS / entries);
+
+    hash = ogs_hash_make();
+    ogs_assert(hash);
+
+    /* Insert all, then delete all */
+    start = now_ns();
+    for (round = 0; round < rounds; round++) {
+        for (i = 0; i < entries; i++)
+            ogs_hash_set(hash, &key[i], sizeof(key[i]), &key[i]);
+        for (i = 0; i < entries; i++)
+            ogs_hash_set(hash, &key[i], sizeof(key[i]), NULL);
+    }
+    elapsed = now_ns() - start;
+
+    ogs_hash_destroy(hash);
+    ogs_free(key);
+
+    *ops = (uint64_t)rounds * entries * 2;
+    return elapsed;
+}
+
+static uint64_t bench_hash_get(int entries, uint64_t *ops)
+{
+    ogs_hash_t *hash = NULL;
+    uint64_t *key = hash_keys(entries);
+    uint32_t *order = NULL;
+    uint64_t start, elapsed, found = 0;
+    int i;
+
+    hash = ogs_hash_make();
+    ogs_assert(hash);
+    for (i = 0; i < entries; i++)
+        ogs_hash_set(hash, &key[i], sizeof(key[i]), &key[i]);
+
+    order = ogs_calloc(BENCH_OPS, sizeof(*order));
+    ogs_assert(order);
+    for (i = 0; i < BENCH_OPS; i++)
+        order[i] = bench_rand() % entries;
+
+    start = now_ns();
+    for (i = 0; i < BENCH_OPS; i++)
+        if (ogs_hash_get(hash, &key[order[i]], sizeof(key[0])))
+            found++;
+    elapsed = now_ns() - start;
+    ogs_assert(found == BENCH_OPS);
+
+    ogs_free(order);
+    ogs_hash_clear(hash);
+    ogs_hash_destroy(hash);
+    ogs_free(key);
+
+    *ops = BENCH_OPS;
+    return elapsed;
+}
+
+/*
+ * Timer : most of the protocol timers are stopped before they expire,
+ * e.g. a retransmission timer on the response. 'cancel' is the percent
+ * of the timers stopped, the others expire.
+ */
+#define BENCH_TIMERS 10000
+
+static int timer_expired;
+
+static void timer_cb(void *data)
+{
+    timer_expired++;
+}
+
+static uint64_t bench_timer(int cancel, uint64_t *ops)
+{
+    ogs_timer_mgr_t *mgr = NULL;
+    ogs_timer_t **timer = NULL;
+    bool *stop = NULL;
+    uint64_t start, elapsed;
+    int i, round, rounds = BENCH_OPS / BENCH_TIMERS, stopped = 0;
+
+    mgr = ogs_timer_mgr_create(BENCH_TIMERS);
+    ogs_assert(mgr);
+    timer = ogs_calloc(BENCH_TIMERS, sizeof(*timer));
+    ogs_assert(timer);
+    stop = ogs_calloc(BENCH_TIMERS, sizeof(*stop));
+    ogs_assert(stop);
+
+    for (i = 0; i < BENCH_TIMERS; i++) {
+        timer[i] = ogs_timer_add(mgr, timer_cb, NULL);
+        ogs_assert(timer[i]);
+        stop[i] = (int)(bench_rand() % 100) < cancel;
+        if (stop[i])
+            stopped++;
+    }
+
+    timer_expired = 0;
+
+    start = now_ns();
+    for (round = 0; round < rounds; round++) {
+        /* The ones to stop would expire much later than the others */
+        for (i = 0; i < BENCH_TIMERS; i++)
+            ogs_timer_start(timer[i], stop[i] ?
+                    ogs_time_from_sec(60 + (i & 63)) : 1);
+        for (i = 0; i < BENCH_TIMERS; i++)
+            if (stop[i])
+                ogs_timer_stop(timer[i]);
+        do {
+            ogs_timer_mgr_expire(mgr);
+        } while (timer_expired < (round + 1) * (BENCH_TIMERS - stopped));
+    }
+    elapsed = now_ns() - start;
+
+    for (i = 0; i < BENCH_TIMERS; i++)
+        ogs_timer_delete(timer[i]);
+    ogs_free(stop);
+    ogs_free(timer);
+    ogs_timer_mgr_destroy(mgr);
+
+    *ops = (uint64_t)rounds * BENCH_TIMERS;
+    return elapsed;
+}
+
+/*
+ * Queue : one producer thread, the consumer is the caller,
+ * like the SBI and the PFCP threads feeding the event loop.
+ */
+static ogs_queue_t *queue;
+
+static void queue_producer(void *data)
+{
+    intptr_t i, count = (intptr_t)data;
+
+    for (i = 1; i <= count; i++)
+        ogs_assert(ogs_queue_push(queue, (void *)i) == OGS_OK);
+}
+
+static uint64_t bench_queue(int capacity, uint64_t *ops)
+{
+    ogs_thread_t *thread = NULL;
+    void *data = NULL;
+    uint64_t start, elapsed;
+    intptr_t i, sum = 0;
+
+    queue = ogs_queue_create(capacity);
+    ogs_assert(queue);
+
+    start = now_ns();
+    thread = ogs_thread_create(queue_producer, (void *)(intptr_t)BENCH_OPS);
+    ogs_assert(thread);
+    for (i = 0; i < BENCH_OPS; i++) {
+        ogs_assert(ogs_queue_pop(queue, &data) == OGS_OK);
+        sum += (intptr_t)data;
+    }
+    elapsed = now_ns() - start;
+    ogs_assert(sum == (intptr_t)BENCH_OPS * (BENCH_OPS + 1) / 2);
+
+    ogs_thread_destroy(thread);
+    ogs_queue_destroy(queue);
+
+    *ops = BENCH_OPS;
+    return elapsed;
+}
+
+/*
+ * Packet buffer
+ */
+static uint64_t bench_pkbuf_alloc_free(int size, uint64_t *ops)
+{
+    ogs_pkbuf_t *pkbuf[64];
+    uint64_t start, elapsed;
+    int i, round, rounds = BENCH_OPS / 64;
+
+    start = now_ns();
+    for (round = 0; round < rounds; round++) {
+        for (i = 0; i < 64; i++) {
+            pkbuf[i] = ogs_pkbuf_alloc(NULL, size);
+            ogs_assert(pkbuf[i]);
+        }
+        for (i = 0; i < 64; i++)
+            ogs_pkbuf_free(pkbuf[i]);
+    }
+    elapsed = now_ns() - start;
+
+    *ops = (uint64_t)rounds * 64;
+    return elapsed;
+}
+
+static uint64_t bench_pkbuf_copy(int size, uint64_t *ops)
+{
+    ogs_pkbuf_t *pkbuf = NULL, *copy = NULL;
+    uint64_t start, elapsed;
+    int i;
+
+    pkbuf = ogs_pkbuf_alloc(NULL, OGS_TLV_MAX_HEADROOM + size);
+    ogs_assert(pkbuf);
+    ogs_pkbuf_reserve(pkbuf, OGS_TLV_MAX_HEADROOM);
+    ogs_pkbuf_put(pkbuf, size);
+    memset(pkbuf->data, 0x5a, size);
+
+    start = now_ns();
+    for (i = 0; i < BENCH_OPS; i++) {
+        copy = ogs_pkbuf_copy(pkbuf);
+        ogs_assert(copy);
+        ogs_pkbuf_free(copy);
+    }
+    elapsed = now_ns() - start;
+
+    ogs_pkbuf_free(pkbuf);
+
+    *ops = BENCH_OPS;
+    return elapsed;
+}
+
+/*
+ * TLV : GTPv2-C Create Session Request of tests/unit/gtp-message-test.c
+ */
+static const char *gtp2_csr_payload =
+    "0100080055153011 340010f44c000600 9471527600414b00 0800536120009178"
+    "840056000d001855 f501102255f50100 019d015300030055 f501520001000657"
+    "0009008a80000084 0a32360a57000901 87000000000a3236 254700220005766f"
+    "6c7465036e673204 6d6e6574066d6e63 303130066d636335 3535046770727380"
+    "000100fc63000100 014f000500010000 00007f0001000048 000800000003e800"
+    "0007d04e001a0080 8021100100001081 0600000000830600 000000000d00000a"
+    "005d001f00490001 0005500016004505 0000000000000000 0000000000000000"
+    "0000000072000200 40005f0002005400";
+
+static ogs_pkbuf_t *payload_pkbuf(const char *payload)
+{
+    char hexbuf[OGS_HUGE_LEN];
+    ogs_pkbuf_t *pkbuf = NULL;
+    int len = 0;
+    const char *p;
+
+    for (p = payload; *p; p++)
+        if (*p != ' ')
+            len++;
+
+    pkbuf = ogs_pkbuf_alloc(NULL, OGS_TLV_MAX_HEADROOM + len / 2);
+    ogs_assert(pkbuf);
+    ogs_pkbuf_reserve(pkbuf, OGS_TLV_MAX_HEADROOM);
+    ogs_pkbuf_put_data(pkbuf,
+            ogs_hex_from_string(payload, hexbuf, sizeof(hexbuf)), len / 2);
+
+    return pkbuf;
+}
+
+static uint64_t bench_tlv_build(int size, uint64_t *ops)
+{
+    ogs_gtp2_create_session_request_t req;
+    ogs_pkbuf_t *pkbuf = payload_pkbuf(gtp2_csr_payload), *msg = NULL;
+    uint64_t start, elapsed;
+    int i;
+
+    /* The IEs point into the payload */
+    memset(&req, 0, sizeof(req));
+    ogs_assert(ogs_tlv_parse_msg(&req,
+            &ogs_gtp2_tlv_desc_create_session_request,
+            pkbuf, OGS_TLV_MODE_T1_L2_I1) == OGS_OK);
+
+    start = now_ns();
+    for (i = 0; i < BENCH_OPS; i++) {
+        msg = ogs_tlv_build_msg(&ogs_gtp2_tlv_desc_create_session_request,
+                &req, OGS_TLV_MODE_T1_L2_I1);
+        ogs_assert(msg);
+        ogs_pkbuf_free(msg);
+    }
+    elapsed = now_ns() - start;
+
+    ogs_pkbuf_free(pkbuf);
+
+    *ops = BENCH_OPS;
+    return elapsed;
+}
+
+static uint64_t bench_tlv_parse(int size, uint64_t *ops)
+{
+    ogs_gtp2_create_session_request_t req;
+    ogs_pkbuf_t *pkbuf = payload_pkbuf(gtp2_csr_payload);
+    uint64_t start, elapsed;
+    int i;
+
+    start = now_ns();
+    for (i = 0; i < BENCH_OPS; i++) {
+        memset(&req, 0, sizeof(req));
+        ogs_assert(ogs_tlv_parse_msg(&req,
+                &ogs_gtp2_tlv_desc_create_session_request,
+                pkbuf, OGS_TLV_MODE_T1_L2_I1) == OGS_OK);
+    }
+    elapsed = now_ns() - start;
+
+    ogs_pkbuf_free(pkbuf);
+
+    *ops = BENCH_OPS;
+    return elapsed;
+}
+
+/*
+ * ASN.1 APER : NG Setup Request of tests/unit/ngap-message-test.c
+ */
+#define BENCH_ASN_OPS (BENCH_OPS / 10)
+
+static const char *ngap_ng_setup_request_payload =
+    "0015004200000500 1b00090009f10728 000800000052400b 0400354720674e42"
+    "2d43550066000d00 000000010009f107 0000000800154001 0001114009403035"
+    "484c41423032";
+
+static uint64_t bench_asn_encode(int size, uint64_t *ops)
+{
+    ogs_ngap_message_t message;
+    ogs_pkbuf_t *pkbuf = payload_pkbuf(ngap_ng_setup_request_payload);
+    ogs_pkbuf_t *encoded = NULL;
+    uint64_t start, elapsed;
+    int i;
+
+    ogs_assert(ogs_ngap_decode(&message, pkbuf) == OGS_OK);
+
+    start = now_ns();
+    for (i = 0; i < BENCH_ASN_OPS; i++) {
+        encoded = ogs_ngap_encode(&message);
+        ogs_assert(encoded);
+        ogs_pkbuf_free(encoded);
+    }
+    elapsed = now_ns() - start;
+
+    ogs_ngap_free(&message);
+    ogs_pkbuf_free(pkbuf);
+
+    *ops = BENCH_ASN_OPS;
+    return elapsed;
+}
+
+static uint64_t bench_asn_decode(int size, uint64_t *ops)
+{
+    ogs_ngap_message_t message;
+    ogs_pkbuf_t *pkbuf = payload_pkbuf(ngap_ng_setup_request_payload);
+    uint64_t start, elapsed;
+    int i;
+
+    start = now_ns();
+    for (i = 0; i < BENCH_ASN_OPS; i++) {
+        ogs_assert(ogs_ngap_decode(&message, pkbuf) == OGS_OK);
+        ogs_ngap_free(&message);
+    }
+    elapsed = now_ns() - start;
+
+    ogs_pkbuf_free(pkbuf);
+
+    *ops = BENCH_ASN_OPS;
+    return elapsed;
+}
+
+static void show_help(const char *name)
+{
+    printf("Usage: %s [options]\n"
+        "Options:\n"
+       "   -b name        : run the benchmarks starting with this name\n"
+       "   -r runs        : measured runs of each benchmark (default:5)\n"
+       "   -m entries     : largest hash table (default:1000000)\n"
+       "   -e level       : set global log-level (default:error)\n"
+       "   -h             : show this message and exit\n"
+       "\n", name);
+}
+
+static void terminate(void)
+{
+    ogs_pkbuf_default_destroy();
+    ogs_core_terminate();
+}
+
+int main(int argc, const char *const argv[])
+{
+    int rv, n, opt_c;
+    ogs_getopt_t options;
+    char *log_level = (char *)"error";
+    ogs_pkbuf_config_t config;
+
+    ogs_getopt_init(&options, (char**)argv);
+    while ((opt_c = ogs_getopt(&options, "hb:r:m:e:")) != -1) {
+        switch (opt_c) {
+        case 'h':
+            show_help(argv[0]);
+            return OGS_OK;
+        case 'b':
+            opt.filter = options.optarg;
+            break;
+        case 'r':
+            opt.runs = atoi(options.optarg);
+            break;
+        case 'm':
+            opt.max_entries = atoi(options.optarg);
+            break;
+        case 'e':
+            log_level = options.optarg;
+            break;
+        case '?':
+            fprintf(stderr, "%s: %s\n", argv[0], options.errmsg);
+            show_help(argv[0]);
+            return OGS_ERROR;
+        default:
+            fprintf(stderr, "%s: should not be reached\n", OGS_FUNC);
+            return OGS_ERROR;
+        }
+    }
+
+    if (opt.runs < 1 || opt.runs > BENCH_MAX_RUNS || opt.max_entries < 1000) {
+        show_help(argv[0]);
+        return OGS_ERROR;
+    }
+
+    ogs_core_initialize();
+    ogs_pkbuf_default_init(&config);
+    ogs_pkbuf_default_create(&config);
+    atexit(terminate);
+
+    rv = ogs_log_config_domain(NULL, log_level);
+    if (rv != OGS_OK) return rv;
+
+    for (n = 1000; n <= 1000000; n *= 10)
+        run("pool_alloc_free", "size", n, bench_pool_alloc_free);
+    for (n = 1000; n <= 1000000; n *= 10)
+        run("pool_find_by_id", "size", n, bench_pool_find_by_id);
+
+    for (n = 1000; n <= opt.max_entries; n *= 10)
+        run("hash_set", "entries", n, bench_hash_set);
+    for (n = 1000; n <= opt.max_entries; n *= 10)
+        run("hash_get", "entries", n, bench_hash_get);
+
+    run("timer", "cancel", 0, bench_timer);
+    run("timer", "cancel", 50, bench_timer);
+    run("timer", "cancel", 90, bench_timer);
+
+    run("queue", "capacity", 64, bench_queue);
+    run("queue", "capacity", 1024, bench_queue);
+
+    run("pkbuf_alloc_free", "size", 128, bench_pkbuf_alloc_free);
+    run("pkbuf_alloc_free", "size", 2048, bench_pkbuf_alloc_free);
+    run("pkbuf_copy", "size", 128, bench_pkbuf_copy);
+    run("pkbuf_copy", "size", 1400, bench_pkbuf_copy);
+
+    run("tlv_build", "size", 240, bench_tlv_build);
+    run("tlv_parse", "size", 240, bench_tlv_parse);
+
+    run("asn_encode", "size", 70, bench_asn_encode);
+    run("asn_decode", "size", 70, bench_asn_decode);
+
+    return OGS_OK;
+}
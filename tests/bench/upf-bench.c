@@ -0,0 +1,1024 @@
+/*
+ * Copyright (C) 2019-2024 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Offline UPF data plane benchmark
+ *
+ * The UPF runs in-process with its own thread, exactly as open5gs-upfd.
+ * This program plays the SMF, the gNB and the data network :
+ *
+ *   SMF  127.0.0.4:8805 <-- PFCP --> 127.0.0.7:8805 UPF
+ *   gNB  127.0.0.2:2152 <-- GTP-U -> 127.0.0.7:2152 UPF
+ *   DN   10.45.0.1:9999 <-- IP ----> ogstun         UPF
+ *
+ * N sessions are set up through the N4 handlers, then UL G-PDUs and
+ * DL IP packets are pushed through the same receive callbacks used in
+ * production. Only the sizes are taken from the pcap file, if any.
+ *
+ * It needs an ogstun device and the loopback addresses, so run it
+ * in a private network namespace :
+ *
+ *   unshare -rn sh -c '
+ *     ip link set lo up;
+ *     ip tuntap add name ogstun mode tun;
+ *     ip addr add 10.45.0.1/16 dev ogstun;
+ *     ip link set ogstun up;
+ *     ./tests/bench/upf-bench -n 1000 -p 1000000 -f 4'
+ *
+ * Each run prints one line of key=value pairs per direction.
+ */
+
+#include <poll.h>
+#include <unistd.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+
+#include "ogs-app.h"
+#include "ogs-gtp.h"
+#include "ogs-pfcp.h"
+#include "version.h"
+
+#define BENCH_SMF_ADDR          "127.0.0.4"
+#define BENCH_GNB_ADDR          "127.0.0.2"
+#define BENCH_UPF_ADDR          "127.0.0.7"
+#define BENCH_DN_ADDR           "10.45.0.1"
+#define BENCH_DN_PORT           9999
+
+#define BENCH_MIN_SIZE          (int)(sizeof(struct ip) + sizeof(struct udphdr))
+#define BENCH_MAX_SIZE          1400
+#define BENCH_MAX_FILTER        7
+#define BENCH_LOSS_TIMEOUT      ogs_time_from_msec(100)
+
+#define BENCH_UL_TEID(__i)      (0x100 + (__i))
+#define BENCH_DL_TEID(__i)      (0x200000 + (__i))
+#define BENCH_UE_ADDR(__i)      htobe32(0x0a2d0000 + (__i) + 2)
+
+static struct {
+    int sessions;
+    int packets;
+    int size;
+    int filters;
+    uint64_t urr_threshold;
+    uint64_t mbr;
+    int window;
+    bool ul;
+    bool dl;
+    const char *pcap_file;
+} opt = {
+    .sessions = 1,
+    .packets = 100000,
+    .size = 128,
+    .window = 256,
+    .ul = true,
+    .dl = true,
+};
+
+static int *size_mix;
+static int num_of_size_mix;
+
+static ogs_pkbuf_t *assoc_req;
+static ogs_pkbuf_t **sess_req;
+
+static int pfcp_fd, gnb_fd, dn_fd, src_fd;
+static uint64_t *up_seid;
+static int num_of_sess_rsp;
+static uint32_t pfcp_xid;
+
+static struct sockaddr_in sockaddr(const char *addr, uint16_t port)
+{
+    struct sockaddr_in sin;
+
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_port = htobe16(port);
+    ogs_assert(inet_pton(AF_INET, addr, &sin.sin_addr) == 1);
+
+    return sin;
+}
+
+static int udp_open(const char *addr, uint16_t port)
+{
+    struct sockaddr_in sin;
+    int fd, rcvbuf = 8*1024*1024;
+
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    ogs_assert(fd >= 0);
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    if (addr) {
+        sin = sockaddr(addr, port);
+        if (bind(fd, (struct sockaddr *)&sin, sizeof(sin)) != 0) {
+            ogs_error("bind(%s:%d) failed : %s",
+                    addr, port, strerror(errno));
+            close(fd);
+            return -1;
+        }
+    }
+
+    return fd;
+}
+
+/*
+ * Packet size mix
+ *
+ * Classic pcap with Ethernet, Linux cooked or raw IP link types.
+ * For GTP-U packets, the size of the inner IP packet is used.
+ */
+static int ip_len(const uint8_t *p, int len)
+{
+    int hlen;
+
+    if (len < 1)
+        return -1;
+
+    if ((p[0] >> 4) == 6)
+        return len < 40 ? -1 : 40 + ((p[4] << 8) | p[5]);
+    if ((p[0] >> 4) != 4 || len < 20)
+        return -1;
+
+    hlen = (p[0] & 0x0f) << 2;
+    if (p[9] == IPPROTO_UDP && len >= hlen + 8 + 8 &&
+        ((p[hlen] << 8 | p[hlen+1]) == OGS_GTPV1_U_UDP_PORT ||
+         (p[hlen+2] << 8 | p[hlen+3]) == OGS_GTPV1_U_UDP_PORT) &&
+        p[hlen+8+1] == OGS_GTPU_MSGTYPE_GPDU) {
+        const uint8_t *gtp = p + hlen + 8;
+        int glen = 8;
+
+        if (gtp[0] & 0x07) {
+            glen += 4;
+            if (gtp[0] & 0x04) {
+                /* Walk the extension header chain */
+                while (glen <= len - hlen - 8 && gtp[glen-1]) {
+                    if (glen >= len - hlen - 8 || !gtp[glen])
+                        return -1;
+                    glen += gtp[glen] * 4;
+                }
+            }
+        }
+        if (hlen + 8 + glen < len)
+            return ip_len(gtp + glen, len - hlen - 8 - glen);
+    }
+
+    return (p[2] << 8) | p[3];
+}
+
+static int pcap_load(const char *filename)
+{
+    FILE *fp = NULL;
+    uint8_t hdr[24], rec[16], *frame = NULL;
+    bool swapped;
+    uint32_t magic, linktype, caplen, maxlen = 65536;
+    int max = 1024;
+
+#define PCAP_U32(__p) (swapped ? \
+        (uint32_t)((__p)[0] << 24 | (__p)[1] << 16 | (__p)[2] << 8 | (__p)[3]) : \
+        (uint32_t)((__p)[3] << 24 | (__p)[2] << 16 | (__p)[1] << 8 | (__p)[0]))
+
+    fp = fopen(filename, "rb");
+    if (!fp) {
+        ogs_error("Cannot open [%s] : %s", filename, strerror(errno));
+        return OGS_ERROR;
+    }
+
+    if (fread(hdr, sizeof(hdr), 1, fp) != 1) {
+        ogs_error("Truncated pcap header [%s]", filename);
+        fclose(fp);
+        return OGS_ERROR;
+    }
+
+    magic = hdr[3] << 24 | hdr[2] << 16 | hdr[1] << 8 | hdr[0];
+    if (magic == 0xa1b2c3d4 || magic == 0xa1b23c4d) {
+        swapped = false;
+    } else if (magic == 0xd4c3b2a1 || magic == 0x4d3cb2a1) {
+        swapped = true;
+    } else {
+        ogs_error("Not a pcap file [%s], pcapng is not supported", filename);
+        fclose(fp);
+        return OGS_ERROR;
+    }
+    linktype = PCAP_U32(hdr + 20) & 0x0fffffff;
+
+    frame = ogs_malloc(maxlen);
+    ogs_assert(frame);
+    size_mix = ogs_calloc(max, sizeof(*size_mix));
+    ogs_assert(size_mix);
+
+    while (fread(rec, sizeof(rec), 1, fp) == 1) {
+        const uint8_t *p = frame;
+        int len, size;
+
+        caplen = PCAP_U32(rec + 8);
+        if (caplen > maxlen) {
+            ogs_error("Invalid record length [%d]", caplen);
+            break;
+        }
+        if (fread(frame, 1, caplen, fp) != caplen)
+            break;
+        len = caplen;
+
+        switch (linktype) {
+        case 1:     /* Ethernet */
+            if (len < 14)
+                continue;
+            if (p[12] == 0x81 && p[13] == 0x00) {
+                p += 4;
+                len -= 4;
+            }
+            p += 14;
+            len -= 14;
+            break;
+        case 113:   /* Linux cooked capture */
+            p += 16;
+            len -= 16;
+            break;
+        case 12:
+        case 101:
+        case 228:
+        case 229:   /* Raw IP */
+            break;
+        default:
+            ogs_error("Unsupported link type [%d]", linktype);
+            fclose(fp);
+            ogs_free(frame);
+            return OGS_ERROR;
+        }
+
+        size = ip_len(p, len);
+        if (size < 0)
+            continue;
+
+        if (num_of_size_mix == max) {
+            max *= 2;
+            size_mix = ogs_realloc(size_mix, max * sizeof(*size_mix));
+            ogs_assert(size_mix);
+        }
+        size_mix[num_of_size_mix++] =
+            ogs_max(BENCH_MIN_SIZE, ogs_min(BENCH_MAX_SIZE, size));
+    }
+
+    fclose(fp);
+    ogs_free(frame);
+
+    if (!num_of_size_mix) {
+        ogs_error("No IP packet in [%s]", filename);
+        return OGS_ERROR;
+    }
+
+    return OGS_OK;
+}
+
+/*
+ * PFCP requests are encoded before the UPF thread starts,
+ * since the TLV pool is not thread-safe.
+ */
+static ogs_pkbuf_t *pfcp_encode(ogs_pfcp_message_t *message, uint64_t seid)
+{
+    ogs_pfcp_header_t *h = NULL;
+    ogs_pkbuf_t *pkbuf = NULL;
+    int hlen;
+
+    pkbuf = ogs_pfcp_build_msg(message);
+    ogs_assert(pkbuf);
+
+    hlen = message->h.type >= OGS_PFCP_SESSION_ESTABLISHMENT_REQUEST_TYPE ?
+        OGS_PFCP_HEADER_LEN : OGS_PFCP_HEADER_LEN - OGS_PFCP_SEID_LEN;
+    ogs_pkbuf_push(pkbuf, hlen);
+    h = (ogs_pfcp_header_t *)pkbuf->data;
+    memset(h, 0, hlen);
+
+    h->version = OGS_PFCP_VERSION;
+    h->type = message->h.type;
+    if (hlen == OGS_PFCP_HEADER_LEN) {
+        h->seid_presence = 1;
+        h->seid = htobe64(seid);
+        h->sqn = OGS_PFCP_XID_TO_SQN(++pfcp_xid);
+    } else {
+        h->sqn_only = OGS_PFCP_XID_TO_SQN(++pfcp_xid);
+    }
+    h->length = htobe16(pkbuf->len - 4);
+
+    return pkbuf;
+}
+
+static ogs_pkbuf_t *build_association_setup_request(void)
+{
+    ogs_pfcp_message_t *message = NULL;
+    ogs_pfcp_association_setup_request_t *req = NULL;
+    ogs_pfcp_node_id_t node_id;
+    ogs_pkbuf_t *pkbuf = NULL;
+
+    message = ogs_calloc(1, sizeof(*message));
+    ogs_assert(message);
+    message->h.type = OGS_PFCP_ASSOCIATION_SETUP_REQUEST_TYPE;
+    req = &message->pfcp_association_setup_request;
+
+    memset(&node_id, 0, sizeof(node_id));
+    node_id.type = OGS_PFCP_NODE_ID_IPV4;
+    ogs_assert(inet_pton(AF_INET, BENCH_SMF_ADDR, &node_id.addr) == 1);
+    req->node_id.presence = 1;
+    req->node_id.data = &node_id;
+    req->node_id.len = 1 + OGS_IPV4_LEN;
+
+    req->recovery_time_stamp.presence = 1;
+    req->recovery_time_stamp.u32 = ogs_time_ntp32_now();
+
+    pkbuf = pfcp_encode(message, 0);
+    ogs_free(message);
+
+    return pkbuf;
+}
+
+static ogs_pkbuf_t *build_session_establishment_request(int i)
+{
+    ogs_pfcp_message_t *message = NULL;
+    ogs_pfcp_session_establishment_request_t *req = NULL;
+    ogs_pfcp_tlv_create_pdr_t *pdr = NULL;
+    ogs_pfcp_tlv_create_far_t *far = NULL;
+    ogs_pkbuf_t *pkbuf = NULL;
+
+    ogs_pfcp_node_id_t node_id;
+    ogs_pfcp_f_seid_t f_seid;
+    ogs_pfcp_f_teid_t f_teid;
+    ogs_pfcp_ue_ip_addr_t ue_ip;
+    ogs_pfcp_outer_header_creation_t ohc;
+    uint8_t ohr = OGS_PFCP_OUTER_HEADER_REMOVAL_GTPU_UDP_IPV4;
+    ogs_pfcp_volume_threshold_t vol;
+    uint8_t volbuf[sizeof(vol)];
+    ogs_pfcp_bitrate_t mbr;
+    uint8_t mbrbuf[OGS_PFCP_BITRATE_LEN];
+    struct {
+        char description[OGS_HUGE_LEN];
+        uint8_t buf[sizeof(ogs_pfcp_sdf_filter_t) + OGS_HUGE_LEN];
+    } sdf[BENCH_MAX_FILTER];
+    uint32_t addr;
+    int j, k;
+
+    message = ogs_calloc(1, sizeof(*message));
+    ogs_assert(message);
+    message->h.type = OGS_PFCP_SESSION_ESTABLISHMENT_REQUEST_TYPE;
+    req = &message->pfcp_session_establishment_request;
+
+    ogs_assert(inet_pton(AF_INET, BENCH_UPF_ADDR, &addr) == 1);
+
+    memset(&node_id, 0, sizeof(node_id));
+    node_id.type = OGS_PFCP_NODE_ID_IPV4;
+    ogs_assert(inet_pton(AF_INET, BENCH_SMF_ADDR, &node_id.addr) == 1);
+    req->node_id.presence = 1;
+    req->node_id.data = &node_id;
+    req->node_id.len = 1 + OGS_IPV4_LEN;
+
+    memset(&f_seid, 0, sizeof(f_seid));
+    f_seid.ipv4 = 1;
+    f_seid.seid = htobe64(i + 1);
+    f_seid.addr = node_id.addr;
+    req->cp_f_seid.presence = 1;
+    req->cp_f_seid.data = &f_seid;
+    req->cp_f_seid.len = 1 + 8 + OGS_IPV4_LEN;
+
+    memset(&f_teid, 0, sizeof(f_teid));
+    f_teid.ipv4 = 1;
+    f_teid.teid = htobe32(BENCH_UL_TEID(i));
+    f_teid.addr = addr;
+
+    memset(&ue_ip, 0, sizeof(ue_ip));
+    ue_ip.ipv4 = 1;
+    ue_ip.sd = OGS_PFCP_UE_IP_DST;
+    ue_ip.addr = BENCH_UE_ADDR(i);
+
+    memset(&ohc, 0, sizeof(ohc));
+    ohc.gtpu4 = 1;
+    ohc.teid = htobe32(BENCH_DL_TEID(i));
+    ogs_assert(inet_pton(AF_INET, BENCH_GNB_ADDR, &ohc.addr) == 1);
+
+    /*
+     * PDR 1/2 carry the traffic.
+     * PDR 3.. never match, but are checked first on every packet.
+     */
+    for (j = 0; j < 2 + 2 * opt.filters; j++) {
+        bool uplink = (j % 2) == 0;
+
+        pdr = &req->create_pdr[j];
+        pdr->presence = 1;
+        pdr->pdr_id.presence = 1;
+        pdr->pdr_id.u16 = j + 1;
+        pdr->precedence.presence = 1;
+        pdr->precedence.u32 = j < 2 ? 255 : j / 2;
+        pdr->pdi.presence = 1;
+        pdr->pdi.source_interface.presence = 1;
+        pdr->far_id.presence = 1;
+        pdr->far_id.u32 = uplink ? 1 : 2;
+
+        if (uplink) {
+            pdr->pdi.source_interface.u8 = OGS_PFCP_INTERFACE_ACCESS;
+            pdr->pdi.local_f_teid.presence = 1;
+            pdr->pdi.local_f_teid.data = &f_teid;
+            pdr->pdi.local_f_teid.len = 1 + 4 + OGS_IPV4_LEN;
+            pdr->outer_header_removal.presence = 1;
+            pdr->outer_header_removal.data = &ohr;
+            pdr->outer_header_removal.len = 1;
+        } else {
+            pdr->pdi.source_interface.u8 = OGS_PFCP_INTERFACE_CORE;
+            pdr->pdi.ue_ip_address.presence = 1;
+            pdr->pdi.ue_ip_address.data = &ue_ip;
+            pdr->pdi.ue_ip_address.len = 1 + OGS_IPV4_LEN;
+        }
+
+        if (j >= 2) {
+            ogs_pfcp_sdf_filter_t filter;
+
+            k = j / 2 - 1;
+            ogs_snprintf(sdf[k].description, sizeof(sdf[k].description),
+                    "permit out 17 from 198.51.100.%d to assigned", k + 1);
+
+            memset(&filter, 0, sizeof(filter));
+            filter.fd = 1;
+            filter.flow_description = sdf[k].description;
+            filter.flow_description_len = strlen(sdf[k].description);
+
+            pdr->pdi.sdf_filter[0].presence = 1;
+            ogs_pfcp_build_sdf_filter(&pdr->pdi.sdf_filter[0],
+                    &filter, sdf[k].buf, sizeof(sdf[k].buf));
+        }
+
+        if (opt.urr_threshold) {
+            pdr->urr_id[0].presence = 1;
+            pdr->urr_id[0].u32 = 1;
+        }
+        if (opt.mbr) {
+            pdr->qer_id.presence = 1;
+            pdr->qer_id.u32 = 1;
+        }
+    }
+
+    far = &req->create_far[0];
+    far->presence = 1;
+    far->far_id.presence = 1;
+    far->far_id.u32 = 1;
+    far->apply_action.presence = 1;
+    far->apply_action.u16 = OGS_PFCP_APPLY_ACTION_FORW;
+    far->forwarding_parameters.presence = 1;
+    far->forwarding_parameters.destination_interface.presence = 1;
+    far->forwarding_parameters.destination_interface.u8 =
+        OGS_PFCP_INTERFACE_CORE;
+
+    far = &req->create_far[1];
+    far->presence = 1;
+    far->far_id.presence = 1;
+    far->far_id.u32 = 2;
+    far->apply_action.presence = 1;
+    far->apply_action.u16 = OGS_PFCP_APPLY_ACTION_FORW;
+    far->forwarding_parameters.presence = 1;
+    far->forwarding_parameters.destination_interface.presence = 1;
+    far->forwarding_parameters.destination_interface.u8 =
+        OGS_PFCP_INTERFACE_ACCESS;
+    far->forwarding_parameters.outer_header_creation.presence = 1;
+    far->forwarding_parameters.outer_header_creation.data = &ohc;
+    far->forwarding_parameters.outer_header_creation.len =
+        2 + 4 + OGS_IPV4_LEN;
+
+    if (opt.urr_threshold) {
+        ogs_pfcp_reporting_triggers_t rep_triggers;
+
+        memset(&rep_triggers, 0, sizeof(rep_triggers));
+        rep_triggers.volume_threshold = 1;
+
+        req->create_urr[0].presence = 1;
+        req->create_urr[0].urr_id.presence = 1;
+        req->create_urr[0].urr_id.u32 = 1;
+        req->create_urr[0].measurement_method.presence = 1;
+        req->create_urr[0].measurement_method.u8 =
+            OGS_PFCP_MEASUREMENT_METHOD_VOLUME;
+        req->create_urr[0].reporting_triggers.presence = 1;
+        req->create_urr[0].reporting_triggers.u24 =
+            (rep_triggers.reptri_5 << 16) |
+            (rep_triggers.reptri_6 << 8) | rep_triggers.reptri_7;
+
+        memset(&vol, 0, sizeof(vol));
+        vol.tovol = 1;
+        vol.total_volume = opt.urr_threshold;
+        req->create_urr[0].volume_threshold.presence = 1;
+        ogs_pfcp_build_volume(&req->create_urr[0].volume_threshold,
+                &vol, volbuf, sizeof(volbuf));
+    }
+
+    if (opt.mbr) {
+        req->create_qer[0].presence = 1;
+        req->create_qer[0].qer_id.presence = 1;
+        req->create_qer[0].qer_id.u32 = 1;
+        req->create_qer[0].gate_status.presence = 1;
+        req->create_qer[0].gate_status.u8 = OGS_PFCP_GATE_OPEN;
+
+        mbr.uplink = opt.mbr;
+        mbr.downlink = opt.mbr;
+        req->create_qer[0].maximum_bitrate.presence = 1;
+        ogs_pfcp_build_bitrate(&req->create_qer[0].maximum_bitrate,
+                &mbr, mbrbuf, sizeof(mbrbuf));
+    }
+
+    req->pdn_type.presence = 1;
+    req->pdn_type.u8 = OGS_PDU_SESSION_TYPE_IPV4;
+
+    pkbuf = pfcp_encode(message, 0);
+    ogs_free(message);
+
+    return pkbuf;
+}
+
+/*
+ * PFCP messages from the UPF are handled on raw bytes :
+ * the bench thread must not touch the PFCP/TLV pools.
+ */
+static const uint8_t *pfcp_ie_find(
+        const uint8_t *p, int len, uint16_t type, int *ie_len)
+{
+    while (len >= 4) {
+        uint16_t t = p[0] << 8 | p[1];
+        uint16_t l = p[2] << 8 | p[3];
+
+        if (l > len - 4)
+            break;
+        if (t == type) {
+            *ie_len = l;
+            return p + 4;
+        }
+        p += 4 + l;
+        len -= 4 + l;
+    }
+
+    return NULL;
+}
+
+static void pfcp_send(const void *data, int len)
+{
+    struct sockaddr_in upf = sockaddr(BENCH_UPF_ADDR, OGS_PFCP_UDP_PORT);
+
+    if (sendto(pfcp_fd, data, len, 0,
+                (struct sockaddr *)&upf, sizeof(upf)) != len)
+        ogs_error("PFCP sendto() failed : %s", strerror(errno));
+}
+
+static int pfcp_recv(void)
+{
+    uint8_t buf[OGS_MAX_SDU_LEN];
+    ogs_pfcp_header_t *h = (ogs_pfcp_header_t *)buf;
+    const uint8_t *ie = NULL;
+    int len, hlen, ie_len;
+    uint64_t seid;
+
+    len = recv(pfcp_fd, buf, sizeof(buf), MSG_DONTWAIT);
+    if (len < OGS_PFCP_HEADER_LEN - OGS_PFCP_SEID_LEN)
+        return 0;
+
+    hlen = h->seid_presence ?
+        OGS_PFCP_HEADER_LEN : OGS_PFCP_HEADER_LEN - OGS_PFCP_SEID_LEN;
+    seid = h->seid_presence ? be64toh(h->seid) : 0;
+
+    switch (h->type) {
+    case OGS_PFCP_HEARTBEAT_REQUEST_TYPE:
+    {
+        uint8_t rsp[8 + 8];
+        uint32_t ts = htobe32(ogs_time_ntp32_now());
+
+        memcpy(rsp, buf, 8);
+        rsp[1] = OGS_PFCP_HEARTBEAT_RESPONSE_TYPE;
+        rsp[2] = 0; rsp[3] = sizeof(rsp) - 4;
+        rsp[8] = 0; rsp[9] = OGS_PFCP_RECOVERY_TIME_STAMP_TYPE;
+        rsp[10] = 0; rsp[11] = 4;
+        memcpy(rsp + 12, &ts, 4);
+        pfcp_send(rsp, sizeof(rsp));
+        break;
+    }
+    case OGS_PFCP_SESSION_ESTABLISHMENT_RESPONSE_TYPE:
+        ie = pfcp_ie_find(buf + hlen, len - hlen,
+                OGS_PFCP_CAUSE_TYPE, &ie_len);
+        if (!ie || ie[0] != OGS_PFCP_CAUSE_REQUEST_ACCEPTED) {
+            ogs_error("Session establishment rejected [SEID:%lld]",
+                    (long long)seid);
+            return -1;
+        }
+        ie = pfcp_ie_find(buf + hlen, len - hlen,
+                OGS_PFCP_F_SEID_TYPE, &ie_len);
+        if (ie && ie_len >= 9 && seid >= 1 && seid <= opt.sessions) {
+            memcpy(&up_seid[seid-1], ie + 1, 8);
+            up_seid[seid-1] = be64toh(up_seid[seid-1]);
+        }
+        num_of_sess_rsp++;
+        break;
+    case OGS_PFCP_SESSION_REPORT_REQUEST_TYPE:
+    {
+        uint8_t rsp[OGS_PFCP_HEADER_LEN + 5];
+        ogs_pfcp_header_t *rh = (ogs_pfcp_header_t *)rsp;
+
+        if (!h->seid_presence || seid < 1 || seid > opt.sessions)
+            break;
+
+        memcpy(rsp, buf, OGS_PFCP_HEADER_LEN);
+        rh->type = OGS_PFCP_SESSION_REPORT_RESPONSE_TYPE;
+        rh->length = htobe16(sizeof(rsp) - 4);
+        rh->seid = htobe64(up_seid[seid-1]);
+        rsp[16] = 0; rsp[17] = OGS_PFCP_CAUSE_TYPE;
+        rsp[18] = 0; rsp[19] = 1;
+        rsp[20] = OGS_PFCP_CAUSE_REQUEST_ACCEPTED;
+        pfcp_send(rsp, sizeof(rsp));
+        break;
+    }
+    case OGS_PFCP_ASSOCIATION_SETUP_RESPONSE_TYPE:
+        break;
+    default:
+        ogs_warn("Unexpected PFCP message [%d]", h->type);
+        break;
+    }
+
+    return h->type;
+}
+
+static int pfcp_wait(int type)
+{
+    ogs_time_t deadline = ogs_get_monotonic_time() + ogs_time_from_sec(5);
+    struct pollfd pfd = { .fd = pfcp_fd, .events = POLLIN };
+
+    while (ogs_get_monotonic_time() < deadline) {
+        int rv;
+
+        if (poll(&pfd, 1, 100) <= 0)
+            continue;
+        rv = pfcp_recv();
+        if (rv < 0)
+            return OGS_ERROR;
+        if (rv == type)
+            return OGS_OK;
+    }
+
+    return OGS_ERROR;
+}
+
+static int setup_sessions(void)
+{
+    ogs_time_t deadline;
+    struct pollfd pfd = { .fd = pfcp_fd, .events = POLLIN };
+    int i;
+
+    pfcp_send(assoc_req->data, assoc_req->len);
+    if (pfcp_wait(OGS_PFCP_ASSOCIATION_SETUP_RESPONSE_TYPE) != OGS_OK) {
+        ogs_error("No PFCP association with the UPF");
+        return OGS_ERROR;
+    }
+
+    deadline = ogs_get_monotonic_time() + ogs_time_from_sec(30);
+    for (i = 0; i < opt.sessions || num_of_sess_rsp < opt.sessions; ) {
+        if (ogs_get_monotonic_time() > deadline) {
+            ogs_error("Only %d of %d sessions established",
+                    num_of_sess_rsp, opt.sessions);
+            return OGS_ERROR;
+        }
+
+        /* Keep the number of outstanding requests bounded */
+        if (i < opt.sessions && i - num_of_sess_rsp < 64) {
+            pfcp_send(sess_req[i]->data, sess_req[i]->len);
+            i++;
+            continue;
+        }
+        if (poll(&pfd, 1, 100) > 0 && pfcp_recv() < 0)
+            return OGS_ERROR;
+    }
+
+    return OGS_OK;
+}
+
+static int build_ul_packet(uint8_t *buf, uint64_t n)
+{
+    int sess = n % opt.sessions;
+    int size = num_of_size_mix ?
+        size_mix[n % num_of_size_mix] : opt.size;
+    ogs_gtp2_header_t *gtp_h = (ogs_gtp2_header_t *)buf;
+    struct ip *ip_h = (struct ip *)(buf + OGS_GTPV1U_HEADER_LEN);
+    struct udphdr *udp_h = (struct udphdr *)(ip_h + 1);
+
+    memset(buf, 0, OGS_GTPV1U_HEADER_LEN + BENCH_MIN_SIZE);
+
+    gtp_h->flags = 0x30;
+    gtp_h->type = OGS_GTPU_MSGTYPE_GPDU;
+    gtp_h->length = htobe16(size);
+    gtp_h->teid = htobe32(BENCH_UL_TEID(sess));
+
+    ip_h->ip_v = 4;
+    ip_h->ip_hl = sizeof(*ip_h) >> 2;
+    ip_h->ip_len = htobe16(size);
+    ip_h->ip_id = htobe16(n);
+    ip_h->ip_ttl = 64;
+    ip_h->ip_p = IPPROTO_UDP;
+    ip_h->ip_src.s_addr = BENCH_UE_ADDR(sess);
+    ogs_assert(inet_pton(AF_INET, BENCH_DN_ADDR, &ip_h->ip_dst) == 1);
+    ip_h->ip_sum = ogs_in_cksum((uint16_t *)ip_h, sizeof(*ip_h));
+
+    udp_h->uh_sport = htobe16(BENCH_DN_PORT + 1);
+    udp_h->uh_dport = htobe16(BENCH_DN_PORT);
+    udp_h->uh_ulen = htobe16(size - sizeof(*ip_h));
+
+    return OGS_GTPV1U_HEADER_LEN + size;
+}
+
+typedef struct bench_stat_s {
+    uint64_t sent;
+    uint64_t received;
+    uint64_t lost;
+    ogs_time_t elapsed;
+    uint64_t pool_hit;
+    uint64_t pool_miss;
+    uint64_t copy;
+} bench_stat_t;
+
+/*
+ * Keep at most opt.window packets in flight so that
+ * the socket buffers never drop and only the UPF is measured.
+ * Packets still missing after BENCH_LOSS_TIMEOUT are counted as lost,
+ * e.g. when the QER drops them.
+ */
+static void run(bool uplink, bench_stat_t *stat)
+{
+    static uint8_t buf[OGS_GTPV1U_HEADER_LEN + BENCH_MAX_SIZE];
+    struct sockaddr_in upf = sockaddr(BENCH_UPF_ADDR, OGS_GTPV1_U_UDP_PORT);
+    struct pollfd pfd[2];
+    int rx_fd = uplink ? dn_fd : gnb_fd;
+    ogs_time_t start, last, now;
+    uint64_t base_hit, base_miss, base_copy;
+
+    memset(stat, 0, sizeof(*stat));
+    memset(buf, 0, sizeof(buf));
+
+    base_hit = ogs_gtp_self()->gtpu_pkbuf_stat.pool_hit;
+    base_miss = ogs_gtp_self()->gtpu_pkbuf_stat.pool_miss;
+    base_copy = ogs_gtp_self()->gtpu_pkbuf_stat.copy;
+
+    pfd[0].fd = rx_fd;
+    pfd[0].events = POLLIN;
+    pfd[1].fd = pfcp_fd;
+    pfd[1].events = POLLIN;
+
+    start = last = ogs_get_monotonic_time();
+
+    while (stat->received + stat->lost < opt.packets) {
+        while (stat->sent < opt.packets &&
+                stat->sent - stat->received - stat->lost < opt.window) {
+            int len;
+
+            if (uplink) {
+                len = build_ul_packet(buf, stat->sent);
+                if (sendto(gnb_fd, buf, len, 0,
+                            (struct sockaddr *)&upf, sizeof(upf)) != len)
+                    break;
+            } else {
+                struct sockaddr_in ue;
+                int sess = stat->sent % opt.sessions;
+
+                len = num_of_size_mix ?
+                    size_mix[stat->sent % num_of_size_mix] : opt.size;
+                len -= BENCH_MIN_SIZE;
+
+                memset(&ue, 0, sizeof(ue));
+                ue.sin_family = AF_INET;
+                ue.sin_port = htobe16(BENCH_DN_PORT);
+                ue.sin_addr.s_addr = BENCH_UE_ADDR(sess);
+                if (sendto(src_fd, buf, len, 0,
+                            (struct sockaddr *)&ue, sizeof(ue)) != len)
+                    break;
+            }
+            stat->sent++;
+        }
+
+        if (poll(pfd, 2, 10) > 0) {
+            if (pfd[1].revents & POLLIN)
+                pfcp_recv();
+
+            if (pfd[0].revents & POLLIN) {
+                while (recv(rx_fd, buf, sizeof(buf), MSG_DONTWAIT) > 0) {
+                    stat->received++;
+                    if (stat->received + stat->lost > stat->sent)
+                        stat->lost--;   /* Late, not lost */
+                }
+                last = ogs_get_monotonic_time();
+                stat->elapsed = last - start;
+                continue;
+            }
+        }
+
+        now = ogs_get_monotonic_time();
+        if (now - last > BENCH_LOSS_TIMEOUT) {
+            stat->lost = stat->sent - stat->received;
+            last = now;
+        }
+    }
+
+    stat->pool_hit = ogs_gtp_self()->gtpu_pkbuf_stat.pool_hit - base_hit;
+    stat->pool_miss = ogs_gtp_self()->gtpu_pkbuf_stat.pool_miss - base_miss;
+    stat->copy = ogs_gtp_self()->gtpu_pkbuf_stat.copy - base_copy;
+}
+
+static void report(bool uplink, bench_stat_t *stat)
+{
+    double sec = (double)stat->elapsed / OGS_USEC_PER_SEC;
+    char size[16];
+
+    if (opt.pcap_file)
+        ogs_cpystrn(size, "pcap", sizeof(size));
+    else
+        ogs_snprintf(size, sizeof(size), "%d", opt.size);
+
+    printf("dir=%s sessions=%d filters=%d urr=%llu mbr=%llu size=%s "
+            "sent=%llu received=%llu lost=%llu seconds=%.6f "
+            "pps=%.0f ns_per_pkt=%.1f "
+            "pool_hit=%llu pool_miss=%llu copy=%llu\n",
+            uplink ? "ul" : "dl", opt.sessions, opt.filters,
+            (unsigned long long)opt.urr_threshold,
+            (unsigned long long)opt.mbr, size,
+            (unsigned long long)stat->sent,
+            (unsigned long long)stat->received,
+            (unsigned long long)stat->lost, sec,
+            sec > 0 ? stat->received / sec : 0,
+            stat->received ? (double)stat->elapsed * 1000 / stat->received : 0,
+            (unsigned long long)stat->pool_hit,
+            (unsigned long long)stat->pool_miss,
+            (unsigned long long)stat->copy);
+    fflush(stdout);
+}
+
+static void show_help(const char *name)
+{
+    printf("Usage: %s [options]\n"
+        "Options:\n"
+       "   -c filename    : set configuration file\n"
+       "   -e level       : set global log-level (default:error)\n"
+       "   -n sessions    : number of PFCP sessions (default:1)\n"
+       "   -p packets     : number of packets per direction (default:100000)\n"
+       "   -s size        : IP packet size (default:128)\n"
+       "   -r filename    : take the IP packet sizes from a pcap file\n"
+       "   -f filters     : non-matching SDF filter PDRs per direction (0-%d)\n"
+       "   -u octets      : add a URR with this volume threshold\n"
+       "   -q bps         : add a QER with this MBR\n"
+       "   -d direction   : ul, dl or both (default:both)\n"
+       "   -w window      : packets in flight (default:256)\n"
+       "   -h             : show this message and exit\n"
+       "\n", name, BENCH_MAX_FILTER);
+}
+
+int main(int argc, const char *const argv[])
+{
+    int rv, i, opt_c;
+    ogs_getopt_t options;
+    char *config_file = NULL;
+    char *log_level = (char *)"error";
+    const char *argv_out[argc+5];
+    bench_stat_t stat;
+
+    ogs_getopt_init(&options, (char**)argv);
+    while ((opt_c = ogs_getopt(&options, "hc:e:n:p:s:r:f:u:q:d:w:")) != -1) {
+        switch (opt_c) {
+        case 'h':
+            show_help(argv[0]);
+            return OGS_OK;
+        case 'c':
+            config_file = options.optarg;
+            break;
+        case 'e':
+            log_level = options.optarg;
+            break;
+        case 'n':
+            opt.sessions = atoi(options.optarg);
+            break;
+        case 'p':
+            opt.packets = atoi(options.optarg);
+            break;
+        case 's':
+            opt.size = atoi(options.optarg);
+            break;
+        case 'r':
+            opt.pcap_file = options.optarg;
+            break;
+        case 'f':
+            opt.filters = atoi(options.optarg);
+            break;
+        case 'u':
+            opt.urr_threshold = strtoull(options.optarg, NULL, 10);
+            break;
+        case 'q':
+            opt.mbr = strtoull(options.optarg, NULL, 10);
+            break;
+        case 'd':
+            opt.ul = strcmp(options.optarg, "dl") != 0;
+            opt.dl = strcmp(options.optarg, "ul") != 0;
+            break;
+        case 'w':
+            opt.window = atoi(options.optarg);
+            break;
+        case '?':
+            fprintf(stderr, "%s: %s\n", argv[0], options.errmsg);
+            show_help(argv[0]);
+            return OGS_ERROR;
+        default:
+            fprintf(stderr, "%s: should not be reached\n", OGS_FUNC);
+            return OGS_ERROR;
+        }
+    }
+
+    if (opt.sessions < 1 || opt.sessions > 0xfff0 ||
+        opt.packets < 1 || opt.window < 1 ||
+        opt.filters < 0 || opt.filters > BENCH_MAX_FILTER ||
+        opt.size < BENCH_MIN_SIZE || opt.size > BENCH_MAX_SIZE) {
+        show_help(argv[0]);
+        return OGS_ERROR;
+    }
+
+    i = 0;
+    argv_out[i++] = argv[0];
+    if (config_file) {
+        argv_out[i++] = "-c";
+        argv_out[i++] = config_file;
+    }
+    argv_out[i++] = "-e";
+    argv_out[i++] = log_level;
+    argv_out[i] = NULL;
+
+    rv = ogs_app_initialize(OPEN5GS_VERSION, DEFAULT_CONFIG_FILENAME, argv_out);
+    if (rv != OGS_OK) {
+        ogs_fatal("Open5GS initialization failed. Aborted");
+        return OGS_ERROR;
+    }
+
+    if (opt.pcap_file && pcap_load(opt.pcap_file) != OGS_OK)
+        goto out;
+
+    assoc_req = build_association_setup_request();
+    sess_req = ogs_calloc(opt.sessions, sizeof(*sess_req));
+    ogs_assert(sess_req);
+    for (i = 0; i < opt.sessions; i++)
+        sess_req[i] = build_session_establishment_request(i);
+    up_seid = ogs_calloc(opt.sessions, sizeof(*up_seid));
+    ogs_assert(up_seid);
+
+    pfcp_fd = udp_open(BENCH_SMF_ADDR, OGS_PFCP_UDP_PORT);
+    gnb_fd = udp_open(BENCH_GNB_ADDR, OGS_GTPV1_U_UDP_PORT);
+    dn_fd = udp_open(BENCH_DN_ADDR, BENCH_DN_PORT);
+    src_fd = udp_open(NULL, 0);
+    if (pfcp_fd < 0 || gnb_fd < 0 || dn_fd < 0) {
+        ogs_error("Run it in a network namespace with ogstun (see %s)",
+                __FILE__);
+        goto out;
+    }
+
+    rv = upf_initialize();
+    if (rv != OGS_OK) {
+        ogs_error("Failed to initialize UPF");
+        goto out;
+    }
+
+    if (setup_sessions() == OGS_OK) {
+        if (opt.ul) {
+            run(true, &stat);
+            report(true, &stat);
+        }
+        if (opt.dl) {
+            run(false, &stat);
+            report(false, &stat);
+        }
+    }
+
+    upf_terminate();
+
+out:
+    if (pfcp_fd > 0) close(pfcp_fd);
+    if (gnb_fd > 0) close(gnb_fd);
+    if (dn_fd > 0) close(dn_fd);
+    if (src_fd > 0) close(src_fd);
+
+    if (sess_req) {
+        for (i = 0; i < opt.sessions; i++)
+            ogs_pkbuf_free(sess_req[i]);
+        ogs_free(sess_req);
+    }
+    if (assoc_req)
+        ogs_pkbuf_free(assoc_req);
+    if (up_seid)
+        ogs_free(up_seid);
+    if (size_mix)
+        ogs_free(size_mix);
+
+    ogs_app_terminate();
+
+    return OGS_OK;
+}
@@ -37,6 +37,7 @@ abts_suite *test_poll(abts_suite *suite);
 abts_suite *test_tlv(abts_suite *suite);
 abts_suite *test_fsm(abts_suite *suite);
 abts_suite *test_hash(abts_suite *suite);
+abts_suite *test_lpm(abts_suite *suite);
 abts_suite *test_uuid(abts_suite *suite);
 
 const struct testlist {
@@ -59,6 +60,7 @@ const struct testlist {
     {test_tlv},
     {test_fsm},
     {test_hash},
+    {test_lpm},
     {test_uuid},
     {NULL},
 };
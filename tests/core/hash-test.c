@@ -386,6 +386,76 @@ static void hash_count_5(abts_case *tc, void *data)
     ogs_hash_destroy(h);
 }
 
+#define NUM_OF_KEY 100000
+
+static void hash_grow_test(abts_case *tc, void *data)
+{
+    ogs_hash_t *h = NULL;
+    ogs_hash_index_t *hi;
+    uint32_t *key4 = NULL;
+    uint64_t *key8 = NULL;
+    int i, n;
+
+    h = ogs_hash_make();
+    ABTS_PTR_NOTNULL(tc, h);
+
+    key4 = ogs_calloc(NUM_OF_KEY, sizeof(*key4));
+    ABTS_PTR_NOTNULL(tc, key4);
+    key8 = ogs_calloc(NUM_OF_KEY, sizeof(*key8));
+    ABTS_PTR_NOTNULL(tc, key8);
+
+    /* Lookups stay correct while the table is being grown */
+    for (i = 0; i < NUM_OF_KEY; i++) {
+        key4[i] = i;
+        key8[i] = (uint64_t)i << 32;
+        ogs_hash_set(h, &key4[i], sizeof(key4[i]), &key4[i]);
+        ogs_hash_set(h, &key8[i], sizeof(key8[i]), &key8[i]);
+
+        ABTS_PTR_EQUAL(tc, &key4[i / 2],
+                ogs_hash_get(h, &key4[i / 2], sizeof(key4[i])));
+        ABTS_PTR_EQUAL(tc, &key8[i / 3],
+                ogs_hash_get(h, &key8[i / 3], sizeof(key8[i])));
+    }
+    ABTS_INT_EQUAL(tc, NUM_OF_KEY * 2, ogs_hash_count(h));
+
+    /* Delete every other key while iterating */
+    n = 0;
+    for (hi = ogs_hash_first(h); hi; hi = ogs_hash_next(hi)) {
+        const void *key = ogs_hash_this_key(hi);
+        if (ogs_hash_this_key_len(hi) == sizeof(uint32_t) &&
+            *(uint32_t *)key % 2)
+            ogs_hash_set(h, key, sizeof(uint32_t), NULL);
+        n++;
+    }
+    ABTS_INT_EQUAL(tc, NUM_OF_KEY * 2, n);
+    ABTS_INT_EQUAL(tc, NUM_OF_KEY * 3 / 2, ogs_hash_count(h));
+
+    /* Reinsert over the deleted slots */
+    for (i = 1; i < NUM_OF_KEY; i += 2)
+        ogs_hash_set(h, &key4[i], sizeof(key4[i]), &key8[i]);
+
+    for (i = 0; i < NUM_OF_KEY; i++) {
+        ABTS_PTR_EQUAL(tc, i % 2 ? (void *)&key8[i] : (void *)&key4[i],
+                ogs_hash_get(h, &key4[i], sizeof(key4[i])));
+        ABTS_PTR_EQUAL(tc, &key8[i],
+                ogs_hash_get(h, &key8[i], sizeof(key8[i])));
+    }
+    ABTS_INT_EQUAL(tc, NUM_OF_KEY * 2, ogs_hash_count(h));
+
+    for (i = 0; i < NUM_OF_KEY; i++)
+        ogs_hash_set(h, &key8[i], sizeof(key8[i]), NULL);
+    ABTS_INT_EQUAL(tc, NUM_OF_KEY, ogs_hash_count(h));
+    ABTS_PTR_EQUAL(tc, NULL, ogs_hash_get(h, &key8[0], sizeof(key8[0])));
+
+    ogs_hash_clear(h);
+    ABTS_INT_EQUAL(tc, 0, ogs_hash_count(h));
+    ABTS_PTR_EQUAL(tc, NULL, ogs_hash_first(h));
+
+    ogs_free(key4);
+    ogs_free(key8);
+    ogs_hash_destroy(h);
+}
+
 abts_suite *test_hash(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -406,6 +476,7 @@ abts_suite *test_hash(abts_suite *suite)
     abts_run_test(suite, hash_clear_test, NULL);
     abts_run_test(suite, hash_traverse, NULL);
     abts_run_test(suite, summation_test, NULL);
+    abts_run_test(suite, hash_grow_test, NULL);
 
     return suite;
 }
@@ -103,11 +103,111 @@ static void test_basic(abts_case *tc, void *data)
 #endif
 }
 
+#if !defined(_WIN32)
+#include <unistd.h>
+
+#define ASYNC_THREADS 4
+#define ASYNC_MESSAGES 1000
+
+static int async_domain = -1;
+
+static void async_logger(void *data)
+{
+    int i, n = *(int *)data;
+
+    for (i = 0; i < ASYNC_MESSAGES; i++)
+        ogs_log_printf(OGS_LOG_INFO, async_domain, 0, __FILE__, __LINE__,
+                OGS_FUNC, 0, "async-test %d %d", n, i);
+}
+
+static void test_async(abts_case *tc, void *data)
+{
+    ogs_thread_t *thread[ASYNC_THREADS];
+    int id[ASYNC_THREADS];
+    ogs_log_t *log = NULL;
+    char path[OGS_MAX_FILEPATH_LEN];
+    char line[OGS_HUGE_LEN];
+    FILE *fp = NULL;
+    int i, rv, lines, saved, before, fatal;
+
+    ogs_log_install_domain(&async_domain, "ASYNC", OGS_LOG_INFO);
+
+    ogs_snprintf(path, sizeof(path), "/tmp/ogs-log-test-%d", (int)getpid());
+    unlink(path);
+    log = ogs_log_add_file(path);
+    ABTS_PTR_NOTNULL(tc, log);
+
+    /* Keep the stderr target quiet */
+    fflush(stderr);
+    saved = dup(2);
+    ABTS_TRUE(tc, saved >= 0);
+    fp = fopen("/dev/null", "w");
+    ABTS_PTR_NOTNULL(tc, fp);
+    dup2(fileno(fp), 2);
+    fclose(fp);
+
+    rv = ogs_log_async_start();
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+
+    /* Fixed one second windows : at most two of them in the loop */
+    ogs_log_set_rate_limit("ASYNC", 5);
+    for (i = 0; i < 50; i++)
+        ogs_log_printf(OGS_LOG_INFO, async_domain, 0, __FILE__, __LINE__,
+                OGS_FUNC, 0, "rate-test %d", i);
+    ABTS_TRUE(tc, ogs_log_get_domain_dropped(async_domain) >= 40);
+    ogs_log_set_rate_limit("ASYNC", 0);
+
+    /* The queued message is written before the FATAL one */
+    ogs_log_printf(OGS_LOG_ERROR, async_domain, 0, __FILE__, __LINE__,
+            OGS_FUNC, 0, "fatal-before");
+    ogs_log_printf(OGS_LOG_FATAL, async_domain, 0, __FILE__, __LINE__,
+            OGS_FUNC, 0, "fatal-test");
+
+    /* Stop while the other threads are still logging */
+    for (i = 0; i < ASYNC_THREADS; i++) {
+        id[i] = i;
+        thread[i] = ogs_thread_create(async_logger, &id[i]);
+        ABTS_PTR_NOTNULL(tc, thread[i]);
+    }
+    ogs_log_async_stop();
+    for (i = 0; i < ASYNC_THREADS; i++)
+        ogs_thread_destroy(thread[i]);
+
+    fflush(stderr);
+    dup2(saved, 2);
+    close(saved);
+
+    ogs_log_remove(log);
+
+    fp = fopen(path, "r");
+    ABTS_PTR_NOTNULL(tc, fp);
+    lines = 0;
+    before = fatal = -1;
+    for (i = 0; fgets(line, sizeof(line), fp); i++) {
+        if (strstr(line, "async-test "))
+            lines++;
+        else if (strstr(line, "fatal-before"))
+            before = i;
+        else if (strstr(line, "fatal-test"))
+            fatal = i;
+    }
+    fclose(fp);
+    unlink(path);
+
+    ABTS_INT_EQUAL(tc, ASYNC_THREADS * ASYNC_MESSAGES, lines);
+    ABTS_TRUE(tc, before >= 0);
+    ABTS_TRUE(tc, before < fatal);
+}
+#endif
+
 abts_suite *test_log(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
 
     abts_run_test(suite, test_basic, NULL);
+#if !defined(_WIN32)
+    abts_run_test(suite, test_async, NULL);
+#endif
 
     return suite;
 }
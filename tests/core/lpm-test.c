@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2019-2024 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-core.h"
+#include "core/abts.h"
+
+static char *v[] = { "a", "b", "c", "d", "e" };
+
+static void lpm_test1(abts_case *tc, void *data)
+{
+    ogs_lpm_t *lpm = NULL;
+    uint32_t addr;
+    int rv;
+
+    lpm = ogs_lpm_create(32);
+    ABTS_PTR_NOTNULL(tc, lpm);
+
+    addr = htobe32(0x0a000000);
+    ABTS_PTR_EQUAL(tc, NULL, ogs_lpm_find(lpm, &addr));
+
+    rv = ogs_lpm_add(lpm, &addr, 8, v[0]);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    addr = htobe32(0x0a2d0000);
+    rv = ogs_lpm_add(lpm, &addr, 16, v[1]);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    addr = htobe32(0x0a2d0100);
+    rv = ogs_lpm_add(lpm, &addr, 20, v[2]);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    addr = htobe32(0x0a2d0102);
+    rv = ogs_lpm_add(lpm, &addr, 32, v[3]);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    addr = 0;
+    rv = ogs_lpm_add(lpm, &addr, 0, v[4]);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    ABTS_INT_EQUAL(tc, 5, ogs_lpm_count(lpm));
+
+    addr = htobe32(0x0a2d0102);
+    ABTS_PTR_EQUAL(tc, v[3], ogs_lpm_find(lpm, &addr));
+    addr = htobe32(0x0a2d0103);
+    ABTS_PTR_EQUAL(tc, v[2], ogs_lpm_find(lpm, &addr));
+    addr = htobe32(0x0a2d1001);
+    ABTS_PTR_EQUAL(tc, v[1], ogs_lpm_find(lpm, &addr));
+    addr = htobe32(0x0a010101);
+    ABTS_PTR_EQUAL(tc, v[0], ogs_lpm_find(lpm, &addr));
+    addr = htobe32(0xc0a80001);
+    ABTS_PTR_EQUAL(tc, v[4], ogs_lpm_find(lpm, &addr));
+
+    /* Host bits of the prefix are ignored */
+    addr = htobe32(0x0a2d01ff);
+    ABTS_PTR_EQUAL(tc, v[2], ogs_lpm_get(lpm, &addr, 20));
+
+    addr = htobe32(0x0a2d0100);
+    ABTS_PTR_EQUAL(tc, v[2], ogs_lpm_delete(lpm, &addr, 20));
+    ABTS_PTR_EQUAL(tc, NULL, ogs_lpm_delete(lpm, &addr, 20));
+    addr = htobe32(0x0a2d0103);
+    ABTS_PTR_EQUAL(tc, v[1], ogs_lpm_find(lpm, &addr));
+    addr = htobe32(0x0a2d0102);
+    ABTS_PTR_EQUAL(tc, v[3], ogs_lpm_find(lpm, &addr));
+
+    ABTS_PTR_EQUAL(tc, v[3], ogs_lpm_delete(lpm, &addr, 32));
+    ABTS_PTR_EQUAL(tc, v[1], ogs_lpm_find(lpm, &addr));
+
+    addr = htobe32(0x0a2d0000);
+    ABTS_PTR_EQUAL(tc, v[1], ogs_lpm_delete(lpm, &addr, 16));
+    addr = htobe32(0x0a2d0102);
+    ABTS_PTR_EQUAL(tc, v[0], ogs_lpm_find(lpm, &addr));
+
+    addr = 0;
+    ABTS_PTR_EQUAL(tc, v[4], ogs_lpm_delete(lpm, &addr, 0));
+    addr = htobe32(0xc0a80001);
+    ABTS_PTR_EQUAL(tc, NULL, ogs_lpm_find(lpm, &addr));
+
+    ABTS_INT_EQUAL(tc, 1, ogs_lpm_count(lpm));
+
+    ogs_lpm_destroy(lpm);
+}
+
+static void lpm_test2(abts_case *tc, void *data)
+{
+    ogs_lpm_t *lpm = NULL;
+    uint8_t addr[16];
+    int rv;
+
+    lpm = ogs_lpm_create(128);
+    ABTS_PTR_NOTNULL(tc, lpm);
+
+    memset(addr, 0, sizeof(addr));
+    addr[0] = 0x20; addr[1] = 0x01; addr[2] = 0x0d; addr[3] = 0xb8;
+    rv = ogs_lpm_add(lpm, addr, 32, v[0]);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    addr[7] = 0x01;
+    rv = ogs_lpm_add(lpm, addr, 64, v[1]);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    addr[15] = 0x01;
+    rv = ogs_lpm_add(lpm, addr, 128, v[2]);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    addr[14] = 0x80;
+    rv = ogs_lpm_add(lpm, addr, 113, v[3]);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+
+    addr[14] = 0x00; addr[15] = 0x01;
+    ABTS_PTR_EQUAL(tc, v[2], ogs_lpm_find(lpm, addr));
+    addr[15] = 0x02;
+    ABTS_PTR_EQUAL(tc, v[1], ogs_lpm_find(lpm, addr));
+    addr[14] = 0xff;
+    ABTS_PTR_EQUAL(tc, v[3], ogs_lpm_find(lpm, addr));
+    addr[7] = 0x02;
+    ABTS_PTR_EQUAL(tc, v[0], ogs_lpm_find(lpm, addr));
+    addr[0] = 0x30;
+    ABTS_PTR_EQUAL(tc, NULL, ogs_lpm_find(lpm, addr));
+
+    memset(addr, 0, sizeof(addr));
+    addr[0] = 0x20; addr[1] = 0x01; addr[2] = 0x0d; addr[3] = 0xb8;
+    addr[7] = 0x01;
+    ABTS_PTR_EQUAL(tc, v[1], ogs_lpm_delete(lpm, addr, 64));
+    addr[15] = 0x01;
+    ABTS_PTR_EQUAL(tc, v[2], ogs_lpm_find(lpm, addr));
+    addr[15] = 0x02;
+    ABTS_PTR_EQUAL(tc, v[0], ogs_lpm_find(lpm, addr));
+
+    ogs_lpm_destroy(lpm);
+}
+
+#define NUM_OF_ROUTE 512
+
+static int naive_find(uint32_t *route, int *len, int num, uint32_t addr)
+{
+    int i, best = -1;
+
+    for (i = 0; i < num; i++) {
+        uint32_t mask;
+
+        if (len[i] < 0)
+            continue;
+        mask = len[i] ? 0xffffffff << (32 - len[i]) : 0;
+        if ((addr & mask) != route[i])
+            continue;
+        if (best < 0 || len[i] > len[best])
+            best = i;
+    }
+
+    return best;
+}
+
+static void lpm_test3(abts_case *tc, void *data)
+{
+    ogs_lpm_t *lpm = NULL;
+    uint32_t route[NUM_OF_ROUTE];
+    int len[NUM_OF_ROUTE];
+    int i, j, k, rv;
+
+    lpm = ogs_lpm_create(32);
+    ABTS_PTR_NOTNULL(tc, lpm);
+
+    /* Distinct prefixes under 10.0.0.0/8 */
+    for (i = 0; i < NUM_OF_ROUTE; i++) {
+        uint32_t addr, mask;
+
+        do {
+            len[i] = 8 + ogs_random32() % 25;
+            mask = 0xffffffff << (32 - len[i]);
+            route[i] = (0x0a000000 | (ogs_random32() & 0x00ffffff)) & mask;
+            for (j = 0; j < i; j++)
+                if (len[j] == len[i] && route[j] == route[i])
+                    break;
+        } while (j < i);
+
+        addr = htobe32(route[i]);
+        rv = ogs_lpm_add(lpm, &addr, len[i], &route[i]);
+        ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    }
+
+    for (k = 0; k < 2; k++) {
+        for (i = 0; i < 10000; i++) {
+            uint32_t host = route[ogs_random32() % NUM_OF_ROUTE] |
+                (ogs_random32() & 0x3ff);
+            uint32_t addr = htobe32(host);
+
+            j = naive_find(route, len, NUM_OF_ROUTE, host);
+            ABTS_PTR_EQUAL(tc, j < 0 ? NULL : &route[j],
+                    ogs_lpm_find(lpm, &addr));
+        }
+
+        /* Delete half of the prefixes and check again */
+        for (i = 0; !k && i < NUM_OF_ROUTE; i += 2) {
+            uint32_t addr = htobe32(route[i]);
+            ABTS_PTR_EQUAL(tc, &route[i], ogs_lpm_delete(lpm, &addr, len[i]));
+            len[i] = -1;
+        }
+    }
+
+    ogs_lpm_destroy(lpm);
+}
+
+abts_suite *test_lpm(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, lpm_test1, NULL);
+    abts_run_test(suite, lpm_test2, NULL);
+    abts_run_test(suite, lpm_test3, NULL);
+
+    return suite;
+}
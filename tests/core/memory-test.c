@@ -74,6 +74,194 @@ static void test4_func(abts_case *tc, void *data)
 #endif
 }
 
+static void test5_func(abts_case *tc, void *data)
+{
+    static const size_t size[] = { 1, 32, 33, 100, 1000, 32768, 40000 };
+    ogs_mem_stat_t before, after;
+    char *ptr[OGS_ARRAY_SIZE(size)];
+    char *s, *p;
+    int i;
+
+    ogs_mem_stat(&before);
+
+    for (i = 0; i < OGS_ARRAY_SIZE(size); i++) {
+        ptr[i] = ogs_calloc(1, size[i]);
+        ABTS_PTR_NOTNULL(tc, ptr[i]);
+        ABTS_INT_EQUAL(tc, 0, ptr[i][size[i] - 1]);
+        memset(ptr[i], i, size[i]);
+    }
+
+    ogs_mem_stat(&after);
+    if (ogs_mem_arena_enabled()) {
+        ABTS_INT_EQUAL(tc, OGS_ARRAY_SIZE(size), after.blocks - before.blocks);
+        ABTS_TRUE(tc, after.size - before.size == 1+32+33+100+1000+32768+40000);
+    }
+
+    for (i = 0; i < OGS_ARRAY_SIZE(size); i++) {
+        ABTS_INT_EQUAL(tc, i, ptr[i][size[i] - 1]);
+        ogs_free(ptr[i]);
+    }
+
+    ogs_mem_stat(&after);
+    ABTS_TRUE(tc, after.blocks == before.blocks);
+
+    p = ogs_realloc(NULL, 10);
+    ABTS_PTR_NOTNULL(tc, p);
+    memcpy(p, "open5gs", 8);
+    p = ogs_realloc(p, 30);
+    ABTS_STR_EQUAL(tc, "open5gs", p);
+    p = ogs_realloc(p, 50000);
+    ABTS_STR_EQUAL(tc, "open5gs", p);
+    p = ogs_realloc(p, 5);
+    ABTS_TRUE(tc, memcmp(p, "open5", 5) == 0);
+    ogs_free(p);
+
+    s = ogs_strdup("abc");
+    ABTS_STR_EQUAL(tc, "abc", s);
+    s = ogs_mstrcatf(s, "%d%s", 123, "def");
+    ABTS_STR_EQUAL(tc, "abc123def", s);
+    ogs_free(s);
+
+    s = ogs_strndup("abcdef", 3);
+    ABTS_STR_EQUAL(tc, "abc", s);
+    ogs_free(s);
+
+    s = ogs_msprintf("%s-%d", "x", 7);
+    ABTS_STR_EQUAL(tc, "x-7", s);
+    ogs_free(s);
+
+    ogs_mem_stat(&after);
+    ABTS_TRUE(tc, after.blocks == before.blocks);
+}
+
+/*
+ * Contention benchmark : a few threads allocate and free at once, half
+ * of the blocks being freed by a neighbor thread as with events and
+ * packets handed over between threads. The global talloc mutex that
+ * ogs_talloc_size() used to take is compared with the per-thread
+ * arenas. Run with '-e info' to see the figures.
+ */
+#define BENCH_THREADS 4
+#define BENCH_ROUNDS 200
+#define BENCH_BATCH 256
+
+typedef struct bench_s {
+    int locked;
+    ogs_queue_t *queue;         /* Handed over to the next thread */
+    ogs_queue_t *next;
+    int failed;
+} bench_t;
+
+static void *bench_alloc(bench_t *b, size_t size)
+{
+    void *ptr = NULL;
+
+    if (b->locked) {
+        ogs_thread_mutex_lock(ogs_mem_get_mutex());
+        ptr = talloc_named_const(__ogs_talloc_core, size, __location__);
+        ogs_thread_mutex_unlock(ogs_mem_get_mutex());
+        return ptr;
+    }
+    return ogs_malloc(size);
+}
+
+static void bench_free(bench_t *b, void *ptr)
+{
+    if (b->locked) {
+        ogs_thread_mutex_lock(ogs_mem_get_mutex());
+        talloc_free(ptr);
+        ogs_thread_mutex_unlock(ogs_mem_get_mutex());
+        return;
+    }
+    ogs_free(ptr);
+}
+
+static void bench_main(void *data)
+{
+    bench_t *b = data;
+    void *ptr[BENCH_BATCH];
+    void *remote = NULL;
+    int i, j, rv;
+
+    for (i = 0; i < BENCH_ROUNDS; i++) {
+        for (j = 0; j < BENCH_BATCH; j++) {
+            ptr[j] = bench_alloc(b, 16 + (j * 37) % 2000);
+            if (!ptr[j]) {
+                b->failed = 1;
+                return;
+            }
+            memset(ptr[j], j, 16);
+        }
+        for (j = 0; j < BENCH_BATCH; j++) {
+            if (j & 1) {
+                rv = ogs_queue_push(b->next, ptr[j]);
+                if (rv != OGS_OK)
+                    bench_free(b, ptr[j]);
+            } else {
+                bench_free(b, ptr[j]);
+            }
+        }
+        while (ogs_queue_trypop(b->queue, &remote) == OGS_OK)
+            bench_free(b, remote);
+    }
+}
+
+static ogs_time_t bench_run(abts_case *tc, int locked)
+{
+    ogs_thread_t *thread[BENCH_THREADS];
+    bench_t bench[BENCH_THREADS];
+    void *remote = NULL;
+    ogs_time_t start;
+    int i;
+
+    for (i = 0; i < BENCH_THREADS; i++) {
+        bench[i].locked = locked;
+        bench[i].queue = ogs_queue_create(BENCH_ROUNDS * BENCH_BATCH);
+        bench[i].failed = 0;
+    }
+    for (i = 0; i < BENCH_THREADS; i++)
+        bench[i].next = bench[(i + 1) % BENCH_THREADS].queue;
+
+    start = ogs_get_monotonic_time();
+
+    for (i = 0; i < BENCH_THREADS; i++) {
+        thread[i] = ogs_thread_create(bench_main, &bench[i]);
+        ABTS_PTR_NOTNULL(tc, thread[i]);
+    }
+    for (i = 0; i < BENCH_THREADS; i++)
+        ogs_thread_destroy(thread[i]);
+
+    start = ogs_get_monotonic_time() - start;
+
+    for (i = 0; i < BENCH_THREADS; i++) {
+        ABTS_INT_EQUAL(tc, 0, bench[i].failed);
+        while (ogs_queue_trypop(bench[i].queue, &remote) == OGS_OK)
+            bench_free(&bench[i], remote);
+        ogs_queue_destroy(bench[i].queue);
+    }
+
+    return start;
+}
+
+static void test6_func(abts_case *tc, void *data)
+{
+    ogs_mem_stat_t before, after;
+    ogs_time_t locked, arena;
+
+    ogs_mem_stat(&before);
+
+    locked = bench_run(tc, 1);
+    arena = bench_run(tc, 0);
+
+    ogs_info("%d threads x %d alloc/free : talloc+mutex %lldus, %s %lldus",
+            BENCH_THREADS, BENCH_ROUNDS * BENCH_BATCH, (long long)locked,
+            ogs_mem_arena_enabled() ? "arena" : "talloc",
+            (long long)arena);
+
+    ogs_mem_stat(&after);
+    ABTS_TRUE(tc, after.blocks == before.blocks);
+}
+
 abts_suite *test_memory(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -82,6 +270,8 @@ abts_suite *test_memory(abts_suite *suite)
     abts_run_test(suite, test2_func, NULL);
     abts_run_test(suite, test3_func, NULL);
     abts_run_test(suite, test4_func, NULL);
+    abts_run_test(suite, test5_func, NULL);
+    abts_run_test(suite, test6_func, NULL);
 
     return suite;
 }
@@ -70,12 +70,87 @@ static void test2_func(abts_case *tc, void *data)
     ogs_pkbuf_free(p3);
 }
 
+static void test3_func(abts_case *tc, void *data)
+{
+    ogs_pkbuf_t *pkbuf = NULL, *p2 = NULL, *p3 = NULL;
+    unsigned char *tmp = NULL;
+    ogs_sock_t *udp = NULL, *peer = NULL;
+    ogs_sockaddr_t *addr = NULL;
+    char buf[64];
+    ssize_t size;
+    int rv;
+
+    /* No headroom : the header gets a segment of its own */
+    pkbuf = ogs_pkbuf_alloc(NULL, 10);
+    ABTS_PTR_NOTNULL(tc, pkbuf);
+    ogs_pkbuf_put_data(pkbuf, "0123456789", 10);
+    pkbuf->param[0] = 7;
+
+    tmp = ogs_pkbuf_prepend(&pkbuf, 4);
+    ABTS_PTR_NOTNULL(tc, tmp);
+    memcpy(tmp, "HDR:", 4);
+    ABTS_PTR_NOTNULL(tc, pkbuf->next);
+    ABTS_INT_EQUAL(tc, 4, pkbuf->len);
+    ABTS_INT_EQUAL(tc, 14, ogs_pkbuf_chain_len(pkbuf));
+    ABTS_INT_EQUAL(tc, 7, pkbuf->param[0]);
+
+    /* Enough headroom now : no further segment */
+    tmp = ogs_pkbuf_prepend(&pkbuf, 2);
+    ABTS_PTR_NOTNULL(tc, tmp);
+    memcpy(tmp, "<<", 2);
+    ABTS_INT_EQUAL(tc, 6, pkbuf->len);
+    ABTS_PTR_EQUAL(tc, NULL, pkbuf->next->next);
+
+    p2 = ogs_pkbuf_alloc(NULL, 4);
+    ABTS_PTR_NOTNULL(tc, p2);
+    ogs_pkbuf_put_data(p2, ">>", 2);
+    ogs_pkbuf_chain(pkbuf, p2);
+    ABTS_INT_EQUAL(tc, 18, ogs_pkbuf_chain_len(pkbuf));
+
+    p3 = ogs_pkbuf_copy(pkbuf);
+    ABTS_PTR_NOTNULL(tc, p3);
+    ABTS_PTR_NOTNULL(tc, p3->next);
+    ABTS_PTR_NOTNULL(tc, p3->next->next);
+    ABTS_INT_EQUAL(tc, 18, ogs_pkbuf_chain_len(p3));
+
+    /* Gathered into a single datagram */
+    addr = NULL;
+    rv = ogs_getaddrinfo(&addr, AF_INET, "127.0.0.1", 47779, 0);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    udp = ogs_udp_server(addr, NULL);
+    ABTS_PTR_NOTNULL(tc, udp);
+    ogs_freeaddrinfo(addr);
+
+    peer = ogs_udp_client(&udp->local_addr, NULL);
+    ABTS_PTR_NOTNULL(tc, peer);
+
+    size = ogs_sendto_pkbuf(peer->fd, p3, 0, &udp->local_addr);
+    ABTS_INT_EQUAL(tc, 18, size);
+    size = ogs_recv(udp->fd, buf, sizeof(buf), 0);
+    ABTS_INT_EQUAL(tc, 18, size);
+    ABTS_TRUE(tc, memcmp(buf, "<<HDR:0123456789>>", 18) == 0);
+
+    ogs_sock_destroy(peer);
+    ogs_sock_destroy(udp);
+
+    pkbuf = ogs_pkbuf_linearize(pkbuf);
+    ABTS_PTR_NOTNULL(tc, pkbuf);
+    ABTS_PTR_EQUAL(tc, NULL, pkbuf->next);
+    ABTS_INT_EQUAL(tc, 18, pkbuf->len);
+    ABTS_INT_EQUAL(tc, 7, pkbuf->param[0]);
+    ABTS_TRUE(tc, memcmp(pkbuf->data, "<<HDR:0123456789>>", 18) == 0);
+
+    ogs_pkbuf_free(pkbuf);
+    ogs_pkbuf_free(p3);
+}
+
 abts_suite *test_pkbuf(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
 
     abts_run_test(suite, test1_func, NULL);
     abts_run_test(suite, test2_func, NULL);
+    abts_run_test(suite, test3_func, NULL);
 
     return suite;
 }
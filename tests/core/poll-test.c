@@ -657,6 +657,97 @@ static void test8_func(abts_case *tc, void *data)
     ogs_pollset_destroy(pollset);
 }
 
+#define TEST9_PORT 47780
+#define TEST9_NUM 5
+
+static int test9_okay;
+
+static void test9_handler(ogs_socket_t fd,
+        ogs_pkbuf_t **pkbuf, ogs_sockaddr_t *from, int num, void *data)
+{
+    abts_case *tc = data;
+    int i;
+
+    ABTS_PTR_NOTNULL(tc, from);
+
+    for (i = 0; i < num; i++) {
+        ABTS_INT_EQUAL(tc, AF_INET, from[i].ogs_sa_family);
+        ABTS_INT_EQUAL(tc, sizeof(DATASTR), pkbuf[i]->len);
+        ABTS_STR_EQUAL(tc, DATASTR, (char *)pkbuf[i]->data);
+        ABTS_TRUE(tc, ogs_pkbuf_headroom(pkbuf[i]) >= 16);
+
+        ogs_pkbuf_free(pkbuf[i]);
+        test9_okay++;
+    }
+}
+
+static void test9_func(abts_case *tc, void *data)
+{
+    int rv, i;
+    ssize_t size;
+    ogs_poll_t *poll;
+    ogs_sock_t *udp, *client;
+    ogs_sockaddr_t *addr;
+    ogs_pollset_t *pollset = ogs_pollset_create(512);
+    ABTS_PTR_NOTNULL(tc, pollset);
+
+    rv = ogs_getaddrinfo(&addr, AF_INET, "127.0.0.1", TEST9_PORT, 0);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    udp = ogs_udp_server(addr, NULL);
+    ABTS_PTR_NOTNULL(tc, udp);
+    client = ogs_udp_client(addr, NULL);
+    ABTS_PTR_NOTNULL(tc, client);
+    rv = ogs_freeaddrinfo(addr);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+
+    poll = ogs_pollset_add_recv(pollset, udp->fd,
+            NULL, 1024, 16, test9_handler, tc);
+    ABTS_PTR_NOTNULL(tc, poll);
+
+    test9_okay = 0;
+    for (i = 0; i < TEST9_NUM; i++) {
+        size = ogs_send(client->fd, DATASTR, sizeof(DATASTR), 0);
+        ABTS_INT_EQUAL(tc, sizeof(DATASTR), size);
+    }
+
+    for (i = 0; i < 100 && test9_okay < TEST9_NUM; i++)
+        ogs_pollset_poll(pollset, ogs_time_from_msec(100));
+    ABTS_INT_EQUAL(tc, TEST9_NUM, test9_okay);
+
+    ogs_pollset_remove(poll);
+
+    ogs_sock_destroy(client);
+    ogs_sock_destroy(udp);
+
+    ogs_pollset_destroy(pollset);
+}
+
+#if defined(__linux__)
+extern bool ogs_pollset_actions_initialized;
+
+static void test10_func(abts_case *tc, void *data)
+{
+    ogs_pollset_actions_t actions = ogs_pollset_actions;
+    bool initialized = ogs_pollset_actions_initialized;
+
+    if (ogs_pollset_use_io_uring() == false)
+        return;
+
+    test5_func(tc, data);
+
+    test6_okay = 1;
+    test6_func(tc, data);
+
+    test8_okay = 1;
+    test8_func(tc, data);
+
+    test9_func(tc, data);
+
+    ogs_pollset_actions = actions;
+    ogs_pollset_actions_initialized = initialized;
+}
+#endif
+
 abts_suite *test_poll(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -672,6 +763,10 @@ abts_suite *test_poll(abts_suite *suite)
     abts_run_test(suite, test6_func, NULL);
     abts_run_test(suite, test7_func, NULL);
     abts_run_test(suite, test8_func, NULL);
+    abts_run_test(suite, test9_func, NULL);
+#if defined(__linux__)
+    abts_run_test(suite, test10_func, NULL);
+#endif
 
     return suite;
 }
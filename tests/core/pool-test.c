@@ -228,6 +228,180 @@ static void test3_func(abts_case *tc, void *data)
     ogs_pool_final(&testpool);
 }
 
+typedef struct {
+    char data[1000];
+} chunknode_t;
+
+#define SIZE_OF_CHUNKPOOL 10000
+
+static OGS_POOL(chunkpool, chunknode_t);
+
+static void test4_func(abts_case *tc, void *data)
+{
+    chunknode_t *node[SIZE_OF_CHUNKPOOL], *extra = NULL;
+    size_t committed;
+    int i, index;
+
+    ogs_pool_init_chunked(&chunkpool, SIZE_OF_CHUNKPOOL);
+    ABTS_INT_EQUAL(tc, SIZE_OF_CHUNKPOOL, ogs_pool_size(&chunkpool));
+    ABTS_INT_EQUAL(tc, SIZE_OF_CHUNKPOOL, ogs_pool_avail(&chunkpool));
+    ABTS_TRUE(tc, ogs_pool_committed(&chunkpool) == 0);
+
+    for (i = 0; i < 100; i++) {
+        ogs_pool_alloc(&chunkpool, &node[i]);
+        ABTS_PTR_NOTNULL(tc, node[i]);
+        memset(node[i]->data, i, sizeof(node[i]->data));
+    }
+    committed = ogs_pool_committed(&chunkpool);
+    ABTS_TRUE(tc, committed > 0);
+    ABTS_TRUE(tc, committed < SIZE_OF_CHUNKPOOL * sizeof(chunknode_t) / 10);
+
+    index = ogs_pool_index(&chunkpool, node[42]);
+    ABTS_PTR_EQUAL(tc, node[42], ogs_pool_find(&chunkpool, index));
+    ABTS_INT_EQUAL(tc, 42, node[42]->data[999]);
+
+    /* Freed nodes are reused before committing more memory */
+    for (i = 0; i < 1000; i++) {
+        ogs_pool_free(&chunkpool, node[i % 100]);
+        ogs_pool_alloc(&chunkpool, &node[i % 100]);
+        ABTS_PTR_NOTNULL(tc, node[i % 100]);
+    }
+    ABTS_TRUE(tc, committed == ogs_pool_committed(&chunkpool));
+    ABTS_INT_EQUAL(tc, 100, ogs_pool_peak(&chunkpool));
+
+    /* Nothing is released while nodes are live */
+    ABTS_INT_EQUAL(tc, 0, ogs_pool_trim(&chunkpool));
+
+    for (i = 100; i < SIZE_OF_CHUNKPOOL; i++) {
+        ogs_pool_alloc(&chunkpool, &node[i]);
+        ABTS_PTR_NOTNULL(tc, node[i]);
+        node[i]->data[0] = 1;
+    }
+    ogs_pool_alloc(&chunkpool, &extra);
+    ABTS_PTR_EQUAL(tc, NULL, extra);
+    ABTS_INT_EQUAL(tc, 0, ogs_pool_avail(&chunkpool));
+    ABTS_INT_EQUAL(tc, SIZE_OF_CHUNKPOOL, ogs_pool_peak(&chunkpool));
+
+    for (i = 1; i < SIZE_OF_CHUNKPOOL; i++)
+        ogs_pool_free(&chunkpool, node[i]);
+
+    /* All chunks but the one holding node[0] are returned */
+    ABTS_TRUE(tc, ogs_pool_trim(&chunkpool) > 0);
+    committed = ogs_pool_committed(&chunkpool);
+    ABTS_TRUE(tc, committed > 0);
+    ABTS_TRUE(tc, committed < SIZE_OF_CHUNKPOOL * sizeof(chunknode_t) / 10);
+    node[0]->data[0] = 1;
+
+    for (i = 1; i < SIZE_OF_CHUNKPOOL; i++) {
+        ogs_pool_alloc(&chunkpool, &node[i]);
+        ABTS_PTR_NOTNULL(tc, node[i]);
+        node[i]->data[999] = 1;
+    }
+    for (i = 0; i < SIZE_OF_CHUNKPOOL; i++)
+        ogs_pool_free(&chunkpool, node[i]);
+    ABTS_INT_EQUAL(tc, SIZE_OF_CHUNKPOOL, ogs_pool_avail(&chunkpool));
+
+    ogs_pool_final(&chunkpool);
+}
+
+typedef struct {
+    ogs_pool_id_t id;
+} idnode_t;
+
+static OGS_POOL(idpool, idnode_t);
+
+static void test5_func(abts_case *tc, void *data)
+{
+    idnode_t *node[3], *found = NULL;
+    ogs_pool_id_t id[3], stale;
+    int i;
+
+    ogs_pool_init(&idpool, 3);
+
+    for (i = 0; i < 3; i++) {
+        ogs_pool_id_calloc(&idpool, &node[i]);
+        ABTS_PTR_NOTNULL(tc, node[i]);
+        id[i] = node[i]->id;
+        ABTS_TRUE(tc, id[i] >= OGS_MIN_POOL_ID && id[i] <= OGS_MAX_POOL_ID);
+    }
+    for (i = 0; i < 3; i++) {
+        found = ogs_pool_find_by_id(&idpool, id[i]);
+        ABTS_PTR_EQUAL(tc, node[i], found);
+    }
+
+    stale = OGS_INVALID_POOL_ID;
+    ABTS_PTR_EQUAL(tc, NULL, ogs_pool_find_by_id(&idpool, stale));
+    stale = -1;
+    ABTS_PTR_EQUAL(tc, NULL, ogs_pool_find_by_id(&idpool, stale));
+    stale = id[2] + 1;
+    ABTS_PTR_EQUAL(tc, NULL, ogs_pool_find_by_id(&idpool, stale));
+
+    /* A stale id does not match the node reusing its slot */
+    stale = id[1];
+    ogs_pool_id_free(&idpool, node[1]);
+    ABTS_PTR_EQUAL(tc, NULL, ogs_pool_find_by_id(&idpool, stale));
+
+    for (i = 0; i < 100; i++) {
+        ogs_pool_id_calloc(&idpool, &node[1]);
+        ABTS_PTR_NOTNULL(tc, node[1]);
+        ABTS_TRUE(tc, node[1]->id != stale);
+        ABTS_PTR_EQUAL(tc, NULL, ogs_pool_find_by_id(&idpool, stale));
+        found = ogs_pool_find_by_id(&idpool, node[1]->id);
+        ABTS_PTR_EQUAL(tc, node[1], found);
+
+        stale = node[1]->id;
+        ogs_pool_id_free(&idpool, node[1]);
+    }
+
+    found = ogs_pool_find_by_id(&idpool, id[0]);
+    ABTS_PTR_EQUAL(tc, node[0], found);
+
+    ogs_pool_id_free(&idpool, node[0]);
+    ogs_pool_id_free(&idpool, node[2]);
+
+    ogs_pool_final(&idpool);
+}
+
+static OGS_POOL(idchunkpool, idnode_t);
+
+static void test6_func(abts_case *tc, void *data)
+{
+    idnode_t *node = NULL, *found = NULL;
+    ogs_pool_id_t last[1], first, id;
+    int bits, i;
+
+    /* The generation of a slot in a pool of 2^26 nodes does not wrap */
+    bits = ogs_pool_id_bits(1 << 26);
+    last[0] = 0;
+    first = ogs_pool_id_next(last, bits, 0);
+    for (i = 0; i < 0x10000; i++) {
+        id = ogs_pool_id_next(last, bits, 0);
+        ABTS_TRUE(tc, id >= OGS_MIN_POOL_ID && id <= OGS_MAX_POOL_ID);
+        ABTS_TRUE(tc, id != first);
+        ABTS_INT_EQUAL(tc, 0, ogs_pool_id_slot(id, bits, 1 << 26));
+    }
+
+    /* A chunked pool hands the same slot out again on every alloc */
+    ogs_pool_init_chunked(&idchunkpool, 3);
+
+    ogs_pool_id_calloc(&idchunkpool, &node);
+    ABTS_PTR_NOTNULL(tc, node);
+    first = node->id;
+    ogs_pool_id_free(&idchunkpool, node);
+
+    for (i = 0; i < 0x10000; i++) {
+        ogs_pool_id_calloc(&idchunkpool, &node);
+        ABTS_PTR_NOTNULL(tc, node);
+        ABTS_TRUE(tc, node->id != first);
+        ABTS_PTR_EQUAL(tc, NULL, ogs_pool_find_by_id(&idchunkpool, first));
+        found = ogs_pool_find_by_id(&idchunkpool, node->id);
+        ABTS_PTR_EQUAL(tc, node, found);
+        ogs_pool_id_free(&idchunkpool, node);
+    }
+
+    ogs_pool_final(&idchunkpool);
+}
+
 abts_suite *test_pool(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -235,6 +409,9 @@ abts_suite *test_pool(abts_suite *suite)
     abts_run_test(suite, test1_func, NULL);
     abts_run_test(suite, test2_func, NULL);
     abts_run_test(suite, test3_func, NULL);
+    abts_run_test(suite, test4_func, NULL);
+    abts_run_test(suite, test5_func, NULL);
+    abts_run_test(suite, test6_func, NULL);
 
     return suite;
 }
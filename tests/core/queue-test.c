@@ -166,12 +166,158 @@ static void test_queue_timeout(abts_case *tc, void *data)
     ogs_queue_destroy(q);
 }
 
+#define BULK_PRODUCERS      4
+#define BULK_ITEMS          10000
+
+static void bulk_producer(void *data)
+{
+    uintptr_t id = (uintptr_t)data;
+    uintptr_t i;
+    int rv;
+
+    for (i = 1; i <= BULK_ITEMS; i++) {
+        do {
+            rv = ogs_queue_push(queue, (void *)(id << 24 | i));
+        } while (rv == OGS_ERROR);
+        ogs_assert(rv == OGS_OK);
+    }
+}
+
+static void test_queue_bulk(abts_case *tc, void *data)
+{
+    ogs_thread_t *producer_thread[BULK_PRODUCERS];
+    uintptr_t last[BULK_PRODUCERS];
+    unsigned int i, n, total = 0;
+    void *v[OGS_QUEUE_BULK_SIZE];
+    int rv;
+
+    queue = ogs_queue_create(QUEUE_SIZE);
+    ABTS_PTR_NOTNULL(tc, queue);
+
+    for (i = 0; i < BULK_PRODUCERS; i++) {
+        last[i] = 0;
+        producer_thread[i] = ogs_thread_create(
+                bulk_producer, (void *)(uintptr_t)i);
+        ABTS_PTR_NOTNULL(tc, producer_thread[i]);
+    }
+
+    /* Items of each producer come out once and in order */
+    while (total < BULK_PRODUCERS * BULK_ITEMS) {
+        rv = ogs_queue_trypop_bulk(queue, v, OGS_QUEUE_BULK_SIZE, &n);
+        if (rv == OGS_RETRY) {
+            /* Sleep until a producer gets to run */
+            rv = ogs_queue_pop(queue, &v[0]);
+            n = 1;
+        }
+        ABTS_INT_EQUAL(tc, OGS_OK, rv);
+        ABTS_TRUE(tc, n > 0 && n <= OGS_QUEUE_BULK_SIZE);
+
+        for (i = 0; i < n; i++) {
+            uintptr_t id = (uintptr_t)v[i] >> 24;
+            uintptr_t seq = (uintptr_t)v[i] & 0xffffff;
+
+            ABTS_TRUE(tc, id < BULK_PRODUCERS);
+            ABTS_TRUE(tc, seq == last[id] + 1);
+            last[id] = seq;
+        }
+        total += n;
+    }
+    ABTS_INT_EQUAL(tc, 0, ogs_queue_size(queue));
+
+    for (i = 0; i < BULK_PRODUCERS; i++)
+        ogs_thread_destroy(producer_thread[i]);
+
+    rv = ogs_queue_term(queue);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    rv = ogs_queue_trypop_bulk(queue, v, OGS_QUEUE_BULK_SIZE, &n);
+    ABTS_INT_EQUAL(tc, OGS_DONE, rv);
+
+    ogs_queue_destroy(queue);
+}
+
+#define WAKEUP_ITEMS        100000
+
+static int wakeup_errors;
+
+static void wakeup_producer(void *data)
+{
+    uintptr_t i;
+    int rv;
+
+    for (i = 1; i <= WAKEUP_ITEMS; i++) {
+        rv = ogs_queue_push(queue, (void *)i);
+        if (rv != OGS_OK)
+            wakeup_errors++;
+    }
+}
+
+static void wakeup_consumer(void *data)
+{
+    int *rv = data;
+    void *v;
+
+    ogs_atomic_store(rv, ogs_queue_pop(queue, &v), OGS_ATOMIC_RELEASE);
+}
+
+static void test_queue_wakeup(abts_case *tc, void *data)
+{
+    ogs_thread_t *thread;
+    uintptr_t i;
+    void *v;
+    int rv, errors = 0;
+
+    /* A small ring keeps both sides waiting on each other */
+    queue = ogs_queue_create(2);
+    ABTS_PTR_NOTNULL(tc, queue);
+
+    wakeup_errors = 0;
+    thread = ogs_thread_create(wakeup_producer, NULL);
+    ABTS_PTR_NOTNULL(tc, thread);
+
+    /* A wait only ends with an item, never with OGS_ERROR */
+    for (i = 1; i <= WAKEUP_ITEMS; i++) {
+        rv = ogs_queue_pop(queue, &v);
+        if (rv != OGS_OK || (uintptr_t)v != i)
+            errors++;
+    }
+    ABTS_INT_EQUAL(tc, 0, errors);
+
+    ogs_thread_destroy(thread);
+    ABTS_INT_EQUAL(tc, 0, wakeup_errors);
+
+    /* ogs_queue_interrupt_all() does end a blocking pop */
+    rv = OGS_RETRY;
+    thread = ogs_thread_create(wakeup_consumer, &rv);
+    ABTS_PTR_NOTNULL(tc, thread);
+
+    while (ogs_atomic_load(&rv, OGS_ATOMIC_ACQUIRE) == OGS_RETRY) {
+        ogs_msleep(10);
+        ogs_queue_interrupt_all(queue);
+    }
+    ogs_thread_destroy(thread);
+    ABTS_INT_EQUAL(tc, OGS_ERROR, rv);
+
+    /* And so does ogs_queue_term() */
+    rv = OGS_RETRY;
+    thread = ogs_thread_create(wakeup_consumer, &rv);
+    ABTS_PTR_NOTNULL(tc, thread);
+
+    ogs_msleep(10);
+    ogs_queue_term(queue);
+    ogs_thread_destroy(thread);
+    ABTS_INT_EQUAL(tc, OGS_DONE, rv);
+
+    ogs_queue_destroy(queue);
+}
+
 abts_suite *test_queue(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
 
     abts_run_test(suite, test_queue_producer_consumer, NULL);
     abts_run_test(suite, test_queue_timeout, NULL);
+    abts_run_test(suite, test_queue_bulk, NULL);
+    abts_run_test(suite, test_queue_wakeup, NULL);
 
     return suite;
 }
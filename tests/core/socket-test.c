@@ -424,6 +424,68 @@ static void test8_func(abts_case *tc, void *data)
     ABTS_INT_EQUAL(tc, OGS_OK, rv);
 }
 
+#if !defined(_WIN32)
+#define TEST9_NUM 3
+static void test9_func(abts_case *tc, void *data)
+{
+    int rv, i;
+    ogs_sock_t *server, *client;
+    ogs_sockaddr_t *addr;
+    ogs_sockaddr_t from[TEST9_NUM];
+    ogs_mmsghdr_t msg[TEST9_NUM];
+    struct iovec iov[TEST9_NUM];
+    char str[TEST9_NUM][STRLEN];
+    char buf[OGS_ADDRSTRLEN];
+
+    rv = ogs_getaddrinfo(&addr, AF_INET, "127.0.0.1", PORT, 0);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    server = ogs_udp_server(addr, NULL);
+    ABTS_PTR_NOTNULL(tc, server);
+    client = ogs_udp_client(addr, NULL);
+    ABTS_PTR_NOTNULL(tc, client);
+
+    memset(msg, 0, sizeof(msg));
+    for (i = 0; i < TEST9_NUM; i++) {
+        iov[i].iov_base = (char *)DATASTR;
+        iov[i].iov_len = strlen(DATASTR) - i;
+        msg[i].msg_hdr.msg_iov = &iov[i];
+        msg[i].msg_hdr.msg_iovlen = 1;
+    }
+    rv = ogs_sendmmsg(client->fd, msg, TEST9_NUM, 0);
+    ABTS_INT_EQUAL(tc, TEST9_NUM, rv);
+
+    memset(msg, 0, sizeof(msg));
+    for (i = 0; i < TEST9_NUM; i++) {
+        iov[i].iov_base = str[i];
+        iov[i].iov_len = STRLEN;
+        msg[i].msg_hdr.msg_iov = &iov[i];
+        msg[i].msg_hdr.msg_iovlen = 1;
+        msg[i].msg_hdr.msg_name = &from[i].sa;
+        msg[i].msg_hdr.msg_namelen = sizeof(from[i]);
+    }
+
+    i = 0;
+    while (i < TEST9_NUM) {
+        rv = ogs_recvmmsg(server->fd, &msg[i], TEST9_NUM - i, 0);
+        ABTS_TRUE(tc, rv > 0);
+        if (rv <= 0)
+            break;
+        i += rv;
+    }
+
+    for (i = 0; i < TEST9_NUM; i++) {
+        ABTS_INT_EQUAL(tc, strlen(DATASTR) - i, msg[i].msg_len);
+        ABTS_STR_EQUAL(tc, "127.0.0.1", OGS_ADDR(&from[i], buf));
+    }
+
+    ogs_sock_destroy(client);
+    ogs_sock_destroy(server);
+
+    rv = ogs_freeaddrinfo(addr);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+}
+#endif
+
 abts_suite *test_socket(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -436,6 +498,9 @@ abts_suite *test_socket(abts_suite *suite)
     abts_run_test(suite, test6_func, NULL);
     abts_run_test(suite, test7_func, NULL);
     abts_run_test(suite, test8_func, NULL);
+#if !defined(_WIN32)
+    abts_run_test(suite, test9_func, NULL);
+#endif
 
     return suite;
 }
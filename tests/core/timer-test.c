@@ -208,6 +208,159 @@ static void test3_func(abts_case *tc, void *data)
     ogs_timer_mgr_destroy(timer);
 }
 
+static void test4_func(abts_case *tc, void *data)
+{
+    int n = 0;
+    ogs_timer_mgr_t *timer = NULL;
+    ogs_timer_t *timer_array[TEST_TIMER_NUM];
+    ogs_time_t duration, earliest;
+    int tm_num[TEST_DURATION/TEST_TIMER_PRECISION];
+    int tm_idx;
+
+    memset(expire_check, 0, TEST_DURATION/TEST_TIMER_PRECISION);
+    memset(tm_num, 0, sizeof(int)*(TEST_DURATION/TEST_TIMER_PRECISION));
+
+    timer = ogs_timer_mgr_create(512);
+    ogs_assert(timer);
+
+    /* A fine resolution spreads the timers over several wheel levels */
+    ogs_timer_mgr_set_resolution(timer, 10);
+
+    earliest = TEST_DURATION;
+    for(n = 0; n < TEST_TIMER_NUM; n++) {
+        tm_idx = ogs_random32() % (TEST_DURATION/TEST_TIMER_PRECISION);
+        duration = tm_idx * TEST_TIMER_PRECISION + (TEST_TIMER_PRECISION >> 1);
+
+        timer_array[n] = ogs_timer_add(
+                timer, test_expire_func_2, (void*)(uintptr_t)tm_idx);
+        ogs_assert(timer_array[n]);
+
+        /* Restarted timers only fire for their last start */
+        ogs_timer_start(timer_array[n], TEST_DURATION * 2);
+        if (n % 2)
+            ogs_timer_stop(timer_array[n]);
+        ogs_timer_start(timer_array[n], duration);
+        tm_num[tm_idx]++;
+
+        if (duration < earliest)
+            earliest = duration;
+    }
+
+    ABTS_TRUE(tc, ogs_timer_mgr_next(timer) <= earliest);
+    ABTS_TRUE(tc, ogs_timer_mgr_next(timer) > 0);
+
+    for(n = 0; n < TEST_DURATION/TEST_TIMER_PRECISION; n++) {
+        ogs_usleep(TEST_TIMER_PRECISION);
+        ogs_timer_mgr_expire(timer);
+        ABTS_INT_EQUAL(tc, tm_num[n], expire_check[n]);
+    }
+    ABTS_INT_EQUAL(tc, OGS_INFINITE_TIME, ogs_timer_mgr_next(timer));
+
+    for(n = 0; n < TEST_TIMER_NUM; n++)
+        ogs_timer_delete(timer_array[n]);
+
+    ogs_timer_mgr_destroy(timer);
+}
+
+#define TEST_WHEEL_SIZE         64
+#define TEST_RESOLUTION         10000
+
+static int boundary_batch;
+static int boundary_fired[4];
+static uint64_t boundary_tick[4];
+
+static void test_expire_func_3(void *data)
+{
+    int index = (uintptr_t)data;
+
+    boundary_fired[index] = boundary_batch;
+    boundary_tick[index] = ogs_get_monotonic_time() / TEST_RESOLUTION;
+}
+
+/* Half a tick before the given one, so that a timer started now is due at it */
+static ogs_time_t until_tick(uint64_t tick)
+{
+    return tick * TEST_RESOLUTION - TEST_RESOLUTION / 2 -
+        ogs_get_monotonic_time();
+}
+
+/*
+ * Block boundary : the current tick reaches the start of a 64-tick block
+ * while the timers of that block still wait in the next level. A timer
+ * started then goes to level 0, but must not delay the waiting ones.
+ */
+static void test5_func(abts_case *tc, void *data)
+{
+    int n, spins = 0;
+    bool missed;
+    ogs_timer_mgr_t *timer = NULL;
+    ogs_timer_t *timer_array[4];
+    uint64_t block;
+    ogs_time_t next;
+
+    timer = ogs_timer_mgr_create(512);
+    ogs_assert(timer);
+    ogs_timer_mgr_set_resolution(timer, TEST_RESOLUTION);
+
+    for (n = 0; n < 4; n++) {
+        timer_array[n] = ogs_timer_add(
+                timer, test_expire_func_3, (void*)(uintptr_t)n);
+        ogs_assert(timer_array[n]);
+        boundary_fired[n] = 0;
+    }
+    boundary_batch = 1;
+
+    block = ogs_get_monotonic_time() / TEST_RESOLUTION;
+    block = (block / TEST_WHEEL_SIZE + 2) * TEST_WHEEL_SIZE;
+
+    /* Both at level 1, due at the start of the block and 8 ticks later */
+    ogs_timer_start(timer_array[0], until_tick(block));
+    ogs_timer_start(timer_array[1], until_tick(block + 8));
+
+    /* Nothing due : the current tick moves to the start of the block */
+    ogs_usleep(until_tick(block));
+    ogs_timer_mgr_expire(timer);
+
+    /* Woken up too late to be just before the block : it already fired */
+    missed = boundary_fired[0] != 0;
+
+    /* At level 0, at the start of the block and 30 ticks later */
+    ogs_timer_start(timer_array[2], until_tick(block));
+    ogs_timer_start(timer_array[3], until_tick(block + 30));
+
+    while (!boundary_fired[3] &&
+            ogs_get_monotonic_time() / TEST_RESOLUTION < block + 100) {
+        next = ogs_timer_mgr_next(timer);
+        if (next == 0)
+            spins++;
+        else
+            ogs_usleep(ogs_min(next, TEST_RESOLUTION));
+
+        boundary_batch++;
+        ogs_timer_mgr_expire(timer);
+    }
+
+    /* The level-1 timer due at the boundary joins the level-0 batch */
+    ABTS_TRUE(tc, boundary_fired[0] != 0);
+    if (!missed)
+        ABTS_INT_EQUAL(tc, boundary_fired[0], boundary_fired[2]);
+
+    /* The cascaded timer is not held back by the later level-0 timer */
+    ABTS_TRUE(tc, boundary_fired[1] != 0);
+    ABTS_TRUE(tc, boundary_fired[1] < boundary_fired[3]);
+    ABTS_TRUE(tc, boundary_tick[1] >= block + 8);
+    ABTS_TRUE(tc, boundary_tick[1] < block + 30);
+    ABTS_TRUE(tc, boundary_tick[3] >= block + 30);
+
+    /* ogs_timer_mgr_next() only returns 0 for a timer about to fire */
+    ABTS_TRUE(tc, spins < 4);
+
+    for (n = 0; n < 4; n++)
+        ogs_timer_delete(timer_array[n]);
+
+    ogs_timer_mgr_destroy(timer);
+}
+
 abts_suite *test_timer(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -215,6 +368,8 @@ abts_suite *test_timer(abts_suite *suite)
     abts_run_test(suite, test1_func, NULL);
     abts_run_test(suite, test2_func, NULL);
     abts_run_test(suite, test3_func, NULL);
+    abts_run_test(suite, test4_func, NULL);
+    abts_run_test(suite, test5_func, NULL);
 
     return suite;
 }
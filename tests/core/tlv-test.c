@@ -852,6 +852,127 @@ static void test6_func(abts_case *tc, void *data)
     ogs_pkbuf_free(req);
 }
 
+/* Mixed TLV/TV message parsed by description */
+typedef struct _tlv_mixed_msg {
+    ogs_tlv_uint16_t u16;
+    ogs_tlv_uint24_t u24;
+    ogs_tlv_uint32_t u32_first;
+    ogs_tlv_uint32_t u32_second;
+    ogs_tlv_null_t null;
+    ogs_tlv_octet_t fixed;
+    ogs_tlv_uint8_t tv;
+} tlv_mixed_msg;
+
+ogs_tlv_desc_t tlv_desc_mixed_u16 =
+    { OGS_TLV_UINT16, "U16", 1, 2, 0, sizeof(ogs_tlv_uint16_t), { NULL } };
+ogs_tlv_desc_t tlv_desc_mixed_u24 =
+    { OGS_TLV_UINT24, "U24", 2, 3, 0, sizeof(ogs_tlv_uint24_t), { NULL } };
+ogs_tlv_desc_t tlv_desc_mixed_u32 =
+    { OGS_TLV_UINT32, "U32", 3, 4, 0, sizeof(ogs_tlv_uint32_t), { NULL } };
+ogs_tlv_desc_t tlv_desc_mixed_null =
+    { OGS_TLV_NULL, "Null", 5, 0, 0, sizeof(ogs_tlv_null_t), { NULL } };
+ogs_tlv_desc_t tlv_desc_mixed_fixed =
+    { OGS_TLV_FIXED_STR, "Fixed", 6, 3, 0, sizeof(ogs_tlv_octet_t), { NULL } };
+ogs_tlv_desc_t tlv_desc_mixed_tv =
+    { OGS_TV_UINT8, "TV", 7, 1, 0, sizeof(ogs_tlv_uint8_t), { NULL } };
+
+ogs_tlv_desc_t tlv_desc_mixed_msg = {
+    OGS_TLV_MESSAGE, "Mixed", 0, 0, 0, 0, {
+    &tlv_desc_mixed_u16,
+    &tlv_desc_mixed_u24,
+    &tlv_desc_mixed_u32,
+    &tlv_desc_mixed_u32,
+    &tlv_desc_mixed_null,
+    &tlv_desc_mixed_fixed,
+    &tlv_desc_mixed_tv,
+    NULL,
+}};
+
+static void test7_func(abts_case *tc, void *data)
+{
+    tlv_mixed_msg msg, msg2;
+    ogs_pkbuf_t *pkbuf = NULL;
+    char testbuf[128];
+    int rv;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.u16.presence = 1;
+    msg.u16.u16 = 0x1122;
+    msg.u24.presence = 1;
+    msg.u24.u24 = 0x334455;
+    msg.u32_first.presence = 1;
+    msg.u32_first.u32 = 0x66778899;
+    msg.u32_second.presence = 1;
+    msg.u32_second.u32 = 0xaabbccdd;
+    msg.null.presence = 1;
+    msg.fixed.presence = 1;
+    msg.fixed.data = (uint8_t *)"\x01\x02\x03";
+    msg.fixed.len = 3;
+    msg.tv.presence = 1;
+    msg.tv.u8 = 0xee;
+
+    /* The message is encoded without any ogs_tlv_t node */
+    pkbuf = ogs_tlv_build_msg(&tlv_desc_mixed_msg, &msg, OGS_TLV_MODE_T1_L2);
+    ABTS_PTR_NOTNULL(tc, pkbuf);
+    ABTS_INT_EQUAL(tc, ogs_core()->tlv.pool, ogs_tlv_pool_avail());
+
+#define TEST_TLV_MIXED_MSG \
+    "01000211 22020003 33445503 00046677" \
+    "88990300 04aabbcc dd050000 06000301" \
+    "020307ee"
+
+    ABTS_INT_EQUAL(tc, 36, pkbuf->len);
+    ABTS_TRUE(tc, memcmp(pkbuf->data,
+        ogs_hex_from_string(TEST_TLV_MIXED_MSG, testbuf, sizeof(testbuf)),
+        pkbuf->len) == 0);
+
+    /* The source message is left in host byte order */
+    ABTS_INT_EQUAL(tc, 0x1122, msg.u16.u16);
+    ABTS_INT_EQUAL(tc, 0x334455, msg.u24.u24);
+
+    /* Repeated <type,instance> goes to the next matching field */
+    memset(&msg2, 0, sizeof(msg2));
+    rv = ogs_tlv_parse_msg_desc(
+            &msg2, &tlv_desc_mixed_msg, pkbuf, OGS_TLV_MODE_T1_L2);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    ABTS_INT_EQUAL(tc, ogs_core()->tlv.pool, ogs_tlv_pool_avail());
+    ABTS_INT_EQUAL(tc, 0x1122, msg2.u16.u16);
+    ABTS_INT_EQUAL(tc, 0x334455, msg2.u24.u24);
+    ABTS_INT_EQUAL(tc, 1, msg2.u32_first.presence);
+    ABTS_INT_EQUAL(tc, 0x66778899, msg2.u32_first.u32);
+    ABTS_INT_EQUAL(tc, 1, msg2.u32_second.presence);
+    ABTS_INT_EQUAL(tc, 0xaabbccdd, msg2.u32_second.u32);
+    ABTS_INT_EQUAL(tc, 1, msg2.null.presence);
+    ABTS_INT_EQUAL(tc, 3, msg2.fixed.len);
+    ABTS_TRUE(tc, memcmp(msg2.fixed.data, "\x01\x02\x03", 3) == 0);
+    ABTS_INT_EQUAL(tc, 1, msg2.tv.presence);
+    ABTS_INT_EQUAL(tc, 0xee, msg2.tv.u8);
+
+    /* Truncated message */
+    ogs_pkbuf_trim(pkbuf, pkbuf->len - 1);
+    memset(&msg2, 0, sizeof(msg2));
+    rv = ogs_tlv_parse_msg_desc(
+            &msg2, &tlv_desc_mixed_msg, pkbuf, OGS_TLV_MODE_T1_L2);
+    ABTS_INT_EQUAL(tc, OGS_ERROR, rv);
+    ogs_pkbuf_free(pkbuf);
+
+    /* Unknown IE is skipped */
+    pkbuf = ogs_pkbuf_alloc(NULL, 64);
+    ABTS_PTR_NOTNULL(tc, pkbuf);
+    ogs_pkbuf_put_data(pkbuf,
+        ogs_hex_from_string(TEST_TLV_MIXED_MSG, testbuf, sizeof(testbuf)), 34);
+    ogs_pkbuf_put_data(pkbuf, "\x09\x00\x01\xff", 4);
+
+    memset(&msg2, 0, sizeof(msg2));
+    rv = ogs_tlv_parse_msg(
+            &msg2, &tlv_desc_mixed_msg, pkbuf, OGS_TLV_MODE_T1_L2);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    ABTS_INT_EQUAL(tc, 0xaabbccdd, msg2.u32_second.u32);
+    ABTS_INT_EQUAL(tc, 0, msg2.tv.presence);
+
+    ogs_pkbuf_free(pkbuf);
+}
+
 abts_suite *test_tlv(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -875,6 +996,7 @@ abts_suite *test_tlv(abts_suite *suite)
     abts_run_test(suite, test5_func, (void*)OGS_TLV_MODE_T1_L2_I1);
 
     abts_run_test(suite, test6_func, NULL);
+    abts_run_test(suite, test7_func, NULL);
 
     return suite;
 }
@@ -372,6 +372,46 @@ static void ngap_message_test5_issues2934(abts_case *tc, void *data)
     ogs_pkbuf_free(ngapbuf);
 }
 
+static void ngap_message_test6(abts_case *tc, void *data)
+{
+    const char *payload =
+        "7e005c00 0d0199f9 07f0ff00 00000020"
+        "3190";
+    ogs_pkbuf_t *gmmbuf = NULL;
+    ogs_pkbuf_t *ngapbuf = NULL;
+    char hexbuf[OGS_HUGE_LEN];
+
+    ogs_ngap_route_t route;
+    int rv;
+
+    gmmbuf = ogs_pkbuf_alloc(NULL, OGS_MAX_SDU_LEN);
+    ogs_assert(gmmbuf);
+    ogs_pkbuf_put_data(gmmbuf,
+            ogs_hex_from_string(payload, hexbuf, sizeof(hexbuf)), 18);
+
+    ngapbuf = build_uplink_nas_transport(0x12345678, 0xffffffffff, gmmbuf);
+    ABTS_PTR_NOTNULL(tc, ngapbuf);
+
+    rv = ogs_ngap_decode_route(&route, ngapbuf);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    ABTS_INT_EQUAL(tc, NGAP_NGAP_PDU_PR_initiatingMessage, route.present);
+    ABTS_INT_EQUAL(tc,
+            NGAP_ProcedureCode_id_UplinkNASTransport, route.procedure_code);
+    ABTS_INT_EQUAL(tc, NGAP_Criticality_ignore, route.criticality);
+    ABTS_TRUE(tc, route.ran_ue_ngap_id_presence);
+    ABTS_TRUE(tc, 0x12345678 == route.ran_ue_ngap_id);
+    ABTS_TRUE(tc, route.amf_ue_ngap_id_presence);
+    ABTS_TRUE(tc, 0xffffffffff == route.amf_ue_ngap_id);
+    ABTS_INT_EQUAL(tc, 18, route.nas_pdu_len);
+    ABTS_TRUE(tc, memcmp(route.nas_pdu, hexbuf, 18) == 0);
+
+    ogs_pkbuf_trim(ngapbuf, ngapbuf->len - 1);
+    rv = ogs_ngap_decode_route(&route, ngapbuf);
+    ABTS_INT_EQUAL(tc, OGS_ERROR, rv);
+
+    ogs_pkbuf_free(ngapbuf);
+}
+
 abts_suite *test_ngap_message(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -383,6 +423,7 @@ abts_suite *test_ngap_message(abts_suite *suite)
     abts_run_test(suite, ngap_message_test3, NULL);
     abts_run_test(suite, ngap_message_test4, NULL);
     abts_run_test(suite, ngap_message_test5_issues2934, NULL);
+    abts_run_test(suite, ngap_message_test6, NULL);
 
     return suite;
 }
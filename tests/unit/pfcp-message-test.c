@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2019-2024 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ogs-pfcp.h"
+#include "core/abts.h"
+
+static void pfcp_message_test1(abts_case *tc, void *data)
+{
+    /* Heartbeat Request */
+    const char *payload =
+        "2001000c00000100 00600004e51e4d3c";
+    char hexbuf[OGS_HUGE_LEN];
+
+    ogs_pkbuf_t *pkbuf = NULL;
+    ogs_pfcp_ie_index_t *index = NULL;
+    ogs_pfcp_heartbeat_request_t req;
+    ogs_pfcp_node_id_t node_id;
+    int rv;
+
+    pkbuf = ogs_pkbuf_alloc(NULL, OGS_MAX_SDU_LEN);
+    ogs_assert(pkbuf);
+    ogs_pkbuf_put_data(pkbuf,
+            ogs_hex_from_string(payload, hexbuf, sizeof(hexbuf)), 16);
+
+    index = ogs_pfcp_ie_index_parse(pkbuf);
+    ABTS_PTR_NOTNULL(tc, index);
+    ABTS_INT_EQUAL(tc, OGS_PFCP_HEARTBEAT_REQUEST_TYPE, index->h.type);
+    ABTS_INT_EQUAL(tc, 0, index->h.seid_presence);
+    ABTS_INT_EQUAL(tc, 1, index->num_of_ie);
+    ABTS_INT_EQUAL(tc, 8, pkbuf->len);
+
+    memset(&req, 0, sizeof(req));
+    rv = ogs_pfcp_ie_index_decode_msg(index,
+            &ogs_pfcp_msg_desc_pfcp_heartbeat_request, &req);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    ABTS_INT_EQUAL(tc, 1, req.recovery_time_stamp.presence);
+    ABTS_INT_EQUAL(tc, 0xe51e4d3c, req.recovery_time_stamp.u32);
+
+    ABTS_INT_EQUAL(tc, OGS_PFCP_STATUS_NODE_ID_NONE,
+            ogs_pfcp_ie_index_extract_node_id(index, &node_id));
+
+    ogs_pfcp_ie_index_free(index);
+    ogs_pkbuf_free(pkbuf);
+}
+
+static void pfcp_message_test2(abts_case *tc, void *data)
+{
+    /* Session Establishment Request */
+    const char *payload =
+        "2132006100000000 0000000000000100"
+        "003c0005007f0000 01"
+        "0039000d02000000 00000000017f0000 02"
+        "0001000e00380002 0001001d00040000 00ff"
+        "0001000e00380002 0002001d00040000 0100"
+        "0003000e006c0004 00000001002c0002 0200"
+        "0071000101";
+    char hexbuf[OGS_HUGE_LEN];
+
+    ogs_pkbuf_t *pkbuf = NULL;
+    ogs_pfcp_ie_index_t *index = NULL;
+    ogs_pfcp_ie_t *ie = NULL;
+    ogs_pfcp_tlv_create_pdr_t create_pdr;
+    ogs_pfcp_tlv_create_far_t create_far;
+    ogs_pfcp_message_t *message = NULL;
+    ogs_pfcp_node_id_t node_id;
+    int rv;
+
+    pkbuf = ogs_pkbuf_alloc(NULL, OGS_MAX_SDU_LEN);
+    ogs_assert(pkbuf);
+    ogs_pkbuf_put_data(pkbuf,
+            ogs_hex_from_string(payload, hexbuf, sizeof(hexbuf)), 101);
+
+    index = ogs_pfcp_ie_index_parse(pkbuf);
+    ABTS_PTR_NOTNULL(tc, index);
+    ABTS_INT_EQUAL(tc, OGS_PFCP_SESSION_ESTABLISHMENT_REQUEST_TYPE,
+            index->h.type);
+    ABTS_INT_EQUAL(tc, 1, index->h.seid_presence);
+    ABTS_INT_EQUAL(tc, 6, index->num_of_ie);
+
+    rv = ogs_pfcp_ie_index_extract_node_id(index, &node_id);
+    ABTS_INT_EQUAL(tc, OGS_PFCP_STATUS_SUCCESS, rv);
+    ABTS_INT_EQUAL(tc, OGS_PFCP_NODE_ID_IPV4, node_id.type);
+    ABTS_TRUE(tc, memcmp(&node_id.addr, "\x7f\x00\x00\x01", 4) == 0);
+
+    ie = ogs_pfcp_ie_find(index, OGS_PFCP_CREATE_PDR_TYPE, NULL);
+    ABTS_PTR_NOTNULL(tc, ie);
+    rv = ogs_pfcp_ie_decode_create_pdr(index, ie, &create_pdr);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    ABTS_INT_EQUAL(tc, 1, create_pdr.presence);
+    ABTS_INT_EQUAL(tc, 1, create_pdr.pdr_id.u16);
+    ABTS_INT_EQUAL(tc, 255, create_pdr.precedence.u32);
+    ABTS_INT_EQUAL(tc, 0, create_pdr.pdi.presence);
+
+    ie = ogs_pfcp_ie_find(index, OGS_PFCP_CREATE_PDR_TYPE, ie);
+    ABTS_PTR_NOTNULL(tc, ie);
+    rv = ogs_pfcp_ie_decode_create_pdr(index, ie, &create_pdr);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    ABTS_INT_EQUAL(tc, 2, create_pdr.pdr_id.u16);
+    ABTS_INT_EQUAL(tc, 256, create_pdr.precedence.u32);
+
+    ABTS_PTR_EQUAL(tc, NULL,
+            ogs_pfcp_ie_find(index, OGS_PFCP_CREATE_PDR_TYPE, ie));
+    ABTS_PTR_EQUAL(tc, NULL,
+            ogs_pfcp_ie_find(index, OGS_PFCP_CREATE_URR_TYPE, NULL));
+
+    ie = ogs_pfcp_ie_find(index, OGS_PFCP_CREATE_FAR_TYPE, NULL);
+    ABTS_PTR_NOTNULL(tc, ie);
+    rv = ogs_pfcp_ie_decode_create_far(index, ie, &create_far);
+    ABTS_INT_EQUAL(tc, OGS_OK, rv);
+    ABTS_INT_EQUAL(tc, 1, create_far.far_id.u32);
+    ABTS_INT_EQUAL(tc, 0x0200, create_far.apply_action.u16);
+
+    message = ogs_pfcp_ie_index_message(index);
+    ABTS_PTR_NOTNULL(tc, message);
+    ABTS_PTR_EQUAL(tc, message, ogs_pfcp_ie_index_message(index));
+    ABTS_INT_EQUAL(tc, 2,
+        message->pfcp_session_establishment_request.create_pdr[1].pdr_id.u16);
+    ABTS_INT_EQUAL(tc, 1,
+        message->pfcp_session_establishment_request.pdn_type.u8);
+    ABTS_INT_EQUAL(tc, 85, pkbuf->len);
+
+    ogs_pfcp_ie_index_free(index);
+
+    /* The last IE is truncated */
+    ogs_pkbuf_push(pkbuf, 16);
+    ogs_pkbuf_trim(pkbuf, 100);
+    ABTS_PTR_EQUAL(tc, NULL, ogs_pfcp_ie_index_parse(pkbuf));
+
+    ogs_pkbuf_free(pkbuf);
+}
+
+abts_suite *test_pfcp_message(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, pfcp_message_test1, NULL);
+    abts_run_test(suite, pfcp_message_test2, NULL);
+
+    return suite;
+}
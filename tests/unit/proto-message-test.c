@@ -75,12 +75,86 @@ static void proto_message_test2(abts_case *tc, void *data)
     ogs_free(full_dnn);
 }
 
+#define NUM_OF_EVENT 1000
+
+static ogs_queue_t *event_queue;
+
+static void event_producer(void *data)
+{
+    size_t *size = data;
+    int i;
+
+    for (i = 0; i < NUM_OF_EVENT; i++) {
+        ogs_event_t *e = ogs_event_size(i, size[i % 3]);
+        ogs_assert(e);
+        ogs_assert(ogs_queue_push(event_queue, e) == OGS_OK);
+    }
+}
+
+static void proto_message_test3(abts_case *tc, void *data)
+{
+    size_t size[3] = { sizeof(ogs_event_t), OGS_EVENT_SIZE, 4096 };
+    ogs_event_stat_t before, after;
+    ogs_thread_t *thread = NULL;
+    ogs_event_t *e[NUM_OF_EVENT];
+    int i, rv;
+
+    ogs_event_stat(&before);
+
+    /* Freed by the owner thread */
+    for (i = 0; i < NUM_OF_EVENT; i++) {
+        e[i] = ogs_event_size(i, size[i % 3]);
+        ABTS_PTR_NOTNULL(tc, e[i]);
+        ABTS_INT_EQUAL(tc, i, e[i]->id);
+        ABTS_INT_EQUAL(tc, 0, e[i]->timer_id);
+        memset(e[i], 0xff, size[i % 3]);
+    }
+    ogs_event_stat(&after);
+    ABTS_TRUE(tc, after.alloc - before.alloc == NUM_OF_EVENT);
+    ABTS_TRUE(tc, after.outstanding - before.outstanding == NUM_OF_EVENT);
+
+    for (i = 0; i < NUM_OF_EVENT; i++)
+        ogs_event_free(e[i]);
+
+    /* Reused events come back zeroed */
+    e[0] = ogs_event_new(1);
+    ABTS_INT_EQUAL(tc, 1, e[0]->id);
+    ABTS_PTR_EQUAL(tc, NULL, e[0]->sbi.message);
+    ogs_event_free(e[0]);
+
+    /* Allocated by another thread, freed by this one */
+    event_queue = ogs_queue_create(NUM_OF_EVENT);
+    ABTS_PTR_NOTNULL(tc, event_queue);
+
+    thread = ogs_thread_create(event_producer, size);
+    ABTS_PTR_NOTNULL(tc, thread);
+
+    for (i = 0; i < NUM_OF_EVENT; i++) {
+        rv = ogs_queue_pop(event_queue, (void **)&e[0]);
+        if (rv == OGS_ERROR) {
+            i--;
+            continue;
+        }
+        ABTS_INT_EQUAL(tc, OGS_OK, rv);
+        ABTS_INT_EQUAL(tc, i, e[0]->id);
+        ogs_event_free(e[0]);
+    }
+    ogs_thread_destroy(thread);
+
+    ogs_queue_destroy(event_queue);
+
+    ogs_event_stat(&after);
+    ABTS_TRUE(tc, after.alloc - before.alloc == 2 * NUM_OF_EVENT + 1);
+    ABTS_TRUE(tc, after.outstanding == before.outstanding);
+}
+
 abts_suite *test_proto_message(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
 
     abts_run_test(suite, proto_message_test1, NULL);
     abts_run_test(suite, proto_message_test2, NULL);
+    abts_run_test(suite, proto_message_test3, NULL);
 
     return suite;
 }
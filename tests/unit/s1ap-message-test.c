@@ -1330,6 +1330,80 @@ static void s1ap_message_test10(abts_case *tc, void *data)
     ogs_pkbuf_free(s1apbuf);
 }
 
+static void s1ap_message_test11(abts_case *tc, void *data)
+{
+    /* S1SetupRequest */
+    const char *payload =
+        "0011002d000004003b00090000f11040"
+        "54f64010003c400903004a4c542d3632"
+        "3100400007000c0e4000f11000894001"
+        "00";
+
+    ogs_s1ap_message_t message, copy;
+    ogs_pkbuf_t *pkbuf, *s1apbuf;
+    int result;
+    char hexbuf[OGS_HUGE_LEN];
+
+    pkbuf = ogs_pkbuf_alloc(NULL, OGS_MAX_SDU_LEN);
+    ogs_assert(pkbuf);
+    ogs_pkbuf_put_data(pkbuf,
+            ogs_hex_from_string(payload, hexbuf, sizeof(hexbuf)), 49);
+
+    result = ogs_s1ap_decode(&message, pkbuf);
+    ABTS_INT_EQUAL(tc, 0, result);
+
+    memset(&copy, 0, sizeof(copy));
+    result = ogs_asn_copy_ie(&asn_DEF_S1AP_S1AP_PDU, &message, &copy);
+    ABTS_INT_EQUAL(tc, OGS_OK, result);
+    ogs_s1ap_free(&message);
+
+    s1apbuf = ogs_s1ap_encode(&copy);
+    ABTS_PTR_NOTNULL(tc, s1apbuf);
+    ABTS_INT_EQUAL(tc, 49, s1apbuf->len);
+    ABTS_TRUE(tc, memcmp(s1apbuf->data, pkbuf->data, 49) == 0);
+
+    ogs_pkbuf_free(s1apbuf);
+    ogs_pkbuf_free(pkbuf);
+}
+
+static void s1ap_message_test12(abts_case *tc, void *data)
+{
+    /* InitialUE(Attach Request) */
+    const char *payload =
+        "000c406f000006000800020001001a00"
+        "3c3b17df675aa8050741020bf600f110"
+        "000201030003e605f070000010000502"
+        "15d011d15200f11030395c0a003103e5"
+        "e0349011035758a65d0100e0c1004300"
+        "060000f1103039006440080000f1108c"
+        "3378200086400130004b00070000f110"
+        "000201";
+
+    ogs_s1ap_route_t route;
+    ogs_pkbuf_t *pkbuf;
+    int result;
+    char hexbuf[OGS_HUGE_LEN];
+
+    pkbuf = ogs_pkbuf_alloc(NULL, OGS_MAX_SDU_LEN);
+    ogs_assert(pkbuf);
+    ogs_pkbuf_put_data(pkbuf,
+            ogs_hex_from_string(payload, hexbuf, sizeof(hexbuf)), 115);
+
+    result = ogs_s1ap_decode_route(&route, pkbuf);
+    ABTS_INT_EQUAL(tc, OGS_OK, result);
+    ABTS_INT_EQUAL(tc, S1AP_S1AP_PDU_PR_initiatingMessage, route.present);
+    ABTS_INT_EQUAL(tc,
+            S1AP_ProcedureCode_id_initialUEMessage, route.procedure_code);
+    ABTS_INT_EQUAL(tc, S1AP_Criticality_ignore, route.criticality);
+    ABTS_TRUE(tc, route.enb_ue_s1ap_id_presence);
+    ABTS_INT_EQUAL(tc, 1, route.enb_ue_s1ap_id);
+    ABTS_TRUE(tc, !route.mme_ue_s1ap_id_presence);
+    ABTS_INT_EQUAL(tc, 59, route.nas_pdu_len);
+    ABTS_INT_EQUAL(tc, 0x17, route.nas_pdu[0]);
+
+    ogs_pkbuf_free(pkbuf);
+}
+
 abts_suite *test_s1ap_message(abts_suite *suite)
 {
     suite = ADD_SUITE(suite)
@@ -1346,6 +1420,8 @@ abts_suite *test_s1ap_message(abts_suite *suite)
     abts_run_test(suite, s1ap_message_test8, NULL);
     abts_run_test(suite, s1ap_message_test9, NULL);
     abts_run_test(suite, s1ap_message_test10, NULL);
+    abts_run_test(suite, s1ap_message_test11, NULL);
+    abts_run_test(suite, s1ap_message_test12, NULL);
 
     return suite;
 }
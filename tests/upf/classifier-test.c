@@ -0,0 +1,388 @@
+/*
+ * Copyright (C) 2019-2024 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "upf-test-common.h"
+#include "core/abts.h"
+
+static ogs_pfcp_pdr_t *pdr_add(upf_sess_t *sess, uint32_t precedence)
+{
+    ogs_pfcp_pdr_t *pdr = NULL;
+
+    pdr = ogs_pfcp_pdr_add(&sess->pfcp);
+    ogs_assert(pdr);
+    pdr->src_if = OGS_PFCP_INTERFACE_CORE;
+    ogs_pfcp_pdr_reorder_by_precedence(pdr, precedence);
+
+    return pdr;
+}
+
+static ogs_pfcp_packet_info_t *info4(ogs_pfcp_packet_info_t *info,
+        uint8_t proto, const char *src, uint16_t sport,
+        const char *dst, uint16_t dport)
+{
+    memset(info, 0, sizeof(*info));
+    info->version = 4;
+    info->proto = proto;
+    ogs_assert(1 == inet_pton(AF_INET, src, &info->src[0]));
+    ogs_assert(1 == inet_pton(AF_INET, dst, &info->dst[0]));
+    info->sport = sport;
+    info->dport = dport;
+
+    return info;
+}
+
+static ogs_pfcp_pdr_t *dispatch4(upf_sess_t *sess,
+        uint8_t proto, const char *src, const char *dst, uint16_t dport)
+{
+    ogs_pfcp_pdr_t *pdr = NULL;
+    ogs_pkbuf_t *pkbuf = NULL;
+
+    pkbuf = test_packet4(proto, src, dst, dport);
+    pdr = upf_sess_dispatch_downlink(sess, pkbuf);
+    ogs_pkbuf_free(pkbuf);
+
+    return pdr;
+}
+
+static int pdr_list(upf_sess_t *sess, ogs_pfcp_pdr_t **pdr)
+{
+    ogs_pfcp_pdr_t *p = NULL;
+    int n = 0;
+
+    ogs_list_for_each(&sess->pfcp.pdr_list, p)
+        pdr[n++] = p;
+
+    return n;
+}
+
+/* The precedence-ordered walk that the classifier replaces */
+static ogs_pfcp_pdr_t *linear_find(ogs_pfcp_pdr_t **pdr, int num_of_pdr,
+        ogs_pfcp_packet_info_t *info)
+{
+    int i;
+
+    for (i = 0; i < num_of_pdr; i++) {
+        if (ogs_list_first(&pdr[i]->rule_list) == NULL ||
+            ogs_pfcp_pdr_rule_find_by_info(pdr[i], info))
+            return pdr[i];
+    }
+
+    return NULL;
+}
+
+static void test1_func(abts_case *tc, void *data)
+{
+    upf_sess_t *sess = NULL;
+    ogs_pfcp_pdr_t *pdr[OGS_MAX_NUM_OF_PDR];
+    ogs_pfcp_pdr_t *a, *b, *c, *d, *e;
+    ogs_pfcp_classifier_t *cls = NULL;
+    ogs_pfcp_packet_info_t info;
+    int n;
+
+    sess = test_sess_add(1);
+    ABTS_PTR_NOTNULL(tc, sess);
+
+    /* Overlapping SDF filters of different precedence */
+    a = pdr_add(sess, 10);
+    test_rule_add(a, "permit out 17 from 10.0.0.0/8 to any 5000-6000");
+    b = pdr_add(sess, 20);
+    test_rule_add(b, "permit out ip from 10.1.0.0/16 to any");
+    c = pdr_add(sess, 30);
+    test_rule_add(c, "permit out 17 from any to any");
+    d = pdr_add(sess, 5);
+    test_rule_add(d, "permit out 6 from 10.1.2.3 to 10.45.0.2 80");
+    e = pdr_add(sess, 40);
+
+    n = pdr_list(sess, pdr);
+    ABTS_INT_EQUAL(tc, 5, n);
+    cls = ogs_pfcp_classifier_build(pdr, n);
+    ABTS_PTR_NOTNULL(tc, cls);
+
+    ABTS_PTR_EQUAL(tc, d, ogs_pfcp_classifier_find(cls,
+        info4(&info, 6, "10.1.2.3", 1234, "10.45.0.2", 80), NULL, NULL));
+    ABTS_PTR_EQUAL(tc, b, ogs_pfcp_classifier_find(cls,
+        info4(&info, 6, "10.1.2.3", 1234, "10.45.0.2", 81), NULL, NULL));
+    ABTS_PTR_EQUAL(tc, a, ogs_pfcp_classifier_find(cls,
+        info4(&info, 17, "10.9.0.1", 1, "10.45.0.2", 5500), NULL, NULL));
+    ABTS_PTR_EQUAL(tc, a, ogs_pfcp_classifier_find(cls,
+        info4(&info, 17, "10.1.0.1", 1, "10.45.0.2", 6000), NULL, NULL));
+    ABTS_PTR_EQUAL(tc, b, ogs_pfcp_classifier_find(cls,
+        info4(&info, 17, "10.1.0.1", 1, "10.45.0.2", 6001), NULL, NULL));
+    ABTS_PTR_EQUAL(tc, c, ogs_pfcp_classifier_find(cls,
+        info4(&info, 17, "192.168.0.1", 1, "10.45.0.2", 7000), NULL, NULL));
+    ABTS_PTR_EQUAL(tc, e, ogs_pfcp_classifier_find(cls,
+        info4(&info, 6, "192.168.0.1", 1, "10.45.0.2", 80), NULL, NULL));
+
+    ogs_pfcp_classifier_free(cls);
+    upf_sess_remove(sess);
+}
+
+static bool accept_not(ogs_pfcp_pdr_t *pdr, void *data)
+{
+    return pdr != data;
+}
+
+static void test2_func(abts_case *tc, void *data)
+{
+    upf_sess_t *sess = NULL;
+    ogs_pfcp_pdr_t *pdr[OGS_MAX_NUM_OF_PDR];
+    ogs_pfcp_pdr_t *a, *b, *c;
+    ogs_pfcp_classifier_t *cls = NULL;
+    ogs_pfcp_packet_info_t info;
+    int n;
+
+    sess = test_sess_add(1);
+    ABTS_PTR_NOTNULL(tc, sess);
+
+    /*
+     * Precedence ties are broken by the order of pdr_list,
+     * not by the length of the prefix.
+     */
+    a = pdr_add(sess, 10);
+    test_rule_add(a, "permit out ip from 10.0.0.0/8 to any");
+    b = pdr_add(sess, 10);
+    test_rule_add(b, "permit out ip from 10.1.0.0/16 to any");
+    c = pdr_add(sess, 10);
+    test_rule_add(c, "permit out 17 from 192.168.0.0/16 to any");
+    test_rule_add(c, "permit out 17 from 10.1.2.0/24 to any");
+
+    n = pdr_list(sess, pdr);
+    ABTS_INT_EQUAL(tc, 3, n);
+    ABTS_PTR_EQUAL(tc, a, pdr[0]);
+    ABTS_PTR_EQUAL(tc, b, pdr[1]);
+    ABTS_PTR_EQUAL(tc, c, pdr[2]);
+
+    cls = ogs_pfcp_classifier_build(pdr, n);
+    ABTS_PTR_NOTNULL(tc, cls);
+
+    ABTS_PTR_EQUAL(tc, a, ogs_pfcp_classifier_find(cls,
+        info4(&info, 17, "10.1.2.3", 1, "10.45.0.2", 1), NULL, NULL));
+    ABTS_PTR_EQUAL(tc, c, ogs_pfcp_classifier_find(cls,
+        info4(&info, 17, "192.168.0.1", 1, "10.45.0.2", 1), NULL, NULL));
+    ABTS_PTR_EQUAL(tc, NULL, ogs_pfcp_classifier_find(cls,
+        info4(&info, 17, "172.16.0.1", 1, "10.45.0.2", 1), NULL, NULL));
+
+    /* A rejected PDR passes the packet on to the next one in the tie */
+    ABTS_PTR_EQUAL(tc, b, ogs_pfcp_classifier_find(cls,
+        info4(&info, 17, "10.1.2.3", 1, "10.45.0.2", 1), accept_not, a));
+
+    ogs_pfcp_classifier_free(cls);
+
+    /* Moving the more specific filter first lets it win the tie */
+    ogs_pfcp_pdr_reorder_by_precedence(a, 10);
+
+    n = pdr_list(sess, pdr);
+    ABTS_PTR_EQUAL(tc, b, pdr[0]);
+
+    cls = ogs_pfcp_classifier_build(pdr, n);
+    ABTS_PTR_NOTNULL(tc, cls);
+
+    ABTS_PTR_EQUAL(tc, b, ogs_pfcp_classifier_find(cls,
+        info4(&info, 17, "10.1.2.3", 1, "10.45.0.2", 1), NULL, NULL));
+    ABTS_PTR_EQUAL(tc, c, ogs_pfcp_classifier_find(cls,
+        info4(&info, 17, "10.1.2.3", 1, "10.45.0.2", 1), accept_not, b));
+    ABTS_PTR_EQUAL(tc, a, ogs_pfcp_classifier_find(cls,
+        info4(&info, 17, "10.2.0.1", 1, "10.45.0.2", 1), NULL, NULL));
+
+    ogs_pfcp_classifier_free(cls);
+    upf_sess_remove(sess);
+}
+
+#define NUM_OF_ROUND 50
+#define NUM_OF_PACKET 500
+
+static void random_flow(char *buf, size_t len)
+{
+    static const char *proto[] = { "ip", "6", "17" };
+    char src[32], dst[32], dport[16];
+    int p = ogs_random32() % 3;
+
+    ogs_snprintf(src, sizeof(src), "10.%d.0.0/%d",
+            ogs_random32() % 4, 8 + (ogs_random32() % 3) * 8);
+    ogs_snprintf(dst, sizeof(dst), "10.45.0.%d/%d",
+            ogs_random32() % 4, 30 + ogs_random32() % 3);
+    dport[0] = 0;
+    if (p && ogs_random32() % 2)
+        ogs_snprintf(dport, sizeof(dport), " %d-%d",
+                1000, 1000 + ogs_random32() % 8);
+
+    if (ogs_random32() % 4 == 0)
+        ogs_snprintf(buf, len, "permit out %s from any to any%s",
+                proto[p], dport);
+    else
+        ogs_snprintf(buf, len, "permit out %s from %s to %s%s",
+                proto[p], src, dst, dport);
+}
+
+static void test3_func(abts_case *tc, void *data)
+{
+    static const uint8_t proto[] = { 1, 6, 17 };
+    upf_sess_t *sess = NULL;
+    ogs_pfcp_pdr_t *pdr[OGS_MAX_NUM_OF_PDR];
+    ogs_pfcp_classifier_t *cls = NULL;
+    ogs_pfcp_packet_info_t info;
+    char flow[128], src[32], dst[32];
+    int round, i, j, n, mismatch = 0;
+
+    /* Randomized comparison against the precedence-ordered walk */
+    for (round = 0; round < NUM_OF_ROUND; round++) {
+        sess = test_sess_add(1);
+        ABTS_PTR_NOTNULL(tc, sess);
+
+        n = 2 + ogs_random32() % (OGS_MAX_NUM_OF_PDR - 2);
+        for (i = 0; i < n; i++) {
+            ogs_pfcp_pdr_t *p = pdr_add(sess, ogs_random32() % 8);
+            int num_of_rule = ogs_random32() % 4;
+
+            for (j = 0; j < num_of_rule; j++) {
+                random_flow(flow, sizeof(flow));
+                test_rule_add(p, flow);
+            }
+        }
+
+        n = pdr_list(sess, pdr);
+        cls = ogs_pfcp_classifier_build(pdr, n);
+        ABTS_PTR_NOTNULL(tc, cls);
+
+        for (i = 0; i < NUM_OF_PACKET; i++) {
+            ogs_snprintf(src, sizeof(src), "10.%d.%d.%d",
+                    ogs_random32() % 5, ogs_random32() % 2,
+                    ogs_random32() % 2);
+            ogs_snprintf(dst, sizeof(dst), "10.45.0.%d",
+                    ogs_random32() % 8);
+            info4(&info, proto[ogs_random32() % 3],
+                    src, 1, dst, 998 + ogs_random32() % 12);
+
+            if (ogs_pfcp_classifier_find(cls, &info, NULL, NULL) !=
+                    linear_find(pdr, n, &info))
+                mismatch++;
+        }
+
+        ogs_pfcp_classifier_free(cls);
+        upf_sess_remove(sess);
+    }
+
+    ABTS_INT_EQUAL(tc, 0, mismatch);
+}
+
+static void test4_func(abts_case *tc, void *data)
+{
+    upf_sess_t *sess = NULL;
+    ogs_pfcp_pdr_t *a, *b, *c;
+    ogs_pfcp_rule_t *rule = NULL;
+
+    sess = test_sess_add(1);
+    ABTS_PTR_NOTNULL(tc, sess);
+
+    a = pdr_add(sess, 10);
+    test_rule_add(a, "permit out 17 from 10.1.0.0/16 to any");
+    rule = test_rule_add(a, "permit out 6 from 10.2.0.0/16 to any");
+    test_pdr_forward(sess, a);
+    b = pdr_add(sess, 20);
+    test_rule_add(b, "permit out 17 from 10.0.0.0/8 to any");
+    test_pdr_forward(sess, b);
+    c = pdr_add(sess, 255);
+    test_pdr_forward(sess, c);
+
+    upf_sess_dispatch_build(sess);
+
+    ABTS_PTR_EQUAL(tc, a, dispatch4(sess, 17, "10.1.0.1", "10.45.0.2", 1));
+    ABTS_PTR_EQUAL(tc, a, dispatch4(sess, 6, "10.2.0.1", "10.45.0.2", 1));
+    ABTS_PTR_EQUAL(tc, b, dispatch4(sess, 17, "10.2.0.1", "10.45.0.2", 1));
+    ABTS_PTR_EQUAL(tc, c, dispatch4(sess, 6, "10.3.0.1", "10.45.0.2", 1));
+
+    /*
+     * Removing an indexed rule or PDR is followed by a rebuild,
+     * as done by the PFCP Session Modification.
+     */
+    ogs_pfcp_rule_remove(rule);
+    upf_sess_dispatch_build(sess);
+
+    ABTS_PTR_EQUAL(tc, a, dispatch4(sess, 17, "10.1.0.1", "10.45.0.2", 1));
+    ABTS_PTR_EQUAL(tc, c, dispatch4(sess, 6, "10.2.0.1", "10.45.0.2", 1));
+    ABTS_PTR_EQUAL(tc, b, dispatch4(sess, 17, "10.2.0.1", "10.45.0.2", 1));
+
+    ogs_pfcp_pdr_remove(a);
+    upf_sess_dispatch_build(sess);
+
+    ABTS_PTR_EQUAL(tc, b, dispatch4(sess, 17, "10.1.0.1", "10.45.0.2", 1));
+    ABTS_PTR_EQUAL(tc, c, dispatch4(sess, 6, "10.2.0.1", "10.45.0.2", 1));
+
+    ogs_pfcp_pdr_remove(b);
+    upf_sess_dispatch_build(sess);
+
+    /* The remaining PDR has no SDF filter and takes every packet */
+    ABTS_PTR_EQUAL(tc, c, dispatch4(sess, 17, "10.1.0.1", "10.45.0.2", 1));
+
+    ogs_pfcp_pdr_remove(c);
+    upf_sess_dispatch_build(sess);
+
+    ABTS_PTR_EQUAL(tc, NULL, dispatch4(sess, 17, "10.1.0.1", "10.45.0.2", 1));
+
+    upf_sess_remove(sess);
+}
+
+static void test5_func(abts_case *tc, void *data)
+{
+    upf_sess_t *sess = NULL;
+    ogs_pfcp_pdr_t *pdr[OGS_MAX_NUM_OF_PDR];
+    ogs_pfcp_pdr_t *a, *b;
+    ogs_pfcp_classifier_t *cls = NULL;
+    ogs_pfcp_packet_info_t info;
+    int n;
+
+    sess = test_sess_add(1);
+    ABTS_PTR_NOTNULL(tc, sess);
+
+    a = pdr_add(sess, 10);
+    test_rule_add(a, "permit out ip from any to any");
+    b = pdr_add(sess, 20);
+
+    n = pdr_list(sess, pdr);
+    ABTS_INT_EQUAL(tc, 2, n);
+    ABTS_PTR_EQUAL(tc, b, pdr[1]);
+    cls = ogs_pfcp_classifier_build(pdr, n);
+    ABTS_PTR_NOTNULL(tc, cls);
+
+    ABTS_PTR_EQUAL(tc, a, ogs_pfcp_classifier_find(cls,
+        info4(&info, 17, "10.1.2.3", 1, "10.45.0.2", 1), NULL, NULL));
+
+    /* Input that was not parsed is refused, even by an any/any filter */
+    memset(&info, 0, sizeof(info));
+    ABTS_PTR_EQUAL(tc, NULL, ogs_pfcp_classifier_find(cls, &info, NULL, NULL));
+    ABTS_PTR_EQUAL(tc, NULL, ogs_pfcp_pdr_rule_find_by_info(a, &info));
+    info.version = 5;
+    ABTS_PTR_EQUAL(tc, NULL, ogs_pfcp_classifier_find(cls, &info, NULL, NULL));
+
+    ogs_pfcp_classifier_free(cls);
+    upf_sess_remove(sess);
+}
+
+abts_suite *test_classifier(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, test1_func, NULL);
+    abts_run_test(suite, test2_func, NULL);
+    abts_run_test(suite, test3_func, NULL);
+    abts_run_test(suite, test4_func, NULL);
+    abts_run_test(suite, test5_func, NULL);
+
+    return suite;
+}
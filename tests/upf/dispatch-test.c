@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2019-2024 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "upf-test-common.h"
+#include "core/abts.h"
+
+static ogs_pfcp_pdr_t *pdr_add(upf_sess_t *sess, uint32_t precedence,
+        ogs_pfcp_interface_t src_if, uint32_t teid, uint8_t qfi)
+{
+    ogs_pfcp_pdr_t *pdr = NULL;
+
+    pdr = ogs_pfcp_pdr_add(&sess->pfcp);
+    ogs_assert(pdr);
+    pdr->src_if = src_if;
+    pdr->f_teid.teid = teid;
+    pdr->qfi = qfi;
+    ogs_pfcp_pdr_reorder_by_precedence(pdr, precedence);
+
+    return pdr;
+}
+
+static ogs_pfcp_pdr_t *uplink(upf_sess_t *sess, uint32_t teid, uint8_t qfi,
+        uint8_t proto, const char *dst)
+{
+    ogs_pfcp_pdr_t *pdr = NULL;
+    ogs_pkbuf_t *pkbuf = NULL;
+
+    pkbuf = test_packet4(proto, "10.45.0.2", dst, 1);
+    pdr = upf_sess_dispatch_uplink(sess, teid, qfi, pkbuf);
+    ogs_pkbuf_free(pkbuf);
+
+    return pdr;
+}
+
+static ogs_pfcp_pdr_t *downlink(upf_sess_t *sess,
+        uint8_t proto, const char *src)
+{
+    ogs_pfcp_pdr_t *pdr = NULL;
+    ogs_pkbuf_t *pkbuf = NULL;
+
+    pkbuf = test_packet4(proto, src, "10.45.0.2", 1);
+    pdr = upf_sess_dispatch_downlink(sess, pkbuf);
+    ogs_pkbuf_free(pkbuf);
+
+    return pdr;
+}
+
+static ogs_pfcp_pdr_t *malformed(upf_sess_t *sess, uint32_t teid,
+        const uint8_t *data, int len)
+{
+    ogs_pfcp_pdr_t *pdr = NULL;
+    ogs_pkbuf_t *pkbuf = NULL;
+
+    pkbuf = ogs_pkbuf_alloc(NULL, OGS_MAX_PKT_LEN);
+    ogs_assert(pkbuf);
+    ogs_pkbuf_put_data(pkbuf, data, len);
+
+    pdr = upf_sess_dispatch_uplink(sess, teid, 0, pkbuf);
+    ogs_pkbuf_free(pkbuf);
+
+    return pdr;
+}
+
+static void test1_func(abts_case *tc, void *data)
+{
+    upf_sess_t *sess = NULL;
+    ogs_pfcp_pdr_t *p1, *p2, *p3, *p4, *p5;
+
+    sess = test_sess_add(1);
+    ABTS_PTR_NOTNULL(tc, sess);
+
+    /* An empty session has no uplink entry */
+    ABTS_PTR_EQUAL(tc, NULL, uplink(sess, 0x100, 1, 17, "8.8.8.8"));
+
+    p1 = pdr_add(sess, 10, OGS_PFCP_INTERFACE_ACCESS, 0x100, 1);
+    p2 = pdr_add(sess, 20, OGS_PFCP_INTERFACE_ACCESS, 0x100, 2);
+    p3 = pdr_add(sess, 30, OGS_PFCP_INTERFACE_ACCESS, 0x200, 0);
+    p4 = pdr_add(sess, 5, OGS_PFCP_INTERFACE_ACCESS, 0x300, 0);
+    test_rule_add(p4, "permit out 17 from any to 8.8.8.8");
+    p5 = pdr_add(sess, 50, OGS_PFCP_INTERFACE_CP_FUNCTION, 0x300, 0);
+
+    upf_sess_dispatch_build(sess);
+
+    /* TEID and QFI */
+    ABTS_PTR_EQUAL(tc, p1, uplink(sess, 0x100, 1, 17, "8.8.8.8"));
+    ABTS_PTR_EQUAL(tc, p2, uplink(sess, 0x100, 2, 17, "8.8.8.8"));
+    ABTS_PTR_EQUAL(tc, NULL, uplink(sess, 0x100, 3, 17, "8.8.8.8"));
+    ABTS_PTR_EQUAL(tc, NULL, uplink(sess, 0x100, 0, 17, "8.8.8.8"));
+
+    /* PDRs without QFI match any QFI of their TEID */
+    ABTS_PTR_EQUAL(tc, p3, uplink(sess, 0x200, 0, 17, "8.8.8.8"));
+    ABTS_PTR_EQUAL(tc, p3, uplink(sess, 0x200, 9, 17, "8.8.8.8"));
+
+    /* SDF filter within a TEID */
+    ABTS_PTR_EQUAL(tc, p4, uplink(sess, 0x300, 1, 17, "8.8.8.8"));
+    ABTS_PTR_EQUAL(tc, p5, uplink(sess, 0x300, 1, 6, "8.8.8.8"));
+    ABTS_PTR_EQUAL(tc, p5, uplink(sess, 0x300, 1, 17, "8.8.4.4"));
+
+    /* Unknown TEID */
+    ABTS_PTR_EQUAL(tc, NULL, uplink(sess, 0x400, 1, 17, "8.8.8.8"));
+
+    /* No downlink PDR */
+    ABTS_PTR_EQUAL(tc, NULL, downlink(sess, 17, "8.8.8.8"));
+
+    upf_sess_remove(sess);
+}
+
+static void test2_func(abts_case *tc, void *data)
+{
+    upf_sess_t *sess = NULL;
+    ogs_pfcp_pdr_t *d1, *d2, *d3;
+
+    sess = test_sess_add(1);
+    ABTS_PTR_NOTNULL(tc, sess);
+
+    d1 = pdr_add(sess, 10, OGS_PFCP_INTERFACE_CORE, 0, 0);
+    test_rule_add(d1, "permit out 17 from 8.8.8.8 to any");
+    test_pdr_forward(sess, d1);
+    d2 = pdr_add(sess, 20, OGS_PFCP_INTERFACE_CORE, 0, 0);
+    test_rule_add(d2, "permit out 6 from 8.8.8.8 to any");
+
+    upf_sess_dispatch_build(sess);
+
+    ABTS_PTR_EQUAL(tc, d1, downlink(sess, 17, "8.8.8.8"));
+
+    /*
+     * A PDR without Outer header creation is not a candidate.
+     * The lowest precedence downlink PDR is the fallback.
+     */
+    ABTS_PTR_EQUAL(tc, d2, downlink(sess, 6, "8.8.8.8"));
+    ABTS_PTR_EQUAL(tc, d2, downlink(sess, 17, "8.8.4.4"));
+
+    d3 = pdr_add(sess, 30, OGS_PFCP_INTERFACE_CORE, 0, 0);
+    test_pdr_forward(sess, d3);
+
+    upf_sess_dispatch_build(sess);
+
+    ABTS_PTR_EQUAL(tc, d1, downlink(sess, 17, "8.8.8.8"));
+    ABTS_PTR_EQUAL(tc, d3, downlink(sess, 6, "8.8.8.8"));
+    ABTS_PTR_EQUAL(tc, d3, downlink(sess, 17, "8.8.4.4"));
+
+    /* The first candidate has no SDF filter : no need to parse */
+    ogs_pfcp_pdr_reorder_by_precedence(d3, 1);
+
+    upf_sess_dispatch_build(sess);
+
+    ABTS_PTR_EQUAL(tc, d3, downlink(sess, 17, "8.8.8.8"));
+
+    upf_sess_remove(sess);
+}
+
+static void test3_func(abts_case *tc, void *data)
+{
+    upf_sess_t *sess = NULL;
+    ogs_pfcp_pdr_t *p1, *p2, *d1;
+
+    sess = test_sess_add(1);
+    ABTS_PTR_NOTNULL(tc, sess);
+
+    p1 = pdr_add(sess, 10, OGS_PFCP_INTERFACE_ACCESS, 0x100, 1);
+    p2 = pdr_add(sess, 20, OGS_PFCP_INTERFACE_ACCESS, 0x100, 2);
+    d1 = pdr_add(sess, 30, OGS_PFCP_INTERFACE_CORE, 0, 0);
+    test_pdr_forward(sess, d1);
+
+    upf_sess_dispatch_build(sess);
+
+    ABTS_PTR_EQUAL(tc, p1, uplink(sess, 0x100, 1, 17, "8.8.8.8"));
+    ABTS_PTR_EQUAL(tc, p2, uplink(sess, 0x100, 2, 17, "8.8.8.8"));
+    ABTS_PTR_EQUAL(tc, d1, downlink(sess, 17, "8.8.8.8"));
+
+    /* Remove PDR */
+    ogs_pfcp_pdr_remove(p2);
+    upf_sess_dispatch_build(sess);
+
+    ABTS_PTR_EQUAL(tc, p1, uplink(sess, 0x100, 1, 17, "8.8.8.8"));
+    ABTS_PTR_EQUAL(tc, NULL, uplink(sess, 0x100, 2, 17, "8.8.8.8"));
+
+    /* Update PDR with a new TEID */
+    p1->f_teid.teid = 0x500;
+    upf_sess_dispatch_build(sess);
+
+    ABTS_PTR_EQUAL(tc, NULL, uplink(sess, 0x100, 1, 17, "8.8.8.8"));
+    ABTS_PTR_EQUAL(tc, p1, uplink(sess, 0x500, 1, 17, "8.8.8.8"));
+
+    /* Remove all */
+    ogs_pfcp_pdr_remove_all(&sess->pfcp);
+    upf_sess_dispatch_build(sess);
+
+    ABTS_PTR_EQUAL(tc, NULL, uplink(sess, 0x500, 1, 17, "8.8.8.8"));
+    ABTS_PTR_EQUAL(tc, NULL, downlink(sess, 17, "8.8.8.8"));
+
+    upf_sess_remove(sess);
+}
+
+static void test4_func(abts_case *tc, void *data)
+{
+    static const uint8_t non_ip[] = { 0x00, 0x01, 0x02, 0x03 };
+    static const uint8_t ipv4[] = { 0x45, 0x00, 0x00, 0x14, 0x00, 0x00 };
+    static const uint8_t ipv6[] = { 0x60, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+    upf_sess_t *sess = NULL;
+    ogs_pfcp_pdr_t *p1, *p2;
+
+    sess = test_sess_add(1);
+    ABTS_PTR_NOTNULL(tc, sess);
+
+    p1 = pdr_add(sess, 10, OGS_PFCP_INTERFACE_ACCESS, 0x100, 0);
+    test_rule_add(p1, "permit out ip from any to any");
+    p2 = pdr_add(sess, 20, OGS_PFCP_INTERFACE_ACCESS, 0x100, 0);
+
+    upf_sess_dispatch_build(sess);
+
+    ABTS_PTR_EQUAL(tc, p1, uplink(sess, 0x100, 0, 17, "8.8.8.8"));
+
+    /* A packet that cannot be parsed never matches an SDF filter */
+    ABTS_PTR_EQUAL(tc, p2, malformed(sess, 0x100, non_ip, sizeof(non_ip)));
+    ABTS_PTR_EQUAL(tc, p2, malformed(sess, 0x100, ipv4, sizeof(ipv4)));
+    ABTS_PTR_EQUAL(tc, p2, malformed(sess, 0x100, ipv6, sizeof(ipv6)));
+
+    /* Without a PDR lacking SDF filter, it is not matched at all */
+    ogs_pfcp_pdr_remove(p2);
+    upf_sess_dispatch_build(sess);
+
+    ABTS_PTR_EQUAL(tc, p1, uplink(sess, 0x100, 0, 17, "8.8.8.8"));
+    ABTS_PTR_EQUAL(tc, NULL, malformed(sess, 0x100, non_ip, sizeof(non_ip)));
+    ABTS_PTR_EQUAL(tc, NULL, malformed(sess, 0x100, ipv4, sizeof(ipv4)));
+
+    upf_sess_remove(sess);
+}
+
+abts_suite *test_dispatch(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, test1_func, NULL);
+    abts_run_test(suite, test2_func, NULL);
+    abts_run_test(suite, test3_func, NULL);
+    abts_run_test(suite, test4_func, NULL);
+
+    return suite;
+}
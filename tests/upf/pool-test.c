@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2019-2024 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "upf-test-common.h"
+#include "core/abts.h"
+
+#define NUM_SESS 256
+
+/*
+ * Sessions and their PDRs commit chunks on demand,
+ * and upf_pool_trim() gives them back once the sessions are gone.
+ */
+static void test1_func(abts_case *tc, void *data)
+{
+    upf_sess_t *sess[NUM_SESS];
+    upf_pool_stat_t before, busy, after;
+    int i;
+
+    upf_pool_trim();
+    upf_pool_stat(&before);
+
+    for (i = 0; i < NUM_SESS; i++) {
+        sess[i] = test_sess_add(0x1000 + i);
+        ABTS_PTR_NOTNULL(tc, sess[i]);
+        ABTS_PTR_NOTNULL(tc, ogs_pfcp_pdr_add(&sess[i]->pfcp));
+    }
+
+    upf_pool_stat(&busy);
+    ABTS_TRUE(tc, busy.sess_peak >= NUM_SESS);
+    ABTS_TRUE(tc, busy.pdr_peak >= NUM_SESS);
+    ABTS_TRUE(tc, busy.committed > before.committed);
+
+    for (i = 0; i < NUM_SESS; i++)
+        upf_sess_remove(sess[i]);
+
+    ABTS_TRUE(tc, upf_pool_trim() > 0);
+    ABTS_INT_EQUAL(tc, 0, upf_pool_trim());
+
+    upf_pool_stat(&after);
+    ABTS_INT_EQUAL(tc, busy.sess_peak, after.sess_peak);
+    ABTS_TRUE(tc, after.committed < busy.committed);
+    ABTS_TRUE(tc, after.committed <= before.committed);
+}
+
+abts_suite *test_pool(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, test1_func, NULL);
+
+    return suite;
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2019-2024 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "upf/context.h"
+#include "core/abts.h"
+
+#define TEST_QFI 1
+
+static ogs_pfcp_qer_t qer;
+static ogs_pfcp_pdr_t pdr;
+static upf_metrics_dp_t *dp;
+
+static void qer_setup(uint64_t uplink, uint64_t downlink)
+{
+    memset(&qer, 0, sizeof(qer));
+    qer.qfi = TEST_QFI;
+    qer.mbr.uplink = uplink;
+    qer.mbr.downlink = downlink;
+
+    memset(&pdr, 0, sizeof(pdr));
+    pdr.qer = &qer;
+
+    if (!dp) {
+        dp = upf_metrics_dp_add();
+        ogs_assert(dp);
+    }
+    memset(dp->by_qfi, 0, sizeof(dp->by_qfi));
+}
+
+/* COUNT packets of SIZE, one every INTERVAL after *NOW */
+static int qer_send(size_t size, bool is_uplink,
+        ogs_time_t *now, ogs_time_t interval, int count)
+{
+    int i, passed = 0;
+
+    for (i = 0; i < count; i++) {
+        *now += interval;
+        if (upf_sess_qer_police(&pdr, size, is_uplink, *now, dp) == true)
+            passed++;
+    }
+
+    return passed;
+}
+
+static void test1_func(abts_case *tc, void *data)
+{
+    ogs_time_t now = ogs_time_from_sec(1);
+
+    qer_setup(0, 0);
+
+    /* No QER */
+    pdr.qer = NULL;
+    ABTS_TRUE(tc, upf_sess_qer_police(&pdr, 1000, true, now, dp) == true);
+    pdr.qer = &qer;
+
+    /* No MBR */
+    ABTS_INT_EQUAL(tc, 1000,
+            qer_send(1000, true, &now, ogs_time_from_msec(1), 1000));
+    ABTS_INT_EQUAL(tc, 0, dp->by_qfi[TEST_QFI][UPF_METR_CTR_QER_MBRDROPPKT]);
+
+    /* Gate closed */
+    qer.gate_status.downlink = OGS_PFCP_GATE_CLOSE;
+    ABTS_TRUE(tc, upf_sess_qer_police(&pdr, 1000, true, now, dp) == true);
+    ABTS_TRUE(tc, upf_sess_qer_police(&pdr, 1000, false, now, dp) == false);
+    ABTS_INT_EQUAL(tc, 1, dp->by_qfi[TEST_QFI][UPF_METR_CTR_QER_GATEDROPPKT]);
+}
+
+static void test2_func(abts_case *tc, void *data)
+{
+    ogs_time_t now = ogs_time_from_sec(1);
+
+    /* 8 kbps : 1000 bytes per second, the bucket holds OGS_MAX_PKT_LEN */
+    qer_setup(8000, 0);
+
+    /* The first packet finds a full bucket */
+    ABTS_TRUE(tc, upf_sess_qer_police(
+                &pdr, OGS_MAX_PKT_LEN, true, now, dp) == true);
+    ABTS_TRUE(tc, upf_sess_qer_police(&pdr, 1, true, now, dp) == false);
+
+    /*
+     * A packet every 500us earns half a byte.
+     * One second still refills 1000 bytes.
+     */
+    ABTS_INT_EQUAL(tc, 10, qer_send(100, true, &now, 500, 2000));
+    ABTS_INT_EQUAL(tc, 10, qer_send(100, true, &now, 500, 2000));
+    ABTS_INT_EQUAL(tc, 1 + 3980,
+            dp->by_qfi[TEST_QFI][UPF_METR_CTR_QER_MBRDROPPKT]);
+
+    /* A packet every 4us earns a 250th of a byte */
+    ABTS_INT_EQUAL(tc, 10, qer_send(100, true, &now, 4, 250000));
+}
+
+static void test3_func(abts_case *tc, void *data)
+{
+    ogs_time_t now = ogs_time_from_sec(1);
+
+    /* 1 Mbps : 125000 bytes per second, the bucket holds 12500 bytes */
+    qer_setup(1000000, 0);
+
+    ABTS_TRUE(tc, upf_sess_qer_police(&pdr, 12500, true, now, dp) == true);
+    ABTS_TRUE(tc, upf_sess_qer_police(&pdr, 1, true, now, dp) == false);
+
+    /* 125 bytes per millisecond */
+    ABTS_INT_EQUAL(tc, 125,
+            qer_send(1000, true, &now, ogs_time_from_msec(1), 1000));
+
+    /* The bucket is full again after an idle burst time */
+    now += UPF_QER_BURST_TIME;
+    ABTS_INT_EQUAL(tc, 12, qer_send(1000, true, &now, 1, 100));
+}
+
+static void test4_func(abts_case *tc, void *data)
+{
+    ogs_time_t now = ogs_time_from_sec(1);
+
+    /* Uplink and downlink are policed by separate buckets */
+    qer_setup(8000, 16000);
+
+    ABTS_TRUE(tc, upf_sess_qer_police(
+                &pdr, OGS_MAX_PKT_LEN, true, now, dp) == true);
+    ABTS_TRUE(tc, upf_sess_qer_police(
+                &pdr, OGS_MAX_PKT_LEN, false, now, dp) == true);
+    ABTS_TRUE(tc, upf_sess_qer_police(&pdr, 1, true, now, dp) == false);
+    ABTS_TRUE(tc, upf_sess_qer_police(&pdr, 1, false, now, dp) == false);
+
+    now += ogs_time_from_msec(50);
+    ABTS_TRUE(tc, upf_sess_qer_police(&pdr, 100, true, now, dp) == false);
+    ABTS_TRUE(tc, upf_sess_qer_police(&pdr, 100, false, now, dp) == true);
+}
+
+static void test5_func(abts_case *tc, void *data)
+{
+    ogs_time_t now = ogs_time_from_sec(1);
+
+    /* 8 kbps uplink, 16 kbps downlink */
+    qer_setup(8000, 16000);
+
+    /* N3 : from the access side, policed as uplink */
+    pdr.src_if = OGS_PFCP_INTERFACE_ACCESS;
+    ABTS_TRUE(tc, upf_sess_pdr_is_uplink(&pdr) == true);
+    ABTS_TRUE(tc, upf_sess_qer_police(&pdr, OGS_MAX_PKT_LEN,
+                upf_sess_pdr_is_uplink(&pdr), now, dp) == true);
+    ABTS_TRUE(tc, upf_sess_qer_police(&pdr, 1,
+                upf_sess_pdr_is_uplink(&pdr), now, dp) == false);
+
+    /* N9 at an I-UPF : from the core side, policed as downlink */
+    pdr.src_if = OGS_PFCP_INTERFACE_CORE;
+    ABTS_TRUE(tc, upf_sess_pdr_is_uplink(&pdr) == false);
+    ABTS_TRUE(tc, upf_sess_qer_police(&pdr, OGS_MAX_PKT_LEN,
+                upf_sess_pdr_is_uplink(&pdr), now, dp) == true);
+
+    /* The downlink gate applies, not the uplink one */
+    qer.gate_status.uplink = OGS_PFCP_GATE_CLOSE;
+    now += ogs_time_from_msec(100);
+    ABTS_TRUE(tc, upf_sess_qer_police(&pdr, 100,
+                upf_sess_pdr_is_uplink(&pdr), now, dp) == true);
+    qer.gate_status.downlink = OGS_PFCP_GATE_CLOSE;
+    ABTS_TRUE(tc, upf_sess_qer_police(&pdr, 100,
+                upf_sess_pdr_is_uplink(&pdr), now, dp) == false);
+}
+
+abts_suite *test_qer(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, test1_func, NULL);
+    abts_run_test(suite, test2_func, NULL);
+    abts_run_test(suite, test3_func, NULL);
+    abts_run_test(suite, test4_func, NULL);
+    abts_run_test(suite, test5_func, NULL);
+
+    return suite;
+}
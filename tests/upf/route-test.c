@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2019-2024 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "upf-test-common.h"
+#include "core/abts.h"
+
+static uint8_t sess_set_ipv4(upf_sess_t *sess, const char *addr)
+{
+    ogs_pfcp_pdr_t pdr;
+    uint32_t addr4;
+
+    ogs_assert(1 == inet_pton(AF_INET, addr, &addr4));
+
+    memset(&pdr, 0, sizeof(pdr));
+    pdr.ue_ip_addr_len = OGS_IPV4_LEN + 1;
+    pdr.ue_ip_addr.ipv4 = 1;
+    pdr.ue_ip_addr.addr = addr4;
+
+    return upf_sess_set_ue_ip(sess, OGS_PDU_SESSION_TYPE_IPV4, &pdr);
+}
+
+static uint8_t sess_set_ipv6(upf_sess_t *sess, const char *addr)
+{
+    ogs_pfcp_pdr_t pdr;
+    uint8_t addr6[OGS_IPV6_LEN];
+
+    ogs_assert(1 == inet_pton(AF_INET6, addr, addr6));
+
+    memset(&pdr, 0, sizeof(pdr));
+    pdr.ue_ip_addr_len = OGS_IPV6_LEN + 1;
+    pdr.ue_ip_addr.ipv6 = 1;
+    memcpy(pdr.ue_ip_addr.addr6, addr6, OGS_IPV6_LEN);
+
+    return upf_sess_set_ue_ip(sess, OGS_PDU_SESSION_TYPE_IPV6, &pdr);
+}
+
+static void test1_func(abts_case *tc, void *data)
+{
+    upf_sess_t *sess = NULL;
+    uint32_t addr;
+
+    sess = test_sess_add(1);
+    ABTS_PTR_NOTNULL(tc, sess);
+    ABTS_INT_EQUAL(tc, OGS_PFCP_CAUSE_REQUEST_ACCEPTED,
+            sess_set_ipv4(sess, "10.45.0.2"));
+
+    ABTS_INT_EQUAL(tc, 1, inet_pton(AF_INET, "10.45.0.2", &addr));
+    ABTS_PTR_EQUAL(tc, sess, upf_sess_find_by_ipv4(addr));
+    ABTS_INT_EQUAL(tc, 1, inet_pton(AF_INET, "10.45.0.3", &addr));
+    ABTS_PTR_EQUAL(tc, NULL, upf_sess_find_by_ipv4(addr));
+
+    upf_sess_remove(sess);
+
+    ABTS_INT_EQUAL(tc, 1, inet_pton(AF_INET, "10.45.0.2", &addr));
+    ABTS_PTR_EQUAL(tc, NULL, upf_sess_find_by_ipv4(addr));
+}
+
+static void test2_func(abts_case *tc, void *data)
+{
+    upf_sess_t *old = NULL, *sess = NULL;
+    uint32_t addr;
+
+    ABTS_INT_EQUAL(tc, 1, inet_pton(AF_INET, "10.45.0.2", &addr));
+
+    old = test_sess_add(1);
+    ABTS_PTR_NOTNULL(tc, old);
+    ABTS_INT_EQUAL(tc, OGS_PFCP_CAUSE_REQUEST_ACCEPTED,
+            sess_set_ipv4(old, "10.45.0.2"));
+    ABTS_PTR_EQUAL(tc, old, upf_sess_find_by_ipv4(addr));
+
+    /* The UE IP address is re-used before the old session is released */
+    sess = test_sess_add(2);
+    ABTS_PTR_NOTNULL(tc, sess);
+    ABTS_INT_EQUAL(tc, OGS_PFCP_CAUSE_REQUEST_ACCEPTED,
+            sess_set_ipv4(sess, "10.45.0.2"));
+    ABTS_PTR_EQUAL(tc, sess, upf_sess_find_by_ipv4(addr));
+
+    /* Releasing the stale session keeps the route of the new session */
+    upf_sess_remove(old);
+    ABTS_PTR_EQUAL(tc, sess, upf_sess_find_by_ipv4(addr));
+
+    upf_sess_remove(sess);
+    ABTS_PTR_EQUAL(tc, NULL, upf_sess_find_by_ipv4(addr));
+}
+
+static void test3_func(abts_case *tc, void *data)
+{
+    upf_sess_t *old = NULL, *sess = NULL;
+    uint32_t addr6[4];
+
+    ABTS_INT_EQUAL(tc, 1, inet_pton(AF_INET6, "2001:db8:cafe:1::1", addr6));
+
+    old = test_sess_add(1);
+    ABTS_PTR_NOTNULL(tc, old);
+    ABTS_INT_EQUAL(tc, OGS_PFCP_CAUSE_REQUEST_ACCEPTED,
+            sess_set_ipv6(old, "2001:db8:cafe:1::"));
+    ABTS_PTR_EQUAL(tc, old, upf_sess_find_by_ipv6(addr6));
+
+    sess = test_sess_add(2);
+    ABTS_PTR_NOTNULL(tc, sess);
+    ABTS_INT_EQUAL(tc, OGS_PFCP_CAUSE_REQUEST_ACCEPTED,
+            sess_set_ipv6(sess, "2001:db8:cafe:1::"));
+    ABTS_PTR_EQUAL(tc, sess, upf_sess_find_by_ipv6(addr6));
+
+    upf_sess_remove(old);
+    ABTS_PTR_EQUAL(tc, sess, upf_sess_find_by_ipv6(addr6));
+
+    upf_sess_remove(sess);
+    ABTS_PTR_EQUAL(tc, NULL, upf_sess_find_by_ipv6(addr6));
+}
+
+static void test4_func(abts_case *tc, void *data)
+{
+    upf_sess_t *old = NULL, *sess = NULL;
+    uint32_t addr;
+
+    ABTS_INT_EQUAL(tc, 1, inet_pton(AF_INET, "10.45.0.2", &addr));
+
+    old = test_sess_add(1);
+    ABTS_PTR_NOTNULL(tc, old);
+    ABTS_INT_EQUAL(tc, OGS_PFCP_CAUSE_REQUEST_ACCEPTED,
+            sess_set_ipv4(old, "10.45.0.2"));
+
+    sess = test_sess_add(2);
+    ABTS_PTR_NOTNULL(tc, sess);
+    ABTS_INT_EQUAL(tc, OGS_PFCP_CAUSE_REQUEST_ACCEPTED,
+            sess_set_ipv4(sess, "10.45.0.2"));
+
+    /* The stale session moving to another address leaves the route alone */
+    ABTS_INT_EQUAL(tc, OGS_PFCP_CAUSE_REQUEST_ACCEPTED,
+            sess_set_ipv4(old, "10.45.0.3"));
+    ABTS_PTR_EQUAL(tc, sess, upf_sess_find_by_ipv4(addr));
+
+    upf_sess_remove(sess);
+    ABTS_PTR_EQUAL(tc, NULL, upf_sess_find_by_ipv4(addr));
+
+    ABTS_INT_EQUAL(tc, 1, inet_pton(AF_INET, "10.45.0.3", &addr));
+    ABTS_PTR_EQUAL(tc, old, upf_sess_find_by_ipv4(addr));
+
+    upf_sess_remove(old);
+    ABTS_PTR_EQUAL(tc, NULL, upf_sess_find_by_ipv4(addr));
+}
+
+abts_suite *test_route(abts_suite *suite)
+{
+    suite = ADD_SUITE(suite)
+
+    abts_run_test(suite, test1_func, NULL);
+    abts_run_test(suite, test2_func, NULL);
+    abts_run_test(suite, test3_func, NULL);
+    abts_run_test(suite, test4_func, NULL);
+
+    return suite;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2019-2024 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "upf-test-common.h"
+
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+
+upf_sess_t *test_sess_add(uint64_t seid)
+{
+    ogs_pfcp_f_seid_t f_seid;
+
+    memset(&f_seid, 0, sizeof(f_seid));
+    f_seid.ipv4 = 1;
+    f_seid.addr = htobe32(0x7f000004);
+    f_seid.seid = seid;
+
+    return upf_sess_add(&f_seid);
+}
+
+ogs_pfcp_rule_t *test_rule_add(ogs_pfcp_pdr_t *pdr, const char *flow)
+{
+    ogs_pfcp_rule_t *rule = NULL;
+    char *flow_description = NULL;
+
+    rule = ogs_pfcp_rule_add(pdr);
+    ogs_assert(rule);
+
+    flow_description = ogs_strdup(flow);
+    ogs_assert(flow_description);
+    ogs_assert(OGS_OK ==
+            ogs_ipfw_compile_rule(&rule->ipfw, flow_description));
+    ogs_free(flow_description);
+
+    return rule;
+}
+
+/* Downlink FAR with Outer header creation */
+void test_pdr_forward(upf_sess_t *sess, ogs_pfcp_pdr_t *pdr)
+{
+    ogs_pfcp_far_t *far = NULL;
+
+    far = ogs_pfcp_far_add(&sess->pfcp);
+    ogs_assert(far);
+    far->dst_if = OGS_PFCP_INTERFACE_ACCESS;
+    far->outer_header_creation.gtpu4 = 1;
+    ogs_pfcp_pdr_associate_far(pdr, far);
+}
+
+ogs_pkbuf_t *test_packet4(uint8_t proto,
+        const char *src, const char *dst, uint16_t dport)
+{
+    ogs_pkbuf_t *pkbuf = NULL;
+    struct ip *ip_h = NULL;
+    struct udphdr *udp_h = NULL;
+
+    pkbuf = ogs_pkbuf_alloc(NULL, OGS_MAX_PKT_LEN);
+    ogs_assert(pkbuf);
+    ogs_pkbuf_put(pkbuf, sizeof(*ip_h) + 20);
+    memset(pkbuf->data, 0, pkbuf->len);
+
+    ip_h = (struct ip *)pkbuf->data;
+    ip_h->ip_v = 4;
+    ip_h->ip_hl = sizeof(*ip_h) >> 2;
+    ip_h->ip_len = htobe16(pkbuf->len);
+    ip_h->ip_ttl = 64;
+    ip_h->ip_p = proto;
+    ogs_assert(1 == inet_pton(AF_INET, src, &ip_h->ip_src));
+    ogs_assert(1 == inet_pton(AF_INET, dst, &ip_h->ip_dst));
+
+    /* TCP and UDP share the position of the ports */
+    udp_h = (struct udphdr *)(ip_h + 1);
+    udp_h->uh_sport = htobe16(1);
+    udp_h->uh_dport = htobe16(dport);
+
+    return pkbuf;
+}
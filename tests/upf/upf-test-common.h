@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2019-2024 by Sukchan Lee <acetcom@gmail.com>
+ *
+ * This file is part of Open5GS.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TEST_UPF_COMMON_H
+#define TEST_UPF_COMMON_H
+
+#include "upf/context.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+upf_sess_t *test_sess_add(uint64_t seid);
+
+ogs_pfcp_rule_t *test_rule_add(ogs_pfcp_pdr_t *pdr, const char *flow);
+void test_pdr_forward(upf_sess_t *sess, ogs_pfcp_pdr_t *pdr);
+
+ogs_pkbuf_t *test_packet4(uint8_t proto,
+        const char *src, const char *dst, uint16_t dport);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_UPF_COMMON_H */